@@ -10,11 +10,27 @@ layout (set = 0, binding = 0) uniform UniformBufferObject {
     mat4 u_ViewProjectionMatrix[CASCADE_COUNT];
 };
 
-layout (push_constant) uniform ModelMatrix {
-    mat4 u_ModelMatrix;
+struct MeshInstance {
+    mat4 ModelMatrix;
+    int EntityIndex;
+    uint ViewMask;
+    uint MaterialIndex;
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer InstanceData {
+    MeshInstance u_Instances[];
 };
 
 void main()
 {
-    gl_Position = u_ViewProjectionMatrix[gl_ViewIndex] * u_ModelMatrix * vec4(a_Position, 1.0);
+    MeshInstance instance = u_Instances[gl_InstanceIndex];
+
+    // The instance doesn't intersect the caster volume of this cascade, so move it outside the clip volume to skip rasterization
+    if ((instance.ViewMask & (1u << gl_ViewIndex)) == 0u)
+    {
+        gl_Position = vec4(2.0, 2.0, 0.0, 1.0);
+        return;
+    }
+
+    gl_Position = u_ViewProjectionMatrix[gl_ViewIndex] * instance.ModelMatrix * vec4(a_Position, 1.0);
 }
\ No newline at end of file
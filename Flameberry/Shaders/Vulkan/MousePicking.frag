@@ -2,12 +2,9 @@
 
 layout (location = 0) out int o_EntityIndex;
 
-layout (push_constant) uniform MousePickingPushConstant {
-    mat4 u_ModelMatrix;
-    int u_EntityIndex;
-};
+layout (location = 0) flat in int v_EntityIndex;
 
 void main()
 {
-    o_EntityIndex = u_EntityIndex;
+    o_EntityIndex = v_EntityIndex;
 }
\ No newline at end of file
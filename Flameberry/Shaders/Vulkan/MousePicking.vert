@@ -6,12 +6,21 @@ layout (set = 0, binding = 0) uniform UniformBufferObject {
     mat4 u_ViewMatrix, u_ProjectionMatrix, u_ViewProjectionMatrix;
 };
 
-layout (push_constant) uniform MousePickingPushConstant {
-    mat4 u_ModelMatrix;
-    int u_EntityIndex;
+struct MeshInstance {
+    mat4 ModelMatrix;
+    int EntityIndex;
+    uint ViewMask;
+    uint MaterialIndex;
 };
 
+layout (std430, set = 0, binding = 1) readonly buffer InstanceData {
+    MeshInstance u_Instances[];
+};
+
+layout (location = 0) flat out int v_EntityIndex;
+
 void main()
 {
-    gl_Position = u_ViewProjectionMatrix * u_ModelMatrix * vec4(a_Position, 1.0);
+    gl_Position = u_ViewProjectionMatrix * u_Instances[gl_InstanceIndex].ModelMatrix * vec4(a_Position, 1.0);
+    v_EntityIndex = u_Instances[gl_InstanceIndex].EntityIndex;
 }
\ No newline at end of file
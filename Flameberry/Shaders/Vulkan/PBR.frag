@@ -1,11 +1,14 @@
 #version 450
 
+#extension GL_EXT_nonuniform_qualifier : require
+
 layout(location = 0) in vec3 v_WorldSpacePosition;
 layout(location = 1) in vec3 v_ClipSpacePosition;
 layout(location = 2) in vec3 v_Normal;
 layout(location = 3) in vec2 v_TextureCoords;
 layout(location = 4) in vec3 v_ViewSpacePosition;
 layout(location = 5) in mat3 v_TBNMatrix;
+layout(location = 8) flat in uint v_MaterialIndex;
 
 layout(location = 0) out vec4 o_FragColor;
 
@@ -32,19 +35,36 @@ struct DirectionalLight {
 
 struct PointLight {
     vec3 Position;
+    float Range;
     vec3 Color;
     float Intensity;
 };
 
 struct SpotLight {
     vec3 Position;
+    float Range;
     vec3 Direction;
+    float InnerConeAngle;
     vec3 Color;
     float Intensity;
-    float InnerConeAngle;
     float OuterConeAngle;
 };
 
+struct LightCluster {
+    uint Offset;
+    uint PointLightCount;
+    uint SpotLightCount;
+};
+
+struct Material {
+    vec3 Albedo;
+    float Roughness;
+    float Metallic;
+
+    uint UseAlbedoMap, UseNormalMap, UseRoughnessMap, UseAmbientMap, UseMetallicMap;
+    uint AlbedoMapIndex, NormalMapIndex, RoughnessMapIndex, AmbientMapIndex, MetallicMapIndex;
+};
+
 struct SceneRendererSettingsUniform {
     int EnableShadows, ShowCascades, SoftShadows, SkyReflections;
     float GammaCorrectionFactor, Exposure;
@@ -57,13 +77,36 @@ layout(std140, set = 1, binding = 0) uniform _FBY_SceneData {
     vec4 CascadeDepthSplits;
     vec3 CameraPosition;
     DirectionalLight DirectionalLight;
-    PointLight PointLights[10];
-    SpotLight SpotLights[10];
-    int PointLightCount, SpotLightCount;
+    uvec4 ClusterGridSize;
+    vec2 ClusterTileSize;
+    vec2 ClusterDepthSliceScaleBias;
     float SkyLightIntensity;
     SceneRendererSettingsUniform SceneRendererSettings;
 } u_SceneData;
 
+// The lights are assigned to a grid of clusters dividing the view frustum, every fragment only evaluates the lights of it's cluster
+// The indices of the point lights followed by the indices of the spot lights of a cluster start at `LightCluster.Offset`
+layout(std430, set = 1, binding = 1) readonly buffer _FBY_PointLights {
+    PointLight u_PointLights[];
+};
+
+layout(std430, set = 1, binding = 2) readonly buffer _FBY_SpotLights {
+    SpotLight u_SpotLights[];
+};
+
+layout(std430, set = 1, binding = 3) readonly buffer _FBY_LightClusters {
+    LightCluster u_LightClusters[];
+};
+
+layout(std430, set = 1, binding = 4) readonly buffer _FBY_LightIndices {
+    uint u_LightIndices[];
+};
+
+// The parameters of all the materials, indexed using the material index of the instance
+layout(std430, set = 1, binding = 5) readonly buffer _FBY_Materials {
+    Material u_Materials[];
+};
+
 // These are the uniforms that are set by Renderer and are not exposed to the Material class
 // How do we decide that? The classes which are marked by _FBY_ prefix are considered Renderer only
 layout(set = 2, binding = 0) uniform sampler2DArray _FBY_u_ShadowMapSamplerArray;
@@ -75,36 +118,35 @@ layout(set = 3, binding = 1) uniform samplerCube _FBY_u_IrradianceMap;
 layout(set = 3, binding = 2) uniform samplerCube _FBY_u_PrefilteredMap;
 layout(set = 3, binding = 3) uniform sampler2D _FBY_u_BRDFLUTMap;
 
-// These are the uniforms that are exposed to the Material class
-// How do we decide that? The classes which are not marked by _FBY_ prefix are exposed to the Material class
-layout(set = 4, binding = 0) uniform sampler2D u_AlbedoMapSampler;
-layout(set = 4, binding = 1) uniform sampler2D u_NormalMapSampler;
-layout(set = 4, binding = 2) uniform sampler2D u_RoughnessMapSampler;
-layout(set = 4, binding = 3) uniform sampler2D u_AmbientMapSampler;
-layout(set = 4, binding = 4) uniform sampler2D u_MetallicMapSampler;
-
-// This is the push constant that is exposed to Material class
-// How do we decide that? The classes which are not marked by _FBY_ prefix are exposed to the Material class
-layout(push_constant) uniform MeshData {
-    layout(offset = 64) vec3 u_Albedo;
-    float u_Roughness;
-    float u_Metallic;
-
-    uint u_UseAlbedoMap, u_UseNormalMap, u_UseRoughnessMap, u_UseAmbientMap, u_UseMetallicMap;
-};
+// The bindless texture table shared by all the materials, which refer to their texture maps using the indices in the material data
+layout(set = 4, binding = 0) uniform sampler2D _FBY_u_TextureTable[];
+
+// The feature bits of the pipeline variant, selected by the Renderer based on the material and the renderer settings
+// The branches on these are resolved when the pipeline is built, so the unused features cost nothing at runtime
+layout(constant_id = 0) const bool c_UseAlbedoMap = true;
+layout(constant_id = 1) const bool c_UseNormalMap = true;
+layout(constant_id = 2) const bool c_UseRoughnessMap = true;
+layout(constant_id = 3) const bool c_UseAmbientMap = true;
+layout(constant_id = 4) const bool c_UseMetallicMap = true;
+layout(constant_id = 5) const bool c_EnableShadows = true;
+layout(constant_id = 6) const bool c_SoftShadows = true;
+layout(constant_id = 7) const bool c_SkyReflections = true;
+
+// The material of the instance, the instances of a draw call can have different materials
+Material g_Material;
 
 vec3 GetPixelColor()
 {
-    if (u_UseAlbedoMap == 1)
-        return texture(u_AlbedoMapSampler, v_TextureCoords).xyz;
-    return u_Albedo;
+    if (c_UseAlbedoMap)
+        return texture(_FBY_u_TextureTable[nonuniformEXT(g_Material.AlbedoMapIndex)], v_TextureCoords).xyz;
+    return g_Material.Albedo;
 }
 
 vec3 GetPixelNormal()
 {
-    if (u_UseNormalMap == 1)
+    if (c_UseNormalMap)
     {
-        vec3 rgbNormal = texture(u_NormalMapSampler, v_TextureCoords).rgb * 2.0f - 1.003921568627451f;
+        vec3 rgbNormal = texture(_FBY_u_TextureTable[nonuniformEXT(g_Material.NormalMapIndex)], v_TextureCoords).rgb * 2.0f - 1.003921568627451f;
         return normalize(v_TBNMatrix * normalize(rgbNormal));
     }
     return normalize(v_Normal);
@@ -112,23 +154,23 @@ vec3 GetPixelNormal()
 
 float GetRoughnessFactor()
 {
-    if (u_UseRoughnessMap == 1)
-        return texture(u_RoughnessMapSampler, v_TextureCoords).x;
-    return u_Roughness;
+    if (c_UseRoughnessMap)
+        return texture(_FBY_u_TextureTable[nonuniformEXT(g_Material.RoughnessMapIndex)], v_TextureCoords).x;
+    return g_Material.Roughness;
 }
 
 float GetAmbientFactor()
 {
-    if (u_UseAmbientMap == 1)
-        return texture(u_AmbientMapSampler, v_TextureCoords).x;
+    if (c_UseAmbientMap)
+        return texture(_FBY_u_TextureTable[nonuniformEXT(g_Material.AmbientMapIndex)], v_TextureCoords).x;
     return 1.0;
 }
 
 float GetMetallicFactor()
 {
-    if (u_UseMetallicMap == 1)
-        return texture(u_MetallicMapSampler, v_TextureCoords).x;
-    return u_Metallic;
+    if (c_UseMetallicMap)
+        return texture(_FBY_u_TextureTable[nonuniformEXT(g_Material.MetallicMapIndex)], v_TextureCoords).x;
+    return g_Material.Metallic;
 }
 
 vec2 VogelDiskSample(uint sampleIndex, uint sampleCount, float phi)
@@ -400,7 +442,7 @@ vec3 PBR_DirectionalLight(DirectionalLight light, vec3 normal)
     vec3 l = normalize(-light.Direction);
 
     float shadow = 1.0f;
-    if (u_SceneData.SceneRendererSettings.EnableShadows == 1)
+    if (c_EnableShadows)
     {
         // Get cascade index for the current fragment's view position
         uint cascadeIndex = 0;
@@ -417,7 +459,7 @@ vec3 PBR_DirectionalLight(DirectionalLight light, vec3 normal)
         // Depth compare for shadowing
         vec4 shadowCoord = (g_BiasMatrix * u_SceneData.CascadeMatrices[cascadeIndex]) * vec4(v_WorldSpacePosition, 1.0f);
 
-        if (u_SceneData.SceneRendererSettings.SoftShadows == 1) {
+        if (c_SoftShadows) {
             float interleavedNoise = 2.0 * PI * Noise(v_ClipSpacePosition.xy);
             shadow = PCSS_Shadow_DirectionalLight(shadowCoord / shadowCoord.w, cascadeIndex, interleavedNoise, bias);
 
@@ -431,6 +473,14 @@ vec3 PBR_DirectionalLight(DirectionalLight light, vec3 normal)
     return shadow * PBR_CalcPixelColor(normal, l, lightIntensity);
 }
 
+// Smoothly brings the inverse square falloff to zero at the range of the light, so that the light doesn't end abruptly at the cluster boundaries
+float GetLightRangeAttenuation(float lightToPixelDistance, float range)
+{
+    float distanceRatio = lightToPixelDistance / range;
+    float window = clamp(1.0 - distanceRatio * distanceRatio * distanceRatio * distanceRatio, 0.0, 1.0);
+    return window * window / max(lightToPixelDistance * lightToPixelDistance, 0.0001);
+}
+
 vec3 PBR_PointLight(PointLight light, vec3 normal)
 {
     vec3 lightIntensity = light.Color * light.Intensity;
@@ -439,7 +489,7 @@ vec3 PBR_PointLight(PointLight light, vec3 normal)
     l = light.Position - v_WorldSpacePosition;
     float lightToPixelDistance = length(l);
     l = normalize(l);
-    lightIntensity /= lightToPixelDistance * lightToPixelDistance;
+    lightIntensity *= GetLightRangeAttenuation(lightToPixelDistance, light.Range);
 
     return PBR_CalcPixelColor(normal, l, lightIntensity);
 }
@@ -452,7 +502,7 @@ vec3 PBR_SpotLight(SpotLight light, vec3 normal)
     l = light.Position - v_WorldSpacePosition;
     float lightToPixelDistance = length(l);
     l = normalize(l);
-    lightIntensity /= lightToPixelDistance * lightToPixelDistance;
+    lightIntensity *= GetLightRangeAttenuation(lightToPixelDistance, light.Range);
 
     float innerConeAngleCos = cos(light.InnerConeAngle);
     float outerConeAngleCos = cos(light.OuterConeAngle);
@@ -466,20 +516,34 @@ vec3 PBR_SpotLight(SpotLight light, vec3 normal)
     return PBR_CalcPixelColor(normal, l, lightIntensity);
 }
 
+uint GetLightClusterIndex()
+{
+    // The depth slices are distributed exponentially between the near and the far planes of the camera
+    float viewSpaceDepth = max(-v_ViewSpacePosition.z, 0.0001);
+    float depthSlice = log(viewSpaceDepth) * u_SceneData.ClusterDepthSliceScaleBias.x - u_SceneData.ClusterDepthSliceScaleBias.y;
+
+    uvec3 cluster = uvec3(uvec2(gl_FragCoord.xy / u_SceneData.ClusterTileSize), uint(max(depthSlice, 0.0)));
+    cluster = min(cluster, u_SceneData.ClusterGridSize.xyz - 1);
+
+    return cluster.x + u_SceneData.ClusterGridSize.x * (cluster.y + u_SceneData.ClusterGridSize.y * cluster.z);
+}
+
 vec3 PBR_TotalLight(vec3 normal)
 {
     vec3 totalLight = vec3(0.0f);
 
     totalLight += PBR_DirectionalLight(u_SceneData.DirectionalLight, normal);
 
-    for (int i = 0; i < u_SceneData.PointLightCount; i++)
-        totalLight += PBR_PointLight(u_SceneData.PointLights[i], normal);
+    LightCluster cluster = u_LightClusters[GetLightClusterIndex()];
+
+    for (uint i = 0; i < cluster.PointLightCount; i++)
+        totalLight += PBR_PointLight(u_PointLights[u_LightIndices[cluster.Offset + i]], normal);
 
-    for (int i = 0; i < u_SceneData.SpotLightCount; i++)
-        totalLight += PBR_SpotLight(u_SceneData.SpotLights[i], normal);
+    for (uint i = 0; i < cluster.SpotLightCount; i++)
+        totalLight += PBR_SpotLight(u_SpotLights[u_LightIndices[cluster.Offset + cluster.PointLightCount + i]], normal);
 
     vec3 ambient = vec3(0.0);
-    if (u_SceneData.SceneRendererSettings.SkyReflections == 1)
+    if (c_SkyReflections)
         ambient += PBR_ImageBasedLighting(normal) * GetAmbientFactor();
     else
         ambient += 0.2f * u_SceneData.SkyLightIntensity * GetAmbientFactor() * GetPixelColor();
@@ -489,6 +553,8 @@ vec3 PBR_TotalLight(vec3 normal)
 
 void main()
 {
+    g_Material = u_Materials[v_MaterialIndex];
+
     vec3 normal = GetPixelNormal();
     vec3 intermediateColor = PBR_TotalLight(normal);
 
@@ -12,6 +12,7 @@ layout(location = 2) out vec3 v_Normal;
 layout(location = 3) out vec2 v_TextureCoords;
 layout(location = 4) out vec3 v_ViewSpacePosition;
 layout(location = 5) out mat3 v_TBNMatrix;
+layout(location = 8) flat out uint v_MaterialIndex;
 
 // These are the uniforms that are set by Renderer and are not exposed to the Material class
 // How do we decide that? The classes which are marked by _FBY_ prefix are considered Renderer only
@@ -19,28 +20,37 @@ layout(set = 0, binding = 0) uniform _FBY_CameraMatrices {
     mat4 u_ViewMatrix, u_ProjectionMatrix, u_ViewProjectionMatrix;
 };
 
-// This is the push constant that is set by the Renderer and is not exposed to the Material class
-// How do we decide that? The classes which are marked by _FBY_ prefix are considered Renderer only
-layout(push_constant) uniform _FBY_ModelMatrix {
-    mat4 u_ModelMatrix;
+struct MeshInstance {
+    mat4 ModelMatrix;
+    int EntityIndex;
+    uint ViewMask;
+    uint MaterialIndex;
+};
+
+// The per instance data of all the meshes in the frame, indexed using `gl_InstanceIndex` (which includes the `firstInstance` of the draw call)
+layout(std430, set = 0, binding = 1) readonly buffer _FBY_InstanceData {
+    MeshInstance u_Instances[];
 };
 
 void main()
 {
-    gl_Position = u_ViewProjectionMatrix * u_ModelMatrix * vec4(a_Position, 1.0);
+    mat4 modelMatrix = u_Instances[gl_InstanceIndex].ModelMatrix;
+    v_MaterialIndex = u_Instances[gl_InstanceIndex].MaterialIndex;
+
+    gl_Position = u_ViewProjectionMatrix * modelMatrix * vec4(a_Position, 1.0);
     v_ClipSpacePosition = gl_Position.xyz;
 
-    v_WorldSpacePosition = vec3(u_ModelMatrix * vec4(a_Position, 1.0));
+    v_WorldSpacePosition = vec3(modelMatrix * vec4(a_Position, 1.0));
     v_Normal = normalize(a_Normal);
     v_TextureCoords = a_TextureCoords;
 
-    mat3 worldSpaceMatrix = transpose(inverse(mat3(u_ModelMatrix)));
+    mat3 worldSpaceMatrix = transpose(inverse(mat3(modelMatrix)));
 
     v_Normal = worldSpaceMatrix * v_Normal; // TODO: Currently inefficient
     v_ViewSpacePosition = (u_ViewMatrix * vec4(v_WorldSpacePosition, 1.0)).xyz;
 
-    vec3 T = normalize(vec3(u_ModelMatrix * vec4(a_Tangent, 0.0)));
-    vec3 N = normalize(vec3(u_ModelMatrix * vec4(a_Normal, 0.0)));
+    vec3 T = normalize(vec3(modelMatrix * vec4(a_Tangent, 0.0)));
+    vec3 N = normalize(vec3(modelMatrix * vec4(a_Normal, 0.0)));
 
     // Re-orthogonalize T with respect to N
     T = normalize(T - dot(T, N) * N);
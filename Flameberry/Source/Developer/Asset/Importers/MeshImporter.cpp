@@ -12,6 +12,12 @@
 
 namespace Flameberry {
 
+	// The occluder geometry is imported with the same post processing as the mesh, so that the indices match the submeshes
+	static constexpr unsigned int s_PostProcessFlags = aiProcessPreset_TargetRealtime_Fast
+		// | aiProcessPreset_TargetRealtime_Quality
+		| aiProcess_FlipUVs
+		| aiProcess_GenBoundingBoxes;
+
 	Ref<StaticMesh> MeshImporter::ImportMesh(AssetHandle handle, const AssetMetadata& metadata)
 	{
 		return LoadMesh(metadata.FilePath);
@@ -158,6 +164,29 @@ namespace Flameberry {
 			ProcessNode(node->mChildren[i], scene, refVertices, refIndices, refSubMeshes, refMatHandles);
 	}
 
+	static void ProcessOccluderNode(aiNode* node, const aiScene* scene, std::vector<glm::vec3>& refPositions, std::vector<uint32_t>& refIndices)
+	{
+		// The meshes are visited in the same order as `ProcessNode()`, so that the index offsets of the submeshes apply
+		for (uint32_t i = 0; i < node->mNumMeshes; i++)
+		{
+			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+			const uint32_t indexBase = (uint32_t)refPositions.size();
+
+			for (uint32_t j = 0; j < mesh->mNumVertices; j++)
+				refPositions.emplace_back(mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z);
+
+			for (uint32_t j = 0; j < mesh->mNumFaces; j++)
+			{
+				const aiFace& face = mesh->mFaces[j];
+				for (uint32_t k = 0; k < face.mNumIndices; k++)
+					refIndices.push_back(indexBase + face.mIndices[k]);
+			}
+		}
+
+		for (uint32_t i = 0; i < node->mNumChildren; i++)
+			ProcessOccluderNode(node->mChildren[i], scene, refPositions, refIndices);
+	}
+
 	Ref<StaticMesh> MeshImporter::LoadMesh(const std::filesystem::path& path)
 	{
 		FBY_SCOPED_TIMER("Load_Model_Assimp");
@@ -168,11 +197,7 @@ namespace Flameberry {
 		// And have it read the given file with some example postprocessing
 		// Usually - if speed is not the most important aspect for you - you'll
 		// probably to request more postprocessing than we do in this example.
-		const aiScene* scene = importer.ReadFile(path.string(),
-			aiProcessPreset_TargetRealtime_Fast
-				// aiProcessPreset_TargetRealtime_Quality
-				| aiProcess_FlipUVs
-				| aiProcess_GenBoundingBoxes);
+		const aiScene* scene = importer.ReadFile(path.string(), s_PostProcessFlags);
 
 		// If the import failed, report it
 		if (!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE))
@@ -199,64 +224,35 @@ namespace Flameberry {
 		// Load Meshes
 		ProcessNode(scene->mRootNode, scene, vertices, indices, submeshes, materialHandles);
 
-		Ref<Buffer> vertexBuffer, indexBuffer;
-
-		{
-			// Creating Vertex Buffer
-			VkDeviceSize bufferSize = sizeof(MeshVertex) * vertices.size();
-
-			BufferSpecification stagingBufferSpec;
-			stagingBufferSpec.InstanceCount = 1;
-			stagingBufferSpec.InstanceSize = bufferSize;
-			stagingBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			stagingBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		// The geometry of all the meshes is suballocated from the shared blocks of the geometry arena
+		const GeometryAllocation geometry = GeometryArena::Allocate(vertices.data(), (uint32_t)vertices.size(), indices.data(), (uint32_t)indices.size());
 
-			Buffer stagingBuffer(stagingBufferSpec);
-
-			stagingBuffer.MapMemory(bufferSize);
-			stagingBuffer.WriteToBuffer(vertices.data(), bufferSize, 0);
-			stagingBuffer.UnmapMemory();
+		FBY_INFO("Loaded Model: '{}': Vertices: {}, Indices: {}", path, vertices.size(), indices.size());
+		Ref<StaticMesh> mesh = CreateRef<StaticMesh>(geometry, submeshes);
+		mesh->SetName(path.stem().string());
+		mesh->SetFilePath(path);
+		return mesh;
+	}
 
-			BufferSpecification vertexBufferSpec;
-			vertexBufferSpec.InstanceCount = 1;
-			vertexBufferSpec.InstanceSize = bufferSize;
-			vertexBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-			vertexBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	void MeshImporter::LoadOccluderGeometry(const Ref<StaticMesh>& mesh)
+	{
+		FBY_SCOPED_TIMER("Load_Occluder_Geometry_Assimp");
 
-			vertexBuffer = std::make_unique<Buffer>(vertexBufferSpec);
-			RenderCommand::CopyBuffer(stagingBuffer.GetVulkanBuffer(), vertexBuffer->GetVulkanBuffer(), bufferSize);
-		}
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(mesh->GetFilePath().string(), s_PostProcessFlags);
 
+		if (!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE))
 		{
-			// Creating Index Buffer
-			VkDeviceSize bufferSize = sizeof(uint32_t) * indices.size();
-			BufferSpecification stagingBufferSpec;
-
-			stagingBufferSpec.InstanceCount = 1;
-			stagingBufferSpec.InstanceSize = bufferSize;
-			stagingBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			stagingBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-			Buffer stagingBuffer(stagingBufferSpec);
-
-			stagingBuffer.MapMemory(bufferSize);
-			stagingBuffer.WriteToBuffer(indices.data(), bufferSize, 0);
-			stagingBuffer.UnmapMemory();
-
-			BufferSpecification indexBufferSpec;
-			indexBufferSpec.InstanceCount = 1;
-			indexBufferSpec.InstanceSize = bufferSize;
-			indexBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-			indexBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-
-			indexBuffer = std::make_unique<Buffer>(indexBufferSpec);
-			RenderCommand::CopyBuffer(stagingBuffer.GetVulkanBuffer(), indexBuffer->GetVulkanBuffer(), bufferSize);
+			FBY_ERROR("Failed to load the occluder geometry of mesh: {}: {}", mesh->GetFilePath(), importer.GetErrorString());
+			return;
 		}
 
-		FBY_INFO("Loaded Model: '{}': Vertices: {}, Indices: {}", path, vertices.size(), indices.size());
-		Ref<StaticMesh> mesh = CreateRef<StaticMesh>(vertexBuffer, indexBuffer, submeshes);
-		mesh->SetName(path.stem().string());
-		return mesh;
+		// The submeshes index into the whole vertex array, so the indices are kept as they are
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+		ProcessOccluderNode(scene->mRootNode, scene, positions, indices);
+
+		mesh->SetOccluderGeometry(std::move(positions), std::move(indices));
 	}
 
 } // namespace Flameberry
@@ -12,6 +12,8 @@ namespace Flameberry {
 	public:
 		static Ref<StaticMesh> ImportMesh(AssetHandle handle, const AssetMetadata& metadata);
 		static Ref<StaticMesh> LoadMesh(const std::filesystem::path& path);
+		// Imports the vertex positions and the indices of the mesh again from it's file, to be kept on the CPU for rasterizing the mesh as an occluder
+		static void LoadOccluderGeometry(const Ref<StaticMesh>& mesh);
 	};
 
 } // namespace Flameberry
\ No newline at end of file
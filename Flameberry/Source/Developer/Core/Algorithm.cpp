@@ -57,6 +57,18 @@ namespace Flameberry {
 			return -1;
 		}
 
+		uint64_t HashFNV1a64(const void* data, size_t size, uint64_t seed)
+		{
+			const uint8_t* bytes = (const uint8_t*)data;
+			uint64_t hash = seed;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
 	} // namespace Algorithm
 
 } // namespace Flameberry
@@ -1,11 +1,76 @@
 #pragma once
 
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <utility>
+
 namespace Flameberry {
 
 	namespace Algorithm {
 
 		int KmpSearch(const char* txt, const char* pat, bool ignoreCase = false);
 
-	}
+		/// @brief 64 bit FNV-1a hash of the bytes, used to key and validate the caches stored on disk.
+		/// @param seed - The hash of the previous bytes, so that multiple buffers can be hashed together
+		uint64_t HashFNV1a64(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+
+		/// @brief Stable LSD radix sort of the items by a 64 bit key using 8 bit digits.
+		/// Digits which are identical for all the items are skipped, so keys using only a few bits sort in fewer passes.
+		/// @param items - The items to be sorted
+		/// @param scratch - A scratch buffer which is reused across calls to avoid allocations
+		/// @param getKey - Returns the 64 bit key of an item
+		template <typename T, typename KeyFn>
+		void RadixSort64(std::vector<T>& items, std::vector<T>& scratch, KeyFn getKey)
+		{
+			constexpr uint32_t digitBits = 8, bucketCount = 1 << digitBits, passCount = 64 / digitBits;
+
+			const size_t count = items.size();
+			if (count < 2)
+				return;
+
+			// Build the histograms of all the digits in one go
+			std::array<std::array<uint32_t, bucketCount>, passCount> histograms{};
+			for (const auto& item : items)
+			{
+				const uint64_t key = getKey(item);
+				for (uint32_t pass = 0; pass < passCount; pass++)
+					histograms[pass][(key >> (pass * digitBits)) & (bucketCount - 1)]++;
+			}
+
+			scratch.resize(count);
+			std::vector<T>* source = &items;
+			std::vector<T>* destination = &scratch;
+
+			for (uint32_t pass = 0; pass < passCount; pass++)
+			{
+				auto& histogram = histograms[pass];
+
+				// Skip the pass if every item falls into the same bucket
+				const uint64_t firstDigit = (getKey((*source)[0]) >> (pass * digitBits)) & (bucketCount - 1);
+				if (histogram[firstDigit] == count)
+					continue;
+
+				// Convert the histogram into the starting offsets of each bucket
+				uint32_t offset = 0;
+				for (auto& bucket : histogram)
+				{
+					const uint32_t bucketSize = bucket;
+					bucket = offset;
+					offset += bucketSize;
+				}
+
+				for (const auto& item : *source)
+					(*destination)[histogram[(getKey(item) >> (pass * digitBits)) & (bucketCount - 1)]++] = item;
+
+				std::swap(source, destination);
+			}
+
+			// Odd number of passes leave the result in the scratch buffer
+			if (source != &items)
+				items.swap(scratch);
+		}
+
+	} // namespace Algorithm
 
 } // namespace Flameberry
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 #include "ImGui/ImGuiLayer.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/GPUProfiler.h"
+#include "Renderer/PipelineCache.h"
 #include "Renderer/Texture2D.h"
 #include "Asset/AssetManager.h"
 
@@ -41,6 +43,7 @@ namespace Flameberry {
 	void Application::Run()
 	{
 		float last = 0.0f;
+		bool isFirstFrame = true;
 		while (m_Window->IsRunning())
 		{
 			float now = glfwGetTime();
@@ -48,24 +51,39 @@ namespace Flameberry {
 			float delta = now - last;
 			last = now;
 
+			// The resources of the frame index are written from here on, so the GPU has to be done with the frame that last used them
+			Renderer::BeginFrame();
+
 			// This is where all the layers get updated and
 			// The layers submit render commands to a command queue present in `Renderer`
+			// This runs in parallel with the render thread which is rendering the previous frame
 			for (auto& layer : m_LayerStack)
 				layer->OnUpdate(delta);
 
-			// ImGui Rendering is submitted as a render command because otherwise it behaves oddly and gives validation errors
-			Renderer::Submit([app = this](VkCommandBuffer, uint32_t)
+			// The UI is built in parallel with the render thread as well, which records the copy of the draw data of the previous frame
+			m_ImGuiLayer->Begin();
+			for (auto& layer : m_LayerStack)
+				layer->OnUIRender();
+			m_ImGuiLayer->End();
+
+			// Only the recording of the ImGui draw data is submitted as a render command
+			GPUProfiler::BeginScope("ImGui");
+			Renderer::Submit([app = this, drawData = m_ImGuiLayer->GetDrawData()](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
 				{
-					app->m_ImGuiLayer->Begin();
-					for (auto& layer : app->m_LayerStack)
-						layer->OnUIRender();
-					app->m_ImGuiLayer->End();
+					app->m_ImGuiLayer->RT_Render(cmdBuffer, imageIndex, drawData);
 				});
+			GPUProfiler::EndScope();
 
-			// This is where the rendering of the entire frame is done
-			// All the render commands are executed one by one here
+			// This kicks the render thread which executes all the render commands one by one
 			Renderer::WaitAndRender();
 			glfwPollEvents();
+
+			// The first frame waits on every pipeline it draws with, so this covers the pipeline builds the cache is meant to speed up
+			if (isFirstFrame)
+			{
+				FBY_INFO("Startup took {} ms (pipeline cache loaded from disk: {})", m_StartupTimer.GetTimeEllapsedMilliseconds(), PipelineCache::IsLoadedFromDisk());
+				isFirstFrame = false;
+			}
 		}
 	}
 
@@ -98,7 +116,8 @@ namespace Flameberry {
 
 	void Application::OnWindowResizedEvent(WindowResizedEvent& e)
 	{
-		// TODO: Wait for Render Thread to finish Rendering
+		// The swapchain and the ImGui framebuffers can't be recreated while the render thread is using them
+		Renderer::WaitForRenderThread();
 		m_Window->Resize();
 		m_ImGuiLayer->InvalidateResources();
 	}
@@ -151,6 +170,7 @@ namespace Flameberry {
 
 	Application::~Application()
 	{
+		Renderer::WaitForRenderThread();
 		VulkanContext::GetCurrentDevice()->WaitIdle();
 
 		for (auto* layer : m_LayerStack)
@@ -4,6 +4,7 @@
 
 #include "Window.h"
 #include "Layer.h"
+#include "Timer.h"
 #include "ImGui/ImGuiLayer.h"
 
 #include "Renderer/VulkanContext.h"
@@ -69,6 +70,9 @@ namespace Flameberry {
 	private:
 		ApplicationSpecification m_Specification;
 
+		// Started when the application is constructed and read once the first frame is handed to the render thread
+		Timer m_StartupTimer;
+
 		Ref<Window> m_Window;
 		Ref<VulkanContext> m_VulkanContext;
 		ImGuiLayer* m_ImGuiLayer;
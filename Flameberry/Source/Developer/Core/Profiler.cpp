@@ -4,6 +4,7 @@
 
 namespace Flameberry {
 
+	std::mutex Profiler::s_Mutex;
 	std::unordered_map<std::string, double> Profiler::s_ScopeExecutionTimes;
 
 	Profiler::Profiler(const std::string& scopeName)
@@ -15,11 +16,20 @@ namespace Flameberry {
 	Profiler::~Profiler()
 	{
 		double executionTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - m_Start).count();
+
+		std::scoped_lock<std::mutex> lock(s_Mutex);
 		s_ScopeExecutionTimes[m_ScopeName] = executionTime;
 	}
 
+	double Profiler::GetExecutionTime(const std::string& scopeName)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+		return s_ScopeExecutionTimes[scopeName];
+	}
+
 	void Profiler::DisplayScopeDetailsImGui()
 	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
 		for (auto& [scope, time] : s_ScopeExecutionTimes)
 			ImGui::Text("%s: %.4f ms", scope.c_str(), time * 0.001 * 0.001);
 	}
@@ -3,6 +3,7 @@
 #include <string>
 #include <unordered_map>
 #include <chrono>
+#include <mutex>
 
 namespace Flameberry {
 
@@ -12,13 +13,15 @@ namespace Flameberry {
 		Profiler(const std::string& scopeName);
 		~Profiler();
 
-		static double GetExecutionTime(const std::string& scopeName) { return s_ScopeExecutionTimes[scopeName]; }
+		static double GetExecutionTime(const std::string& scopeName);
 		static void DisplayScopeDetailsImGui();
 
 	private:
 		std::string m_ScopeName;
 		decltype(std::chrono::high_resolution_clock::now()) m_Start;
 
+		// Scopes are recorded by both the main thread and the render thread
+		static std::mutex s_Mutex;
 		static std::unordered_map<std::string, double> s_ScopeExecutionTimes;
 	};
 
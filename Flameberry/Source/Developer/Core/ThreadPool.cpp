@@ -0,0 +1,63 @@
+#include "ThreadPool.h"
+
+#include "Core/Core.h"
+
+namespace Flameberry {
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		FBY_ASSERT(threadCount, "ThreadPool: Thread count must be greater than 0");
+
+		m_Workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	std::future<void> ThreadPool::Submit(const Job& job)
+	{
+		std::packaged_task<void()> task(job);
+		std::future<void> future = task.get_future();
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_Jobs.emplace(std::move(task));
+		}
+		m_ConditionVariable.notify_one();
+		return future;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::packaged_task<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_ConditionVariable.wait(lock, [this] { return !m_Jobs.empty() || !m_IsRunning; });
+
+				// Finish the remaining jobs before exiting
+				if (!m_IsRunning && m_Jobs.empty())
+					break;
+
+				task = std::move(m_Jobs.front());
+				m_Jobs.pop();
+			}
+			task();
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_IsRunning = false;
+		}
+		m_ConditionVariable.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			if (worker.joinable())
+				worker.join();
+		}
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+namespace Flameberry {
+
+	// A fixed size pool of worker threads which execute the submitted jobs in FIFO order
+	class ThreadPool
+	{
+	public:
+		using Job = std::function<void()>;
+
+	public:
+		ThreadPool(uint32_t threadCount);
+		~ThreadPool();
+
+		// Queues the job and returns a future that becomes ready once the job has been executed
+		std::future<void> Submit(const Job& job);
+
+		uint32_t GetThreadCount() const { return (uint32_t)m_Workers.size(); }
+
+	private:
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> m_Workers;
+		std::queue<std::packaged_task<void()>> m_Jobs;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_ConditionVariable;
+		bool m_IsRunning = true;
+	};
+
+} // namespace Flameberry
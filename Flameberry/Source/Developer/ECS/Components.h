@@ -73,6 +73,9 @@ namespace Flameberry {
 		// This stores the materials that are used for rendering instead of the default ones which are loaded from the mesh source file
 		MaterialTable OverridenMaterialTable;
 
+		// Occluders are rasterized into the software occlusion buffer to cull the submeshes hidden behind them, suited for large opaque meshes like walls
+		bool IsOccluder = false;
+
 		MeshComponent(AssetHandle meshHandle = 0)
 			: MeshHandle(meshHandle) {}
 	};
@@ -192,6 +192,9 @@ namespace Flameberry {
 					auto& meshComp = destScene->m_Registry->EmplaceComponent<MeshComponent>(deserializedEntity, 0);
 					meshComp.MeshHandle = mesh["MeshHandle"].as<AssetHandle>();
 
+					if (auto isOccluder = mesh["IsOccluder"])
+						meshComp.IsOccluder = isOccluder.as<bool>();
+
 					for (auto entry : mesh["OverridenMaterialTable"])
 						meshComp.OverridenMaterialTable[entry["SubmeshIndex"].as<uint32_t>()] = entry["Material"].as<AssetHandle>();
 				}
@@ -366,6 +369,7 @@ namespace Flameberry {
 			auto& mesh = scene->m_Registry->GetComponent<MeshComponent>(entity);
 			out << YAML::Key << "MeshComponent" << YAML::BeginMap;
 			out << YAML::Key << "MeshHandle" << YAML::Value << mesh.MeshHandle;
+			out << YAML::Key << "IsOccluder" << YAML::Value << mesh.IsOccluder;
 
 			out << YAML::Key << "OverridenMaterialTable" << YAML::BeginSeq;
 
@@ -13,6 +13,7 @@
 #include "Renderer/VulkanDebug.h"
 #include "Renderer/VulkanContext.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/PipelineCache.h"
 
 namespace Flameberry {
 
@@ -133,7 +134,7 @@ namespace Flameberry {
 		init_info.Device = device->GetVulkanDevice();
 		init_info.QueueFamily = device->GetQueueFamilyIndices().GraphicsQueueFamilyIndex;
 		init_info.Queue = device->GetGraphicsQueue();
-		init_info.PipelineCache = VK_NULL_HANDLE;
+		init_info.PipelineCache = PipelineCache::GetVulkanPipelineCache();
 		init_info.DescriptorPool = VulkanContext::GetCurrentGlobalDescriptorPool()->GetVulkanDescriptorPool();
 		init_info.Subpass = 0;
 		init_info.MinImageCount = vk_swap_chain_details.SurfaceCapabilities.minImageCount;
@@ -150,6 +151,9 @@ namespace Flameberry {
 		// Saving ImGui Layout
 		ImGui::SaveIniSettingsToDisk(s_ImGuiLayoutPath);
 
+		for (auto& snapshot : m_DrawDataSnapshots)
+			ClearDrawDataSnapshot(snapshot);
+
 		ImGui_ImplVulkan_Shutdown();
 		ImGui_ImplGlfw_Shutdown();
 		ImGui::DestroyContext();
@@ -179,13 +183,35 @@ namespace Flameberry {
 		io.DisplaySize = ImVec2((float)VulkanContext::GetCurrentWindow()->GetSpecification().Width, (float)VulkanContext::GetCurrentWindow()->GetSpecification().Height);
 
 		ImGui::Render();
-		ImDrawData* main_draw_data = ImGui::GetDrawData();
 
+		// The draw data of ImGui is only valid until the next `ImGui::NewFrame()`, which is called while the render thread might still be recording it
+		m_DrawDataSnapshotIndex = (m_DrawDataSnapshotIndex + 1) % m_DrawDataSnapshots.size();
+		auto& snapshot = m_DrawDataSnapshots[m_DrawDataSnapshotIndex];
+		ClearDrawDataSnapshot(snapshot);
+
+		snapshot = *ImGui::GetDrawData();
+		for (ImDrawList*& drawList : snapshot.CmdLists)
+			drawList = drawList->CloneOutput();
+
+		// Update and Render additional Platform Windows
+		// This has to be done in the main thread as it makes use of the windowing API
+		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+		{
+			std::scoped_lock<std::mutex> lock(VulkanContext::GetCurrentDevice()->GetQueueMutex());
+
+			GLFWwindow* backup_current_context = glfwGetCurrentContext();
+			ImGui::UpdatePlatformWindows();
+			ImGui::RenderPlatformWindowsDefault();
+			glfwMakeContextCurrent(backup_current_context);
+		}
+	}
+
+	void ImGuiLayer::RT_Render(VkCommandBuffer cmdBuffer, uint32_t imageIndex, ImDrawData* drawData)
+	{
 		// Begin ImGui Render Pass
 		VkClearValue clear_value{};
 		clear_value.color = { 0.0f, 0.0f, 0.0f, 1.0f };
 
-		uint32_t imageIndex = VulkanContext::GetCurrentWindow()->GetImageIndex();
 		const auto& swapchain = VulkanContext::GetCurrentWindow()->GetSwapChain();
 
 		VkRenderPassBeginInfo imgui_render_pass_begin_info{};
@@ -196,23 +222,20 @@ namespace Flameberry {
 		imgui_render_pass_begin_info.clearValueCount = 1;
 		imgui_render_pass_begin_info.pClearValues = &clear_value;
 
-		VkCommandBuffer commandBuffer = Renderer::GetActiveVulkanCommandBuffer();
-		vkCmdBeginRenderPass(commandBuffer, &imgui_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(cmdBuffer, &imgui_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
 		// Record dear imgui primitives into command buffer
-		ImGui_ImplVulkan_RenderDrawData(main_draw_data, commandBuffer);
+		ImGui_ImplVulkan_RenderDrawData(drawData, cmdBuffer);
 
 		// End ImGui Render Pass
-		vkCmdEndRenderPass(commandBuffer);
+		vkCmdEndRenderPass(cmdBuffer);
+	}
 
-		// Update and Render additional Platform Windows
-		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-		{
-			GLFWwindow* backup_current_context = glfwGetCurrentContext();
-			ImGui::UpdatePlatformWindows();
-			ImGui::RenderPlatformWindowsDefault();
-			glfwMakeContextCurrent(backup_current_context);
-		}
+	void ImGuiLayer::ClearDrawDataSnapshot(ImDrawData& snapshot)
+	{
+		for (ImDrawList* drawList : snapshot.CmdLists)
+			IM_DELETE(drawList);
+		snapshot.Clear();
 	}
 
 	void ImGuiLayer::InvalidateResources()
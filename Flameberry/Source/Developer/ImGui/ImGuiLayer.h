@@ -2,6 +2,8 @@
 
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <array>
+#include <imgui.h>
 
 #include "Core/Layer.h"
 
@@ -19,8 +21,13 @@ namespace Flameberry {
 		void OnEvent(Event& e) override;
 		void OnDestroy() override;
 
+		// Builds the UI of the frame, called by the main thread while the render thread is rendering the previous frame
 		void Begin();
 		void End();
+		// The copy of the draw data generated by the last `End()` call, which stays valid while the UI of the next frame is built
+		ImDrawData* GetDrawData() { return &m_DrawDataSnapshots[m_DrawDataSnapshotIndex]; }
+		// Records the given draw data into the main command buffer
+		void RT_Render(VkCommandBuffer cmdBuffer, uint32_t imageIndex, ImDrawData* drawData);
 
 		void BlockEvents(bool block) { m_BlockEvents = block; }
 		void InvalidateResources();
@@ -28,12 +35,17 @@ namespace Flameberry {
 	private:
 		void SetupImGuiStyle();
 		void CreateResources();
+		static void ClearDrawDataSnapshot(ImDrawData& snapshot);
 
 	private:
 		bool m_BlockEvents = false;
 		VkRenderPass m_ImGuiLayerRenderPass;
 		std::vector<VkFramebuffer> m_ImGuiFramebuffers;
 		std::vector<VkImageView> m_ImGuiImageViews;
+
+		// The render thread records the draw data of a frame while the next one is being built, hence the draw lists are copied
+		std::array<ImDrawData, 2> m_DrawDataSnapshots;
+		uint32_t m_DrawDataSnapshotIndex = 0;
 	};
 
 } // namespace Flameberry
\ No newline at end of file
@@ -9,11 +9,23 @@
 #include "Asset/RuntimeAssetManager.h"
 
 #include "Project/ProjectSerializer.h"
+#include "Renderer/PipelineCache.h"
 
 namespace Flameberry {
 
 	Ref<Project> Project::s_ActiveProject;
 
+	void Project::SetActive(const Ref<Project>& project)
+	{
+		if (s_ActiveProject)
+			PipelineCache::SaveProjectCache();
+
+		s_ActiveProject = project;
+
+		if (s_ActiveProject)
+			PipelineCache::LoadProjectCache(s_ActiveProject->GetCacheDirectory());
+	}
+
 	Ref<Project> Project::CreateProjectOnDisk(const std::filesystem::path& targetFolder, const std::string& projectName)
 	{
 		ProjectConfig projectConfig;
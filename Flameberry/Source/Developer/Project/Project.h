@@ -25,7 +25,8 @@ namespace Flameberry {
 
 		static inline const std::filesystem::path& GetActiveProjectDirectory() { return s_ActiveProject->GetProjectDirectory(); }
 		static Ref<Project> GetActiveProject() { return s_ActiveProject; }
-		static void SetActive(const Ref<Project>& project) { s_ActiveProject = project; }
+		// The pipeline cache of the renderer is saved for the previously active project and loaded for the new one
+		static void SetActive(const Ref<Project>& project);
 
 		// Standard procedure for creating a project on disk
 		static Ref<Project> CreateProjectOnDisk(const std::filesystem::path& targetFolder, const std::string& projectName);
@@ -44,6 +45,8 @@ namespace Flameberry {
 		std::filesystem::path GetAssetDirectory() const { return m_ProjectDirectory / m_Config.AssetDirectory; }
 		std::filesystem::path GetAssetRegistryPath() const { return m_ProjectDirectory / m_Config.AssetRegistryPath; }
 		std::filesystem::path GetThumbnailCacheDirectory() const { return m_ProjectDirectory / m_Config.ThumbnailCacheDirectory; }
+		// The caches which are specific to the machine, like the pipeline cache
+		std::filesystem::path GetCacheDirectory() const { return m_ProjectDirectory / "Intermediate" / "Cache"; }
 
 		ProjectConfig& GetConfig() { return m_Config; }
 
@@ -1,5 +1,7 @@
 #include "Buffer.h"
 
+#include <algorithm>
+
 #include "VulkanDebug.h"
 #include "RenderCommand.h"
 #include "VulkanContext.h"
@@ -20,7 +22,6 @@ namespace Flameberry {
 		VkDeviceSize bufferSize = m_AlignmentSize * m_BufferSpec.InstanceCount;
 
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-		const auto& physicalDevice = VulkanContext::GetPhysicalDevice();
 
 		VkBufferCreateInfo vk_buffer_create_info{};
 		vk_buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -30,46 +31,35 @@ namespace Flameberry {
 
 		VK_CHECK_RESULT(vkCreateBuffer(device, &vk_buffer_create_info, nullptr, &m_VkBuffer));
 
-		VkMemoryRequirements vk_memory_requirements{};
-		vkGetBufferMemoryRequirements(device, m_VkBuffer, &vk_memory_requirements);
-
-		VkMemoryAllocateInfo vk_memory_allocate_info{};
-		vk_memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		vk_memory_allocate_info.allocationSize = vk_memory_requirements.size;
-		vk_memory_allocate_info.memoryTypeIndex = RenderCommand::GetValidMemoryTypeIndex(physicalDevice, vk_memory_requirements.memoryTypeBits, m_BufferSpec.MemoryProperties);
-
-		VK_CHECK_RESULT(vkAllocateMemory(device, &vk_memory_allocate_info, nullptr, &m_VkBufferDeviceMemory));
-		vkBindBufferMemory(device, m_VkBuffer, m_VkBufferDeviceMemory, 0);
+		m_MemoryAllocation = VulkanContext::GetCurrentDevice()->GetMemoryAllocator().AllocateBufferMemory(m_VkBuffer, m_BufferSpec.Usage, m_BufferSpec.MemoryProperties);
 	}
 
 	Buffer::~Buffer()
 	{
-		if (m_VkBuffer != VK_NULL_HANDLE && m_VkBufferDeviceMemory != VK_NULL_HANDLE)
+		if (m_VkBuffer != VK_NULL_HANDLE && m_MemoryAllocation.IsValid())
 		{
-			const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-			vkDestroyBuffer(device, m_VkBuffer, nullptr);
-			vkFreeMemory(device, m_VkBufferDeviceMemory, nullptr);
+			const auto& device = VulkanContext::GetCurrentDevice();
+			vkDestroyBuffer(device->GetVulkanDevice(), m_VkBuffer, nullptr);
+			device->GetMemoryAllocator().Free(m_MemoryAllocation);
 
 			m_VkBuffer = VK_NULL_HANDLE;
-			m_VkBufferDeviceMemory = VK_NULL_HANDLE;
+			m_MemoryAllocation = {};
 		}
 	}
 
 	VkResult Buffer::MapMemory(VkDeviceSize size, VkDeviceSize offset)
 	{
-		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-		FBY_ASSERT(size && m_VkBufferDeviceMemory, "Cannot Map memory of size: 0!");
-		return vkMapMemory(device, m_VkBufferDeviceMemory, offset, size, 0, &m_VkBufferMappedMemory);
+		FBY_ASSERT(size && m_MemoryAllocation.IsValid(), "Cannot Map memory of size: 0!");
+		FBY_ASSERT(m_MemoryAllocation.MappedMemory, "Cannot Map memory which is not host visible!");
+
+		// The allocator keeps the host visible memory mapped, as the other buffers in the same block might be mapped too
+		m_VkBufferMappedMemory = (char*)m_MemoryAllocation.MappedMemory + offset;
+		return VK_SUCCESS;
 	}
 
 	void Buffer::UnmapMemory()
 	{
-		if (m_VkBufferMappedMemory)
-		{
-			const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-			vkUnmapMemory(device, m_VkBufferDeviceMemory);
-			m_VkBufferMappedMemory = nullptr;
-		}
+		m_VkBufferMappedMemory = nullptr;
 	}
 
 	void Buffer::WriteToBuffer(const void* data, VkDeviceSize size, VkDeviceSize offset)
@@ -92,11 +82,16 @@ namespace Flameberry {
 
 	VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset)
 	{
+		// The range is relative to the allocation and has to be aligned to the atoms in the device memory
+		const VkDeviceSize atomSize = VulkanContext::GetCurrentDevice()->GetMemoryAllocator().GetNonCoherentAtomSize();
+		const VkDeviceSize begin = (m_MemoryAllocation.Offset + offset) & ~(atomSize - 1);
+		const VkDeviceSize end = size == VK_WHOLE_SIZE ? m_MemoryAllocation.Offset + m_MemoryAllocation.Size : m_MemoryAllocation.Offset + offset + size;
+
 		VkMappedMemoryRange mappedRange = {};
 		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = m_VkBufferDeviceMemory;
-		mappedRange.offset = offset;
-		mappedRange.size = size;
+		mappedRange.memory = m_MemoryAllocation.Memory;
+		mappedRange.offset = begin;
+		mappedRange.size = std::min((end - begin + atomSize - 1) & ~(atomSize - 1), m_MemoryAllocation.Offset + m_MemoryAllocation.Size - begin);
 
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 		return vkFlushMappedMemoryRanges(device, 1, &mappedRange);
@@ -4,6 +4,7 @@
 #include <vulkan/vulkan.h>
 
 #include "Core/Core.h"
+#include "DeviceMemoryAllocator.h"
 
 namespace Flameberry {
 
@@ -39,7 +40,8 @@ namespace Flameberry {
 
 	private:
 		VkBuffer m_VkBuffer = VK_NULL_HANDLE;
-		VkDeviceMemory m_VkBufferDeviceMemory = VK_NULL_HANDLE;
+		// Suballocated from the blocks of the device memory allocator, host visible memory is always mapped
+		MemoryAllocation m_MemoryAllocation;
 		void* m_VkBufferMappedMemory = nullptr;
 
 		VkDeviceSize m_AlignmentSize;
@@ -22,12 +22,21 @@ namespace Flameberry {
 	{
 	}
 
-	void CommandBuffer::Begin()
+	void CommandBuffer::Begin(const VkCommandBufferInheritanceInfo* inheritanceInfo)
 	{
+		FBY_ASSERT(m_Specification.IsPrimary || inheritanceInfo, "Secondary command buffers require inheritance info!");
+
 		VkCommandBufferBeginInfo commandBufferBeginInfo{};
 		commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		commandBufferBeginInfo.flags = m_Specification.SingleTimeUsage ? VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT : 0;
 
+		if (!m_Specification.IsPrimary)
+		{
+			commandBufferBeginInfo.pInheritanceInfo = inheritanceInfo;
+			if (inheritanceInfo->renderPass != VK_NULL_HANDLE)
+				commandBufferBeginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		}
+
 		VK_CHECK_RESULT(vkBeginCommandBuffer(m_CommandBuffer, &commandBufferBeginInfo));
 	}
 
@@ -17,7 +17,9 @@ namespace Flameberry {
 		CommandBuffer(const CommandBufferSpecification& specification);
 		~CommandBuffer();
 
-		void Begin();
+		// The inheritance info is only required for secondary command buffers
+		// If it provides a render pass, then the command buffer is assumed to be executed entirely inside that render pass
+		void Begin(const VkCommandBufferInheritanceInfo* inheritanceInfo = nullptr);
 		void End();
 
 		void Reset();
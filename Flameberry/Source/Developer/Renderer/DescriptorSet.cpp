@@ -1,6 +1,7 @@
 #include "DescriptorSet.h"
 
 #include <array>
+#include <algorithm>
 
 #include <MurmurHash/MurmurHash3.h>
 
@@ -30,7 +31,7 @@ namespace Flameberry {
 		// This is to notify the developer about too many comparisons
 		g_DescriptorSetLayoutSpecificationComparisons++;
 
-		return s1.Bindings == s2.Bindings;
+		return s1.Bindings == s2.Bindings && s1.Flags == s2.Flags && s1.BindingFlags == s2.BindingFlags;
 	}
 
 } // namespace Flameberry
@@ -53,14 +54,14 @@ namespace std {
 
 namespace Flameberry {
 
-	DescriptorPool::DescriptorPool(VkDevice device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxSets)
+	DescriptorPool::DescriptorPool(VkDevice device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxSets, VkDescriptorPoolCreateFlags flags)
 	{
 		VkDescriptorPoolCreateInfo vk_descriptor_pool_create_info{};
 		vk_descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		vk_descriptor_pool_create_info.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		vk_descriptor_pool_create_info.pPoolSizes = poolSizes.data();
 		vk_descriptor_pool_create_info.maxSets = maxSets;
-		vk_descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		vk_descriptor_pool_create_info.flags = flags;
 
 		VK_CHECK_RESULT(vkCreateDescriptorPool(device, &vk_descriptor_pool_create_info, nullptr, &m_VkDescriptorPool));
 	}
@@ -80,11 +81,22 @@ namespace Flameberry {
 		vk_descriptor_set_allocate_info.pSetLayouts = &descriptorSetLayout;
 
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &vk_descriptor_set_allocate_info, descriptorSet));
+		const VkResult result = vkAllocateDescriptorSets(device, &vk_descriptor_set_allocate_info, descriptorSet);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+			return false;
+
+		VK_CHECK_RESULT(result);
 		return true;
 	}
 
+	void DescriptorPool::Reset()
+	{
+		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+		VK_CHECK_RESULT(vkResetDescriptorPool(device, m_VkDescriptorPool, 0));
+	}
+
 	std::unordered_map<DescriptorSetLayoutSpecification, Ref<DescriptorSetLayout>> DescriptorSetLayout::s_CachedDescriptorSetLayouts;
+	std::mutex DescriptorSetLayout::s_CacheMutex;
 
 	DescriptorSetLayout::DescriptorSetLayout(const DescriptorSetLayoutSpecification& specification)
 		: m_DescSetLayoutSpec(specification)
@@ -93,6 +105,19 @@ namespace Flameberry {
 		vk_descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 		vk_descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(m_DescSetLayoutSpec.Bindings.size());
 		vk_descriptor_set_layout_create_info.pBindings = m_DescSetLayoutSpec.Bindings.data();
+		vk_descriptor_set_layout_create_info.flags = m_DescSetLayoutSpec.Flags;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo{};
+		if (m_DescSetLayoutSpec.BindingFlags.size())
+		{
+			FBY_ASSERT(m_DescSetLayoutSpec.BindingFlags.size() == m_DescSetLayoutSpec.Bindings.size(), "The binding flags must be specified for all the bindings of the descriptor set layout");
+
+			bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+			bindingFlagsCreateInfo.bindingCount = (uint32_t)m_DescSetLayoutSpec.BindingFlags.size();
+			bindingFlagsCreateInfo.pBindingFlags = m_DescSetLayoutSpec.BindingFlags.data();
+
+			vk_descriptor_set_layout_create_info.pNext = &bindingFlagsCreateInfo;
+		}
 
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &vk_descriptor_set_layout_create_info, nullptr, &m_Layout));
@@ -106,6 +131,8 @@ namespace Flameberry {
 
 	Ref<DescriptorSetLayout> DescriptorSetLayout::CreateOrGetCached(const DescriptorSetLayoutSpecification& specification)
 	{
+		std::scoped_lock<std::mutex> lock(s_CacheMutex);
+
 #ifdef FBY_DEBUG
 		// Debug only
 		static int calls = 0;
@@ -125,25 +152,122 @@ namespace Flameberry {
 
 	void DescriptorSetLayout::ClearCache()
 	{
+		std::scoped_lock<std::mutex> lock(s_CacheMutex);
 		s_CachedDescriptorSetLayouts.clear();
 	}
 
-	DescriptorSet::DescriptorSet(const DescriptorSetSpecification& specification)
-		: m_Specification(specification)
+	DescriptorAllocator::DescriptorAllocator(uint32_t setsPerPool, VkDescriptorPoolCreateFlags flags)
+		: m_SetsPerPool(setsPerPool), m_Flags(flags)
 	{
-		auto layout = m_Specification.Layout->GetLayout();
+	}
 
-		if (!m_Specification.Pool)
-			m_Specification.Pool = VulkanContext::GetCurrentGlobalDescriptorPool();
+	Ref<DescriptorPool> DescriptorAllocator::Allocate(const Ref<DescriptorSetLayout>& layout, VkDescriptorSet* outDescriptorSet)
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
 
-		VkDescriptorSetAllocateInfo vk_descriptor_set_allocate_info{};
-		vk_descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		vk_descriptor_set_allocate_info.descriptorPool = m_Specification.Pool->GetVulkanDescriptorPool();
-		vk_descriptor_set_allocate_info.descriptorSetCount = 1;
-		vk_descriptor_set_allocate_info.pSetLayouts = &layout;
+		const auto& layoutSpec = layout->GetSpecification();
+		for (const auto& binding : layoutSpec.Bindings)
+		{
+			if (binding.descriptorType < DescriptorTypeCount)
+				m_DescriptorCounts[binding.descriptorType] += binding.descriptorCount;
+		}
+		m_AllocatedSetCount++;
+		m_SetsAllocatedSinceReset++;
+
+		// The sets freed from the earlier pools make space in them again, so all the pools are tried before chaining a new one
+		for (uint32_t i = 0; i < m_Pools.size(); i++)
+		{
+			const uint32_t poolIndex = (m_CurrentPoolIndex + i) % (uint32_t)m_Pools.size();
+			if (m_Pools[poolIndex]->AllocateDescriptorSet(outDescriptorSet, layout->GetLayout()))
+			{
+				m_CurrentPoolIndex = poolIndex;
+				return m_Pools[poolIndex];
+			}
+		}
+
+		CreatePool(layoutSpec);
+		m_CurrentPoolIndex = (uint32_t)m_Pools.size() - 1;
+
+		const bool allocated = m_Pools.back()->AllocateDescriptorSet(outDescriptorSet, layout->GetLayout());
+		FBY_ASSERT(allocated, "Failed to allocate a descriptor set from a newly created descriptor pool");
+		return m_Pools.back();
+	}
+
+	void DescriptorAllocator::Reset()
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+
+		if (m_Pools.size() > 1)
+		{
+			// Size the next pool to hold all the sets of the last use, so that it doesn't have to be chained again
+			m_SetsPerPool = std::min(std::max(m_SetsPerPool, m_SetsAllocatedSinceReset), MaxSetsPerPool);
+			m_Pools.clear();
+		}
+		else
+		{
+			for (auto& pool : m_Pools)
+				pool->Reset();
+		}
+
+		m_CurrentPoolIndex = 0;
+		m_SetsAllocatedSinceReset = 0;
+	}
+
+	uint32_t DescriptorAllocator::GetPoolCount() const
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		return (uint32_t)m_Pools.size();
+	}
+
+	uint64_t DescriptorAllocator::GetAllocatedSetCount() const
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		return m_AllocatedSetCount;
+	}
+
+	void DescriptorAllocator::CreatePool(const DescriptorSetLayoutSpecification& layoutSpec)
+	{
+		// The chained pools grow, as running out of the previous ones means that many more sets are used than expected
+		if (m_Pools.size())
+			m_SetsPerPool = std::min(m_SetsPerPool * 2, MaxSetsPerPool);
+
+		// The set which failed to be allocated must fit in the new pool
+		std::array<uint32_t, DescriptorTypeCount> descriptorCounts{};
+		for (const auto& binding : layoutSpec.Bindings)
+		{
+			if (binding.descriptorType < DescriptorTypeCount)
+				descriptorCounts[binding.descriptorType] += binding.descriptorCount;
+		}
+
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (uint32_t type = 0; type < DescriptorTypeCount; type++)
+		{
+			// The average count of the type per set, rounded up
+			const uint64_t expectedCount = (m_DescriptorCounts[type] * m_SetsPerPool + m_AllocatedSetCount - 1) / m_AllocatedSetCount;
+			const uint32_t count = std::max((uint32_t)expectedCount, descriptorCounts[type]);
+
+			if (count)
+				poolSizes.push_back({ (VkDescriptorType)type, count });
+		}
 
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &vk_descriptor_set_allocate_info, &m_DescriptorSet));
+		m_Pools.emplace_back(CreateRef<DescriptorPool>(device, poolSizes, m_SetsPerPool, m_Flags));
+
+		FBY_TRACE("Created descriptor pool {} with a capacity of {} sets", m_Pools.size() - 1, m_SetsPerPool);
+	}
+
+	DescriptorSet::DescriptorSet(const DescriptorSetSpecification& specification)
+		: m_Specification(specification)
+	{
+		if (!m_Specification.Pool)
+		{
+			// The set is freed to the pool of the allocator it was allocated from
+			m_Specification.Pool = VulkanContext::GetCurrentGlobalDescriptorAllocator()->Allocate(m_Specification.Layout, &m_DescriptorSet);
+			return;
+		}
+
+		const bool allocated = m_Specification.Pool->AllocateDescriptorSet(&m_DescriptorSet, m_Specification.Layout->GetLayout());
+		FBY_ASSERT(allocated, "The descriptor pool doesn't have enough space left for the descriptor set");
 	}
 
 	DescriptorSet::~DescriptorSet()
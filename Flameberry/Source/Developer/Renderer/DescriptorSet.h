@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 #include <vulkan/vulkan.h>
@@ -10,11 +12,14 @@ namespace Flameberry {
 	class DescriptorPool
 	{
 	public:
-		DescriptorPool(VkDevice device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxSets);
+		DescriptorPool(VkDevice device, const std::vector<VkDescriptorPoolSize>& poolSizes, uint32_t maxSets, VkDescriptorPoolCreateFlags flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
 		~DescriptorPool();
 
 		VkDescriptorPool GetVulkanDescriptorPool() { return m_VkDescriptorPool; }
+		// Returns false if the pool doesn't have enough space left for the set
 		bool AllocateDescriptorSet(VkDescriptorSet* descriptorSet, VkDescriptorSetLayout descriptorSetLayout);
+		// Frees all the descriptor sets allocated from the pool at once
+		void Reset();
 
 	private:
 		VkDescriptorPool m_VkDescriptorPool = VK_NULL_HANDLE;
@@ -23,6 +28,10 @@ namespace Flameberry {
 	struct DescriptorSetLayoutSpecification
 	{
 		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+
+		VkDescriptorSetLayoutCreateFlags Flags = 0;
+		// Either empty or one per binding, used for the descriptor indexing features like `VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT`
+		std::vector<VkDescriptorBindingFlags> BindingFlags;
 	};
 
 	class DescriptorSetLayout
@@ -42,10 +51,54 @@ namespace Flameberry {
 		VkDescriptorSetLayout m_Layout;
 
 		static std::unordered_map<DescriptorSetLayoutSpecification, Ref<DescriptorSetLayout>> s_CachedDescriptorSetLayouts;
+		// The layouts are created by the shaders which are loaded in parallel
+		static std::mutex s_CacheMutex;
+	};
+
+	// Allocates the descriptor sets from a chain of pools, a new pool is created whenever all the pools are full
+	// The sizes of the new pools follow the average descriptor counts of the sets allocated so far
+	class DescriptorAllocator
+	{
+	public:
+		// The pools can't free the individual sets if the flags don't include `VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT`, and are only reset
+		DescriptorAllocator(uint32_t setsPerPool, VkDescriptorPoolCreateFlags flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT);
+
+		// Returns the pool which the set is allocated from, the set is to be freed to the same pool
+		Ref<DescriptorPool> Allocate(const Ref<DescriptorSetLayout>& layout, VkDescriptorSet* outDescriptorSet);
+		// Frees all the sets allocated so far with one `vkResetDescriptorPool()` per pool
+		// The pools which had to be chained since the last reset are merged into a single larger pool
+		void Reset();
+
+		uint32_t GetPoolCount() const;
+		uint64_t GetAllocatedSetCount() const;
+
+	private:
+		void CreatePool(const DescriptorSetLayoutSpecification& layoutSpec);
+
+	private:
+		static constexpr uint32_t MaxSetsPerPool = 4096;
+		// Only the core descriptor types are tracked, i.e. up to `VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT`
+		static constexpr uint32_t DescriptorTypeCount = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT + 1;
+
+		uint32_t m_SetsPerPool;
+		VkDescriptorPoolCreateFlags m_Flags;
+
+		std::vector<Ref<DescriptorPool>> m_Pools;
+		// The pool which the last set was allocated from, which is tried first
+		uint32_t m_CurrentPoolIndex = 0;
+		uint32_t m_SetsAllocatedSinceReset = 0;
+
+		// The descriptor counts of all the sets allocated so far, indexed by the descriptor type
+		std::array<uint64_t, DescriptorTypeCount> m_DescriptorCounts{};
+		uint64_t m_AllocatedSetCount = 0;
+
+		// The descriptor sets are allocated by the shaders and the materials which are loaded in parallel
+		mutable std::mutex m_Mutex;
 	};
 
 	struct DescriptorSetSpecification
 	{
+		// The set is allocated from the global descriptor allocator if the pool is not specified
 		Ref<DescriptorPool> Pool;
 		Ref<DescriptorSetLayout> Layout;
 	};
@@ -0,0 +1,429 @@
+#include "DeviceMemoryAllocator.h"
+
+#include <algorithm>
+
+#include "VulkanDebug.h"
+
+namespace Flameberry {
+
+	// The blocks of the small heaps (like the host visible device local heap) are smaller, so that a few of them don't exhaust the heap
+	static constexpr VkDeviceSize s_PreferredBlockSize = 64 * 1024 * 1024;
+	static constexpr uint32_t s_MinBlockCountPerHeap = 8;
+
+	const char* MemoryCategoryToString(MemoryCategory category)
+	{
+		switch (category)
+		{
+			case MemoryCategory::Other: return "Other";
+			case MemoryCategory::Texture: return "Textures";
+			case MemoryCategory::Mesh: return "Meshes";
+			case MemoryCategory::RenderTarget: return "Render Targets";
+			case MemoryCategory::Uniform: return "Uniforms";
+			case MemoryCategory::Staging: return "Staging";
+			default: return "Unknown";
+		}
+	}
+
+	static MemoryCategory GetBufferMemoryCategory(VkBufferUsageFlags usage)
+	{
+		if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+			return MemoryCategory::Mesh;
+		if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+			return MemoryCategory::Uniform;
+		if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+			return MemoryCategory::Staging;
+		return MemoryCategory::Other;
+	}
+
+	static MemoryCategory GetImageMemoryCategory(VkImageUsageFlags usage)
+	{
+		if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+			return MemoryCategory::RenderTarget;
+		return MemoryCategory::Texture;
+	}
+
+	DeviceMemoryAllocator::DeviceMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, bool isMemoryBudgetSupported)
+		: m_PhysicalDevice(physicalDevice), m_Device(device), m_IsMemoryBudgetSupported(isMemoryBudgetSupported)
+	{
+		vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+		m_NonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+		m_MaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+		m_Pools.resize(2 * m_MemoryProperties.memoryTypeCount);
+		for (uint32_t i = 0; i < m_Pools.size(); i++)
+		{
+			const uint32_t memoryTypeIndex = i / 2;
+			const VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+
+			m_Pools[i].MemoryTypeIndex = memoryTypeIndex;
+			m_Pools[i].BlockSize = std::min(s_PreferredBlockSize, heapSize / s_MinBlockCountPerHeap);
+		}
+
+		m_HeapBudgets.resize(m_MemoryProperties.memoryHeapCount);
+		m_HeapAllocatedSizes.resize(m_MemoryProperties.memoryHeapCount, 0);
+		UpdateHeapBudgets();
+
+		FBY_INFO("Device memory allocator: {} memory types, {} heaps, maxMemoryAllocationCount: {}, VK_EXT_memory_budget: {}", m_MemoryProperties.memoryTypeCount, m_MemoryProperties.memoryHeapCount, m_MaxAllocationCount, m_IsMemoryBudgetSupported);
+	}
+
+	DeviceMemoryAllocator::~DeviceMemoryAllocator()
+	{
+		uint32_t leakedAllocationCount = 0;
+		for (auto& pool : m_Pools)
+		{
+			for (auto& block : pool.Blocks)
+			{
+				if (block.Memory == VK_NULL_HANDLE)
+					continue;
+
+				leakedAllocationCount += block.AllocationCount;
+				if (block.MappedMemory)
+					vkUnmapMemory(m_Device, block.Memory);
+				vkFreeMemory(m_Device, block.Memory, nullptr);
+			}
+		}
+
+		if (leakedAllocationCount)
+			FBY_WARN("Device memory allocator destroyed with {} allocations still alive in it's blocks", leakedAllocationCount);
+	}
+
+	MemoryAllocation DeviceMemoryAllocator::AllocateBufferMemory(VkBuffer buffer, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties)
+	{
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+
+		VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.buffer = buffer;
+
+		vkGetBufferMemoryRequirements2(m_Device, &requirementsInfo, &requirements);
+
+		const bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+		MemoryAllocation allocation = Allocate(requirements.memoryRequirements, memoryProperties, GetBufferMemoryCategory(usage), false, dedicated, buffer, VK_NULL_HANDLE);
+
+		VK_CHECK_RESULT(vkBindBufferMemory(m_Device, buffer, allocation.Memory, allocation.Offset));
+		return allocation;
+	}
+
+	MemoryAllocation DeviceMemoryAllocator::AllocateImageMemory(VkImage image, VkImageUsageFlags usage, VkImageTiling tiling, VkMemoryPropertyFlags memoryProperties)
+	{
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+
+		VkImageMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.image = image;
+
+		vkGetImageMemoryRequirements2(m_Device, &requirementsInfo, &requirements);
+
+		// The render targets are recreated whenever the viewport is resized, so they are kept out of the blocks
+		const MemoryCategory category = GetImageMemoryCategory(usage);
+		const bool dedicated = category == MemoryCategory::RenderTarget || dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+		MemoryAllocation allocation = Allocate(requirements.memoryRequirements, memoryProperties, category, tiling == VK_IMAGE_TILING_OPTIMAL, dedicated, VK_NULL_HANDLE, image);
+
+		VK_CHECK_RESULT(vkBindImageMemory(m_Device, image, allocation.Memory, allocation.Offset));
+		return allocation;
+	}
+
+	MemoryAllocation DeviceMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags memoryProperties, MemoryCategory category, bool isOptimalImage, bool dedicated, VkBuffer dedicatedBuffer, VkImage dedicatedImage)
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+
+		const uint32_t memoryTypeIndex = FindMemoryTypeIndex(requirements.memoryTypeBits, memoryProperties);
+		FBY_ASSERT(memoryTypeIndex != UINT32_MAX, "Failed to find valid memory type!");
+
+		auto& categoryStats = m_CategoryStats[(size_t)category];
+		categoryStats.AllocationCount++;
+
+		const uint32_t poolIndex = 2 * memoryTypeIndex + (isOptimalImage ? 1 : 0);
+		auto& pool = m_Pools[poolIndex];
+
+		// The allocations larger than half of a block would waste most of the rest of it
+		if (dedicated || requirements.size > pool.BlockSize / 2)
+		{
+			MemoryAllocation allocation = AllocateDedicated(memoryTypeIndex, requirements.size, category, dedicatedBuffer, dedicatedImage);
+			allocation.PoolIndex = poolIndex;
+			categoryStats.AllocatedSize += allocation.Size;
+			return allocation;
+		}
+
+		// Flushing the non coherent memory affects whole atoms, so the allocations shouldn't share them
+		VkDeviceSize alignment = requirements.alignment;
+		VkDeviceSize size = requirements.size;
+		if (!(m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) && (m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+		{
+			alignment = std::max(alignment, m_NonCoherentAtomSize);
+			size = (size + m_NonCoherentAtomSize - 1) & ~(m_NonCoherentAtomSize - 1);
+		}
+
+		uint32_t blockIndex = UINT32_MAX;
+		uint64_t offset = FreeListAllocator::InvalidOffset;
+		for (uint32_t i = 0; i < pool.Blocks.size() && offset == FreeListAllocator::InvalidOffset; i++)
+		{
+			if (pool.Blocks[i].Memory == VK_NULL_HANDLE)
+				continue;
+
+			offset = pool.Blocks[i].Allocator.Allocate(size, alignment);
+			blockIndex = i;
+		}
+
+		if (offset == FreeListAllocator::InvalidOffset)
+		{
+			blockIndex = CreateBlock(pool);
+			offset = pool.Blocks[blockIndex].Allocator.Allocate(size, alignment);
+			FBY_ASSERT(offset != FreeListAllocator::InvalidOffset, "Failed to suballocate {} bytes from a new memory block!", size);
+		}
+
+		auto& block = pool.Blocks[blockIndex];
+		block.AllocationCount++;
+		categoryStats.AllocatedSize += size;
+
+		MemoryAllocation allocation;
+		allocation.Memory = block.Memory;
+		allocation.Offset = offset;
+		allocation.Size = size;
+		allocation.MappedMemory = block.MappedMemory ? (char*)block.MappedMemory + offset : nullptr;
+		allocation.PoolIndex = poolIndex;
+		allocation.BlockIndex = blockIndex;
+		allocation.Category = category;
+		return allocation;
+	}
+
+	MemoryAllocation DeviceMemoryAllocator::AllocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, MemoryCategory category, VkBuffer buffer, VkImage image)
+	{
+		CheckBudget(memoryTypeIndex, size);
+
+		VkMemoryDedicatedAllocateInfo dedicatedAllocateInfo{};
+		dedicatedAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		dedicatedAllocateInfo.buffer = buffer;
+		dedicatedAllocateInfo.image = image;
+
+		VkMemoryAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.pNext = (buffer != VK_NULL_HANDLE || image != VK_NULL_HANDLE) ? &dedicatedAllocateInfo : nullptr;
+		allocateInfo.allocationSize = size;
+		allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+		MemoryAllocation allocation;
+		VK_CHECK_RESULT(vkAllocateMemory(m_Device, &allocateInfo, nullptr, &allocation.Memory));
+
+		m_DeviceMemoryCount++;
+		m_HeapAllocatedSizes[m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex] += size;
+
+		allocation.Size = size;
+		allocation.MappedMemory = MapMemoryIfHostVisible(allocation.Memory, memoryTypeIndex);
+		allocation.Category = category;
+		return allocation;
+	}
+
+	uint32_t DeviceMemoryAllocator::CreateBlock(MemoryPool& pool)
+	{
+		CheckBudget(pool.MemoryTypeIndex, pool.BlockSize);
+
+		VkMemoryAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = pool.BlockSize;
+		allocateInfo.memoryTypeIndex = pool.MemoryTypeIndex;
+
+		VkDeviceMemory memory;
+		VK_CHECK_RESULT(vkAllocateMemory(m_Device, &allocateInfo, nullptr, &memory));
+
+		m_DeviceMemoryCount++;
+		m_HeapAllocatedSizes[m_MemoryProperties.memoryTypes[pool.MemoryTypeIndex].heapIndex] += pool.BlockSize;
+
+		// Reuse the slot of a released block so that the indices of the other blocks stay the same
+		uint32_t blockIndex = 0;
+		while (blockIndex < pool.Blocks.size() && pool.Blocks[blockIndex].Memory != VK_NULL_HANDLE)
+			blockIndex++;
+
+		if (blockIndex == pool.Blocks.size())
+			pool.Blocks.emplace_back();
+
+		auto& block = pool.Blocks[blockIndex];
+		block.Memory = memory;
+		block.Allocator = FreeListAllocator(pool.BlockSize);
+		block.MappedMemory = MapMemoryIfHostVisible(memory, pool.MemoryTypeIndex);
+		block.AllocationCount = 0;
+
+		FBY_INFO("Created device memory block of {} MB for memory type {}, {} device memory objects are allocated", pool.BlockSize / (1024 * 1024), pool.MemoryTypeIndex, m_DeviceMemoryCount);
+		return blockIndex;
+	}
+
+	void* DeviceMemoryAllocator::MapMemoryIfHostVisible(VkDeviceMemory memory, uint32_t memoryTypeIndex)
+	{
+		// The host visible memory stays mapped as a `VkDeviceMemory` can't be mapped more than once at a time
+		if (!(m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+			return nullptr;
+
+		void* mappedMemory = nullptr;
+		VK_CHECK_RESULT(vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, &mappedMemory));
+		return mappedMemory;
+	}
+
+	void DeviceMemoryAllocator::Free(const MemoryAllocation& allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+
+		auto& categoryStats = m_CategoryStats[(size_t)allocation.Category];
+		categoryStats.AllocationCount--;
+		categoryStats.AllocatedSize -= allocation.Size;
+
+		auto& pool = m_Pools[allocation.PoolIndex];
+
+		if (allocation.IsDedicated())
+		{
+			if (allocation.MappedMemory)
+				vkUnmapMemory(m_Device, allocation.Memory);
+			vkFreeMemory(m_Device, allocation.Memory, nullptr);
+
+			m_DeviceMemoryCount--;
+			m_HeapAllocatedSizes[m_MemoryProperties.memoryTypes[pool.MemoryTypeIndex].heapIndex] -= allocation.Size;
+			return;
+		}
+
+		// The empty blocks are kept around, so that the resources which are created and destroyed frequently don't reallocate them
+		auto& block = pool.Blocks[allocation.BlockIndex];
+		block.Allocator.Free(allocation.Offset, allocation.Size);
+		block.AllocationCount--;
+	}
+
+	VkDeviceSize DeviceMemoryAllocator::ReleaseEmptyBlocks()
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+		return ReleaseEmptyBlocksUnlocked();
+	}
+
+	VkDeviceSize DeviceMemoryAllocator::ReleaseEmptyBlocksUnlocked()
+	{
+		VkDeviceSize releasedSize = 0;
+		for (auto& pool : m_Pools)
+		{
+			for (auto& block : pool.Blocks)
+			{
+				if (block.Memory == VK_NULL_HANDLE || block.AllocationCount)
+					continue;
+
+				if (block.MappedMemory)
+					vkUnmapMemory(m_Device, block.Memory);
+				vkFreeMemory(m_Device, block.Memory, nullptr);
+
+				block.Memory = VK_NULL_HANDLE;
+				block.MappedMemory = nullptr;
+
+				m_DeviceMemoryCount--;
+				m_HeapAllocatedSizes[m_MemoryProperties.memoryTypes[pool.MemoryTypeIndex].heapIndex] -= pool.BlockSize;
+				releasedSize += pool.BlockSize;
+			}
+		}
+		return releasedSize;
+	}
+
+	void DeviceMemoryAllocator::CheckBudget(uint32_t memoryTypeIndex, VkDeviceSize size)
+	{
+		if (m_DeviceMemoryCount + 1 > m_MaxAllocationCount)
+			FBY_WARN("Allocating more device memory objects ({}) than maxMemoryAllocationCount ({})", m_DeviceMemoryCount + 1, m_MaxAllocationCount);
+
+		const uint32_t heapIndex = m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+
+		UpdateHeapBudgets();
+		if (m_HeapBudgets[heapIndex].Usage + size <= m_HeapBudgets[heapIndex].Budget)
+			return;
+
+		const VkDeviceSize releasedSize = ReleaseEmptyBlocksUnlocked();
+		UpdateHeapBudgets();
+
+		if (m_HeapBudgets[heapIndex].Usage + size > m_HeapBudgets[heapIndex].Budget)
+			FBY_WARN("Allocating {} MB from memory heap {} exceeds it's budget (Usage: {} MB, Budget: {} MB), released {} MB of empty blocks", size / (1024 * 1024), heapIndex, m_HeapBudgets[heapIndex].Usage / (1024 * 1024), m_HeapBudgets[heapIndex].Budget / (1024 * 1024), releasedSize / (1024 * 1024));
+	}
+
+	void DeviceMemoryAllocator::UpdateHeapBudgets()
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		if (m_IsMemoryBudgetSupported)
+		{
+			VkPhysicalDeviceMemoryProperties2 memoryProperties2{};
+			memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			memoryProperties2.pNext = &budgetProperties;
+			vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &memoryProperties2);
+		}
+
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++)
+		{
+			auto& heapBudget = m_HeapBudgets[i];
+			heapBudget.Size = m_MemoryProperties.memoryHeaps[i].size;
+			heapBudget.IsDeviceLocal = m_MemoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+
+			if (m_IsMemoryBudgetSupported)
+			{
+				heapBudget.Usage = budgetProperties.heapUsage[i];
+				heapBudget.Budget = budgetProperties.heapBudget[i];
+			}
+			else
+			{
+				// Without the extension, leave some of the heap for the other processes, similar to what the drivers report
+				heapBudget.Usage = m_HeapAllocatedSizes[i];
+				heapBudget.Budget = heapBudget.Size * 8 / 10;
+			}
+		}
+	}
+
+	uint32_t DeviceMemoryAllocator::FindMemoryTypeIndex(uint32_t typeFilter, VkMemoryPropertyFlags memoryProperties) const
+	{
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			if ((typeFilter & (1 << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & memoryProperties) == memoryProperties)
+				return i;
+		}
+		return UINT32_MAX;
+	}
+
+	DeviceMemoryStats DeviceMemoryAllocator::GetStats()
+	{
+		std::scoped_lock<std::mutex> lock(m_Mutex);
+
+		DeviceMemoryStats stats;
+		stats.Categories = m_CategoryStats;
+
+		for (const auto& pool : m_Pools)
+		{
+			for (const auto& block : pool.Blocks)
+			{
+				if (block.Memory == VK_NULL_HANDLE)
+					continue;
+
+				stats.BlockCount++;
+				stats.EmptyBlockCount += block.AllocationCount == 0;
+				stats.BlockSize += block.Allocator.GetSize();
+				stats.UsedBlockSize += block.Allocator.GetUsedSize();
+				stats.FreeRangeCount += block.Allocator.GetFreeBlockCount();
+				stats.LargestFreeRangeSize = std::max(stats.LargestFreeRangeSize, block.Allocator.GetLargestFreeBlockSize());
+			}
+		}
+
+		stats.DedicatedAllocationCount = m_DeviceMemoryCount - stats.BlockCount;
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryHeapCount; i++)
+			stats.DedicatedSize += m_HeapAllocatedSizes[i];
+		stats.DedicatedSize -= stats.BlockSize;
+
+		UpdateHeapBudgets();
+		stats.Heaps = m_HeapBudgets;
+		return stats;
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Core/Core.h"
+#include "FreeListAllocator.h"
+
+namespace Flameberry {
+
+	// Used only for the statistics, deduced from the usage of the buffer or the image
+	enum class MemoryCategory : uint8_t
+	{
+		Other = 0,
+		Texture,
+		Mesh,
+		RenderTarget,
+		Uniform,
+		Staging,
+		Count
+	};
+
+	const char* MemoryCategoryToString(MemoryCategory category);
+
+	struct MemoryAllocation
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0, Size = 0;
+		// Points to `Offset` in the persistently mapped memory, null when the memory is not host visible
+		void* MappedMemory = nullptr;
+
+		uint32_t PoolIndex = UINT32_MAX;
+		// `UINT32_MAX` for the dedicated allocations, which own their `VkDeviceMemory`
+		uint32_t BlockIndex = UINT32_MAX;
+		MemoryCategory Category = MemoryCategory::Other;
+
+		bool IsValid() const { return Memory != VK_NULL_HANDLE; }
+		bool IsDedicated() const { return BlockIndex == UINT32_MAX; }
+	};
+
+	struct MemoryHeapBudget
+	{
+		VkDeviceSize Size = 0;
+		// Reported by `VK_EXT_memory_budget` when it is supported, otherwise estimated from the allocations of this allocator
+		VkDeviceSize Usage = 0, Budget = 0;
+		bool IsDeviceLocal = false;
+	};
+
+	struct DeviceMemoryStats
+	{
+		struct CategoryStats
+		{
+			uint32_t AllocationCount = 0;
+			VkDeviceSize AllocatedSize = 0;
+		};
+
+		std::array<CategoryStats, (size_t)MemoryCategory::Count> Categories;
+
+		uint32_t BlockCount = 0, EmptyBlockCount = 0, DedicatedAllocationCount = 0;
+		// The total size of the blocks and the size suballocated from them
+		VkDeviceSize BlockSize = 0, UsedBlockSize = 0, DedicatedSize = 0;
+		// The number of free ranges in the blocks, a large number of small ranges indicates fragmentation
+		uint32_t FreeRangeCount = 0;
+		VkDeviceSize LargestFreeRangeSize = 0;
+
+		std::vector<MemoryHeapBudget> Heaps;
+	};
+
+	// Suballocates the memory of the buffers and the images from large `VkDeviceMemory` blocks
+	// There is a pool of blocks per memory type, the linear resources and the optimal images are kept in separate pools to respect `bufferImageGranularity`
+	// The render targets and the resources preferring it get a dedicated allocation, so that they don't fragment the blocks when the viewport is resized
+	class DeviceMemoryAllocator
+	{
+	public:
+		DeviceMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, bool isMemoryBudgetSupported);
+		~DeviceMemoryAllocator();
+
+		// Allocates and binds the memory of the resource
+		MemoryAllocation AllocateBufferMemory(VkBuffer buffer, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties);
+		MemoryAllocation AllocateImageMemory(VkImage image, VkImageUsageFlags usage, VkImageTiling tiling, VkMemoryPropertyFlags memoryProperties);
+		// The resource should be destroyed before it's memory is freed
+		void Free(const MemoryAllocation& allocation);
+
+		// Defragmentation hook, the allocations are never moved as the resources can't be rebound, but the blocks which became empty are released
+		// Called automatically when a new block would exceed the budget of it's heap, returns the number of bytes released
+		VkDeviceSize ReleaseEmptyBlocks();
+
+		DeviceMemoryStats GetStats();
+		// Flushing needs the offsets and the sizes of non coherent memory to be aligned to it
+		VkDeviceSize GetNonCoherentAtomSize() const { return m_NonCoherentAtomSize; }
+
+	private:
+		struct MemoryBlock
+		{
+			// `VK_NULL_HANDLE` when the block is released, it's slot is reused by the next block of the pool
+			VkDeviceMemory Memory = VK_NULL_HANDLE;
+			FreeListAllocator Allocator;
+			void* MappedMemory = nullptr;
+			uint32_t AllocationCount = 0;
+		};
+
+		struct MemoryPool
+		{
+			uint32_t MemoryTypeIndex;
+			VkDeviceSize BlockSize;
+			std::vector<MemoryBlock> Blocks;
+		};
+
+		MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags memoryProperties, MemoryCategory category, bool isOptimalImage, bool dedicated, VkBuffer dedicatedBuffer, VkImage dedicatedImage);
+		MemoryAllocation AllocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, MemoryCategory category, VkBuffer buffer, VkImage image);
+		uint32_t CreateBlock(MemoryPool& pool);
+		void* MapMemoryIfHostVisible(VkDeviceMemory memory, uint32_t memoryTypeIndex);
+		// Expects `m_Mutex` to be locked by the caller
+		VkDeviceSize ReleaseEmptyBlocksUnlocked();
+
+		uint32_t FindMemoryTypeIndex(uint32_t typeFilter, VkMemoryPropertyFlags memoryProperties) const;
+		// Warns about the heaps which are over budget and releases the empty blocks when the new allocation won't fit in the budget
+		void CheckBudget(uint32_t memoryTypeIndex, VkDeviceSize size);
+		void UpdateHeapBudgets();
+
+	private:
+		VkPhysicalDevice m_PhysicalDevice;
+		VkDevice m_Device;
+		bool m_IsMemoryBudgetSupported;
+
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+		VkDeviceSize m_NonCoherentAtomSize;
+		uint32_t m_MaxAllocationCount, m_DeviceMemoryCount = 0;
+
+		// Index `2 * memoryTypeIndex` for the linear resources and `2 * memoryTypeIndex + 1` for the optimal images
+		std::vector<MemoryPool> m_Pools;
+		std::vector<MemoryHeapBudget> m_HeapBudgets;
+		// The memory allocated from each heap by this allocator, blocks and dedicated allocations included
+		std::vector<VkDeviceSize> m_HeapAllocatedSizes;
+		std::array<DeviceMemoryStats::CategoryStats, (size_t)MemoryCategory::Count> m_CategoryStats;
+
+		// The resources are created and destroyed by both the main and the render thread
+		std::mutex m_Mutex;
+	};
+
+} // namespace Flameberry
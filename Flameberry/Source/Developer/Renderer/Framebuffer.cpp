@@ -71,6 +71,10 @@ namespace Flameberry {
 			{
 				imageSpec.ViewSpecification.AspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
 				imageSpec.Usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+				// The contents of a loaded depth attachment are usually provided by transfer commands
+				if (m_FramebufferSpec.DepthLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+					imageSpec.Usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 				m_DepthAttachmentIndex = m_FramebufferImages.size();
 			}
 			else
@@ -0,0 +1,84 @@
+#include "FreeListAllocator.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "Core/Core.h"
+
+namespace Flameberry {
+
+	FreeListAllocator::FreeListAllocator(uint64_t size)
+		: m_Size(size)
+	{
+		if (size)
+			m_FreeBlocks.emplace(0, size);
+	}
+
+	uint64_t FreeListAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		FBY_ASSERT(size && alignment, "FreeListAllocator: Size and alignment of an allocation must not be 0!");
+
+		for (auto it = m_FreeBlocks.begin(); it != m_FreeBlocks.end(); ++it)
+		{
+			const auto [blockOffset, blockSize] = *it;
+			const uint64_t offset = (blockOffset + alignment - 1) / alignment * alignment;
+			const uint64_t padding = offset - blockOffset;
+
+			if (padding + size > blockSize)
+				continue;
+
+			m_FreeBlocks.erase(it);
+
+			// The padding in front of the allocation and the remaining part of the block stay free
+			if (padding)
+				m_FreeBlocks.emplace(blockOffset, padding);
+			if (padding + size < blockSize)
+				m_FreeBlocks.emplace(offset + size, blockSize - padding - size);
+
+			m_UsedSize += size;
+			return offset;
+		}
+		return InvalidOffset;
+	}
+
+	void FreeListAllocator::Free(uint64_t offset, uint64_t size)
+	{
+		FBY_ASSERT(size && offset + size <= m_Size, "FreeListAllocator: Freed range is out of bounds!");
+
+		m_UsedSize -= size;
+
+		auto next = m_FreeBlocks.lower_bound(offset);
+		FBY_ASSERT(next == m_FreeBlocks.end() || offset + size <= next->first, "FreeListAllocator: Range is already free!");
+
+		// Merge with the next free block if it starts where the freed range ends
+		if (next != m_FreeBlocks.end() && next->first == offset + size)
+		{
+			size += next->second;
+			next = m_FreeBlocks.erase(next);
+		}
+
+		// Merge with the previous free block if it ends where the freed range starts
+		if (next != m_FreeBlocks.begin())
+		{
+			auto prev = std::prev(next);
+			FBY_ASSERT(prev->first + prev->second <= offset, "FreeListAllocator: Range is already free!");
+
+			if (prev->first + prev->second == offset)
+			{
+				prev->second += size;
+				return;
+			}
+		}
+
+		m_FreeBlocks.emplace_hint(next, offset, size);
+	}
+
+	uint64_t FreeListAllocator::GetLargestFreeBlockSize() const
+	{
+		uint64_t largest = 0;
+		for (const auto& [offset, size] : m_FreeBlocks)
+			largest = std::max(largest, size);
+		return largest;
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <map>
+#include <cstdint>
+
+namespace Flameberry {
+
+	// Suballocates ranges of a fixed size region, the free blocks are kept sorted by their offset and are merged with their neighbours when freed
+	// The offsets and the sizes are in arbitrary units (bytes, vertices, indices, etc.), nothing is stored in the region itself
+	class FreeListAllocator
+	{
+	public:
+		static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+	public:
+		explicit FreeListAllocator(uint64_t size = 0);
+
+		// Returns the offset of the first free range large enough for the aligned allocation or `InvalidOffset` when there isn't any
+		uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+		// The size should be the same as the one the range was allocated with
+		void Free(uint64_t offset, uint64_t size);
+
+		uint64_t GetSize() const { return m_Size; }
+		uint64_t GetUsedSize() const { return m_UsedSize; }
+		uint32_t GetFreeBlockCount() const { return (uint32_t)m_FreeBlocks.size(); }
+		uint64_t GetLargestFreeBlockSize() const;
+
+	private:
+		uint64_t m_Size = 0, m_UsedSize = 0;
+		// Offset -> Size
+		std::map<uint64_t, uint64_t> m_FreeBlocks;
+	};
+
+} // namespace Flameberry
@@ -1,5 +1,13 @@
 #include "Frustum.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FBY_FRUSTUM_CULLING_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#define FBY_FRUSTUM_CULLING_NEON
+#include <arm_neon.h>
+#endif
+
 namespace Flameberry {
 
 	void Frustum::ExtractFrustumPlanes(const glm::mat4& viewProjectionMatrix)
@@ -80,4 +88,130 @@ namespace Flameberry {
 		return true;
 	}
 
+	void AABBSoA::Add(const glm::vec3& center, const glm::vec3& extent)
+	{
+		CenterX.push_back(center.x);
+		CenterY.push_back(center.y);
+		CenterZ.push_back(center.z);
+		ExtentX.push_back(extent.x);
+		ExtentY.push_back(extent.y);
+		ExtentZ.push_back(extent.z);
+	}
+
+	void AABBSoA::Reserve(uint32_t count)
+	{
+		for (auto* array : { &CenterX, &CenterY, &CenterZ, &ExtentX, &ExtentY, &ExtentZ })
+			array->reserve(count);
+	}
+
+	void AABBSoA::Clear()
+	{
+		for (auto* array : { &CenterX, &CenterY, &CenterZ, &ExtentX, &ExtentY, &ExtentZ })
+			array->clear();
+	}
+
+	void TransformAABB(const AABB& aabb, const glm::mat4& transform, glm::vec3& outCenter, glm::vec3& outExtent)
+	{
+		const glm::vec3 center = 0.5f * (aabb.Min + aabb.Max);
+		const glm::vec3 extent = 0.5f * (aabb.Max - aabb.Min);
+
+		// The extent of the enclosing box is the extent projected onto the absolute values of the rotation and scale part of the transform
+		const glm::mat3 absoluteTransform(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])));
+
+		outCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+		outExtent = absoluteTransform * extent;
+	}
+
+	uint32_t CullAABBs(const AABBSoA& boxes, const Frustum& frustum, std::vector<uint64_t>& outVisibilityMask)
+	{
+		const uint32_t count = boxes.GetCount();
+		outVisibilityMask.assign((count + 63) / 64, 0);
+
+		// A box is outside a plane when the distance of it's center from the plane is smaller than the projected extent
+		// i.e. dot(n, c) + w + dot(|n|, e) <= 0, which matches the corner test of `IsAABBInsideFrustum()`
+		std::array<glm::vec3, 6> absoluteNormals;
+		for (uint32_t p = 0; p < 6; p++)
+			absoluteNormals[p] = glm::abs(glm::vec3(frustum.Planes[p]));
+
+		uint32_t visibleCount = 0;
+		uint32_t i = 0;
+
+#if defined(FBY_FRUSTUM_CULLING_SSE) || defined(FBY_FRUSTUM_CULLING_NEON)
+		for (; i + 4 <= count; i += 4)
+		{
+			uint32_t outsideBits = 0;
+
+#ifdef FBY_FRUSTUM_CULLING_SSE
+			const __m128 cx = _mm_loadu_ps(&boxes.CenterX[i]), cy = _mm_loadu_ps(&boxes.CenterY[i]), cz = _mm_loadu_ps(&boxes.CenterZ[i]);
+			const __m128 ex = _mm_loadu_ps(&boxes.ExtentX[i]), ey = _mm_loadu_ps(&boxes.ExtentY[i]), ez = _mm_loadu_ps(&boxes.ExtentZ[i]);
+
+			for (uint32_t p = 0; p < 6; p++)
+			{
+				const auto& plane = frustum.Planes[p];
+				const auto& absoluteNormal = absoluteNormals[p];
+
+				__m128 distance = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+				distance = _mm_add_ps(distance, _mm_mul_ps(cy, _mm_set1_ps(plane.y)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(plane.z)));
+
+				__m128 radius = _mm_mul_ps(ex, _mm_set1_ps(absoluteNormal.x));
+				radius = _mm_add_ps(radius, _mm_mul_ps(ey, _mm_set1_ps(absoluteNormal.y)));
+				radius = _mm_add_ps(radius, _mm_mul_ps(ez, _mm_set1_ps(absoluteNormal.z)));
+
+				outsideBits |= (uint32_t)_mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+#else
+			const float32x4_t cx = vld1q_f32(&boxes.CenterX[i]), cy = vld1q_f32(&boxes.CenterY[i]), cz = vld1q_f32(&boxes.CenterZ[i]);
+			const float32x4_t ex = vld1q_f32(&boxes.ExtentX[i]), ey = vld1q_f32(&boxes.ExtentY[i]), ez = vld1q_f32(&boxes.ExtentZ[i]);
+
+			static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+			const uint32x4_t laneBitMask = vld1q_u32(laneBits);
+
+			for (uint32_t p = 0; p < 6; p++)
+			{
+				const auto& plane = frustum.Planes[p];
+				const auto& absoluteNormal = absoluteNormals[p];
+
+				float32x4_t distance = vmlaq_n_f32(vdupq_n_f32(plane.w), cx, plane.x);
+				distance = vmlaq_n_f32(distance, cy, plane.y);
+				distance = vmlaq_n_f32(distance, cz, plane.z);
+
+				float32x4_t radius = vmulq_n_f32(ex, absoluteNormal.x);
+				radius = vmlaq_n_f32(radius, ey, absoluteNormal.y);
+				radius = vmlaq_n_f32(radius, ez, absoluteNormal.z);
+
+				const uint32x4_t outside = vcleq_f32(vaddq_f32(distance, radius), vdupq_n_f32(0.0f));
+				outsideBits |= vaddvq_u32(vandq_u32(outside, laneBitMask));
+			}
+#endif
+
+			// `i` is a multiple of 4, so the 4 bits never straddle two words of the mask
+			const uint64_t visibleBits = ~outsideBits & 0xF;
+			outVisibilityMask[i / 64] |= visibleBits << (i % 64);
+			visibleCount += (uint32_t)((visibleBits & 1) + ((visibleBits >> 1) & 1) + ((visibleBits >> 2) & 1) + ((visibleBits >> 3) & 1));
+		}
+#endif
+
+		// Scalar path for the remaining boxes
+		for (; i < count; i++)
+		{
+			bool isVisible = true;
+			for (uint32_t p = 0; p < 6 && isVisible; p++)
+			{
+				const auto& plane = frustum.Planes[p];
+				const float distance = plane.x * boxes.CenterX[i] + plane.y * boxes.CenterY[i] + plane.z * boxes.CenterZ[i] + plane.w;
+				const float radius = absoluteNormals[p].x * boxes.ExtentX[i] + absoluteNormals[p].y * boxes.ExtentY[i] + absoluteNormals[p].z * boxes.ExtentZ[i];
+				isVisible = distance + radius > 0.0f;
+			}
+
+			if (isVisible)
+			{
+				outVisibilityMask[i / 64] |= 1ull << (i % 64);
+				visibleCount++;
+			}
+		}
+
+		return visibleCount;
+	}
+
 } // namespace Flameberry
\ No newline at end of file
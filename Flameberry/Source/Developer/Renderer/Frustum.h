@@ -1,6 +1,8 @@
 #pragma once
 
 #include <array>
+#include <vector>
+#include <cstdint>
 
 #include "AABB.h"
 
@@ -15,4 +17,24 @@ namespace Flameberry {
 
 	bool IsAABBInsideFrustum(const AABB& aabb, const glm::mat4& transform, const Frustum& frustum);
 
+	// World space AABBs in center/extent form stored as a structure of arrays, so that multiple boxes can be culled at once using SIMD
+	struct AABBSoA
+	{
+		std::vector<float> CenterX, CenterY, CenterZ;
+		std::vector<float> ExtentX, ExtentY, ExtentZ;
+
+		void Add(const glm::vec3& center, const glm::vec3& extent);
+		void Reserve(uint32_t count);
+		void Clear();
+
+		uint32_t GetCount() const { return (uint32_t)CenterX.size(); }
+	};
+
+	// Calculates the center and the extent of the world space AABB enclosing the transformed local space AABB
+	void TransformAABB(const AABB& aabb, const glm::mat4& transform, glm::vec3& outCenter, glm::vec3& outExtent);
+
+	// Tests 4 boxes per iteration against the frustum (using SSE or NEON when available)
+	// Writes the visibility of box `i` to the bit `i % 64` of `outVisibilityMask[i / 64]` and returns the number of visible boxes
+	uint32_t CullAABBs(const AABBSoA& boxes, const Frustum& frustum, std::vector<uint64_t>& outVisibilityMask);
+
 } // namespace Flameberry
\ No newline at end of file
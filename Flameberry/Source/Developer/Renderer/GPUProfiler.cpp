@@ -0,0 +1,188 @@
+#include "GPUProfiler.h"
+
+#include <imgui/imgui.h>
+
+#include "Core/Core.h"
+#include "Renderer.h"
+#include "VulkanContext.h"
+#include "VulkanDebug.h"
+
+namespace Flameberry {
+
+	std::array<GPUProfiler::FrameQueries, SwapChain::MAX_FRAMES_IN_FLIGHT> GPUProfiler::s_FrameQueries;
+	uint32_t GPUProfiler::s_FrameIndex = 0;
+	uint64_t GPUProfiler::s_FrameNumber = UINT64_MAX, GPUProfiler::s_ResultsFrameNumber = UINT64_MAX;
+	std::vector<uint32_t> GPUProfiler::s_ScopeStack;
+
+	std::vector<GPUScopeResult> GPUProfiler::s_Results;
+	std::vector<uint64_t> GPUProfiler::s_Timestamps;
+	double GPUProfiler::s_TimestampPeriod = 1.0;
+	uint64_t GPUProfiler::s_TimestampMask = ~0ull;
+	bool GPUProfiler::s_IsEnabled = false;
+
+	void GPUProfiler::Init()
+	{
+		const auto& vulkanDevice = VulkanContext::GetCurrentDevice();
+		const auto device = vulkanDevice->GetVulkanDevice();
+
+		// The timestamps are written by the command buffers of the graphics queue
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(VulkanContext::GetPhysicalDevice(), &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(VulkanContext::GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+		const uint32_t timestampValidBits = queueFamilies[vulkanDevice->GetQueueFamilyIndices().GraphicsQueueFamilyIndex].timestampValidBits;
+		s_IsEnabled = timestampValidBits != 0;
+		if (!s_IsEnabled)
+		{
+			FBY_WARN("The graphics queue doesn't support timestamps, the GPU profiler is disabled");
+			return;
+		}
+
+		s_TimestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+
+		VkQueryPoolCreateInfo queryPoolCreateInfo{};
+		queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolCreateInfo.queryCount = 2 * MaxScopeCount;
+
+		for (auto& frameQueries : s_FrameQueries)
+		{
+			VK_CHECK_RESULT(vkCreateQueryPool(device, &queryPoolCreateInfo, nullptr, &frameQueries.QueryPool));
+			frameQueries.Scopes.reserve(MaxScopeCount);
+		}
+
+		s_Timestamps.resize(2 * 2 * MaxScopeCount);
+		// The number of nanoseconds it takes for a timestamp to be incremented by 1
+		s_TimestampPeriod = VulkanContext::GetPhysicalDeviceProperties().limits.timestampPeriod;
+	}
+
+	void GPUProfiler::Shutdown()
+	{
+		const auto device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+		for (auto& frameQueries : s_FrameQueries)
+		{
+			vkDestroyQueryPool(device, frameQueries.QueryPool, nullptr);
+			frameQueries = FrameQueries{};
+		}
+
+		s_ScopeStack.clear();
+		s_Results.clear();
+		s_ResultsFrameNumber = UINT64_MAX;
+		s_IsEnabled = false;
+	}
+
+	void GPUProfiler::BeginFrame(uint32_t frameIndex)
+	{
+		if (!s_IsEnabled)
+			return;
+
+		s_FrameIndex = frameIndex;
+		auto& frameQueries = s_FrameQueries[s_FrameIndex];
+
+		// Only the queries of a recorded frame are reset and written, the render thread finished recording it before the last frame was handed over
+		if (frameQueries.IsRecorded && frameQueries.Scopes.size())
+		{
+			// The GPU is done with the frame by now, the availability of every query is still checked along with it's timestamp
+			const uint32_t queryCount = 2 * (uint32_t)frameQueries.Scopes.size();
+			const VkResult result = vkGetQueryPoolResults(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), frameQueries.QueryPool, 0, queryCount, 2 * queryCount * sizeof(uint64_t), s_Timestamps.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+			// The scope of the whole frame ends last, if it's available then so are all the scopes, otherwise the older results are kept
+			if ((result == VK_SUCCESS || result == VK_NOT_READY) && s_Timestamps[1] && s_Timestamps[3])
+			{
+				s_ResultsFrameNumber = frameQueries.FrameNumber;
+				s_Results.clear();
+				for (uint32_t i = 0; i < (uint32_t)frameQueries.Scopes.size(); i++)
+				{
+					const uint64_t* beginQuery = &s_Timestamps[4 * i];
+					const uint64_t* endQuery = &s_Timestamps[4 * i + 2];
+					if (!beginQuery[1] || !endQuery[1])
+						continue;
+
+					// The timestamps wrap around at the valid bits, the masked difference is correct as long as it wraps at most once
+					auto& scope = s_Results.emplace_back(frameQueries.Scopes[i]);
+					scope.Time = (double)((endQuery[0] - beginQuery[0]) & s_TimestampMask) * s_TimestampPeriod * 1e-6;
+				}
+			}
+		}
+
+		frameQueries.Scopes.clear();
+		frameQueries.FrameNumber = ++s_FrameNumber;
+		frameQueries.IsRecorded = false;
+		s_ScopeStack.clear();
+
+		// The reset is recorded as the frame begins, so that it's outside of any render pass
+		Renderer::Submit([&frameQueries](VkCommandBuffer cmdBuffer, uint32_t)
+			{
+				vkCmdResetQueryPool(cmdBuffer, frameQueries.QueryPool, 0, 2 * MaxScopeCount);
+				frameQueries.IsRecorded = true;
+			});
+
+		BeginScope("Frame");
+	}
+
+	void GPUProfiler::EndFrame()
+	{
+		if (!s_IsEnabled)
+			return;
+
+		EndScope();
+		FBY_ASSERT(s_ScopeStack.empty(), "GPUProfiler::EndScope() was not called for {} scopes", s_ScopeStack.size());
+	}
+
+	void GPUProfiler::BeginScope(const char* name)
+	{
+		if (!s_IsEnabled)
+			return;
+
+		auto& frameQueries = s_FrameQueries[s_FrameIndex];
+
+		// The scopes exceeding the capacity of the query pool are not measured
+		if (frameQueries.Scopes.size() == MaxScopeCount)
+		{
+			s_ScopeStack.push_back(UINT32_MAX);
+			return;
+		}
+
+		const uint32_t scopeIndex = (uint32_t)frameQueries.Scopes.size();
+		frameQueries.Scopes.push_back(GPUScopeResult{ name, (uint32_t)s_ScopeStack.size(), 0.0 });
+		s_ScopeStack.push_back(scopeIndex);
+
+		Renderer::Submit([queryPool = frameQueries.QueryPool, scopeIndex](VkCommandBuffer cmdBuffer, uint32_t)
+			{
+				vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 2 * scopeIndex);
+			});
+	}
+
+	void GPUProfiler::EndScope()
+	{
+		if (!s_IsEnabled)
+			return;
+
+		FBY_ASSERT(s_ScopeStack.size(), "GPUProfiler::EndScope() called without beginning a scope!");
+
+		const uint32_t scopeIndex = s_ScopeStack.back();
+		s_ScopeStack.pop_back();
+
+		if (scopeIndex == UINT32_MAX)
+			return;
+
+		Renderer::Submit([queryPool = s_FrameQueries[s_FrameIndex].QueryPool, scopeIndex](VkCommandBuffer cmdBuffer, uint32_t)
+			{
+				vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 2 * scopeIndex + 1);
+			});
+	}
+
+	void GPUProfiler::DisplayScopeDetailsImGui()
+	{
+		if (!s_IsEnabled)
+		{
+			ImGui::TextUnformatted("GPU timestamps are not supported");
+			return;
+		}
+
+		for (const auto& scope : s_Results)
+			ImGui::Text("%*sGPU %s: %.4f ms", 2 * scope.Depth, "", scope.Name, scope.Time);
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "SwapChain.h"
+
+namespace Flameberry {
+
+	struct GPUScopeResult
+	{
+		const char* Name;
+		// The number of scopes enclosing this scope
+		uint32_t Depth;
+		double Time; // in milliseconds
+	};
+
+	// Measures the GPU time of the scopes of a frame using timestamp queries, every frame in flight has a query pool of it's own
+	// The results of a frame are read back when it's query pool is reused, after the in flight fence of the frame index has been waited
+	// The scopes are begun and ended by the main thread while recording the frame, as commands that write the timestamps into the command buffer they are submitted to
+	// A scope has to be begun and ended within the same command list, and outside of the multiview render passes
+	// The profiler is disabled when the graphics queue doesn't support timestamps
+	class GPUProfiler
+	{
+	public:
+		static constexpr uint32_t MaxScopeCount = 64;
+
+	public:
+		static void Init();
+		static void Shutdown();
+
+		// Reads back the results of the last frame recorded with the given index and begins the scope of the whole frame
+		// To be called by the main thread once the GPU is done with the last frame having the given index
+		static void BeginFrame(uint32_t frameIndex);
+		// Ends the scope of the whole frame, to be called once the main thread finishes recording the frame
+		static void EndFrame();
+
+		// The name is expected to be a string literal as it is stored until the results are read back
+		static void BeginScope(const char* name);
+		static void EndScope();
+
+		// The results of the last frame whose results were available, the first scope is the whole frame
+		static const std::vector<GPUScopeResult>& GetResults() { return s_Results; }
+		// The number of the frame the results were measured in, compared with `GetFrameNumber()` of that frame to tell the results apart
+		static uint64_t GetResultsFrameNumber() { return s_ResultsFrameNumber; }
+		// The number of the frame being recorded, every begun frame gets a new one including the dropped ones
+		static uint64_t GetFrameNumber() { return s_FrameNumber; }
+		static void DisplayScopeDetailsImGui();
+
+	private:
+		struct FrameQueries
+		{
+			VkQueryPool QueryPool = VK_NULL_HANDLE;
+			// The scopes recorded into the query pool, the scope `i` writes the queries `2 * i` and `2 * i + 1`
+			std::vector<GPUScopeResult> Scopes;
+			uint64_t FrameNumber = UINT64_MAX;
+			// Set by the render thread once it records the frame, the queries of a dropped frame are neither reset nor written
+			bool IsRecorded = false;
+		};
+
+	private:
+		static std::array<FrameQueries, SwapChain::MAX_FRAMES_IN_FLIGHT> s_FrameQueries;
+		static uint32_t s_FrameIndex;
+		static uint64_t s_FrameNumber, s_ResultsFrameNumber;
+		// The indices of the scopes which are begun but not ended yet
+		static std::vector<uint32_t> s_ScopeStack;
+
+		static std::vector<GPUScopeResult> s_Results;
+		// The timestamp of every query followed by it's availability
+		static std::vector<uint64_t> s_Timestamps;
+		static double s_TimestampPeriod;
+		// Only the lower `timestampValidBits` bits of the timestamps are valid
+		static uint64_t s_TimestampMask;
+		static bool s_IsEnabled;
+	};
+
+} // namespace Flameberry
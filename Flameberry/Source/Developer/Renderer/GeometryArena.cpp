@@ -0,0 +1,142 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+
+#include "Core/Core.h"
+
+namespace Flameberry {
+
+	std::vector<GeometryArena::GeometryBlock> GeometryArena::s_Blocks;
+	std::vector<GeometryAllocation> GeometryArena::s_FreedAllocations[SwapChain::MAX_FRAMES_IN_FLIGHT];
+	uint32_t GeometryArena::s_FrameIndex = 0;
+	std::mutex GeometryArena::s_Mutex;
+
+	void GeometryArena::Shutdown()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		// The meshes destroyed after this don't have any block to return their ranges to
+		s_Blocks.clear();
+		for (auto& freedAllocations : s_FreedAllocations)
+			freedAllocations.clear();
+	}
+
+	GeometryAllocation GeometryArena::Allocate(const MeshVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+	{
+		FBY_ASSERT(vertexCount && indexCount, "GeometryArena: Cannot allocate empty geometry!");
+
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		GeometryAllocation allocation;
+		allocation.VertexCount = vertexCount;
+		allocation.IndexCount = indexCount;
+
+		for (uint32_t i = 0; i < (uint32_t)s_Blocks.size() && !allocation.IsValid(); i++)
+		{
+			auto& block = s_Blocks[i];
+
+			const uint64_t vertexOffset = block.VertexAllocator.Allocate(vertexCount);
+			if (vertexOffset == FreeListAllocator::InvalidOffset)
+				continue;
+
+			const uint64_t firstIndex = block.IndexAllocator.Allocate(indexCount);
+			if (firstIndex == FreeListAllocator::InvalidOffset)
+			{
+				block.VertexAllocator.Free(vertexOffset, vertexCount);
+				continue;
+			}
+
+			allocation.BlockIndex = i;
+			allocation.VertexOffset = (uint32_t)vertexOffset;
+			allocation.FirstIndex = (uint32_t)firstIndex;
+		}
+
+		if (!allocation.IsValid())
+		{
+			CreateBlock(std::max(vertexCount, BlockVertexCapacity), std::max(indexCount, BlockIndexCapacity));
+
+			auto& block = s_Blocks.back();
+			allocation.BlockIndex = (uint32_t)s_Blocks.size() - 1;
+			allocation.VertexOffset = (uint32_t)block.VertexAllocator.Allocate(vertexCount);
+			allocation.FirstIndex = (uint32_t)block.IndexAllocator.Allocate(indexCount);
+		}
+
+		auto& block = s_Blocks[allocation.BlockIndex];
+		block.AllocationCount++;
+
+		// Upload the geometry into it's ranges, the batches complete in order so the token of the index upload covers both
+		UploadManager::UploadToBuffer(block.VertexBuffer->GetVulkanBuffer(), sizeof(MeshVertex) * allocation.VertexOffset, vertices, sizeof(MeshVertex) * vertexCount);
+		allocation.Upload = UploadManager::UploadToBuffer(block.IndexBuffer->GetVulkanBuffer(), sizeof(uint32_t) * allocation.FirstIndex, indices, sizeof(uint32_t) * indexCount);
+
+		return allocation;
+	}
+
+	void GeometryArena::Free(const GeometryAllocation& allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+		if (allocation.BlockIndex < s_Blocks.size())
+			s_FreedAllocations[s_FrameIndex].emplace_back(allocation);
+	}
+
+	void GeometryArena::ReleaseFreedRanges()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		// The oldest frame's ranges are no longer used by any frame in flight
+		s_FrameIndex = (s_FrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+
+		for (const auto& allocation : s_FreedAllocations[s_FrameIndex])
+		{
+			auto& block = s_Blocks[allocation.BlockIndex];
+			block.VertexAllocator.Free(allocation.VertexOffset, allocation.VertexCount);
+			block.IndexAllocator.Free(allocation.FirstIndex, allocation.IndexCount);
+			block.AllocationCount--;
+		}
+		s_FreedAllocations[s_FrameIndex].clear();
+	}
+
+	GeometryArenaStats GeometryArena::GetStats()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		GeometryArenaStats stats;
+		stats.BlockCount = (uint32_t)s_Blocks.size();
+		for (const auto& block : s_Blocks)
+		{
+			stats.AllocationCount += block.AllocationCount;
+			stats.VertexCapacity += block.VertexAllocator.GetSize();
+			stats.UsedVertexCount += block.VertexAllocator.GetUsedSize();
+			stats.IndexCapacity += block.IndexAllocator.GetSize();
+			stats.UsedIndexCount += block.IndexAllocator.GetUsedSize();
+		}
+		return stats;
+	}
+
+	void GeometryArena::CreateBlock(uint32_t vertexCapacity, uint32_t indexCapacity)
+	{
+		auto& block = s_Blocks.emplace_back();
+
+		BufferSpecification vertexBufferSpec;
+		vertexBufferSpec.InstanceCount = 1;
+		vertexBufferSpec.InstanceSize = sizeof(MeshVertex) * (VkDeviceSize)vertexCapacity;
+		vertexBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		vertexBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+		BufferSpecification indexBufferSpec;
+		indexBufferSpec.InstanceCount = 1;
+		indexBufferSpec.InstanceSize = sizeof(uint32_t) * (VkDeviceSize)indexCapacity;
+		indexBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		indexBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+		block.VertexBuffer = std::make_unique<Buffer>(vertexBufferSpec);
+		block.IndexBuffer = std::make_unique<Buffer>(indexBufferSpec);
+		block.VertexAllocator = FreeListAllocator(vertexCapacity);
+		block.IndexAllocator = FreeListAllocator(indexCapacity);
+
+		FBY_INFO("Created geometry block {}: Vertices: {}, Indices: {}", s_Blocks.size() - 1, vertexCapacity, indexCapacity);
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Buffer.h"
+#include "FreeListAllocator.h"
+#include "VulkanVertex.h"
+#include "SwapChain.h"
+#include "UploadManager.h"
+
+namespace Flameberry {
+
+	// The range of a mesh in a geometry block, the indices are relative to `VertexOffset`
+	struct GeometryAllocation
+	{
+		uint32_t BlockIndex = UINT32_MAX;
+		uint32_t VertexOffset = 0, VertexCount = 0;
+		uint32_t FirstIndex = 0, IndexCount = 0;
+		// The geometry can be drawn by the frames submitted after the allocation, this only tells when the upload is complete on the GPU
+		UploadToken Upload;
+
+		bool IsValid() const { return BlockIndex != UINT32_MAX; }
+	};
+
+	struct GeometryArenaStats
+	{
+		uint32_t BlockCount = 0, AllocationCount = 0;
+		uint64_t VertexCapacity = 0, UsedVertexCount = 0;
+		uint64_t IndexCapacity = 0, UsedIndexCount = 0;
+	};
+
+	// Stores the vertices and the indices of all the static meshes in a few large device local buffers (blocks)
+	// The meshes sharing a block are drawn using `vertexOffset` and `firstIndex` without rebinding the vertex and index buffers
+	class GeometryArena
+	{
+	public:
+		// The capacities of a block in vertices and indices, a mesh larger than this gets a block of it's own
+		static constexpr uint32_t BlockVertexCapacity = 1 << 20, BlockIndexCapacity = 1 << 22;
+
+	public:
+		static void Shutdown();
+
+		// Uploads the geometry into the first block having enough space for it, a new block is created if none of them have
+		static GeometryAllocation Allocate(const MeshVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+		// The ranges are reused only after the frames in flight which might be drawing them are complete
+		static void Free(const GeometryAllocation& allocation);
+		// Releases the ranges freed `MAX_FRAMES_IN_FLIGHT` frames ago, to be called once per frame while the render thread is idle
+		static void ReleaseFreedRanges();
+
+		static VkBuffer GetVertexBuffer(uint32_t blockIndex) { return s_Blocks[blockIndex].VertexBuffer->GetVulkanBuffer(); }
+		static VkBuffer GetIndexBuffer(uint32_t blockIndex) { return s_Blocks[blockIndex].IndexBuffer->GetVulkanBuffer(); }
+		static GeometryArenaStats GetStats();
+
+	private:
+		struct GeometryBlock
+		{
+			std::unique_ptr<Buffer> VertexBuffer, IndexBuffer;
+			FreeListAllocator VertexAllocator, IndexAllocator;
+			uint32_t AllocationCount = 0;
+		};
+
+		static void CreateBlock(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+	private:
+		static std::vector<GeometryBlock> s_Blocks;
+		// The allocations freed during each of the last frames, indexed by the frame
+		static std::vector<GeometryAllocation> s_FreedAllocations[SwapChain::MAX_FRAMES_IN_FLIGHT];
+		static uint32_t s_FrameIndex;
+		// The meshes can be destroyed by the render thread when it releases the last reference to them
+		static std::mutex s_Mutex;
+	};
+
+} // namespace Flameberry
@@ -10,7 +10,6 @@ namespace Flameberry {
 		: m_Specification(specification), m_ReferenceCount(new uint32_t(1))
 	{
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-		const auto& physicalDevice = VulkanContext::GetPhysicalDevice();
 
 		// Creating Image
 		VkImageCreateInfo vk_image_create_info{};
@@ -33,13 +32,7 @@ namespace Flameberry {
 
 		vkGetImageMemoryRequirements(device, m_VkImage, &m_MemoryRequirements);
 
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = m_MemoryRequirements.size;
-		allocInfo.memoryTypeIndex = RenderCommand::GetValidMemoryTypeIndex(physicalDevice, m_MemoryRequirements.memoryTypeBits, m_Specification.MemoryProperties);
-
-		VK_CHECK_RESULT(vkAllocateMemory(device, &allocInfo, nullptr, &m_VkImageDeviceMemory));
-		vkBindImageMemory(device, m_VkImage, m_VkImageDeviceMemory, 0);
+		m_MemoryAllocation = VulkanContext::GetCurrentDevice()->GetMemoryAllocator().AllocateImageMemory(m_VkImage, m_Specification.Usage, m_Specification.Tiling, m_Specification.MemoryProperties);
 
 		// Creating Image View
 		VkImageViewCreateInfo vk_image_view_create_info{};
@@ -64,7 +57,7 @@ namespace Flameberry {
 	}
 
 	Image::Image(const Ref<Image>& image, const ImageViewSpecification& viewSpecification)
-		: m_VkImage(image->m_VkImage), m_VkImageDeviceMemory(image->m_VkImageDeviceMemory), m_Specification(image->m_Specification), m_ReferenceCount(image->m_ReferenceCount)
+		: m_VkImage(image->m_VkImage), m_MemoryAllocation(image->m_MemoryAllocation), m_Specification(image->m_Specification), m_ReferenceCount(image->m_ReferenceCount)
 	{
 		m_Specification.ViewSpecification = viewSpecification;
 
@@ -91,23 +84,22 @@ namespace Flameberry {
 
 	Image::~Image()
 	{
-		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-		vkDestroyImageView(device, m_VkImageView, nullptr);
+		const auto& device = VulkanContext::GetCurrentDevice();
+		vkDestroyImageView(device->GetVulkanDevice(), m_VkImageView, nullptr);
 		if (--(*m_ReferenceCount) == 0)
 		{
-			vkDestroyImage(device, m_VkImage, nullptr);
-			vkFreeMemory(device, m_VkImageDeviceMemory, nullptr);
+			vkDestroyImage(device->GetVulkanDevice(), m_VkImage, nullptr);
+			device->GetMemoryAllocator().Free(m_MemoryAllocation);
 			delete m_ReferenceCount;
 		}
 	}
 
-	void Image::GenerateMipmaps(VkImageLayout oldLayout, VkImageLayout newLayout)
+	OneShotSubmission Image::GenerateMipmaps(VkImageLayout oldLayout, VkImageLayout newLayout)
 	{
 		const auto& device = VulkanContext::GetCurrentDevice();
-		VkCommandBuffer cmdBuffer;
-		device->BeginSingleTimeCommandBuffer(cmdBuffer);
+		VkCommandBuffer cmdBuffer = device->BeginOneShotCommandBuffer();
 		CmdGenerateMipmaps(cmdBuffer, oldLayout, newLayout);
-		device->EndSingleTimeCommandBuffer(cmdBuffer);
+		return device->SubmitOneShot(cmdBuffer);
 	}
 
 	void Image::CmdGenerateMipmaps(VkCommandBuffer cmdBuffer, VkImageLayout oldLayout, VkImageLayout newLayout)
@@ -193,15 +185,19 @@ namespace Flameberry {
 			1, &barrier);
 	}
 
-	void Image::WriteFromBuffer(VkBuffer srcBuffer)
+	OneShotSubmission Image::WriteFromBuffer(VkBuffer srcBuffer)
 	{
 		const auto& device = VulkanContext::GetCurrentDevice();
 
-		VkCommandBuffer commandBuffer;
-		device->BeginSingleTimeCommandBuffer(commandBuffer);
+		VkCommandBuffer commandBuffer = device->BeginOneShotCommandBuffer();
+		CmdWriteFromBuffer(commandBuffer, srcBuffer);
+		return device->SubmitOneShot(commandBuffer);
+	}
 
+	void Image::CmdWriteFromBuffer(VkCommandBuffer cmdBuffer, VkBuffer srcBuffer, VkDeviceSize srcOffset)
+	{
 		VkBufferImageCopy vk_buffer_image_copy_region{};
-		vk_buffer_image_copy_region.bufferOffset = 0;
+		vk_buffer_image_copy_region.bufferOffset = srcOffset;
 		vk_buffer_image_copy_region.bufferRowLength = 0;
 		vk_buffer_image_copy_region.bufferImageHeight = 0;
 
@@ -213,18 +209,16 @@ namespace Flameberry {
 		vk_buffer_image_copy_region.imageOffset = { 0, 0, 0 };
 		vk_buffer_image_copy_region.imageExtent = { m_Specification.Width, m_Specification.Height, 1 };
 
-		vkCmdCopyBufferToImage(commandBuffer, srcBuffer, m_VkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vk_buffer_image_copy_region);
-		device->EndSingleTimeCommandBuffer(commandBuffer);
+		vkCmdCopyBufferToImage(cmdBuffer, srcBuffer, m_VkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vk_buffer_image_copy_region);
 	}
 
-	void Image::TransitionLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask)
+	OneShotSubmission Image::TransitionLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask)
 	{
 		const auto& device = VulkanContext::GetCurrentDevice();
-		VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
 
-		device->BeginSingleTimeCommandBuffer(cmdBuffer);
+		VkCommandBuffer cmdBuffer = device->BeginOneShotCommandBuffer();
 		CmdTransitionLayout(cmdBuffer, oldLayout, newLayout, aspectMask);
-		device->EndSingleTimeCommandBuffer(cmdBuffer);
+		return device->SubmitOneShot(cmdBuffer);
 	}
 
 	void Image::CmdTransitionLayout(VkCommandBuffer cmdBuffer, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask)
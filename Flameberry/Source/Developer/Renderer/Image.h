@@ -4,8 +4,11 @@
 #include <vulkan/vulkan.h>
 
 #include "Core/Core.h"
+#include "DeviceMemoryAllocator.h"
 
 namespace Flameberry {
+	struct OneShotSubmission;
+
 	struct ImageViewSpecification
 	{
 		VkImageAspectFlags AspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -32,13 +35,15 @@ namespace Flameberry {
 		Image(const Ref<Image>& image, const ImageViewSpecification& viewSpecification);
 		~Image();
 
-		void GenerateMipmaps(VkImageLayout oldLayout, VkImageLayout newLayout);
+		// The one-shot functions submit the commands without waiting for them, the image and the source buffer are to be kept alive until the submission completes
+		OneShotSubmission GenerateMipmaps(VkImageLayout oldLayout, VkImageLayout newLayout);
 		void CmdGenerateMipmaps(VkCommandBuffer cmdBuffer, VkImageLayout oldLayout, VkImageLayout newLayout);
 
-		void WriteFromBuffer(VkBuffer srcBuffer);
+		OneShotSubmission WriteFromBuffer(VkBuffer srcBuffer);
+		// Copies the first mip level of the image from the buffer, the image should be in `VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL`
+		void CmdWriteFromBuffer(VkCommandBuffer cmdBuffer, VkBuffer srcBuffer, VkDeviceSize srcOffset = 0);
 
-		// This function just straight up creates, begins and ends a command buffer, which might be inefficient
-		void TransitionLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
+		OneShotSubmission TransitionLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
 		void CmdTransitionLayout(VkCommandBuffer cmdBuffer, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
 
 		VkImage GetVulkanImage() const { return m_VkImage; }
@@ -50,7 +55,7 @@ namespace Flameberry {
 	private:
 		VkImage m_VkImage;
 		VkImageView m_VkImageView;
-		VkDeviceMemory m_VkImageDeviceMemory;
+		MemoryAllocation m_MemoryAllocation;
 
 		VkMemoryRequirements m_MemoryRequirements;
 		ImageSpecification m_Specification;
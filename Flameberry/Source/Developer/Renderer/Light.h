@@ -11,20 +11,25 @@ namespace Flameberry {
 		alignas(4) float Intensity = 0.0f, LightSize = 0.0f;
 	};
 
+	// Matches the `PointLight` struct (std430) of the point light storage buffer
 	struct PointLight
 	{
 		alignas(16) glm::vec3 Position;
+		// The distance beyond which the light has no influence, used for assigning the light to the clusters
+		alignas(4) float Range;
 		alignas(16) glm::vec3 Color;
 		alignas(4) float Intensity;
 	};
 
+	// Matches the `SpotLight` struct (std430) of the spot light storage buffer
 	struct SpotLight
 	{
 		alignas(16) glm::vec3 Position;
+		alignas(4) float Range;
 		alignas(16) glm::vec3 Direction;
+		alignas(4) float InnerConeAngle;
 		alignas(16) glm::vec3 Color;
 		alignas(4) float Intensity;
-		alignas(4) float InnerConeAngle;
 		alignas(4) float OuterConeAngle;
 	};
 
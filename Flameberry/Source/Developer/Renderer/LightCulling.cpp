@@ -0,0 +1,312 @@
+#include "LightCulling.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Core/Core.h"
+#include "Core/Profiler.h"
+
+namespace Flameberry {
+
+	// The radiance below which a light is considered to have no influence
+	constexpr static float s_LightInfluenceThreshold = 0.05f;
+	// The depth slices are assigned in chunks, there are more chunks than workers so that the uneven chunks are balanced among them
+	constexpr static uint32_t s_SlicesPerJob = 2;
+	// Distributing the work among the workers only pays off when there are enough lights
+	constexpr static uint32_t s_MinLightCountForParallelAssignment = 32;
+
+	float CalculateLightRange(const glm::vec3& color, float intensity)
+	{
+		const float maxRadiance = std::max({ color.r, color.g, color.b }) * intensity;
+		return std::sqrt(std::max(maxRadiance, 0.0f) / s_LightInfluenceThreshold);
+	}
+
+	void LightClusterGrid::LightBoundsSoA::Add(const glm::vec3& center, float radius, const glm::uvec3& minCluster, const glm::uvec3& maxCluster, uint32_t lightIndex)
+	{
+		CenterX.emplace_back(center.x);
+		CenterY.emplace_back(center.y);
+		CenterZ.emplace_back(center.z);
+		Radius.emplace_back(radius);
+		MinTileX.emplace_back((uint8_t)minCluster.x);
+		MaxTileX.emplace_back((uint8_t)maxCluster.x);
+		MinTileY.emplace_back((uint8_t)minCluster.y);
+		MaxTileY.emplace_back((uint8_t)maxCluster.y);
+		MinSlice.emplace_back((uint8_t)minCluster.z);
+		MaxSlice.emplace_back((uint8_t)maxCluster.z);
+		LightIndex.emplace_back(lightIndex);
+	}
+
+	void LightClusterGrid::LightBoundsSoA::Clear()
+	{
+		CenterX.clear();
+		CenterY.clear();
+		CenterZ.clear();
+		Radius.clear();
+		MinTileX.clear();
+		MaxTileX.clear();
+		MinTileY.clear();
+		MaxTileY.clear();
+		MinSlice.clear();
+		MaxSlice.clear();
+		LightIndex.clear();
+	}
+
+	LightClusterGrid::LightClusterGrid()
+	{
+		m_ClusterMinX.resize(ClusterCount);
+		m_ClusterMinY.resize(ClusterCount);
+		m_ClusterMinZ.resize(ClusterCount);
+		m_ClusterMaxX.resize(ClusterCount);
+		m_ClusterMaxY.resize(ClusterCount);
+		m_ClusterMaxZ.resize(ClusterCount);
+
+		m_Clusters.resize(ClusterCount, LightCluster{ 0, 0, 0 });
+	}
+
+	void LightClusterGrid::Update(const glm::mat4& projectionMatrix, float cameraNear, float cameraFar, const glm::vec2& viewportSize)
+	{
+		if (viewportSize.x == 0.0f || viewportSize.y == 0.0f)
+			return;
+
+		if (projectionMatrix == m_ProjectionMatrix && cameraNear == m_Near && cameraFar == m_Far && viewportSize == m_ViewportSize)
+			return;
+
+		FBY_PROFILE_SCOPE("LightClusterGrid::Update");
+
+		m_ProjectionMatrix = projectionMatrix;
+		m_Near = cameraNear;
+		m_Far = cameraFar;
+		m_ViewportSize = viewportSize;
+
+		m_TileSize = glm::ceil(viewportSize / glm::vec2(GridSizeX, GridSizeY));
+
+		const float logDepthRatio = std::log(cameraFar / cameraNear);
+		m_DepthSliceScaleBias = glm::vec2((float)GridSizeZ / logDepthRatio, (float)GridSizeZ * std::log(cameraNear) / logDepthRatio);
+
+		// The view space points on the near and the far planes at the corners of the tiles
+		// Any point of a tile at a given depth lies on the line joining these points, which works for orthographic projections too
+		constexpr uint32_t cornerCountX = GridSizeX + 1, cornerCountY = GridSizeY + 1;
+		glm::vec3 nearCorners[cornerCountX * cornerCountY], farCorners[cornerCountX * cornerCountY];
+
+		const glm::mat4 inverseProjectionMatrix = glm::inverse(projectionMatrix);
+		for (uint32_t y = 0; y < cornerCountY; y++)
+		{
+			for (uint32_t x = 0; x < cornerCountX; x++)
+			{
+				// The last column and row of tiles might extend beyond the viewport
+				const glm::vec2 ndc = glm::min(glm::vec2(x, y) * m_TileSize / viewportSize, 1.0f) * 2.0f - 1.0f;
+
+				const glm::vec4 nearCorner = inverseProjectionMatrix * glm::vec4(ndc, 0.0f, 1.0f);
+				const glm::vec4 farCorner = inverseProjectionMatrix * glm::vec4(ndc, 1.0f, 1.0f);
+
+				nearCorners[x + y * cornerCountX] = glm::vec3(nearCorner) / nearCorner.w;
+				farCorners[x + y * cornerCountX] = glm::vec3(farCorner) / farCorner.w;
+			}
+		}
+
+		for (uint32_t z = 0; z < GridSizeZ; z++)
+		{
+			const float sliceDepths[2] = {
+				cameraNear * std::pow(cameraFar / cameraNear, (float)z / GridSizeZ),
+				cameraNear * std::pow(cameraFar / cameraNear, (float)(z + 1) / GridSizeZ)
+			};
+
+			for (uint32_t y = 0; y < GridSizeY; y++)
+			{
+				for (uint32_t x = 0; x < GridSizeX; x++)
+				{
+					glm::vec3 minPoint(std::numeric_limits<float>::max()), maxPoint(std::numeric_limits<float>::lowest());
+
+					for (uint32_t corner = 0; corner < 4; corner++)
+					{
+						const uint32_t cornerIndex = (x + (corner & 1)) + (y + (corner >> 1)) * cornerCountX;
+						const glm::vec3& nearCorner = nearCorners[cornerIndex];
+						const glm::vec3& farCorner = farCorners[cornerIndex];
+
+						for (const float depth : sliceDepths)
+						{
+							const float t = (depth + nearCorner.z) / (nearCorner.z - farCorner.z);
+							const glm::vec3 point = glm::mix(nearCorner, farCorner, t);
+
+							minPoint = glm::min(minPoint, point);
+							maxPoint = glm::max(maxPoint, point);
+						}
+					}
+
+					const uint32_t clusterIndex = x + GridSizeX * (y + GridSizeY * z);
+					m_ClusterMinX[clusterIndex] = minPoint.x;
+					m_ClusterMinY[clusterIndex] = minPoint.y;
+					m_ClusterMinZ[clusterIndex] = minPoint.z;
+					m_ClusterMaxX[clusterIndex] = maxPoint.x;
+					m_ClusterMaxY[clusterIndex] = maxPoint.y;
+					m_ClusterMaxZ[clusterIndex] = maxPoint.z;
+				}
+			}
+		}
+	}
+
+	bool LightClusterGrid::CalculateLightClusterRange(const glm::vec3& viewSpaceCenter, float radius, glm::uvec3& outMinCluster, glm::uvec3& outMaxCluster) const
+	{
+		// The camera looks towards -Z in view space
+		const float minDepth = -viewSpaceCenter.z - radius, maxDepth = -viewSpaceCenter.z + radius;
+		if (maxDepth < m_Near || minDepth > m_Far)
+			return false;
+
+		const auto getDepthSlice = [this](float depth)
+		{
+			const float slice = std::floor(std::log(depth) * m_DepthSliceScaleBias.x - m_DepthSliceScaleBias.y);
+			return (uint32_t)glm::clamp(slice, 0.0f, (float)(GridSizeZ - 1));
+		};
+
+		outMinCluster = glm::uvec3(0, 0, getDepthSlice(std::max(minDepth, m_Near)));
+		outMaxCluster = glm::uvec3(GridSizeX - 1, GridSizeY - 1, getDepthSlice(std::min(maxDepth, m_Far)));
+
+		// The sphere intersecting the near plane can cover any of the tiles
+		if (minDepth <= m_Near)
+			return true;
+
+		// Project the view space AABB of the sphere to find the tiles that it covers
+		glm::vec2 minNDC(std::numeric_limits<float>::max()), maxNDC(std::numeric_limits<float>::lowest());
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			const glm::vec3 offset((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+			const glm::vec4 clipSpaceCorner = m_ProjectionMatrix * glm::vec4(viewSpaceCenter + offset, 1.0f);
+			const glm::vec2 ndc = glm::vec2(clipSpaceCorner) / clipSpaceCorner.w;
+
+			minNDC = glm::min(minNDC, ndc);
+			maxNDC = glm::max(maxNDC, ndc);
+		}
+
+		if (maxNDC.x < -1.0f || maxNDC.y < -1.0f || minNDC.x > 1.0f || minNDC.y > 1.0f)
+			return false;
+
+		const glm::vec2 gridSize(GridSizeX, GridSizeY);
+		const glm::vec2 minTile = glm::clamp(glm::floor((minNDC * 0.5f + 0.5f) * m_ViewportSize / m_TileSize), glm::vec2(0.0f), gridSize - 1.0f);
+		const glm::vec2 maxTile = glm::clamp(glm::floor((maxNDC * 0.5f + 0.5f) * m_ViewportSize / m_TileSize), glm::vec2(0.0f), gridSize - 1.0f);
+
+		outMinCluster.x = (uint32_t)minTile.x;
+		outMinCluster.y = (uint32_t)minTile.y;
+		outMaxCluster.x = (uint32_t)maxTile.x;
+		outMaxCluster.y = (uint32_t)maxTile.y;
+		return true;
+	}
+
+	void LightClusterGrid::AssignLights(const glm::mat4& viewMatrix, const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights, ThreadPool* threadPool)
+	{
+		FBY_PROFILE_SCOPE("LightClusterGrid::AssignLights");
+
+		m_LightBounds.Clear();
+
+		glm::uvec3 minCluster, maxCluster;
+
+		// The spot lights are bounded by the sphere enclosing their whole range, which is conservative for narrow cones
+		for (uint32_t i = 0; i < (uint32_t)pointLights.size(); i++)
+		{
+			const glm::vec3 center = glm::vec3(viewMatrix * glm::vec4(pointLights[i].Position, 1.0f));
+			if (CalculateLightClusterRange(center, pointLights[i].Range, minCluster, maxCluster))
+				m_LightBounds.Add(center, pointLights[i].Range, minCluster, maxCluster, i);
+		}
+
+		m_VisiblePointLightCount = m_LightBounds.GetCount();
+
+		for (uint32_t i = 0; i < (uint32_t)spotLights.size(); i++)
+		{
+			const glm::vec3 center = glm::vec3(viewMatrix * glm::vec4(spotLights[i].Position, 1.0f));
+			if (CalculateLightClusterRange(center, spotLights[i].Range, minCluster, maxCluster))
+				m_LightBounds.Add(center, spotLights[i].Range, minCluster, maxCluster, i);
+		}
+
+		constexpr uint32_t jobCount = (GridSizeZ + s_SlicesPerJob - 1) / s_SlicesPerJob;
+		m_JobLightIndices.resize(jobCount);
+
+		if (threadPool && m_LightBounds.GetCount() >= s_MinLightCountForParallelAssignment)
+		{
+			std::future<void> futures[jobCount];
+			for (uint32_t i = 0; i < jobCount; i++)
+			{
+				futures[i] = threadPool->Submit([this, i]()
+					{
+						AssignLightsToSlices(i * s_SlicesPerJob, std::min((i + 1) * s_SlicesPerJob, GridSizeZ), m_JobLightIndices[i]);
+					});
+			}
+
+			for (auto& future : futures)
+				future.wait();
+		}
+		else
+		{
+			for (uint32_t i = 0; i < jobCount; i++)
+				AssignLightsToSlices(i * s_SlicesPerJob, std::min((i + 1) * s_SlicesPerJob, GridSizeZ), m_JobLightIndices[i]);
+		}
+
+		// Merge the light indices of the jobs and make the offsets of their clusters absolute
+		m_LightIndices.clear();
+		for (uint32_t i = 0; i < jobCount; i++)
+		{
+			const uint32_t baseOffset = (uint32_t)m_LightIndices.size();
+			const uint32_t firstCluster = i * s_SlicesPerJob * GridSizeX * GridSizeY;
+			const uint32_t lastCluster = std::min((i + 1) * s_SlicesPerJob, GridSizeZ) * GridSizeX * GridSizeY;
+
+			for (uint32_t cluster = firstCluster; cluster < lastCluster; cluster++)
+				m_Clusters[cluster].Offset += baseOffset;
+
+			m_LightIndices.insert(m_LightIndices.end(), m_JobLightIndices[i].begin(), m_JobLightIndices[i].end());
+		}
+	}
+
+	void LightClusterGrid::AssignLightsToSlices(uint32_t firstSlice, uint32_t lastSlice, std::vector<uint32_t>& outLightIndices)
+	{
+		outLightIndices.clear();
+
+		// Lights overlapping the current slice, kept in the order of `m_LightBounds` so that the point lights come before the spot lights
+		std::vector<uint32_t> sliceLights;
+		sliceLights.reserve(m_LightBounds.GetCount());
+
+		for (uint32_t z = firstSlice; z < lastSlice; z++)
+		{
+			sliceLights.clear();
+			for (uint32_t i = 0; i < m_LightBounds.GetCount(); i++)
+			{
+				if (m_LightBounds.MinSlice[i] <= z && z <= m_LightBounds.MaxSlice[i])
+					sliceLights.emplace_back(i);
+			}
+
+			for (uint32_t y = 0; y < GridSizeY; y++)
+			{
+				for (uint32_t x = 0; x < GridSizeX; x++)
+				{
+					const uint32_t clusterIndex = x + GridSizeX * (y + GridSizeY * z);
+
+					LightCluster& cluster = m_Clusters[clusterIndex];
+					cluster = LightCluster{ (uint32_t)outLightIndices.size(), 0, 0 };
+
+					const float minX = m_ClusterMinX[clusterIndex], minY = m_ClusterMinY[clusterIndex], minZ = m_ClusterMinZ[clusterIndex];
+					const float maxX = m_ClusterMaxX[clusterIndex], maxY = m_ClusterMaxY[clusterIndex], maxZ = m_ClusterMaxZ[clusterIndex];
+
+					for (const uint32_t light : sliceLights)
+					{
+						if (x < m_LightBounds.MinTileX[light] || x > m_LightBounds.MaxTileX[light] || y < m_LightBounds.MinTileY[light] || y > m_LightBounds.MaxTileY[light])
+							continue;
+
+						// Squared distance from the center of the sphere to the closest point of the cluster
+						const float dx = std::max(std::max(minX - m_LightBounds.CenterX[light], 0.0f), m_LightBounds.CenterX[light] - maxX);
+						const float dy = std::max(std::max(minY - m_LightBounds.CenterY[light], 0.0f), m_LightBounds.CenterY[light] - maxY);
+						const float dz = std::max(std::max(minZ - m_LightBounds.CenterZ[light], 0.0f), m_LightBounds.CenterZ[light] - maxZ);
+
+						if (dx * dx + dy * dy + dz * dz > m_LightBounds.Radius[light] * m_LightBounds.Radius[light])
+							continue;
+
+						outLightIndices.emplace_back(m_LightBounds.LightIndex[light]);
+
+						if (light < m_VisiblePointLightCount)
+							cluster.PointLightCount++;
+						else
+							cluster.SpotLightCount++;
+					}
+				}
+			}
+		}
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Light.h"
+#include "Core/ThreadPool.h"
+
+namespace Flameberry {
+
+	// Matches the `LightCluster` struct (std430) of the light cluster storage buffer
+	// The indices of the point lights followed by the indices of the spot lights of a cluster start at `Offset` in the light index storage buffer
+	struct LightCluster
+	{
+		uint32_t Offset, PointLightCount, SpotLightCount;
+	};
+
+	// The lights don't have a range, so the distance at which their inverse square falloff drops below a small threshold is used
+	float CalculateLightRange(const glm::vec3& color, float intensity);
+
+	// Divides the view frustum into a grid of clusters (froxels), tiled uniformly in screen space and sliced exponentially in depth
+	// Every cluster stores the lights influencing it, so that a fragment only evaluates the lights of the cluster it lies in
+	class LightClusterGrid
+	{
+	public:
+		static constexpr uint32_t GridSizeX = 16, GridSizeY = 9, GridSizeZ = 24;
+		static constexpr uint32_t ClusterCount = GridSizeX * GridSizeY * GridSizeZ;
+
+	public:
+		LightClusterGrid();
+
+		// Recalculates the view space bounds of the clusters, only when the projection or the viewport size has changed
+		void Update(const glm::mat4& projectionMatrix, float cameraNear, float cameraFar, const glm::vec2& viewportSize);
+		// Assigns the lights to the clusters they influence, the depth slices are distributed among the workers of the thread pool
+		void AssignLights(const glm::mat4& viewMatrix, const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights, ThreadPool* threadPool);
+
+		const std::vector<LightCluster>& GetClusters() const { return m_Clusters; }
+		const std::vector<uint32_t>& GetLightIndices() const { return m_LightIndices; }
+
+		// The size of a cluster in pixels
+		glm::vec2 GetTileSize() const { return m_TileSize; }
+		// The depth slice of a fragment at view space depth `d` is `log(d) * scale - bias`
+		glm::vec2 GetDepthSliceScaleBias() const { return m_DepthSliceScaleBias; }
+
+	private:
+		// Calculates the range of the clusters overlapped by the bounding sphere of a light, returns false if the light lies outside the view frustum
+		bool CalculateLightClusterRange(const glm::vec3& viewSpaceCenter, float radius, glm::uvec3& outMinCluster, glm::uvec3& outMaxCluster) const;
+		// Gathers the lights of the clusters in the depth slices [firstSlice, lastSlice) into `outLightIndices`, the cluster offsets are relative to it
+		void AssignLightsToSlices(uint32_t firstSlice, uint32_t lastSlice, std::vector<uint32_t>& outLightIndices);
+
+	private:
+		glm::mat4 m_ProjectionMatrix{ 0.0f };
+		float m_Near = 0.0f, m_Far = 0.0f;
+		glm::vec2 m_ViewportSize{ 0.0f };
+
+		glm::vec2 m_TileSize{ 1.0f }, m_DepthSliceScaleBias{ 0.0f };
+
+		// View space AABBs of the clusters stored as a structure of arrays
+		std::vector<float> m_ClusterMinX, m_ClusterMinY, m_ClusterMinZ;
+		std::vector<float> m_ClusterMaxX, m_ClusterMaxY, m_ClusterMaxZ;
+
+		// View space bounding spheres of the visible point lights followed by the visible spot lights of the current frame
+		// along with the ranges of the clusters that they overlap and their indices in the light arrays
+		struct LightBoundsSoA
+		{
+			std::vector<float> CenterX, CenterY, CenterZ, Radius;
+			std::vector<uint8_t> MinTileX, MaxTileX, MinTileY, MaxTileY, MinSlice, MaxSlice;
+			std::vector<uint32_t> LightIndex;
+
+			void Add(const glm::vec3& center, float radius, const glm::uvec3& minCluster, const glm::uvec3& maxCluster, uint32_t lightIndex);
+			void Clear();
+
+			uint32_t GetCount() const { return (uint32_t)CenterX.size(); }
+		} m_LightBounds;
+		uint32_t m_VisiblePointLightCount = 0;
+
+		std::vector<LightCluster> m_Clusters;
+		std::vector<uint32_t> m_LightIndices;
+
+		// The light indices gathered by each job, merged into `m_LightIndices` in order
+		std::vector<std::vector<uint32_t>> m_JobLightIndices;
+	};
+
+} // namespace Flameberry
@@ -64,7 +64,6 @@ namespace Flameberry {
 			if (vulkanDescSetBindings.size())
 			{
 				DescriptorSetSpecification descSetSpecification;
-				descSetSpecification.Pool = VulkanContext::GetCurrentGlobalDescriptorPool();
 
 				DescriptorSetLayoutSpecification layoutSpecification{ vulkanDescSetBindings };
 				descSetSpecification.Layout = DescriptorSetLayout::CreateOrGetCached(layoutSpecification);
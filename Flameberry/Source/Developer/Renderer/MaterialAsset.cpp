@@ -5,57 +5,62 @@
 
 #include "Core/YamlUtils.h"
 #include "ShaderLibrary.h"
+#include "TextureTable.h"
 #include "Asset/AssetManager.h"
 
 namespace Flameberry {
 
 	MaterialAsset::MaterialAsset(const std::string& name)
-		: m_Name(name), m_MaterialRef(CreateRef<Material>(ShaderLibrary::Get("PBR"))) // TODO: This should be changed immediately
+		: m_Name(name), m_MaterialBufferIndex(MaterialParameterBuffer::Allocate()), m_MaterialRef(CreateRef<Material>(ShaderLibrary::Get("PBR"))) // TODO: This should be changed immediately
 	{
-		// This is here to remind the developer to update the GPU representation of the Material Struct when it is updated in the shader
-		FBY_ASSERT(sizeof(MaterialStructGPURepresentation) == m_MaterialRef->GetUniformDataSize(), "The GPU Representation of Material has a size ({}) which is not the same as actual Uniform size ({})", sizeof(MaterialStructGPURepresentation), m_MaterialRef->GetUniformDataSize());
-
-		// This is very frustrating to do, otherwise Vulkan complains about no vkUpdateDescriptorSet called on certain bindings
-		m_MaterialRef->Set("u_AlbedoMapSampler", Texture2D::GetEmptyImage(), Texture2D::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		m_MaterialRef->Set("u_NormalMapSampler", Texture2D::GetEmptyImage(), Texture2D::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		m_MaterialRef->Set("u_RoughnessMapSampler", Texture2D::GetEmptyImage(), Texture2D::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		m_MaterialRef->Set("u_AmbientMapSampler", Texture2D::GetEmptyImage(), Texture2D::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		m_MaterialRef->Set("u_MetallicMapSampler", Texture2D::GetEmptyImage(), Texture2D::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// The texture maps are sampled from the texture table, the unassigned ones refer to the empty texture
+		auto& materialData = GetMaterialDataRef();
+		materialData.AlbedoMapIndex = TextureTable::EmptyTextureIndex;
+		materialData.NormalMapIndex = TextureTable::EmptyTextureIndex;
+		materialData.RoughnessMapIndex = TextureTable::EmptyTextureIndex;
+		materialData.AmbientMapIndex = TextureTable::EmptyTextureIndex;
+		materialData.MetallicMapIndex = TextureTable::EmptyTextureIndex;
+	}
+
+	MaterialAsset::~MaterialAsset()
+	{
+		MaterialParameterBuffer::Free(m_MaterialBufferIndex);
 	}
 
 	void MaterialAsset::SetAlbedoMap(AssetHandle handle)
 	{
 		m_AlbedoMap = handle;
 		Ref<Texture2D> map = AssetManager::GetAsset<Texture2D>(handle);
-		m_MaterialRef->Set("u_AlbedoMapSampler", map);
+		GetMaterialDataRef().AlbedoMapIndex = map ? map->GetTextureTableIndex() : TextureTable::EmptyTextureIndex;
 	}
 
 	void MaterialAsset::SetNormalMap(AssetHandle handle)
 	{
 		m_NormalMap = handle;
 		Ref<Texture2D> map = AssetManager::GetAsset<Texture2D>(handle);
-		m_MaterialRef->Set("u_NormalMapSampler", map);
+		GetMaterialDataRef().NormalMapIndex = map ? map->GetTextureTableIndex() : TextureTable::EmptyTextureIndex;
 	}
 
 	void MaterialAsset::SetRoughnessMap(AssetHandle handle)
 	{
 		m_RoughnessMap = handle;
 		Ref<Texture2D> map = AssetManager::GetAsset<Texture2D>(handle);
-		m_MaterialRef->Set("u_RoughnessMapSampler", map);
+		GetMaterialDataRef().RoughnessMapIndex = map ? map->GetTextureTableIndex() : TextureTable::EmptyTextureIndex;
 	}
 
 	void MaterialAsset::SetAmbientMap(AssetHandle handle)
 	{
 		m_AmbientMap = handle;
 		Ref<Texture2D> map = AssetManager::GetAsset<Texture2D>(handle);
-		m_MaterialRef->Set("u_AmbientMapSampler", map);
+		GetMaterialDataRef().AmbientMapIndex = map ? map->GetTextureTableIndex() : TextureTable::EmptyTextureIndex;
 	}
 
 	void MaterialAsset::SetMetallicMap(AssetHandle handle)
 	{
 		m_MetallicMap = handle;
 		Ref<Texture2D> map = AssetManager::GetAsset<Texture2D>(handle);
-		m_MaterialRef->Set("u_MetallicMapSampler", map);
+		GetMaterialDataRef().MetallicMapIndex = map ? map->GetTextureTableIndex() : TextureTable::EmptyTextureIndex;
 	}
 
 	void MaterialAssetSerializer::Serialize(const Ref<MaterialAsset>& materialAsset, const std::filesystem::path& path)
@@ -65,20 +70,19 @@ namespace Flameberry {
 		out << YAML::Key << "Material" << YAML::Value << YAML::BeginMap;
 		out << YAML::Key << "Name" << YAML::Value << materialAsset->m_Name;
 
-		const float* albedo = materialAsset->m_MaterialRef->GetArray<float>("u_Albedo");
-		out << YAML::Key << "Albedo" << YAML::Value << glm::vec3(albedo[0], albedo[1], albedo[2]);
+		out << YAML::Key << "Albedo" << YAML::Value << materialAsset->GetAlbedo();
 
-		out << YAML::Key << "Roughness" << YAML::Value << materialAsset->m_MaterialRef->Get<float>("u_Roughness");
-		out << YAML::Key << "Metallic" << YAML::Value << materialAsset->m_MaterialRef->Get<float>("u_Metallic");
-		out << YAML::Key << "UseAlbedoMap" << YAML::Value << (bool)materialAsset->m_MaterialRef->Get<uint32_t>("u_UseAlbedoMap");
+		out << YAML::Key << "Roughness" << YAML::Value << materialAsset->GetRoughness();
+		out << YAML::Key << "Metallic" << YAML::Value << materialAsset->GetMetallic();
+		out << YAML::Key << "UseAlbedoMap" << YAML::Value << materialAsset->IsUsingAlbedoMap();
 		out << YAML::Key << "AlbedoMap" << YAML::Value << materialAsset->m_AlbedoMap;
-		out << YAML::Key << "UseNormalMap" << YAML::Value << (bool)materialAsset->m_MaterialRef->Get<uint32_t>("u_UseNormalMap");
+		out << YAML::Key << "UseNormalMap" << YAML::Value << materialAsset->IsUsingNormalMap();
 		out << YAML::Key << "NormalMap" << YAML::Value << materialAsset->m_NormalMap;
-		out << YAML::Key << "UseRoughnessMap" << YAML::Value << (bool)materialAsset->m_MaterialRef->Get<uint32_t>("u_UseRoughnessMap");
+		out << YAML::Key << "UseRoughnessMap" << YAML::Value << materialAsset->IsUsingRoughnessMap();
 		out << YAML::Key << "RoughnessMap" << YAML::Value << materialAsset->m_RoughnessMap;
-		out << YAML::Key << "UseAmbientMap" << YAML::Value << (bool)materialAsset->m_MaterialRef->Get<uint32_t>("u_UseAmbientMap");
+		out << YAML::Key << "UseAmbientMap" << YAML::Value << materialAsset->IsUsingAmbientMap();
 		out << YAML::Key << "AmbientMap" << YAML::Value << materialAsset->m_AmbientMap;
-		out << YAML::Key << "UseMetallicMap" << YAML::Value << (bool)materialAsset->m_MaterialRef->Get<uint32_t>("u_UseMetallicMap");
+		out << YAML::Key << "UseMetallicMap" << YAML::Value << materialAsset->IsUsingMetallicMap();
 		out << YAML::Key << "MetallicMap" << YAML::Value << materialAsset->m_MetallicMap;
 		out << YAML::EndMap;
 
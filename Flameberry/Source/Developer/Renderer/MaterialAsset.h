@@ -2,47 +2,44 @@
 
 #include "Asset/Asset.h"
 #include "Material.h"
+#include "MaterialParameterBuffer.h"
 #include "Texture2D.h"
 
 namespace Flameberry {
 
-	struct MaterialStructGPURepresentation
-	{
-		glm::vec3 Albedo;
-		float Roughness, Metallic;
-		FBoolean UseAlbedoMap, UseNormalMap, UseRoughnessMap, UseAmbientMap, UseMetallicMap;
-	};
-
 	// This class is basically a wrapper for the `Material` class to add utilities for using Materials for Meshes
 	class MaterialAsset : public Asset
 	{
 	public:
 		MaterialAsset(const std::string& name);
+		~MaterialAsset();
 
 		Ref<Material> GetUnderlyingMaterial() { return m_MaterialRef; }
 
 		// Getters
 		std::string GetName() const { return m_Name; }
-		glm::vec3 GetAlbedo() const { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().Albedo; }
-		float GetRoughness() const { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().Roughness; }
-		float GetMetallic() const { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().Metallic; }
-		bool IsUsingAlbedoMap() const { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseAlbedoMap; }
-		bool IsUsingNormalMap() const { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseNormalMap; }
-		bool IsUsingRoughnessMap() const { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseRoughnessMap; }
-		bool IsUsingAmbientMap() const { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseAmbientMap; }
-		bool IsUsingMetallicMap() const { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseMetallicMap; }
+		// The index of the parameters of this material in the `MaterialParameterBuffer`
+		uint32_t GetMaterialBufferIndex() const { return m_MaterialBufferIndex; }
+		glm::vec3 GetAlbedo() const { return GetMaterialData().Albedo; }
+		float GetRoughness() const { return GetMaterialData().Roughness; }
+		float GetMetallic() const { return GetMaterialData().Metallic; }
+		bool IsUsingAlbedoMap() const { return GetMaterialData().UseAlbedoMap; }
+		bool IsUsingNormalMap() const { return GetMaterialData().UseNormalMap; }
+		bool IsUsingRoughnessMap() const { return GetMaterialData().UseRoughnessMap; }
+		bool IsUsingAmbientMap() const { return GetMaterialData().UseAmbientMap; }
+		bool IsUsingMetallicMap() const { return GetMaterialData().UseMetallicMap; }
 
 		// Setters
 		void SetName(const char* name) { m_Name = name; }
-		void SetAlbedo(const glm::vec3& albedo) { m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().Albedo = albedo; }
-		void SetRoughness(float roughness) { m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().Roughness = roughness; }
-		void SetMetallic(float metallic) { m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().Metallic = metallic; }
+		void SetAlbedo(const glm::vec3& albedo) { GetMaterialDataRef().Albedo = albedo; }
+		void SetRoughness(float roughness) { GetMaterialDataRef().Roughness = roughness; }
+		void SetMetallic(float metallic) { GetMaterialDataRef().Metallic = metallic; }
 
-		void SetUseAlbedoMap(bool value) { m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseAlbedoMap = (FBoolean)value; }
-		void SetUseNormalMap(bool value) { m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseNormalMap = (FBoolean)value; }
-		void SetUseRoughnessMap(bool value) { m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseRoughnessMap = (FBoolean)value; }
-		void SetUseAmbientMap(bool value) { m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseAmbientMap = (FBoolean)value; }
-		void SetUseMetallicMap(bool value) { m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>().UseMetallicMap = (FBoolean)value; }
+		void SetUseAlbedoMap(bool value) { GetMaterialDataRef().UseAlbedoMap = (FBoolean)value; }
+		void SetUseNormalMap(bool value) { GetMaterialDataRef().UseNormalMap = (FBoolean)value; }
+		void SetUseRoughnessMap(bool value) { GetMaterialDataRef().UseRoughnessMap = (FBoolean)value; }
+		void SetUseAmbientMap(bool value) { GetMaterialDataRef().UseAmbientMap = (FBoolean)value; }
+		void SetUseMetallicMap(bool value) { GetMaterialDataRef().UseMetallicMap = (FBoolean)value; }
 
 		void SetAlbedoMap(AssetHandle handle);
 		void SetNormalMap(AssetHandle handle);
@@ -53,10 +50,13 @@ namespace Flameberry {
 		FBY_DECLARE_ASSET_TYPE(AssetType::Material);
 
 	protected:
-		MaterialStructGPURepresentation& GetMaterialDataRef() { return m_MaterialRef->GetUniformDataReferenceAs<MaterialStructGPURepresentation>(); }
+		const MaterialStructGPURepresentation& GetMaterialData() const { return MaterialParameterBuffer::Get(m_MaterialBufferIndex); }
+		// Marks the parameters as changed so that they are uploaded to the material parameter buffer
+		MaterialStructGPURepresentation& GetMaterialDataRef() { return MaterialParameterBuffer::GetMutable(m_MaterialBufferIndex); }
 
 	private:
 		std::string m_Name;
+		uint32_t m_MaterialBufferIndex;
 		// This is the core material which has a reference to the actual shader and stores the DescriptorSets and PushConstantData
 		Ref<Material> m_MaterialRef;
 
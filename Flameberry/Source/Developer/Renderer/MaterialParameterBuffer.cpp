@@ -0,0 +1,114 @@
+#include "MaterialParameterBuffer.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace Flameberry {
+
+	std::vector<MaterialStructGPURepresentation> MaterialParameterBuffer::s_Materials;
+	std::array<Unique<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> MaterialParameterBuffer::s_Buffers;
+	std::array<uint32_t, SwapChain::MAX_FRAMES_IN_FLIGHT> MaterialParameterBuffer::s_DirtyBegin, MaterialParameterBuffer::s_DirtyEnd;
+
+	uint32_t MaterialParameterBuffer::s_SlotCount = 0;
+	std::vector<uint32_t> MaterialParameterBuffer::s_FreeSlots;
+	std::mutex MaterialParameterBuffer::s_Mutex;
+
+	void MaterialParameterBuffer::Init()
+	{
+		s_Materials.assign(MaxMaterialCount, MaterialStructGPURepresentation{});
+
+		BufferSpecification bufferSpec;
+		bufferSpec.InstanceCount = MaxMaterialCount;
+		bufferSpec.InstanceSize = sizeof(MaterialStructGPURepresentation);
+		bufferSpec.Usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		bufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		for (auto& buffer : s_Buffers)
+		{
+			buffer = CreateUnique<Buffer>(bufferSpec);
+			buffer->MapMemory(buffer->GetBufferSize());
+		}
+
+		s_DirtyBegin.fill(UINT32_MAX);
+		s_DirtyEnd.fill(0);
+	}
+
+	void MaterialParameterBuffer::Shutdown()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		for (auto& buffer : s_Buffers)
+			buffer = nullptr;
+
+		s_SlotCount = 0;
+		s_FreeSlots.clear();
+	}
+
+	uint32_t MaterialParameterBuffer::Allocate()
+	{
+		uint32_t index;
+		{
+			std::scoped_lock<std::mutex> lock(s_Mutex);
+
+			if (s_FreeSlots.size())
+			{
+				index = s_FreeSlots.back();
+				s_FreeSlots.pop_back();
+			}
+			else
+			{
+				FBY_ASSERT(s_SlotCount < MaxMaterialCount, "Material parameter buffer capacity of {} materials exceeded", MaxMaterialCount);
+				index = s_SlotCount++;
+			}
+		}
+
+		GetMutable(index) = MaterialStructGPURepresentation{};
+		return index;
+	}
+
+	void MaterialParameterBuffer::Free(uint32_t index)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		// The materials outliving the renderer don't have to give their slots back
+		if (!s_Buffers[0])
+			return;
+
+		s_FreeSlots.push_back(index);
+	}
+
+	MaterialStructGPURepresentation& MaterialParameterBuffer::GetMutable(uint32_t index)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		for (uint32_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			s_DirtyBegin[i] = std::min(s_DirtyBegin[i], index);
+			s_DirtyEnd[i] = std::max(s_DirtyEnd[i], index + 1);
+		}
+		return s_Materials[index];
+	}
+
+	void MaterialParameterBuffer::FlushFrame(uint32_t frameIndex)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		if (s_DirtyBegin[frameIndex] < s_DirtyEnd[frameIndex])
+		{
+			const VkDeviceSize offset = s_DirtyBegin[frameIndex] * sizeof(MaterialStructGPURepresentation);
+			const VkDeviceSize size = (s_DirtyEnd[frameIndex] - s_DirtyBegin[frameIndex]) * sizeof(MaterialStructGPURepresentation);
+
+			memcpy((uint8_t*)s_Buffers[frameIndex]->GetMappedMemory() + offset, s_Materials.data() + s_DirtyBegin[frameIndex], size);
+		}
+
+		s_DirtyBegin[frameIndex] = UINT32_MAX;
+		s_DirtyEnd[frameIndex] = 0;
+	}
+
+	uint32_t MaterialParameterBuffer::GetMaterialCount()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+		return s_SlotCount - (uint32_t)s_FreeSlots.size();
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include "Core/Core.h"
+#include "Buffer.h"
+#include "Shader.h"
+#include "SwapChain.h"
+
+namespace Flameberry {
+
+	// Matches the `Material` struct (std430) of `PBR.frag`, hence the alignment of the array stride
+	struct alignas(16) MaterialStructGPURepresentation
+	{
+		glm::vec3 Albedo;
+		float Roughness, Metallic;
+		FBoolean UseAlbedoMap, UseNormalMap, UseRoughnessMap, UseAmbientMap, UseMetallicMap;
+		// Indices into the bindless `TextureTable`
+		uint32_t AlbedoMapIndex, NormalMapIndex, RoughnessMapIndex, AmbientMapIndex, MetallicMapIndex;
+	};
+
+	// The parameters of all the materials stored in a single storage buffer, which the shaders index using the material index of the instance data
+	// Hence the draws don't push or bind anything per material, and the draws with different materials can be merged
+	// The buffer is persistently mapped and duplicated per frame in flight, only the range of the materials changed since the buffer of the frame
+	// was last written is copied from the CPU side copy, once the main thread finishes recording the frame
+	// As the frames in flight read their own copies, a freed index can be reused right away
+	class MaterialParameterBuffer
+	{
+	public:
+		static constexpr uint32_t MaxMaterialCount = 16 * 1024;
+
+	public:
+		static void Init();
+		static void Shutdown();
+
+		// Returns the index of a new zero initialized material
+		static uint32_t Allocate();
+		static void Free(uint32_t index);
+
+		static const MaterialStructGPURepresentation& Get(uint32_t index) { return s_Materials[index]; }
+		// Marks the material as changed, the returned reference is to be written to right away
+		static MaterialStructGPURepresentation& GetMutable(uint32_t index);
+
+		// Copies the changed materials into the buffer of the frame, to be called once the main thread finishes recording the frame with the given index
+		static void FlushFrame(uint32_t frameIndex);
+
+		static VkBuffer GetBuffer(uint32_t frameIndex) { return s_Buffers[frameIndex]->GetVulkanBuffer(); }
+		static uint32_t GetMaterialCount();
+
+	private:
+		// The CPU side copy of the materials, allocated with the full capacity up front so that the references to it stay valid
+		static std::vector<MaterialStructGPURepresentation> s_Materials;
+		static std::array<Unique<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> s_Buffers;
+		// The range of the materials changed since the buffer of each frame was last written
+		static std::array<uint32_t, SwapChain::MAX_FRAMES_IN_FLIGHT> s_DirtyBegin, s_DirtyEnd;
+
+		static uint32_t s_SlotCount;
+		static std::vector<uint32_t> s_FreeSlots;
+		// The materials can be destroyed by the render thread when it releases the last reference to them
+		static std::mutex s_Mutex;
+	};
+
+} // namespace Flameberry
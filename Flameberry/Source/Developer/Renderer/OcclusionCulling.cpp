@@ -0,0 +1,322 @@
+#include "OcclusionCulling.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "Core/Core.h"
+#include "Core/Profiler.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FBY_OCCLUSION_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Flameberry {
+
+	// The rows of tiles rasterized by a single job, every job rasterizes all the triangles but only writes to it's own rows
+	constexpr static uint32_t s_TileRowsPerJob = 2;
+	// Distributing the rasterization among the workers only pays off when there are enough triangles
+	constexpr static uint32_t s_MinTriangleCountForParallelRasterization = 256;
+
+	void SoftwareOcclusionCuller::TriangleSoA::Add(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+	{
+		X0.emplace_back(v0.x);
+		Y0.emplace_back(v0.y);
+		Z0.emplace_back(v0.z);
+		X1.emplace_back(v1.x);
+		Y1.emplace_back(v1.y);
+		Z1.emplace_back(v1.z);
+		X2.emplace_back(v2.x);
+		Y2.emplace_back(v2.y);
+		Z2.emplace_back(v2.z);
+	}
+
+	void SoftwareOcclusionCuller::TriangleSoA::Clear()
+	{
+		X0.clear();
+		Y0.clear();
+		Z0.clear();
+		X1.clear();
+		Y1.clear();
+		Z1.clear();
+		X2.clear();
+		Y2.clear();
+		Z2.clear();
+	}
+
+	SoftwareOcclusionCuller::SoftwareOcclusionCuller()
+	{
+		m_DepthBuffer.resize(Width * Height, 1.0f);
+		m_TileDepths.resize(TileCountX * TileCountY, 1.0f);
+	}
+
+	void SoftwareOcclusionCuller::BeginFrame(const glm::mat4& viewProjectionMatrix)
+	{
+		m_ViewProjectionMatrix = viewProjectionMatrix;
+		m_Triangles.Clear();
+
+		std::fill(m_DepthBuffer.begin(), m_DepthBuffer.end(), 1.0f);
+		std::fill(m_TileDepths.begin(), m_TileDepths.end(), 1.0f);
+	}
+
+	void SoftwareOcclusionCuller::AddOccluder(const glm::mat4& modelMatrix, const glm::vec3* positions, const uint32_t* indices, uint32_t indexCount)
+	{
+		const glm::mat4 modelViewProjectionMatrix = m_ViewProjectionMatrix * modelMatrix;
+
+		for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			const glm::vec4 v[3] = {
+				modelViewProjectionMatrix * glm::vec4(positions[indices[i]], 1.0f),
+				modelViewProjectionMatrix * glm::vec4(positions[indices[i + 1]], 1.0f),
+				modelViewProjectionMatrix * glm::vec4(positions[indices[i + 2]], 1.0f)
+			};
+
+			// Reject the triangles lying completely outside any of the planes of the frustum
+			if ((v[0].x > v[0].w && v[1].x > v[1].w && v[2].x > v[2].w) || (v[0].x < -v[0].w && v[1].x < -v[1].w && v[2].x < -v[2].w)
+				|| (v[0].y > v[0].w && v[1].y > v[1].w && v[2].y > v[2].w) || (v[0].y < -v[0].w && v[1].y < -v[1].w && v[2].y < -v[2].w)
+				|| (v[0].z > v[0].w && v[1].z > v[1].w && v[2].z > v[2].w) || (v[0].z < 0.0f && v[1].z < 0.0f && v[2].z < 0.0f))
+				continue;
+
+			if (v[0].z >= 0.0f && v[1].z >= 0.0f && v[2].z >= 0.0f)
+			{
+				AddClipSpaceTriangle(v[0], v[1], v[2]);
+				continue;
+			}
+
+			// Clip the triangle against the near plane (z = 0 as the depth range is [0, 1]), which results in a triangle or a quad
+			glm::vec4 polygon[4];
+			uint32_t vertexCount = 0;
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				const glm::vec4& a = v[j];
+				const glm::vec4& b = v[(j + 1) % 3];
+
+				if (a.z >= 0.0f)
+					polygon[vertexCount++] = a;
+				if ((a.z >= 0.0f) != (b.z >= 0.0f))
+					polygon[vertexCount++] = glm::mix(a, b, a.z / (a.z - b.z));
+			}
+
+			for (uint32_t j = 1; j + 1 < vertexCount; j++)
+				AddClipSpaceTriangle(polygon[0], polygon[j], polygon[j + 1]);
+		}
+	}
+
+	void SoftwareOcclusionCuller::AddClipSpaceTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+	{
+		if (v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f)
+			return;
+
+		const auto toScreenSpace = [](const glm::vec4& v)
+		{
+			return glm::vec3((v.x / v.w * 0.5f + 0.5f) * Width, (v.y / v.w * 0.5f + 0.5f) * Height, v.z / v.w);
+		};
+
+		m_Triangles.Add(toScreenSpace(v0), toScreenSpace(v1), toScreenSpace(v2));
+	}
+
+	void SoftwareOcclusionCuller::RasterizeOccluders(ThreadPool* threadPool)
+	{
+		FBY_PROFILE_SCOPE("SoftwareOcclusionCuller::RasterizeOccluders");
+
+		if (!m_Triangles.GetCount())
+			return;
+
+		constexpr uint32_t jobCount = (TileCountY + s_TileRowsPerJob - 1) / s_TileRowsPerJob;
+
+		if (threadPool && m_Triangles.GetCount() >= s_MinTriangleCountForParallelRasterization)
+		{
+			std::future<void> futures[jobCount];
+			for (uint32_t i = 0; i < jobCount; i++)
+			{
+				futures[i] = threadPool->Submit([this, i]()
+					{
+						RasterizeTileRows(i * s_TileRowsPerJob, std::min((i + 1) * s_TileRowsPerJob, TileCountY));
+					});
+			}
+
+			for (auto& future : futures)
+				future.wait();
+		}
+		else
+			RasterizeTileRows(0, TileCountY);
+	}
+
+	void SoftwareOcclusionCuller::RasterizeTileRows(uint32_t firstTileRow, uint32_t lastTileRow)
+	{
+		const int firstRow = (int)(firstTileRow * TileSize), lastRow = (int)(lastTileRow * TileSize);
+
+		for (uint32_t i = 0; i < m_Triangles.GetCount(); i++)
+		{
+			const float x0 = m_Triangles.X0[i], y0 = m_Triangles.Y0[i], z0 = m_Triangles.Z0[i];
+			const float x1 = m_Triangles.X1[i], y1 = m_Triangles.Y1[i], z1 = m_Triangles.Z1[i];
+			const float x2 = m_Triangles.X2[i], y2 = m_Triangles.Y2[i], z2 = m_Triangles.Z2[i];
+
+			// The pixel rows whose centers might be covered by the triangle
+			const int minY = std::max((int)std::floor(std::min({ y0, y1, y2 })), firstRow);
+			const int maxY = std::min((int)std::ceil(std::max({ y0, y1, y2 })), lastRow);
+			if (minY >= maxY)
+				continue;
+
+			// The columns are processed in groups of 4 pixels, the pixels of a group outside the triangle are rejected by the edge functions
+			const int minX = std::max((int)std::floor(std::min({ x0, x1, x2 })), 0) & ~3;
+			const int maxX = std::min((int)std::ceil(std::max({ x0, x1, x2 })), (int)Width);
+			if (minX >= maxX)
+				continue;
+
+			float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+			if (std::abs(area) < 1e-6f)
+				continue;
+
+			// Both the windings are rasterized, so the edge functions are flipped to be positive inside the triangle
+			const float orientation = area > 0.0f ? 1.0f : -1.0f;
+			area *= orientation;
+
+			// Edge function of the edge (a, b): (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x) = A * x + B * y + C
+			const float a0 = -(y1 - y0) * orientation, b0 = (x1 - x0) * orientation, c0 = -(a0 * x0 + b0 * y0);
+			const float a1 = -(y2 - y1) * orientation, b1 = (x2 - x1) * orientation, c1 = -(a1 * x1 + b1 * y1);
+			const float a2 = -(y0 - y2) * orientation, b2 = (x0 - x2) * orientation, c2 = -(a2 * x2 + b2 * y2);
+
+			// The depth after the perspective divide is linear in screen space
+			const float dzdx = ((z1 - z0) * (y2 - y0) - (z2 - z0) * (y1 - y0)) * orientation / area;
+			const float dzdy = ((z2 - z0) * (x1 - x0) - (z1 - z0) * (x2 - x0)) * orientation / area;
+			const float zc = z0 - dzdx * x0 - dzdy * y0;
+
+			for (int y = minY; y < maxY; y++)
+			{
+				const float py = (float)y + 0.5f;
+				float* depthRow = m_DepthBuffer.data() + y * Width;
+
+#ifdef FBY_OCCLUSION_CULLING_SSE
+				const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+				const __m128 zero = _mm_setzero_ps();
+
+				for (int x = minX; x < maxX; x += 4)
+				{
+					const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+
+					const __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), _mm_set1_ps(b0 * py + c0));
+					const __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), _mm_set1_ps(b1 * py + c1));
+					const __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), _mm_set1_ps(b2 * py + c2));
+
+					const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+					if (!_mm_movemask_ps(inside))
+						continue;
+
+					const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), px), _mm_set1_ps(dzdy * py + zc));
+					const __m128 depth = _mm_loadu_ps(depthRow + x);
+					const __m128 nearest = _mm_min_ps(depth, z);
+
+					_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, depth)));
+				}
+#else
+				for (int x = minX; x < maxX; x += 4)
+				{
+					for (int lane = 0; lane < 4; lane++)
+					{
+						const float px = (float)(x + lane) + 0.5f;
+						if (a0 * px + b0 * py + c0 < 0.0f || a1 * px + b1 * py + c1 < 0.0f || a2 * px + b2 * py + c2 < 0.0f)
+							continue;
+
+						const float z = dzdx * px + dzdy * py + zc;
+						depthRow[x + lane] = std::min(depthRow[x + lane], z);
+					}
+				}
+#endif
+			}
+		}
+
+		// Reduce the rows of pixels into the farthest depth of each tile
+		for (uint32_t tileY = firstTileRow; tileY < lastTileRow; tileY++)
+		{
+			for (uint32_t tileX = 0; tileX < TileCountX; tileX++)
+			{
+				float farthestDepth = 0.0f;
+				for (uint32_t y = tileY * TileSize; y < (tileY + 1) * TileSize; y++)
+				{
+					const float* depthRow = m_DepthBuffer.data() + y * Width + tileX * TileSize;
+					for (uint32_t x = 0; x < TileSize; x++)
+						farthestDepth = std::max(farthestDepth, depthRow[x]);
+				}
+				m_TileDepths[tileX + tileY * TileCountX] = farthestDepth;
+			}
+		}
+	}
+
+	bool SoftwareOcclusionCuller::IsAABBVisible(const glm::vec3& center, const glm::vec3& extent) const
+	{
+		glm::vec2 minScreen(std::numeric_limits<float>::max()), maxScreen(std::numeric_limits<float>::lowest());
+		float nearestDepth = std::numeric_limits<float>::max();
+
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			const glm::vec3 offset((corner & 1) ? extent.x : -extent.x, (corner & 2) ? extent.y : -extent.y, (corner & 4) ? extent.z : -extent.z);
+			const glm::vec4 clipSpaceCorner = m_ViewProjectionMatrix * glm::vec4(center + offset, 1.0f);
+
+			// The box intersecting the near plane can't be occluded
+			if (clipSpaceCorner.z < 0.0f || clipSpaceCorner.w <= 0.0f)
+				return true;
+
+			const glm::vec3 ndc = glm::vec3(clipSpaceCorner) / clipSpaceCorner.w;
+			const glm::vec2 screen = (glm::vec2(ndc) * 0.5f + 0.5f) * glm::vec2(Width, Height);
+
+			minScreen = glm::min(minScreen, screen);
+			maxScreen = glm::max(maxScreen, screen);
+			nearestDepth = std::min(nearestDepth, ndc.z);
+		}
+
+		// Every pixel touched by the projected rectangle of the box is considered
+		const int minX = std::max((int)std::floor(minScreen.x), 0), maxX = std::min((int)std::ceil(maxScreen.x), (int)Width);
+		const int minY = std::max((int)std::floor(minScreen.y), 0), maxY = std::min((int)std::ceil(maxScreen.y), (int)Height);
+		if (minX >= maxX || minY >= maxY)
+			return true;
+
+		for (int tileY = minY / (int)TileSize; tileY <= (maxY - 1) / (int)TileSize; tileY++)
+		{
+			for (int tileX = minX / (int)TileSize; tileX <= (maxX - 1) / (int)TileSize; tileX++)
+			{
+				// All the occluders of the tile are in front of the box
+				if (m_TileDepths[tileX + tileY * TileCountX] < nearestDepth)
+					continue;
+
+				// Otherwise the pixels of the tile covered by the box are tested individually
+				const int tileMinX = std::max(minX, tileX * (int)TileSize), tileMaxX = std::min(maxX, (tileX + 1) * (int)TileSize);
+				const int tileMinY = std::max(minY, tileY * (int)TileSize), tileMaxY = std::min(maxY, (tileY + 1) * (int)TileSize);
+
+				for (int y = tileMinY; y < tileMaxY; y++)
+				{
+					const float* depthRow = m_DepthBuffer.data() + y * Width;
+					for (int x = tileMinX; x < tileMaxX; x++)
+					{
+						if (depthRow[x] >= nearestDepth)
+							return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+
+	uint32_t SoftwareOcclusionCuller::CullOccludedAABBs(const AABBSoA& boxes, std::vector<uint64_t>& inOutVisibilityMask) const
+	{
+		FBY_PROFILE_SCOPE("SoftwareOcclusionCuller::CullOccludedAABBs");
+
+		uint32_t occludedCount = 0;
+		for (uint32_t i = 0; i < boxes.GetCount(); i++)
+		{
+			uint64_t& word = inOutVisibilityMask[i / 64];
+			const uint64_t bit = 1ull << (i % 64);
+			if (!(word & bit))
+				continue;
+
+			if (IsAABBVisible(glm::vec3(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]), glm::vec3(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i])))
+				continue;
+
+			word &= ~bit;
+			occludedCount++;
+		}
+		return occludedCount;
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.h"
+#include "Core/ThreadPool.h"
+
+namespace Flameberry {
+
+	// A low resolution depth buffer into which the occluders are rasterized on the CPU
+	// The bounding boxes of the submeshes are tested against it's hierarchical depth before they are drawn
+	// It doesn't depend upon the GPU, so it can be tested and benchmarked headless
+	class SoftwareOcclusionCuller
+	{
+	public:
+		static constexpr uint32_t Width = 256, Height = 128;
+		// Each tile stores the farthest depth of it's pixels, so that most of the occluded boxes are rejected without visiting the pixels
+		static constexpr uint32_t TileSize = 8, TileCountX = Width / TileSize, TileCountY = Height / TileSize;
+
+	public:
+		SoftwareOcclusionCuller();
+
+		// Clears the depth buffer and the occluders of the previous frame
+		void BeginFrame(const glm::mat4& viewProjectionMatrix);
+		// Transforms the triangles of the occluder into screen space, the triangles are clipped against the near plane
+		void AddOccluder(const glm::mat4& modelMatrix, const glm::vec3* positions, const uint32_t* indices, uint32_t indexCount);
+		// Rasterizes the occluders and builds the tile depths, the rows of tiles are distributed among the workers of the thread pool
+		void RasterizeOccluders(ThreadPool* threadPool);
+
+		// Tests a world space AABB in center/extent form against the hierarchical depth buffer
+		bool IsAABBVisible(const glm::vec3& center, const glm::vec3& extent) const;
+		// Clears the bits of the occluded boxes in a visibility mask written by `CullAABBs()` and returns the number of occluded boxes
+		uint32_t CullOccludedAABBs(const AABBSoA& boxes, std::vector<uint64_t>& inOutVisibilityMask) const;
+
+		uint32_t GetOccluderTriangleCount() const { return m_Triangles.GetCount(); }
+		// Row major depths of the pixels, 0 being the near plane and 1 being the far plane
+		const std::vector<float>& GetDepthBuffer() const { return m_DepthBuffer; }
+
+	private:
+		// Rasterizes all the triangles into the rows of tiles [firstTileRow, lastTileRow) and updates their tile depths
+		void RasterizeTileRows(uint32_t firstTileRow, uint32_t lastTileRow);
+		void AddClipSpaceTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+
+	private:
+		glm::mat4 m_ViewProjectionMatrix{ 1.0f };
+
+		// Screen space triangles, x and y are in pixels and z is the depth
+		struct TriangleSoA
+		{
+			std::vector<float> X0, Y0, Z0, X1, Y1, Z1, X2, Y2, Z2;
+
+			void Add(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+			void Clear();
+
+			uint32_t GetCount() const { return (uint32_t)X0.size(); }
+		} m_Triangles;
+
+		std::vector<float> m_DepthBuffer, m_TileDepths;
+	};
+
+} // namespace Flameberry
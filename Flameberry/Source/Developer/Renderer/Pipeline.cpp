@@ -2,8 +2,11 @@
 
 #include "RenderCommand.h"
 #include "VulkanContext.h"
+#include "PipelineCache.h"
+#include "PipelineBuilder.h"
 #include "Renderer/Renderer.h"
 
+#include "Core/Profiler.h"
 #include "VulkanDebug.h"
 
 namespace Flameberry {
@@ -129,36 +132,12 @@ namespace Flameberry {
 
 	static void PopulateVulkanDescriptorSetLayouts(std::vector<VkDescriptorSetLayout>& outVulkanDescriptorSetLayouts, std::vector<Ref<DescriptorSetLayout>>& outDescriptorSetLayouts, const Ref<Shader>& shader)
 	{
-		// Creating the Descriptor Set Layouts required for creating the Pipeline based on the Shader Reflection Data
-		const auto& reflectionDescriptorSets = shader->GetDescriptorSetSpecifications();
-		const auto& descriptorBindings = shader->GetDescriptorBindingSpecifications();
+		// The descriptor set layouts are created by the shader once it is loaded, based on the Shader Reflection Data
+		outDescriptorSetLayouts = shader->GetDescriptorSetLayouts();
 
-		std::vector<VkDescriptorSetLayoutBinding> vulkanDescSetBindings;
-		uint32_t index = 0;
-
-		for (const auto& reflectionDescSet : reflectionDescriptorSets)
-		{
-			vulkanDescSetBindings.reserve(reflectionDescSet.BindingCount);
-			for (uint32_t i = 0; i < reflectionDescSet.BindingCount; i++)
-			{
-				vulkanDescSetBindings.emplace_back(VkDescriptorSetLayoutBinding{
-					descriptorBindings[index].Binding,
-					descriptorBindings[index].Type,
-					descriptorBindings[index].Count,
-					descriptorBindings[index].VulkanShaderStage,
-					nullptr });
-				index++;
-			}
-
-			// Create or Get the Cached descriptor set layout
-			if (vulkanDescSetBindings.size())
-			{
-				DescriptorSetLayoutSpecification layoutSpecification{ vulkanDescSetBindings };
-				auto& layout = outDescriptorSetLayouts.emplace_back(DescriptorSetLayout::CreateOrGetCached(layoutSpecification));
-				outVulkanDescriptorSetLayouts.push_back(layout->GetLayout());
-				vulkanDescSetBindings.clear();
-			}
-		}
+		outVulkanDescriptorSetLayouts.reserve(outDescriptorSetLayouts.size());
+		for (const auto& layout : outDescriptorSetLayouts)
+			outVulkanDescriptorSetLayouts.push_back(layout->GetLayout());
 	}
 
 	static uint32_t PopulateVulkanSpecializationMapEntries(std::vector<VkSpecializationMapEntry>& outVulkanSpecializationMapEntries, const SpecializationConstantLayout& specializationConstantLayout, const Ref<Shader>& shader)
@@ -178,7 +157,7 @@ namespace Flameberry {
 					SizeOfShaderDataType(specializationConstant.Type),
 				});
 			}
-			offset += outVulkanSpecializationMapEntries.back().size;
+			offset += (uint32_t)SizeOfShaderDataType(specializationConstant.Type);
 		}
 		return offset;
 	}
@@ -186,10 +165,49 @@ namespace Flameberry {
 	Pipeline::Pipeline(const PipelineSpecification& pipelineSpec)
 		: m_Specification(pipelineSpec)
 	{
+		if (m_Specification.SpecializationConstantData)
+		{
+			uint32_t dataSize = 0;
+			for (const auto& specializationConstant : m_Specification.SpecializationConstantLayout)
+				dataSize += (uint32_t)SizeOfShaderDataType(specializationConstant.Type);
+
+			const uint8_t* data = (const uint8_t*)m_Specification.SpecializationConstantData;
+			m_SpecializationConstantData.assign(data, data + dataSize);
+			m_Specification.SpecializationConstantData = m_SpecializationConstantData.data();
+		}
+
 		CreatePipeline();
 	}
 
 	void Pipeline::CreatePipeline()
+	{
+		// The layout is needed right away by the callers binding the descriptor sets, and is cheap to create unlike the pipeline itself
+		CreatePipelineLayout();
+
+		m_IsReady.store(false, std::memory_order_relaxed);
+		m_ReadyFence = PipelineBuilder::Submit([this]()
+			{
+				BuildPipeline();
+				m_IsReady.store(true, std::memory_order_release);
+			});
+	}
+
+	void Pipeline::WaitUntilReady() const
+	{
+		if (!m_IsReady.load(std::memory_order_acquire))
+		{
+			FBY_PROFILE_SCOPE("Pipeline::WaitUntilReady");
+			m_ReadyFence.get();
+		}
+	}
+
+	VkPipeline Pipeline::GetVulkanPipeline() const
+	{
+		WaitUntilReady();
+		return m_GraphicsPipeline;
+	}
+
+	void Pipeline::CreatePipelineLayout()
 	{
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 
@@ -208,6 +226,11 @@ namespace Flameberry {
 		vk_pipeline_layout_create_info.pPushConstantRanges = vulkanPushConstantRanges.data();
 
 		VK_CHECK_RESULT(vkCreatePipelineLayout(device, &vk_pipeline_layout_create_info, nullptr, &m_PipelineLayout));
+	}
+
+	void Pipeline::BuildPipeline()
+	{
+		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 
 		// Creating Pipeline
 		VkShaderModule vertexModule, fragmentModule;
@@ -225,6 +248,20 @@ namespace Flameberry {
 		vk_pipeline_fragment_shader_stage_create_info.module = fragmentModule;
 		vk_pipeline_fragment_shader_stage_create_info.pName = "main";
 
+		std::vector<VkSpecializationMapEntry> vulkanSpecializationMapEntries;
+		VkSpecializationInfo specializationInfo{};
+		if (m_Specification.SpecializationConstantData)
+		{
+			specializationInfo.dataSize = PopulateVulkanSpecializationMapEntries(vulkanSpecializationMapEntries, m_Specification.SpecializationConstantLayout, m_Specification.Shader);
+			specializationInfo.mapEntryCount = (uint32_t)vulkanSpecializationMapEntries.size();
+			specializationInfo.pMapEntries = vulkanSpecializationMapEntries.data();
+			specializationInfo.pData = m_Specification.SpecializationConstantData;
+
+			// The entries whose constant ID is not present in a stage are ignored by that stage
+			vk_pipeline_vertex_shader_stage_create_info.pSpecializationInfo = &specializationInfo;
+			vk_pipeline_fragment_shader_stage_create_info.pSpecializationInfo = &specializationInfo;
+		}
+
 		VkPipelineShaderStageCreateInfo vk_shader_stages_create_infos[2] = { vk_pipeline_vertex_shader_stage_create_info, vk_pipeline_fragment_shader_stage_create_info };
 
 		VkPipelineColorBlendAttachmentState pipelineColorBlendAttachmentState{};
@@ -400,11 +437,13 @@ namespace Flameberry {
 		vk_graphics_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
 		vk_graphics_pipeline_create_info.basePipelineIndex = -1;
 
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &vk_graphics_pipeline_create_info, nullptr, &m_GraphicsPipeline));
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, PipelineCache::GetVulkanPipelineCache(), 1, &vk_graphics_pipeline_create_info, nullptr, &m_GraphicsPipeline));
 	}
 
 	void Pipeline::ReloadShaders()
 	{
+		WaitUntilReady();
+
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 		vkDestroyPipeline(device, m_GraphicsPipeline, nullptr);
 		vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
@@ -414,6 +453,9 @@ namespace Flameberry {
 
 	Pipeline::~Pipeline()
 	{
+		// The pipeline can't be destroyed while it is still being built
+		WaitUntilReady();
+
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 		vkDestroyPipeline(device, m_GraphicsPipeline, nullptr);
 		vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
@@ -462,7 +504,7 @@ namespace Flameberry {
 		computePipelineCreateInfo.layout = m_PipelineLayout;
 		computePipelineCreateInfo.stage = pipelineComputeShaderStageCreateInfo;
 
-		VK_CHECK_RESULT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr, &m_ComputePipeline));
+		VK_CHECK_RESULT(vkCreateComputePipelines(device, PipelineCache::GetVulkanPipelineCache(), 1, &computePipelineCreateInfo, nullptr, &m_ComputePipeline));
 	}
 
 	ComputePipeline::~ComputePipeline()
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <future>
 #include <vulkan/vulkan.h>
 
 #include "RenderPass.h"
@@ -28,8 +30,9 @@ namespace Flameberry {
 		// And for those that don't need to be used in the shader replace them with the equivalent Dummy Types
 		VertexInputLayout VertexLayout;
 
+		// Applied to both the vertex and the fragment stage, the data is copied by the pipeline
 		SpecializationConstantLayout SpecializationConstantLayout;
-		void* SpecializationConstantData = nullptr;
+		const void* SpecializationConstantData = nullptr;
 
 		uint32_t SubPass = 0;
 		uint32_t Samples = 1;
@@ -53,18 +56,31 @@ namespace Flameberry {
 
 		const PipelineSpecification& GetSpecification() const { return m_Specification; }
 		VkPipelineLayout GetVulkanPipelineLayout() const { return m_PipelineLayout; }
-		VkPipeline GetVulkanPipeline() const { return m_GraphicsPipeline; }
+		// The pipeline is built on a worker thread, this blocks until it is ready when it is used for the first time
+		VkPipeline GetVulkanPipeline() const;
+		bool IsReady() const { return m_IsReady.load(std::memory_order_acquire); }
 
 		void ReloadShaders();
 
 	private:
 		void CreatePipeline();
+		void CreatePipelineLayout();
+		// Runs on the pipeline builder threads
+		void BuildPipeline();
+		void WaitUntilReady() const;
 
 	private:
 		PipelineSpecification m_Specification;
-		VkPipeline m_GraphicsPipeline;
+		VkPipeline m_GraphicsPipeline = VK_NULL_HANDLE;
 		VkPipelineLayout m_PipelineLayout;
 
+		std::shared_future<void> m_ReadyFence;
+		// Avoids waiting on the fence once the pipeline is known to be built
+		std::atomic<bool> m_IsReady{ false };
+
+		// Owned copy of the specialization constant data, as the pipeline is built after the constructor returns
+		std::vector<uint8_t> m_SpecializationConstantData;
+
 		std::vector<Ref<DescriptorSetLayout>> m_DescriptorSetLayouts;
 	};
 
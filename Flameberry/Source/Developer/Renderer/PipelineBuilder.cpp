@@ -0,0 +1,31 @@
+#include "PipelineBuilder.h"
+
+#include <thread>
+#include <algorithm>
+
+namespace Flameberry {
+
+	Unique<ThreadPool> PipelineBuilder::s_ThreadPool;
+
+	void PipelineBuilder::Init()
+	{
+		// The main thread mostly waits for the builds at startup, hence a worker is used per core except for the main thread
+		const uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+		const uint32_t workerCount = std::clamp(hardwareThreadCount > 1 ? hardwareThreadCount - 1 : 1u, 1u, 8u);
+		s_ThreadPool = CreateUnique<ThreadPool>(workerCount);
+
+		FBY_INFO("Created {} worker threads for building shaders and pipelines", workerCount);
+	}
+
+	void PipelineBuilder::Shutdown()
+	{
+		// The thread pool finishes the remaining jobs before joining the workers
+		s_ThreadPool = nullptr;
+	}
+
+	std::shared_future<void> PipelineBuilder::Submit(const ThreadPool::Job& job)
+	{
+		return s_ThreadPool->Submit(job).share();
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <future>
+
+#include "Core/Core.h"
+#include "Core/ThreadPool.h"
+
+namespace Flameberry {
+
+	// Runs the costly parts of creating the shaders and the graphics pipelines on worker threads, so that they are created in parallel at startup
+	// The jobs return a `std::shared_future` which is waited on only when the shader or the pipeline is used for the first time
+	// All the pipelines share the engine wide pipeline cache, which is internally synchronized by the driver
+	class PipelineBuilder
+	{
+	public:
+		static void Init();
+		// Waits for the queued jobs to finish
+		static void Shutdown();
+
+		static std::shared_future<void> Submit(const ThreadPool::Job& job);
+
+	private:
+		static Unique<ThreadPool> s_ThreadPool;
+	};
+
+} // namespace Flameberry
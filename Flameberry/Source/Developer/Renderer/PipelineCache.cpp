@@ -0,0 +1,229 @@
+#include "PipelineCache.h"
+
+#include <fstream>
+#include <cstring>
+#include <fmt/format.h>
+
+#include "Core/Core.h"
+#include "Core/Timer.h"
+#include "Core/Algorithm.h"
+#include "VulkanDebug.h"
+#include "VulkanContext.h"
+
+namespace Flameberry {
+
+	namespace Utils {
+
+		// 'FBPC'
+		static constexpr uint32_t s_PipelineCacheMagic = 0x43504246;
+		static constexpr uint32_t s_PipelineCacheVersion = 1;
+
+		// Written before the cache data returned by the driver
+		struct PipelineCacheFileHeader
+		{
+			uint32_t Magic, Version;
+			uint32_t VendorID, DeviceID, DriverVersion;
+			uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+			uint64_t DataSize, DataHash;
+		};
+
+	} // namespace Utils
+
+	std::atomic<VkPipelineCache> PipelineCache::s_PipelineCache = VK_NULL_HANDLE;
+	std::vector<VkPipelineCache> PipelineCache::s_ReplacedPipelineCaches;
+	std::filesystem::path PipelineCache::s_CacheFilePath;
+	bool PipelineCache::s_IsLoadedFromDisk = false;
+
+	void PipelineCache::Init()
+	{
+		VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+		pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		VK_CHECK_RESULT(vkCreatePipelineCache(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), &pipelineCacheCreateInfo, nullptr, &pipelineCache));
+		s_PipelineCache.store(pipelineCache, std::memory_order_release);
+	}
+
+	void PipelineCache::Shutdown()
+	{
+		SaveProjectCache();
+
+		const auto device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+		for (VkPipelineCache pipelineCache : s_ReplacedPipelineCaches)
+			vkDestroyPipelineCache(device, pipelineCache, nullptr);
+
+		vkDestroyPipelineCache(device, s_PipelineCache.load(), nullptr);
+		s_PipelineCache.store(VK_NULL_HANDLE);
+		s_ReplacedPipelineCaches.clear();
+	}
+
+	void PipelineCache::LoadProjectCache(const std::filesystem::path& cacheDirectory)
+	{
+		Timer timer;
+
+		const auto device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+		const VkPhysicalDeviceProperties properties = VulkanContext::GetPhysicalDeviceProperties();
+
+		s_CacheFilePath = GetCacheFilePath(cacheDirectory, properties);
+		s_IsLoadedFromDisk = false;
+
+		const std::vector<uint8_t> cacheData = LoadCacheData(s_CacheFilePath, properties);
+		if (cacheData.empty())
+		{
+			FBY_INFO("No valid pipeline cache found at '{}', the pipelines will be compiled from scratch", s_CacheFilePath.string());
+			return;
+		}
+
+		VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+		pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		pipelineCacheCreateInfo.initialDataSize = cacheData.size();
+		pipelineCacheCreateInfo.pInitialData = cacheData.data();
+
+		// The driver can still reject the data, in which case the current cache is kept
+		VkPipelineCache projectPipelineCache = VK_NULL_HANDLE;
+		if (vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &projectPipelineCache) != VK_SUCCESS)
+		{
+			FBY_WARN("Discarding pipeline cache '{}': The driver rejected the data", s_CacheFilePath.string());
+			return;
+		}
+
+		// The current cache is merged into the new one instead of the other way around, as only the destination of a merge has to be externally synchronized
+		const VkPipelineCache currentPipelineCache = s_PipelineCache.load(std::memory_order_acquire);
+		VK_CHECK_RESULT(vkMergePipelineCaches(device, projectPipelineCache, 1, &currentPipelineCache));
+
+		s_ReplacedPipelineCaches.push_back(currentPipelineCache);
+		s_PipelineCache.store(projectPipelineCache, std::memory_order_release);
+		s_IsLoadedFromDisk = true;
+
+		FBY_INFO("Loaded pipeline cache of {} bytes from '{}' in {} ms", cacheData.size(), s_CacheFilePath.string(), timer.GetTimeEllapsedMilliseconds());
+	}
+
+	void PipelineCache::SaveProjectCache()
+	{
+		if (s_CacheFilePath.empty())
+			return;
+
+		SaveCacheData(s_CacheFilePath, VulkanContext::GetPhysicalDeviceProperties());
+		s_CacheFilePath.clear();
+		s_IsLoadedFromDisk = false;
+	}
+
+	std::vector<uint8_t> PipelineCache::LoadCacheData(const std::filesystem::path& path, const VkPhysicalDeviceProperties& properties)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return {};
+
+		const size_t fileSize = (size_t)file.tellg();
+		if (fileSize < sizeof(Utils::PipelineCacheFileHeader))
+		{
+			FBY_WARN("Discarding pipeline cache '{}': File is too small", path.string());
+			return {};
+		}
+
+		Utils::PipelineCacheFileHeader header;
+		file.seekg(0);
+		file.read((char*)&header, sizeof(Utils::PipelineCacheFileHeader));
+
+		if (header.Magic != Utils::s_PipelineCacheMagic || header.Version != Utils::s_PipelineCacheVersion)
+		{
+			FBY_WARN("Discarding pipeline cache '{}': Unknown file format", path.string());
+			return {};
+		}
+
+		if (header.VendorID != properties.vendorID || header.DeviceID != properties.deviceID || header.DriverVersion != properties.driverVersion
+			|| memcmp(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			FBY_INFO("Discarding pipeline cache '{}': It was created by a different device or driver", path.string());
+			return {};
+		}
+
+		if (header.DataSize != fileSize - sizeof(Utils::PipelineCacheFileHeader))
+		{
+			FBY_WARN("Discarding pipeline cache '{}': File is truncated", path.string());
+			return {};
+		}
+
+		std::vector<uint8_t> data(header.DataSize);
+		file.read((char*)data.data(), data.size());
+
+		if (!file || Algorithm::HashFNV1a64(data.data(), data.size()) != header.DataHash)
+		{
+			FBY_WARN("Discarding pipeline cache '{}': File is corrupted", path.string());
+			return {};
+		}
+
+		// The header of the driver's data is checked too, the layout of `VkPipelineCacheHeaderVersionOne` being fixed by the spec
+		VkPipelineCacheHeaderVersionOne driverHeader;
+		if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+			return {};
+
+		memcpy(&driverHeader, data.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+		if (driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || driverHeader.vendorID != properties.vendorID || driverHeader.deviceID != properties.deviceID
+			|| memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			FBY_WARN("Discarding pipeline cache '{}': The driver cache header doesn't match the device", path.string());
+			return {};
+		}
+
+		return data;
+	}
+
+	void PipelineCache::SaveCacheData(const std::filesystem::path& path, const VkPhysicalDeviceProperties& properties)
+	{
+		const auto device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+
+		size_t dataSize = 0;
+		const VkPipelineCache pipelineCache = s_PipelineCache.load(std::memory_order_acquire);
+		VK_CHECK_RESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr));
+
+		std::vector<uint8_t> data(dataSize);
+		VK_CHECK_RESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()));
+		data.resize(dataSize);
+
+		Utils::PipelineCacheFileHeader header;
+		header.Magic = Utils::s_PipelineCacheMagic;
+		header.Version = Utils::s_PipelineCacheVersion;
+		header.VendorID = properties.vendorID;
+		header.DeviceID = properties.deviceID;
+		header.DriverVersion = properties.driverVersion;
+		memcpy(header.PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.DataSize = data.size();
+		header.DataHash = Algorithm::HashFNV1a64(data.data(), data.size());
+
+		std::error_code error;
+		std::filesystem::create_directories(path.parent_path(), error);
+
+		// Written to a temporary file first, so that a crash while saving doesn't leave a truncated cache behind
+		auto temporaryPath = path;
+		temporaryPath += ".tmp";
+
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				FBY_WARN("Failed to save pipeline cache to '{}'", temporaryPath.string());
+				return;
+			}
+
+			file.write((const char*)&header, sizeof(Utils::PipelineCacheFileHeader));
+			file.write((const char*)data.data(), data.size());
+		}
+
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			FBY_WARN("Failed to save pipeline cache to '{}': {}", path.string(), error.message());
+			return;
+		}
+
+		FBY_INFO("Saved pipeline cache of {} bytes to '{}'", data.size(), path.string());
+	}
+
+	std::filesystem::path PipelineCache::GetCacheFilePath(const std::filesystem::path& cacheDirectory, const VkPhysicalDeviceProperties& properties)
+	{
+		// Every device gets a cache file of it's own, so that switching between the GPUs doesn't invalidate the cache
+		return cacheDirectory / fmt::format("PipelineCache_{:04x}_{:04x}.bin", properties.vendorID, properties.deviceID);
+	}
+
+} // namespace Flameberry
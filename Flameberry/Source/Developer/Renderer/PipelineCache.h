@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <filesystem>
+#include <vulkan/vulkan.h>
+
+namespace Flameberry {
+
+	// The engine wide `VkPipelineCache` used to create all the graphics and compute pipelines
+	// It is loaded from the cache directory of the project when the project is activated and saved when it is deactivated, so that the driver doesn't recompile the pipelines every launch
+	// The cache file is keyed by the device and the driver version, as the cache data of the driver is invalid for any other device or driver
+	class PipelineCache
+	{
+	public:
+		// Creates an empty cache, which is used until a project is activated
+		static void Init();
+		// Saves the cache data of the active project and destroys the caches
+		static void Shutdown();
+
+		// Replaces the cache by the one loaded from the directory, merged with the pipelines cached so far
+		static void LoadProjectCache(const std::filesystem::path& cacheDirectory);
+		// Saves the cache data to the directory it was loaded from, if any
+		static void SaveProjectCache();
+
+		static VkPipelineCache GetVulkanPipelineCache() { return s_PipelineCache.load(std::memory_order_acquire); }
+		// Whether valid cache data was found on disk for the active project
+		static bool IsLoadedFromDisk() { return s_IsLoadedFromDisk; }
+
+	private:
+		// Returns the cache data when the file exists and was created by the same device and driver, otherwise returns an empty vector
+		static std::vector<uint8_t> LoadCacheData(const std::filesystem::path& path, const VkPhysicalDeviceProperties& properties);
+		static void SaveCacheData(const std::filesystem::path& path, const VkPhysicalDeviceProperties& properties);
+		static std::filesystem::path GetCacheFilePath(const std::filesystem::path& cacheDirectory, const VkPhysicalDeviceProperties& properties);
+
+	private:
+		static std::atomic<VkPipelineCache> s_PipelineCache;
+		// The replaced caches may still be used by the pipeline builder threads, hence they are destroyed only at shutdown
+		static std::vector<VkPipelineCache> s_ReplacedPipelineCaches;
+		static std::filesystem::path s_CacheFilePath;
+		static bool s_IsLoadedFromDisk;
+	};
+
+} // namespace Flameberry
@@ -0,0 +1,45 @@
+#include "PipelinePermutationCache.h"
+
+namespace Flameberry {
+
+	PipelinePermutationCache::PipelinePermutationCache(const PipelineSpecification& pipelineSpec, uint32_t featureCount, uint32_t defaultFeatureBits, uint32_t firstConstantID)
+		: m_Specification(pipelineSpec), m_FeatureCount(featureCount)
+	{
+		FBY_ASSERT(featureCount <= 32, "A pipeline can have at most 32 feature bits, but {} were requested", featureCount);
+
+		// The boolean specialization constants are 32 bit wide, i.e. `VkBool32`
+		m_Specification.SpecializationConstantLayout.clear();
+		for (uint32_t i = 0; i < featureCount; i++)
+			m_Specification.SpecializationConstantLayout.push_back({ firstConstantID + i, ShaderDataType::UInt });
+
+		GetOrCreateVariantIndex(defaultFeatureBits);
+	}
+
+	uint32_t PipelinePermutationCache::GetOrCreateVariantIndex(uint32_t featureBits)
+	{
+		if (const auto it = m_FeatureBitsToVariantIndex.find(featureBits); it != m_FeatureBitsToVariantIndex.end())
+			return it->second;
+
+		std::vector<VkBool32> constants(m_FeatureCount);
+		for (uint32_t i = 0; i < m_FeatureCount; i++)
+			constants[i] = (featureBits >> i) & 1u;
+
+		// The pipeline copies the specialization constant data before it is built
+		PipelineSpecification variantSpec = m_Specification;
+		variantSpec.SpecializationConstantData = constants.data();
+
+		const uint32_t variantIndex = (uint32_t)m_Variants.size();
+		m_Variants.emplace_back(CreateRef<Pipeline>(variantSpec));
+		m_FeatureBitsToVariantIndex[featureBits] = variantIndex;
+
+		FBY_TRACE("Created variant {} of pipeline with shader '{}' for the feature bits: {:#x}", variantIndex, m_Specification.Shader->GetName(), featureBits);
+		return variantIndex;
+	}
+
+	void PipelinePermutationCache::ReloadShaders()
+	{
+		for (auto& variant : m_Variants)
+			variant->ReloadShaders();
+	}
+
+} // namespace Flameberry
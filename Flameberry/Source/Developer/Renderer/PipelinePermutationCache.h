@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "Core/Core.h"
+#include "Pipeline.h"
+
+namespace Flameberry {
+
+	// Builds the variants of a pipeline which differ only by a set of boolean specialization constants, called the feature bits
+	// The bit `i` of the feature bits is the value of the specialization constant with the ID `FirstConstantID + i`
+	// This lets the shader branch on the features at compile time, instead of on uniforms or push constants for every fragment
+	// The variants are created lazily when they are requested for the first time, and are built on the pipeline builder threads
+	class PipelinePermutationCache
+	{
+	public:
+		// The variant with the `defaultFeatureBits` is created right away, so that the pipeline layout is available before any draw is recorded
+		PipelinePermutationCache(const PipelineSpecification& pipelineSpec, uint32_t featureCount, uint32_t defaultFeatureBits, uint32_t firstConstantID = 0);
+
+		// Returns the index of the variant in the order of creation, which is small enough to be packed into the draw sort keys
+		uint32_t GetOrCreateVariantIndex(uint32_t featureBits);
+		const Ref<Pipeline>& GetVariant(uint32_t variantIndex) const { return m_Variants[variantIndex]; }
+		uint32_t GetVariantCount() const { return (uint32_t)m_Variants.size(); }
+
+		// All the variants are created from the same shader, hence their pipeline layouts are compatible with each other
+		VkPipelineLayout GetVulkanPipelineLayout() const { return m_Variants[0]->GetVulkanPipelineLayout(); }
+
+		void ReloadShaders();
+
+	private:
+		PipelineSpecification m_Specification;
+		uint32_t m_FeatureCount;
+
+		std::vector<Ref<Pipeline>> m_Variants;
+		std::unordered_map<uint32_t, uint32_t> m_FeatureBitsToVariantIndex;
+	};
+
+} // namespace Flameberry
@@ -22,12 +22,11 @@ namespace Flameberry {
 			|| format == VK_FORMAT_D32_SFLOAT_S8_UINT;
 	}
 
-	void RenderCommand::WritePixelFromImageToBuffer(VkBuffer buffer, VkImage image, VkImageLayout currentImageLayout, const glm::vec2& pixelOffset)
+	OneShotSubmission RenderCommand::WritePixelFromImageToBuffer(VkBuffer buffer, VkImage image, VkImageLayout currentImageLayout, const glm::vec2& pixelOffset)
 	{
 		const auto& device = VulkanContext::GetCurrentDevice();
 
-		VkCommandBuffer commandBuffer;
-		device->BeginSingleTimeCommandBuffer(commandBuffer);
+		VkCommandBuffer commandBuffer = device->BeginOneShotCommandBuffer();
 		{
 			VkPipelineStageFlags sourceStageFlags;
 			VkPipelineStageFlags destinationStageFlags;
@@ -92,7 +91,15 @@ namespace Flameberry {
 
 			vkCmdPipelineBarrier(commandBuffer, sourceStageFlags, destinationStageFlags, 0, 0, nullptr, 0, nullptr, 1, &vk_image_memory_barrier);
 		}
-		device->EndSingleTimeCommandBuffer(commandBuffer);
+
+		// Make the copied pixel visible to the host once the submission completes
+		VkMemoryBarrier hostReadBarrier{};
+		hostReadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostReadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostReadBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostReadBarrier, 0, nullptr, 0, nullptr);
+		return device->SubmitOneShot(commandBuffer);
 	}
 
 	void RenderCommand::SetViewport(float x, float y, float width, float height)
@@ -123,19 +130,18 @@ namespace Flameberry {
 			});
 	}
 
-	void RenderCommand::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize)
+	OneShotSubmission RenderCommand::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
 	{
 		const auto& device = VulkanContext::GetCurrentDevice();
 
-		VkCommandBuffer commandBuffer;
-		device->BeginSingleTimeCommandBuffer(commandBuffer);
+		VkCommandBuffer commandBuffer = device->BeginOneShotCommandBuffer();
 		VkBufferCopy vk_buffer_copy_info{};
-		vk_buffer_copy_info.srcOffset = 0;
-		vk_buffer_copy_info.dstOffset = 0;
+		vk_buffer_copy_info.srcOffset = srcOffset;
+		vk_buffer_copy_info.dstOffset = dstOffset;
 		vk_buffer_copy_info.size = bufferSize;
 
 		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &vk_buffer_copy_info);
-		device->EndSingleTimeCommandBuffer(commandBuffer);
+		return device->SubmitOneShot(commandBuffer);
 	}
 
 	VkShaderModule RenderCommand::CreateShaderModule(const std::vector<char>& compiledShaderCode)
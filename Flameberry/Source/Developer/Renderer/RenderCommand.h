@@ -8,6 +8,7 @@
 namespace Flameberry {
 
 	struct QueueFamilyIndices;
+	struct OneShotSubmission;
 
 	struct SwapChainDetails
 	{
@@ -20,10 +21,11 @@ namespace Flameberry {
 	{
 	public:
 		static bool DoesFormatSupportDepthAttachment(VkFormat format);
-		static void WritePixelFromImageToBuffer(VkBuffer buffer, VkImage image, VkImageLayout currentImageLayout, const glm::vec2& pixelOffset);
+		// The copies are submitted without waiting for them, the buffer is to be read by the host only once the submission completes
+		static OneShotSubmission WritePixelFromImageToBuffer(VkBuffer buffer, VkImage image, VkImageLayout currentImageLayout, const glm::vec2& pixelOffset);
 		static void SetViewport(float x, float y, float width, float height);
 		static void SetScissor(VkOffset2D offset, VkExtent2D extent);
-		static void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize);
+		static OneShotSubmission CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
 		static VkShaderModule CreateShaderModule(const std::vector<char>& compiledShaderCode);
 		static VkSampleCountFlagBits GetMaxUsableSampleCount(VkPhysicalDevice physicalDevice);
 		static uint32_t GetValidMemoryTypeIndex(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags vk_memory_property_flags);
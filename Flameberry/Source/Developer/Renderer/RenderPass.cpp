@@ -22,7 +22,9 @@ namespace Flameberry {
 			FBY_ASSERT(spec.Samples == m_RenderPassSpec.TargetFramebuffers[0]->GetSpecification().Samples, "Framebuffers having different sample count must not be provided to single RenderPass!");
 		}
 
-		const auto& framebufferSpec = m_RenderPassSpec.TargetFramebuffers[0]->GetSpecification();
+		auto framebufferSpec = m_RenderPassSpec.TargetFramebuffers[0]->GetSpecification();
+		if (m_RenderPassSpec.DepthLoadOp)
+			framebufferSpec.DepthLoadOp = *m_RenderPassSpec.DepthLoadOp;
 
 		if (!m_RenderPassSpec.Dependencies.size())
 		{
@@ -112,6 +114,10 @@ namespace Flameberry {
 				attachments[i].storeOp = framebufferSpec.DepthStoreOp;
 				attachments[i].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
+				// The contents of a loaded depth attachment are preserved only if it's layout is defined, it is expected to be transitioned before the pass
+				if (framebufferSpec.DepthLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+					attachments[i].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
 				depthRef.attachment = i;
 				depthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 			}
@@ -187,13 +193,16 @@ namespace Flameberry {
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 		VK_CHECK_RESULT(vkCreateRenderPass(device, &vk_render_pass_create_info, nullptr, &m_VkRenderPass));
 
-		for (auto& framebuffer : m_RenderPassSpec.TargetFramebuffers)
-			framebuffer->CreateVulkanFramebuffer(m_VkRenderPass);
+		if (!m_RenderPassSpec.DepthLoadOp)
+		{
+			for (auto& framebuffer : m_RenderPassSpec.TargetFramebuffers)
+				framebuffer->CreateVulkanFramebuffer(m_VkRenderPass);
+		}
 	}
 
-	void RenderPass::Begin(uint32_t framebufferInstance, VkOffset2D renderAreaOffset, VkExtent2D renderAreaExtent)
+	void RenderPass::Begin(uint32_t framebufferInstance, VkOffset2D renderAreaOffset, VkExtent2D renderAreaExtent, VkSubpassContents subpassContents)
 	{
-		Renderer::Submit([renderPass = this, framebufferInstance, renderAreaOffset, renderAreaExtent](VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
+		Renderer::Submit([renderPass = this, framebufferInstance, renderAreaOffset, renderAreaExtent, subpassContents](VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
 			uint32_t index = (framebufferInstance == -1) ? imageIndex : framebufferInstance;
 			const auto& framebufferSpec = renderPass->m_RenderPassSpec.TargetFramebuffers[index]->GetSpecification();
 
@@ -224,7 +233,7 @@ namespace Flameberry {
 			vk_render_pass_begin_info.clearValueCount = static_cast<uint32_t>(clearValues.size());
 			vk_render_pass_begin_info.pClearValues = clearValues.data();
 
-			vkCmdBeginRenderPass(cmdBuffer, &vk_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBeginRenderPass(cmdBuffer, &vk_render_pass_begin_info, subpassContents);
 		});
 	}
 
@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <optional>
 
 #include "Framebuffer.h"
 
@@ -11,6 +12,9 @@ namespace Flameberry {
 	{
 		std::vector<Ref<Framebuffer>> TargetFramebuffers;
 		std::vector<VkSubpassDependency> Dependencies;
+		// Overrides the load operation of the depth attachment specified by the framebuffers
+		// The framebuffers are expected to be created by a compatible render pass already, which they are shared with
+		std::optional<VkAttachmentLoadOp> DepthLoadOp;
 	};
 
 	class RenderPass
@@ -19,7 +23,8 @@ namespace Flameberry {
 		RenderPass(const RenderPassSpecification& specification);
 		~RenderPass();
 
-		void Begin(uint32_t framebufferInstance = -1, VkOffset2D renderAreaOffset = { 0, 0 }, VkExtent2D renderAreaExtent = { 0, 0 });
+		// Use `VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS` when all the commands of the pass are submitted using `Renderer::BeginCommandList()`
+		void Begin(uint32_t framebufferInstance = -1, VkOffset2D renderAreaOffset = { 0, 0 }, VkExtent2D renderAreaExtent = { 0, 0 }, VkSubpassContents subpassContents = VK_SUBPASS_CONTENTS_INLINE);
 		void End();
 
 		RenderPassSpecification GetSpecification() const { return m_RenderPassSpec; }
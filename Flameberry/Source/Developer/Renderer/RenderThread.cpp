@@ -0,0 +1,87 @@
+#include "RenderThread.h"
+
+#include "Core/Core.h"
+#include "Core/Profiler.h"
+
+namespace Flameberry {
+
+	void RenderThread::Run(const std::function<void()>& renderFunction)
+	{
+		FBY_ASSERT(!m_IsRunning, "Render Thread is already running!");
+
+		m_RenderFunction = renderFunction;
+		m_State = State::Idle;
+		m_IsRunning = true;
+		m_Thread = std::thread(&RenderThread::ThreadLoop, this);
+
+		FBY_INFO("Started Render Thread");
+	}
+
+	void RenderThread::Terminate()
+	{
+		if (!m_IsRunning)
+			return;
+
+		// Let the last kicked frame finish before the thread is asked to exit
+		BlockUntilRenderComplete();
+
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			m_IsRunning = false;
+		}
+		m_ConditionVariable.notify_all();
+
+		if (m_Thread.joinable())
+			m_Thread.join();
+
+		FBY_INFO("Terminated Render Thread");
+	}
+
+	void RenderThread::Kick()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m_Mutex);
+			FBY_ASSERT(m_State == State::Idle, "Render Thread was kicked while it was still rendering the previous frame!");
+			m_State = State::Kicked;
+		}
+		m_ConditionVariable.notify_all();
+	}
+
+	void RenderThread::BlockUntilRenderComplete()
+	{
+		FBY_PROFILE_SCOPE("RenderThread::BlockUntilRenderComplete");
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_ConditionVariable.wait(lock, [this] { return m_State == State::Idle; });
+	}
+
+	void RenderThread::ThreadLoop()
+	{
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_ConditionVariable.wait(lock, [this] { return m_State == State::Kicked || !m_IsRunning; });
+
+				if (!m_IsRunning)
+					break;
+
+				m_State = State::Busy;
+			}
+
+			m_RenderFunction();
+
+			{
+				std::scoped_lock<std::mutex> lock(m_Mutex);
+				m_State = State::Idle;
+			}
+			m_ConditionVariable.notify_all();
+		}
+	}
+
+	RenderThread::~RenderThread()
+	{
+		Terminate();
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Flameberry {
+
+	// The Render Thread executes the render commands of frame N while the main thread builds frame N + 1
+	// The handshake between the two threads is a simple state machine guarded by a mutex and a condition variable
+	class RenderThread
+	{
+	public:
+		enum class State : uint8_t
+		{
+			Idle = 0,
+			Kicked,
+			Busy
+		};
+
+	public:
+		RenderThread() = default;
+		~RenderThread();
+
+		// Spawns the render thread which runs `renderFunction` every time it is kicked
+		void Run(const std::function<void()>& renderFunction);
+		void Terminate();
+
+		// Called by the main thread to hand over a frame to the render thread
+		void Kick();
+		// Called by the main thread to block until the render thread has finished rendering the kicked frame
+		void BlockUntilRenderComplete();
+
+		bool IsRunning() const { return m_IsRunning; }
+
+	private:
+		void ThreadLoop();
+
+	private:
+		std::thread m_Thread;
+		std::mutex m_Mutex;
+		std::condition_variable m_ConditionVariable;
+
+		std::function<void()> m_RenderFunction;
+		State m_State = State::Idle;
+		bool m_IsRunning = false;
+	};
+
+} // namespace Flameberry
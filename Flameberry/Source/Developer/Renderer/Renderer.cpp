@@ -1,11 +1,13 @@
 #include "Renderer.h"
 
+#include <algorithm>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Asset/Importers/TextureImporter.h"
 #include "Core/Application.h"
 #include "Core/Core.h"
 #include "Core/Profiler.h"
+#include "Core/Timer.h"
 
 #include "VulkanContext.h"
 #include "Asset/AssetManager.h"
@@ -15,31 +17,75 @@
 #include "MaterialAsset.h"
 #include "Skymap.h"
 #include "Font.h"
-
-// #define FBY_ENABLE_QUERY_TIMESTAMP
+#include "GeometryArena.h"
+#include "UploadManager.h"
+#include "UniformRing.h"
+#include "TextureTable.h"
+#include "MaterialParameterBuffer.h"
+#include "PipelineCache.h"
+#include "PipelineBuilder.h"
+#include "GPUProfiler.h"
 
 namespace Flameberry {
 
-	std::vector<Renderer::Command> Renderer::s_CommandQueue;
+	std::array<std::vector<Renderer::Command>, Renderer::s_CommandQueueCount> Renderer::s_CommandQueues;
+	uint32_t Renderer::s_CommandQueueSubmissionIndex = 0, Renderer::s_RT_CommandQueueIndex = 0;
+	std::vector<Renderer::Command>* Renderer::s_ActiveCommandQueue = &Renderer::s_CommandQueues[0];
+	RenderThread Renderer::s_RenderThread;
+
+	std::array<std::vector<Renderer::CommandList>, Renderer::s_CommandQueueCount> Renderer::s_CommandLists;
+	std::array<std::vector<Renderer::SecondaryCommandBuffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> Renderer::s_RT_SecondaryCommandBuffers;
+	std::vector<std::future<void>> Renderer::s_RT_CommandListRecordingFutures;
+	Unique<ThreadPool> Renderer::s_CommandListRecordingThreadPool;
+	bool Renderer::s_IsSwapChainImageAcquired = false, Renderer::s_IsLastFrameDropped = false;
+	std::array<Unique<DescriptorAllocator>, SwapChain::MAX_FRAMES_IN_FLIGHT> Renderer::s_TransientDescriptorAllocators;
+
 	uint32_t Renderer::s_RT_FrameIndex = 0, Renderer::s_FrameIndex = 0;
-	RendererFrameStats Renderer::s_RendererFrameStats;
+	uint64_t Renderer::s_FrameNumber = 0;
+	RendererFrameStats Renderer::s_RendererFrameStats, Renderer::s_RT_RendererFrameStats;
+	thread_local RendererFrameStats Renderer::s_RT_LocalFrameStats;
+	std::mutex Renderer::s_RendererFrameStatsMutex;
+	VkCommandPool Renderer::s_CommandPool;
 	std::array<Ref<CommandBuffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> Renderer::s_CommandBuffers;
 
-	VkQueryPool Renderer::s_QueryPool;
-	std::array<uint64_t, 4 * SwapChain::MAX_FRAMES_IN_FLIGHT> Renderer::s_Timestamps;
 	Ref<Texture2D> Renderer::s_CheckerboardTexture;
 
 	void Renderer::Init()
 	{
+		Timer timer;
+
+		// Has to be created before any of the pipelines
+		PipelineCache::Init();
+		PipelineBuilder::Init();
+		UploadManager::Init();
+		UniformRing::Init();
+		// Has to be created before any of the materials
+		MaterialParameterBuffer::Init();
+
+		// The transient sets are never freed individually, the pools are only reset
+		for (auto& allocator : s_TransientDescriptorAllocators)
+			allocator = CreateUnique<DescriptorAllocator>(64, 0);
+
 		// Create the generic texture descriptor layout
 		Texture2D::InitStaticResources();
+		// Has to be created before any of the textures and the shaders, which refer to the layout of the table
+		TextureTable::Init();
 		Skymap::Init();
 		ShaderLibrary::Init();
 
 		{
+			// The render thread records the main command buffers, hence they need a command pool of their own
+			// as command pools need to be externally synchronized and the device command pools are used by the main thread
+			VkCommandPoolCreateInfo commandPoolCreateInfo{};
+			commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			commandPoolCreateInfo.queueFamilyIndex = VulkanContext::GetCurrentDevice()->GetQueueFamilyIndices().GraphicsQueueFamilyIndex;
+			commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+			VK_CHECK_RESULT(vkCreateCommandPool(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), &commandPoolCreateInfo, nullptr, &s_CommandPool));
+
 			// The main command buffers
 			CommandBufferSpecification cmdBufferSpec;
-			cmdBufferSpec.CommandPool = VulkanContext::GetCurrentDevice()->GetGraphicsCommandPool();
+			cmdBufferSpec.CommandPool = s_CommandPool;
 			cmdBufferSpec.IsPrimary = true;
 			cmdBufferSpec.SingleTimeUsage = false;
 
@@ -48,95 +94,288 @@ namespace Flameberry {
 				commandBuffer = CreateRef<CommandBuffer>(cmdBufferSpec);
 		}
 
-		s_CommandQueue.reserve(5 * 1028 * 1028 / sizeof(Renderer::Command)); // 5 MB
+		for (auto& commandQueue : s_CommandQueues)
+			commandQueue.reserve(5 * 1028 * 1028 / sizeof(Renderer::Command)); // 5 MB
+
+		{
+			// Leave a couple of cores for the main thread and the render thread
+			const uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+			const uint32_t workerCount = std::clamp(hardwareThreadCount > 2 ? hardwareThreadCount - 2 : 1u, 1u, 4u);
+			s_CommandListRecordingThreadPool = CreateUnique<ThreadPool>(workerCount);
+
+			FBY_INFO("Created {} worker threads for recording command lists", workerCount);
+		}
 
 		// Load Generic Resources
 		s_CheckerboardTexture = TextureImporter::LoadTexture2D(FBY_PROJECT_DIR "Flameberry/Assets/Icons/Checkerboard.png");
 
-#ifdef FBY_ENABLE_QUERY_TIMESTAMP
-
-		// Creating the query pool for recording GPU timestamps
-		VkQueryPoolCreateInfo queryPoolCreateInfo = {};
-		queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-		queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
-		queryPoolCreateInfo.queryCount = s_Timestamps.size();
+		GPUProfiler::Init();
 
-		VK_CHECK_RESULT(vkCreateQueryPool(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), &queryPoolCreateInfo, nullptr, &s_QueryPool));
+		s_RenderThread.Run(Renderer::RT_RenderFrame);
 
-#endif
+		FBY_INFO("Initialized renderer in {} ms", timer.GetTimeEllapsedMilliseconds());
 	}
 
 	void Renderer::Shutdown()
 	{
-#ifdef FBY_ENABLE_QUERY_TIMESTAMP
+		s_RenderThread.Terminate();
+		s_CommandListRecordingThreadPool = nullptr;
+		PipelineBuilder::Shutdown();
 
-		vkDestroyQueryPool(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), s_QueryPool, nullptr);
-
-#endif
+		GPUProfiler::Shutdown();
 
 		// Destroy Generic Resources
+		UploadManager::Shutdown();
+		UniformRing::Shutdown();
+		MaterialParameterBuffer::Shutdown();
+		for (auto& allocator : s_TransientDescriptorAllocators)
+			allocator = nullptr;
 		s_CheckerboardTexture = nullptr;
 
 		Font::DestroyDefault();
+		GeometryArena::Shutdown();
 		ShaderLibrary::Shutdown();
 		Skymap::Destroy();
 		Texture2D::DestroyStaticResources();
+		TextureTable::Shutdown();
 
 		DescriptorSetLayout::ClearCache(); // TODO: Maybe move this to somewhere obvious like VulkanDevice or Renderer
+		PipelineCache::Shutdown();
+
+		// Freeing the command pool also frees the main command buffers
+		for (auto& commandBuffer : s_CommandBuffers)
+			commandBuffer = nullptr;
+		vkDestroyCommandPool(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), s_CommandPool, nullptr);
+
+		for (auto& secondaryCommandBuffers : s_RT_SecondaryCommandBuffers)
+		{
+			for (auto& secondaryCommandBuffer : secondaryCommandBuffers)
+			{
+				secondaryCommandBuffer.CommandBuffer = nullptr;
+				vkDestroyCommandPool(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), secondaryCommandBuffer.CommandPool, nullptr);
+			}
+			secondaryCommandBuffers.clear();
+		}
 	}
 
 	void Renderer::WaitAndRender()
 	{
+		// Wait for the render thread to finish the previous frame, so that it's command queue is free to be reused
+		WaitForRenderThread();
+
+		// The main thread reads the stats of the frame while the render thread is rendering the next one
+		s_RendererFrameStats = s_RT_RendererFrameStats;
+
+		// The swapchain is only used by the render thread while it is kicked
+		s_IsSwapChainImageAcquired = Application::Get().GetWindow().BeginFrame();
+		// The render thread drops a frame without a swapchain image, none of it's commands reach the GPU
+		s_IsLastFrameDropped = !s_IsSwapChainImageAcquired;
+
+		// The deferred releases count the frames submitted to the GPU, a dropped frame doesn't retire any older frame
+		if (!s_IsLastFrameDropped)
+		{
+			GeometryArena::ReleaseFreedRanges();
+			TextureTable::ReleaseFreedSlots();
+		}
+
+		// The uploads recorded during this frame are submitted before the frame that uses them
+		UploadManager::SubmitPendingUploads();
+		MaterialParameterBuffer::FlushFrame(s_FrameIndex);
+
+		FBY_ASSERT(s_ActiveCommandQueue == &s_CommandQueues[s_CommandQueueSubmissionIndex], "Renderer::EndCommandList() was not called before rendering the frame!");
+		GPUProfiler::EndFrame();
+
+		// Hand over the submitted commands to the render thread and start recording the next frame into the other queue
+		s_RT_CommandQueueIndex = s_CommandQueueSubmissionIndex;
+		s_CommandQueueSubmissionIndex = (s_CommandQueueSubmissionIndex + 1) % s_CommandQueueCount;
+		s_ActiveCommandQueue = &s_CommandQueues[s_CommandQueueSubmissionIndex];
+
 		// Update the Frame Index of the Main Thread
-		s_FrameIndex = (s_FrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
-		RT_RenderFrame();
+		// The frame index only advances with the submitted frames, so that it stays in step with the in flight fences of the swapchain
+		// The resources of a dropped frame never reached the GPU, hence the next frame records into them again
+		if (!s_IsLastFrameDropped)
+			s_FrameIndex = (s_FrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+		s_FrameNumber++;
+		UniformRing::BeginFrame(s_FrameIndex);
+		s_RenderThread.Kick();
+	}
+
+	VkDescriptorSet Renderer::AllocateTransientDescriptorSet(const Ref<DescriptorSetLayout>& layout)
+	{
+		VkDescriptorSet descriptorSet;
+		s_TransientDescriptorAllocators[s_FrameIndex]->Allocate(layout, &descriptorSet);
+		return descriptorSet;
+	}
+
+	void Renderer::BeginCommandList(VkRenderPass renderPass)
+	{
+		FBY_ASSERT(s_ActiveCommandQueue == &s_CommandQueues[s_CommandQueueSubmissionIndex], "Renderer::BeginCommandList() called before ending the previous command list!");
+
+		auto& commandList = s_CommandLists[s_CommandQueueSubmissionIndex].emplace_back();
+		commandList.RenderPass = renderPass;
+		s_ActiveCommandQueue = &commandList.Commands;
+	}
+
+	void Renderer::EndCommandList()
+	{
+		FBY_ASSERT(s_ActiveCommandQueue != &s_CommandQueues[s_CommandQueueSubmissionIndex], "Renderer::EndCommandList() called without beginning a command list!");
+
+		const uint32_t commandListIndex = (uint32_t)s_CommandLists[s_CommandQueueSubmissionIndex].size() - 1;
+		s_ActiveCommandQueue = &s_CommandQueues[s_CommandQueueSubmissionIndex];
+
+		// The command list is executed in the place where it ends in the primary command queue
+		Renderer::Submit([commandListIndex](VkCommandBuffer cmdBuffer, uint32_t)
+			{
+				Renderer::RT_ExecuteCommandList(cmdBuffer, commandListIndex);
+			});
+	}
+
+	void Renderer::WaitForRenderThread()
+	{
+		s_RenderThread.BlockUntilRenderComplete();
+	}
+
+	void Renderer::BeginFrame()
+	{
+		FBY_PROFILE_SCOPE("Renderer::BeginFrame");
+		VulkanContext::GetCurrentWindow()->GetSwapChain()->WaitForFrame(s_FrameIndex);
+
+		// The transient descriptor sets of the frame which last used this frame index are no longer in use by the GPU
+		// After a dropped frame the index is reused right away, the sets of the dropped frame were never submitted
+		s_TransientDescriptorAllocators[s_FrameIndex]->Reset();
+
+		// The timestamps of the frame which last used this frame index are written by now, so they're read back before the queries are reset
+		GPUProfiler::BeginFrame(s_FrameIndex);
 	}
 
 	void Renderer::RT_RenderFrame()
 	{
 		FBY_PROFILE_SCOPE("RT_RenderLoop");
 		auto& window = Application::Get().GetWindow();
-		const auto& device = VulkanContext::GetCurrentDevice();
+		auto& commandQueue = s_CommandQueues[s_RT_CommandQueueIndex];
+
+		// The stats of the render thread are reset at the beginning of the frame, the main thread reads the copy of the last completed frame
+		ResetStats();
 
 		// Execute all Render Commands
-		if (window.BeginFrame())
+		if (s_IsSwapChainImageAcquired)
 		{
 			s_CommandBuffers[s_RT_FrameIndex]->Reset();
 			s_CommandBuffers[s_RT_FrameIndex]->Begin();
 
 			const uint32_t imageIndex = window.GetImageIndex();
 
-#ifdef FBY_ENABLE_QUERY_TIMESTAMP
+			// Start recording the command lists on the worker threads while the primary command buffer is being recorded
+			RT_DispatchCommandLists(imageIndex);
 
-			vkCmdResetQueryPool(commandBuffer, s_QueryPool, s_RT_FrameIndex * 2, 2);
-			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, s_QueryPool, s_RT_FrameIndex * 2);
+			for (auto& cmd : commandQueue)
+				cmd(s_CommandBuffers[s_RT_FrameIndex]->GetVulkanCommandBuffer(), imageIndex);
 
-#endif
+			s_CommandBuffers[s_RT_FrameIndex]->End();
 
-			for (auto& cmd : s_CommandQueue)
-				cmd(s_CommandBuffers[s_RT_FrameIndex]->GetVulkanCommandBuffer(), imageIndex);
+			FBY_ASSERT(VulkanContext::GetCurrentWindow()->GetSwapChain()->GetCurrentFrameIndex() == s_RT_FrameIndex, "The frame index of the render thread is out of step with the swapchain!");
+			window.SwapBuffers();
 
-#ifdef FBY_ENABLE_QUERY_TIMESTAMP
+			// Update the Frame Index of the Render Thread, only the submitted frames advance it like the main thread's
+			s_RT_FrameIndex = (s_RT_FrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+		}
 
-			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, s_QueryPool, s_RT_FrameIndex * 2 + 1);
+		RT_MergeLocalFrameStats();
 
-#endif
+		s_IsSwapChainImageAcquired = false;
+		commandQueue.clear();
+		s_CommandLists[s_RT_CommandQueueIndex].clear();
+		s_RT_CommandListRecordingFutures.clear();
+	}
 
-			s_CommandBuffers[s_RT_FrameIndex]->End();
-			window.SwapBuffers();
+	void Renderer::RT_DispatchCommandLists(uint32_t imageIndex)
+	{
+		const auto& commandLists = s_CommandLists[s_RT_CommandQueueIndex];
+		auto& secondaryCommandBuffers = s_RT_SecondaryCommandBuffers[s_RT_FrameIndex];
+
+		// Create the secondary command buffers lazily as the number of command lists can vary every frame
+		while (secondaryCommandBuffers.size() < commandLists.size())
+		{
+			auto& secondaryCommandBuffer = secondaryCommandBuffers.emplace_back();
+
+			VkCommandPoolCreateInfo commandPoolCreateInfo{};
+			commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			commandPoolCreateInfo.queueFamilyIndex = VulkanContext::GetCurrentDevice()->GetQueueFamilyIndices().GraphicsQueueFamilyIndex;
+			commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+			VK_CHECK_RESULT(vkCreateCommandPool(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), &commandPoolCreateInfo, nullptr, &secondaryCommandBuffer.CommandPool));
+
+			CommandBufferSpecification cmdBufferSpec;
+			cmdBufferSpec.CommandPool = secondaryCommandBuffer.CommandPool;
+			cmdBufferSpec.IsPrimary = false;
+			cmdBufferSpec.SingleTimeUsage = true;
+
+			secondaryCommandBuffer.CommandBuffer = CreateRef<CommandBuffer>(cmdBufferSpec);
 		}
 
-#ifdef FBY_ENABLE_QUERY_TIMESTAMP
+		s_RT_CommandListRecordingFutures.resize(commandLists.size());
+		for (uint32_t i = 0; i < commandLists.size(); i++)
+		{
+			s_RT_CommandListRecordingFutures[i] = s_CommandListRecordingThreadPool->Submit([i, imageIndex]()
+				{
+					Renderer::RT_RecordCommandList(i, imageIndex);
+				});
+		}
+	}
+
+	void Renderer::RT_RecordCommandList(uint32_t commandListIndex, uint32_t imageIndex)
+	{
+		FBY_PROFILE_SCOPE("RT_RecordCommandList");
 
-		QueryTimestampResults();
+		const auto& commandList = s_CommandLists[s_RT_CommandQueueIndex][commandListIndex];
+		const auto& secondaryCommandBuffer = s_RT_SecondaryCommandBuffers[s_RT_FrameIndex][commandListIndex];
 
-#endif
+		// The command pool is only used by this command list, so resetting it here doesn't need any synchronization
+		VK_CHECK_RESULT(vkResetCommandPool(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), secondaryCommandBuffer.CommandPool, 0));
 
-		ResetStats();
-		s_CommandQueue.clear();
+		// The framebuffer is left unspecified as it may be recreated by the primary command buffer in this frame
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = commandList.RenderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+		secondaryCommandBuffer.CommandBuffer->Begin(&inheritanceInfo);
 
-		// Update the Frame Index of the Render Thread
-		s_RT_FrameIndex = (s_RT_FrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+		const VkCommandBuffer cmdBuffer = secondaryCommandBuffer.CommandBuffer->GetVulkanCommandBuffer();
+		for (auto& cmd : commandList.Commands)
+			cmd(cmdBuffer, imageIndex);
+
+		secondaryCommandBuffer.CommandBuffer->End();
+
+		RT_MergeLocalFrameStats();
+	}
+
+	void Renderer::RT_ExecuteCommandList(VkCommandBuffer cmdBuffer, uint32_t commandListIndex)
+	{
+		// Wait for the worker thread to finish recording the command list
+		s_RT_CommandListRecordingFutures[commandListIndex].get();
+
+		const VkCommandBuffer secondaryCmdBuffer = s_RT_SecondaryCommandBuffers[s_RT_FrameIndex][commandListIndex].CommandBuffer->GetVulkanCommandBuffer();
+		vkCmdExecuteCommands(cmdBuffer, 1, &secondaryCmdBuffer);
+	}
+
+	void Renderer::RT_MergeLocalFrameStats()
+	{
+		std::scoped_lock<std::mutex> lock(s_RendererFrameStatsMutex);
+
+		s_RT_RendererFrameStats.MeshCount += s_RT_LocalFrameStats.MeshCount;
+		s_RT_RendererFrameStats.SubMeshCount += s_RT_LocalFrameStats.SubMeshCount;
+		s_RT_RendererFrameStats.BoundMaterials += s_RT_LocalFrameStats.BoundMaterials;
+		s_RT_RendererFrameStats.DrawCallCount += s_RT_LocalFrameStats.DrawCallCount;
+		s_RT_RendererFrameStats.IndexCount += s_RT_LocalFrameStats.IndexCount;
+		s_RT_RendererFrameStats.VertexAndIndexBufferStateSwitches += s_RT_LocalFrameStats.VertexAndIndexBufferStateSwitches;
+		s_RT_RendererFrameStats.VisibleSubMeshCount += s_RT_LocalFrameStats.VisibleSubMeshCount;
+		s_RT_RendererFrameStats.CulledSubMeshCount += s_RT_LocalFrameStats.CulledSubMeshCount;
+		s_RT_RendererFrameStats.OccludedSubMeshCount += s_RT_LocalFrameStats.OccludedSubMeshCount;
+		s_RT_RendererFrameStats.ShadowCasterSubMeshCount += s_RT_LocalFrameStats.ShadowCasterSubMeshCount;
+
+		s_RT_LocalFrameStats = RendererFrameStats{};
 	}
 
 	/// @brief Obsolete: This function is used to render a single mesh by individually binding it's resources.
@@ -149,8 +388,10 @@ namespace Flameberry {
 	{
 		Renderer::Submit([mesh, pipelineLayout = pipeline->GetVulkanPipelineLayout(), transform](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
 			{
-				Renderer::RT_BindVertexAndIndexBuffers(cmdBuffer, mesh->GetVertexBuffer()->GetVulkanBuffer(), mesh->GetIndexBuffer()->GetVulkanBuffer());
+				Renderer::RT_BindVertexAndIndexBuffers(cmdBuffer, mesh->GetVertexBuffer(), mesh->GetIndexBuffer());
 				vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), glm::value_ptr(transform));
+
+				s_RT_LocalFrameStats.MeshCount++;
 			});
 
 		uint32_t submeshIndex = 0;
@@ -163,44 +404,42 @@ namespace Flameberry {
 			else if (AssetManager::IsAssetHandleValid(submesh.MaterialHandle))
 				materialAsset = AssetManager::GetAsset<MaterialAsset>(submesh.MaterialHandle);
 
-			Renderer::Submit([pipelineLayout = pipeline->GetVulkanPipelineLayout(), materialAsset, submesh = mesh->GetSubMeshes()[submeshIndex]](VkCommandBuffer cmdBuffer, uint32_t)
+			Renderer::Submit([pipelineLayout = pipeline->GetVulkanPipelineLayout(), materialAsset, submesh = mesh->GetSubMeshes()[submeshIndex], firstIndex = mesh->GetFirstIndex(), vertexOffset = mesh->GetVertexOffset()](VkCommandBuffer cmdBuffer, uint32_t)
 				{
 					RT_BindMaterial(cmdBuffer, pipelineLayout, materialAsset->GetUnderlyingMaterial());
-					vkCmdDrawIndexed(cmdBuffer, submesh.IndexCount, 1, submesh.IndexOffset, 0, 0);
+					vkCmdDrawIndexed(cmdBuffer, submesh.IndexCount, 1, firstIndex + submesh.IndexOffset, vertexOffset, 0);
+
+					// Record Statistics
+					s_RT_LocalFrameStats.SubMeshCount++;
+					s_RT_LocalFrameStats.DrawCallCount++;
+					s_RT_LocalFrameStats.IndexCount += submesh.IndexCount;
 				});
 			submeshIndex++;
-
-			// Record Statistics
-			s_RendererFrameStats.SubMeshCount++;
-			s_RendererFrameStats.DrawCallCount++;
-			s_RendererFrameStats.IndexCount += submesh.IndexCount;
 		}
-		s_RendererFrameStats.MeshCount++;
 	}
 
 	void Renderer::RT_BindMaterial(VkCommandBuffer cmdBuffer, VkPipelineLayout pipelineLayout, const Ref<Material>& material)
 	{
-		vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, material->GetPushConstantOffset(), material->GetUniformDataSize(), material->GetUniformDataPtr());
+		// The materials reading their parameters from the material parameter buffer don't have any push constants of their own
+		if (material->GetUniformDataSize())
+			vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, material->GetPushConstantOffset(), material->GetUniformDataSize(), material->GetUniformDataPtr());
 
+		// The materials sampling their textures from the texture table don't have any descriptor sets of their own
 		if (material->m_DescriptorSets.size())
 		{
-			int idx = 0;
-			std::vector<VkDescriptorSet> descSetArray(material->m_DescriptorSets.size());
+			constexpr uint32_t maxDescriptorSetCount = 8;
+			FBY_ASSERT(material->m_DescriptorSets.size() <= maxDescriptorSetCount, "A material can have at most {} descriptor sets", maxDescriptorSetCount);
 
+			uint32_t count = 0;
+			VkDescriptorSet descSetArray[maxDescriptorSetCount];
 			for (const auto& set : material->m_DescriptorSets)
-			{
-				descSetArray[idx] = set->GetVulkanDescriptorSet();
-				idx++;
-			}
-
-			const uint32_t setNumber = material->m_StartSetIndex;
-			const uint32_t count = idx;
+				descSetArray[count++] = set->GetVulkanDescriptorSet();
 
-			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, setNumber, count, &descSetArray[0], 0, nullptr);
+			vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, material->m_StartSetIndex, count, descSetArray, 0, nullptr);
 		}
 
 		// Record Statistics
-		s_RendererFrameStats.BoundMaterials++;
+		s_RT_LocalFrameStats.BoundMaterials++;
 	}
 
 	void Renderer::RT_BindVertexAndIndexBuffers(VkCommandBuffer cmdBuffer, VkBuffer vertexBuffer, VkBuffer indexBuffer)
@@ -209,47 +448,34 @@ namespace Flameberry {
 		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexBuffer, offsets);
 		vkCmdBindIndexBuffer(cmdBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-		s_RendererFrameStats.VertexAndIndexBufferStateSwitches++;
+		s_RT_LocalFrameStats.VertexAndIndexBufferStateSwitches++;
 	}
 
-	void Renderer::RT_BindPipeline(VkCommandBuffer cmdBuffer, VkPipeline pipeline)
+	void Renderer::RT_RecordCullingStats(uint32_t visibleSubMeshCount, uint32_t culledSubMeshCount, uint32_t occludedSubMeshCount, uint32_t shadowCasterSubMeshCount)
 	{
-		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		s_RT_LocalFrameStats.VisibleSubMeshCount += visibleSubMeshCount;
+		s_RT_LocalFrameStats.CulledSubMeshCount += culledSubMeshCount;
+		s_RT_LocalFrameStats.OccludedSubMeshCount += occludedSubMeshCount;
+		s_RT_LocalFrameStats.ShadowCasterSubMeshCount += shadowCasterSubMeshCount;
 	}
 
-	void Renderer::ResetStats()
+	void Renderer::RT_BindPipeline(VkCommandBuffer cmdBuffer, VkPipeline pipeline)
 	{
-		s_RendererFrameStats.MeshCount = 0;
-		s_RendererFrameStats.SubMeshCount = 0;
-		s_RendererFrameStats.BoundMaterials = 0;
-		s_RendererFrameStats.DrawCallCount = 0;
-		s_RendererFrameStats.IndexCount = 0;
-		s_RendererFrameStats.VertexAndIndexBufferStateSwitches = 0;
+		vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 	}
 
-	void Renderer::QueryTimestampResults()
+	void Renderer::ResetStats()
 	{
-		vkGetQueryPoolResults(
-			VulkanContext::GetCurrentDevice()->GetVulkanDevice(),
-			s_QueryPool,
-			s_RT_FrameIndex * 2,
-			2,
-			2 * sizeof(uint64_t),
-			&s_Timestamps[s_RT_FrameIndex * 2],
-			sizeof(uint64_t),
-			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-
-		uint64_t startTime = s_Timestamps[s_RT_FrameIndex * 2];
-		uint64_t endTime = s_Timestamps[s_RT_FrameIndex * 2 + 1];
-		uint64_t duration = endTime - startTime;
-
-		// Convert the duration to milliseconds (or the desired unit)
-		VkPhysicalDeviceProperties properties = VulkanContext::GetPhysicalDeviceProperties();
-
-		double timestampPeriod = properties.limits.timestampPeriod;
-		double gpuTime = duration * timestampPeriod / 1e6; // Convert to milliseconds
-
-		FBY_LOG("GPU Time: {} ms", gpuTime);
+		s_RT_RendererFrameStats.MeshCount = 0;
+		s_RT_RendererFrameStats.SubMeshCount = 0;
+		s_RT_RendererFrameStats.BoundMaterials = 0;
+		s_RT_RendererFrameStats.DrawCallCount = 0;
+		s_RT_RendererFrameStats.IndexCount = 0;
+		s_RT_RendererFrameStats.VertexAndIndexBufferStateSwitches = 0;
+		s_RT_RendererFrameStats.VisibleSubMeshCount = 0;
+		s_RT_RendererFrameStats.CulledSubMeshCount = 0;
+		s_RT_RendererFrameStats.OccludedSubMeshCount = 0;
+		s_RT_RendererFrameStats.ShadowCasterSubMeshCount = 0;
 	}
 
 } // namespace Flameberry
@@ -11,6 +11,8 @@
 #include "Renderer/Texture2D.h"
 #include "StaticMesh.h"
 #include "CommandBuffer.h"
+#include "RenderThread.h"
+#include "Core/ThreadPool.h"
 #include "ECS/Components.h"
 
 namespace Flameberry {
@@ -21,6 +23,9 @@ namespace Flameberry {
 		uint32_t DrawCallCount = 0, IndexCount = 0;
 
 		uint32_t VertexAndIndexBufferStateSwitches = 0;
+
+		// Frustum and Occlusion Culling
+		uint32_t VisibleSubMeshCount = 0, CulledSubMeshCount = 0, OccludedSubMeshCount = 0, ShadowCasterSubMeshCount = 0;
 	};
 
 	class Renderer
@@ -34,16 +39,36 @@ namespace Flameberry {
 		static void Shutdown();
 
 		// This is a hot function which is most likely a bottleneck and cause of high CPU usage
-		inline static void Submit(const Command&& cmd) { s_CommandQueue.push_back(cmd); }
-		// Currently just renders, the `Wait` part is for a future implementation of Multi-threading
+		inline static void Submit(const Command&& cmd) { s_ActiveCommandQueue->push_back(cmd); }
+		// All the commands submitted between these calls are recorded into a secondary command buffer by a worker thread
+		// The secondary command buffer is then executed by the primary command buffer in the order of the `EndCommandList()` call
+		// The render pass should be begun with `VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS` and the commands must not depend upon any state set outside the list
+		static void BeginCommandList(VkRenderPass renderPass);
+		static void EndCommandList();
+		// Waits for the render thread to finish the previous frame, acquires the next swapchain image, swaps the command queues and kicks the render thread to render the submitted frame
 		static void WaitAndRender();
+		// Blocks the main thread until the render thread has finished executing the last kicked frame
+		// Should be called before touching any resource that the render thread might be using, for e.g. while resizing the window
+		static void WaitForRenderThread();
+		// Waits for the GPU to finish the frame which last used the resources of the current frame index
+		// Must be called by the main thread before it writes any per frame resource, it doesn't wait for the render thread
+		static void BeginFrame();
 
 		// Get the Renderer Stats
 		static const RendererFrameStats& GetRendererFrameStats() { return s_RendererFrameStats; }
-		// Get the current frame index in the update/main thread
+		// Get the current frame index in the update/main thread, it only advances once a frame is submitted to the GPU
 		static uint32_t GetCurrentFrameIndex() { return s_FrameIndex; }
+		// Whether the last frame handed over to the render thread is dropped as no swapchain image could be acquired for it
+		// The work recorded in a dropped frame never reaches the GPU, so anything that relied on it has to be redone
+		static bool WasLastFrameDropped() { return s_IsLastFrameDropped; }
+		// The number of the frame being recorded by the main thread, it advances with every frame including the dropped ones
+		static uint64_t GetFrameNumber() { return s_FrameNumber; }
 		// Get the current frame index in the render thread
 		static uint32_t RT_GetCurrentFrameIndex() { return s_RT_FrameIndex; }
+
+		// Allocates a descriptor set which is valid only for the frame being recorded by the main thread, it is not to be freed
+		// All the transient sets of a frame are freed at once when the frame index is reused
+		static VkDescriptorSet AllocateTransientDescriptorSet(const Ref<DescriptorSetLayout>& layout);
 		// The render function to be called in the Render Thread which does the actual rendering by execution of the submitted commands
 		static void RT_RenderFrame();
 		// Get the Vulkan Command Buffer that is being actively recorded
@@ -54,26 +79,64 @@ namespace Flameberry {
 		static void RT_BindPipeline(VkCommandBuffer cmdBuffer, VkPipeline pipeline);
 		static void RT_BindMaterial(VkCommandBuffer cmdBuffer, VkPipelineLayout pipelineLayout, const Ref<Material>& material);
 		static void RT_BindVertexAndIndexBuffers(VkCommandBuffer cmdBuffer, VkBuffer vertexBuffer, VkBuffer indexBuffer);
+		// The culling is done by the main thread, hence the results are submitted as a command to be recorded with the stats of the frame
+		static void RT_RecordCullingStats(uint32_t visibleSubMeshCount, uint32_t culledSubMeshCount, uint32_t occludedSubMeshCount, uint32_t shadowCasterSubMeshCount);
 
 		// Retrieve Generic Resources
 		static Ref<Texture2D> GetCheckerboardTexture() { return s_CheckerboardTexture; }
 
 	private:
 		static void ResetStats();
-		static void QueryTimestampResults();
+
+		static void RT_DispatchCommandLists(uint32_t imageIndex);
+		static void RT_RecordCommandList(uint32_t commandListIndex, uint32_t imageIndex);
+		static void RT_ExecuteCommandList(VkCommandBuffer cmdBuffer, uint32_t commandListIndex);
+		static void RT_MergeLocalFrameStats();
+
+	private:
+		struct CommandList
+		{
+			std::vector<Command> Commands;
+			VkRenderPass RenderPass = VK_NULL_HANDLE;
+		};
+
+		// Each command list of a frame in flight gets it's own command pool, so that the worker threads never share one
+		struct SecondaryCommandBuffer
+		{
+			VkCommandPool CommandPool = VK_NULL_HANDLE;
+			Ref<CommandBuffer> CommandBuffer;
+		};
 
 	private:
 		static uint32_t s_RT_FrameIndex, s_FrameIndex;
+		static uint64_t s_FrameNumber;
+		static VkCommandPool s_CommandPool;
 		static std::array<Ref<CommandBuffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> s_CommandBuffers;
 
-		static RendererFrameStats s_RendererFrameStats;
+		// The stats of the last completed frame, copied from the stats of the render thread when the frames are swapped
+		static RendererFrameStats s_RendererFrameStats, s_RT_RendererFrameStats;
+		// The stats are recorded per thread and merged once the thread is done recording
+		static thread_local RendererFrameStats s_RT_LocalFrameStats;
+		static std::mutex s_RendererFrameStatsMutex;
 
 		// Critical Variables
-		static std::vector<Command> s_CommandQueue;
-
-		// Query Pool
-		static VkQueryPool s_QueryPool;
-		static std::array<uint64_t, 4 * SwapChain::MAX_FRAMES_IN_FLIGHT> s_Timestamps;
+		// The main thread records into one command queue while the render thread executes the other one
+		static constexpr uint32_t s_CommandQueueCount = 2;
+		static std::array<std::vector<Command>, s_CommandQueueCount> s_CommandQueues;
+		static uint32_t s_CommandQueueSubmissionIndex, s_RT_CommandQueueIndex;
+		static std::vector<Command>* s_ActiveCommandQueue;
+
+		// Command Lists which are recorded in parallel into secondary command buffers
+		static std::array<std::vector<CommandList>, s_CommandQueueCount> s_CommandLists;
+		static std::array<std::vector<SecondaryCommandBuffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> s_RT_SecondaryCommandBuffers;
+		static std::vector<std::future<void>> s_RT_CommandListRecordingFutures;
+		static Unique<ThreadPool> s_CommandListRecordingThreadPool;
+
+		static RenderThread s_RenderThread;
+		static bool s_IsSwapChainImageAcquired, s_IsLastFrameDropped;
+
+		// The descriptor allocators of the transient sets, indexed by the frame
+		static std::array<Unique<DescriptorAllocator>, SwapChain::MAX_FRAMES_IN_FLIGHT> s_TransientDescriptorAllocators;
 
 	private:
 		// Generic Resources required all over the application
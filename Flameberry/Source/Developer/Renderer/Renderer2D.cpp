@@ -7,6 +7,7 @@
 #include "RenderPass.h"
 #include "VulkanDebug.h"
 #include "RenderCommand.h"
+#include "UploadManager.h"
 #include "MSDFFontData.h"
 
 #define MAX_LINES 10000
@@ -29,8 +30,11 @@ namespace Flameberry {
 			bufferSpec.Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 			bufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-			s_Renderer2DData.LineVertexBuffer = CreateRef<Buffer>(bufferSpec);
-			s_Renderer2DData.LineVertexBuffer->MapMemory(bufferSpec.InstanceSize);
+			for (auto& vertexBuffer : s_Renderer2DData.LineVertexBuffers)
+			{
+				vertexBuffer = CreateRef<Buffer>(bufferSpec);
+				vertexBuffer->MapMemory(bufferSpec.InstanceSize);
+			}
 
 			PipelineSpecification pipelineSpec{};
 			pipelineSpec.Shader = ShaderLibrary::Get("SolidColor");
@@ -58,8 +62,11 @@ namespace Flameberry {
 			bufferSpec.Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 			bufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-			s_Renderer2DData.QuadVertexBuffer = CreateRef<Buffer>(bufferSpec);
-			s_Renderer2DData.QuadVertexBuffer->MapMemory(bufferSpec.InstanceSize);
+			for (auto& vertexBuffer : s_Renderer2DData.QuadVertexBuffers)
+			{
+				vertexBuffer = CreateRef<Buffer>(bufferSpec);
+				vertexBuffer->MapMemory(bufferSpec.InstanceSize);
+			}
 
 			BufferSpecification indexBufferSpec{};
 			indexBufferSpec.InstanceCount = 1;
@@ -84,19 +91,7 @@ namespace Flameberry {
 				offset += 4;
 			}
 
-			BufferSpecification stagingBufferSpec{};
-			stagingBufferSpec.InstanceCount = 1;
-			stagingBufferSpec.InstanceSize = indexBufferSpec.InstanceSize;
-			stagingBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			stagingBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-			Buffer stagingBuffer(stagingBufferSpec);
-
-			stagingBuffer.MapMemory(indexBufferSpec.InstanceSize);
-			stagingBuffer.WriteToBuffer(indices, indexBufferSpec.InstanceSize, 0);
-			stagingBuffer.UnmapMemory();
-
-			RenderCommand::CopyBuffer(stagingBuffer.GetVulkanBuffer(), s_Renderer2DData.QuadIndexBuffer->GetVulkanBuffer(), indexBufferSpec.InstanceSize);
+			UploadManager::UploadToBuffer(s_Renderer2DData.QuadIndexBuffer->GetVulkanBuffer(), 0, indices, indexBufferSpec.InstanceSize);
 
 			delete[] indices;
 
@@ -127,8 +122,11 @@ namespace Flameberry {
 			bufferSpec.Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 			bufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-			s_Renderer2DData.TextVertexBuffer = CreateRef<Buffer>(bufferSpec);
-			s_Renderer2DData.TextVertexBuffer->MapMemory(bufferSpec.InstanceSize);
+			for (auto& vertexBuffer : s_Renderer2DData.TextVertexBuffers)
+			{
+				vertexBuffer = CreateRef<Buffer>(bufferSpec);
+				vertexBuffer->MapMemory(bufferSpec.InstanceSize);
+			}
 
 			BufferSpecification indexBufferSpec{};
 			indexBufferSpec.InstanceCount = 1;
@@ -153,19 +151,7 @@ namespace Flameberry {
 				offset += 4;
 			}
 
-			BufferSpecification stagingBufferSpec{};
-			stagingBufferSpec.InstanceCount = 1;
-			stagingBufferSpec.InstanceSize = indexBufferSpec.InstanceSize;
-			stagingBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			stagingBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-			Buffer stagingBuffer(stagingBufferSpec);
-
-			stagingBuffer.MapMemory(indexBufferSpec.InstanceSize);
-			stagingBuffer.WriteToBuffer(indices, indexBufferSpec.InstanceSize, 0);
-			stagingBuffer.UnmapMemory();
-
-			RenderCommand::CopyBuffer(stagingBuffer.GetVulkanBuffer(), s_Renderer2DData.TextIndexBuffer->GetVulkanBuffer(), indexBufferSpec.InstanceSize);
+			UploadManager::UploadToBuffer(s_Renderer2DData.TextIndexBuffer->GetVulkanBuffer(), 0, indices, indexBufferSpec.InstanceSize);
 
 			delete[] indices;
 
@@ -431,9 +417,10 @@ namespace Flameberry {
 		}
 	}
 
-	void Renderer2D::BeginScene(VkDescriptorSet globalDescriptorSet)
+	void Renderer2D::BeginScene(VkDescriptorSet globalDescriptorSet, uint32_t globalDynamicOffset)
 	{
 		s_GlobalDescriptorSet = globalDescriptorSet;
+		s_GlobalDynamicOffset = globalDynamicOffset;
 		s_Renderer2DData.QuadVertexBufferOffset = 0;
 		s_Renderer2DData.TextVertexBufferOffset = 0;
 	}
@@ -443,19 +430,20 @@ namespace Flameberry {
 	{
 		if (s_Renderer2DData.QuadVertices.size())
 		{
+			const uint32_t frameIndex = Renderer::GetCurrentFrameIndex();
 			FBY_ASSERT(s_Renderer2DData.QuadVertices.size() <= MAX_QUAD_VERTICES, "MAX_QUAD_VERTICES limit reached!");
-			s_Renderer2DData.QuadVertexBuffer->WriteToBuffer(s_Renderer2DData.QuadVertices.data(), s_Renderer2DData.QuadVertices.size() * sizeof(QuadVertex), s_Renderer2DData.QuadVertexBufferOffset);
+			s_Renderer2DData.QuadVertexBuffers[frameIndex]->WriteToBuffer(s_Renderer2DData.QuadVertices.data(), s_Renderer2DData.QuadVertices.size() * sizeof(QuadVertex), s_Renderer2DData.QuadVertexBufferOffset);
 
-			auto vertexBuffer = s_Renderer2DData.QuadVertexBuffer->GetVulkanBuffer();
+			auto vertexBuffer = s_Renderer2DData.QuadVertexBuffers[frameIndex]->GetVulkanBuffer();
 			auto indexBuffer = s_Renderer2DData.QuadIndexBuffer->GetVulkanBuffer();
 			auto vulkanPipeline = s_Renderer2DData.QuadPipeline->GetVulkanPipeline();
 			auto pipelineLayout = s_Renderer2DData.QuadPipeline->GetVulkanPipelineLayout();
 			auto indexCount = 6 * (uint32_t)s_Renderer2DData.QuadVertices.size() / 4;
 
-			Renderer::Submit([vulkanPipeline, pipelineLayout, globalDescriptorSet = s_GlobalDescriptorSet, descSet = s_Renderer2DData.TextureMap->CreateOrGetDescriptorSet(), vertexBuffer, offset = s_Renderer2DData.QuadVertexBufferOffset, indexBuffer, indexCount](VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
+			Renderer::Submit([vulkanPipeline, pipelineLayout, globalDescriptorSet = s_GlobalDescriptorSet, globalDynamicOffset = s_GlobalDynamicOffset, descSet = s_Renderer2DData.TextureMap->CreateOrGetDescriptorSet(), vertexBuffer, offset = s_Renderer2DData.QuadVertexBufferOffset, indexBuffer, indexCount](VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
 				Renderer::RT_BindPipeline(cmdBuffer, vulkanPipeline);
 				VkDescriptorSet descriptorSets[] = { globalDescriptorSet, descSet };
-				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 2, descriptorSets, 0, nullptr);
+				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 2, descriptorSets, 1, &globalDynamicOffset);
 
 				VkDeviceSize offsets[] = { offset };
 				vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexBuffer, offsets);
@@ -469,19 +457,21 @@ namespace Flameberry {
 
 	void Renderer2D::EndScene()
 	{
+		const uint32_t frameIndex = Renderer::GetCurrentFrameIndex();
+
 		if (!s_Renderer2DData.LineVertices.empty())
 		{
 			FBY_ASSERT(s_Renderer2DData.LineVertices.size() <= 2 * MAX_LINES, "MAX_LINES limit reached!");
-			s_Renderer2DData.LineVertexBuffer->WriteToBuffer(s_Renderer2DData.LineVertices.data(), s_Renderer2DData.LineVertices.size() * sizeof(LineVertex), 0);
+			s_Renderer2DData.LineVertexBuffers[frameIndex]->WriteToBuffer(s_Renderer2DData.LineVertices.data(), s_Renderer2DData.LineVertices.size() * sizeof(LineVertex), 0);
 
 			uint32_t vertexCount = (uint32_t)s_Renderer2DData.LineVertices.size();
-			const VkBuffer vertexBuffer = s_Renderer2DData.LineVertexBuffer->GetVulkanBuffer();
+			const VkBuffer vertexBuffer = s_Renderer2DData.LineVertexBuffers[frameIndex]->GetVulkanBuffer();
 			const VkPipelineLayout pipelineLayout = s_Renderer2DData.LinePipeline->GetVulkanPipelineLayout();
 			const VkPipeline vulkanPipeline = s_Renderer2DData.LinePipeline->GetVulkanPipeline();
 
-			Renderer::Submit([vulkanPipeline, pipelineLayout, globalDescriptorSet = s_GlobalDescriptorSet, vertexBuffer, vertexCount](VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
+			Renderer::Submit([vulkanPipeline, pipelineLayout, globalDescriptorSet = s_GlobalDescriptorSet, globalDynamicOffset = s_GlobalDynamicOffset, vertexBuffer, vertexCount](VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
 				Renderer::RT_BindPipeline(cmdBuffer, vulkanPipeline);
-				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &globalDescriptorSet, 0, nullptr);
+				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &globalDescriptorSet, 1, &globalDynamicOffset);
 
 				VkDeviceSize offsets[] = { 0 };
 				vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexBuffer, offsets);
@@ -497,19 +487,19 @@ namespace Flameberry {
 			if (batch.TextVertices.size())
 			{
 				FBY_ASSERT(batch.TextVertices.size() <= MAX_QUAD_INDICES, "MAX_QUAD_INDICES reached!");
-				s_Renderer2DData.TextVertexBuffer->WriteToBuffer(batch.TextVertices.data(), batch.TextVertices.size() * sizeof(TextVertex), s_Renderer2DData.TextVertexBufferOffset);
+				s_Renderer2DData.TextVertexBuffers[frameIndex]->WriteToBuffer(batch.TextVertices.data(), batch.TextVertices.size() * sizeof(TextVertex), s_Renderer2DData.TextVertexBufferOffset);
 
-				const VkBuffer vertexBuffer = s_Renderer2DData.TextVertexBuffer->GetVulkanBuffer();
+				const VkBuffer vertexBuffer = s_Renderer2DData.TextVertexBuffers[frameIndex]->GetVulkanBuffer();
 				const VkBuffer indexBuffer = s_Renderer2DData.TextIndexBuffer->GetVulkanBuffer();
 				const VkPipelineLayout pipelineLayout = s_Renderer2DData.TextPipeline->GetVulkanPipelineLayout();
 				const VkPipeline vulkanPipeline = s_Renderer2DData.TextPipeline->GetVulkanPipeline();
 				const uint32_t vertexCount = (uint32_t)batch.TextVertices.size();
 				const uint32_t indexCount = 6 * (uint32_t)batch.TextVertices.size() / 4;
 
-				Renderer::Submit([vulkanPipeline, pipelineLayout, globalDescriptorSet = s_GlobalDescriptorSet, descSet = batch.FontAtlasTexture->CreateOrGetDescriptorSet(), vertexBuffer, offset = s_Renderer2DData.TextVertexBufferOffset, indexBuffer, indexCount](VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
+				Renderer::Submit([vulkanPipeline, pipelineLayout, globalDescriptorSet = s_GlobalDescriptorSet, globalDynamicOffset = s_GlobalDynamicOffset, descSet = batch.FontAtlasTexture->CreateOrGetDescriptorSet(), vertexBuffer, offset = s_Renderer2DData.TextVertexBufferOffset, indexBuffer, indexCount](VkCommandBuffer cmdBuffer, uint32_t imageIndex) {
 					Renderer::RT_BindPipeline(cmdBuffer, vulkanPipeline);
 					VkDescriptorSet descriptorSets[] = { globalDescriptorSet, descSet };
-					vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 2, descriptorSets, 0, nullptr);
+					vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 2, descriptorSets, 1, &globalDynamicOffset);
 
 					VkDeviceSize offsets[] = { offset };
 					vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexBuffer, offsets);
@@ -528,14 +518,17 @@ namespace Flameberry {
 	void Renderer2D::Shutdown()
 	{
 		s_Renderer2DData.LinePipeline = nullptr;
-		s_Renderer2DData.LineVertexBuffer = nullptr;
+		for (auto& vertexBuffer : s_Renderer2DData.LineVertexBuffers)
+			vertexBuffer = nullptr;
 
 		s_Renderer2DData.QuadPipeline = nullptr;
-		s_Renderer2DData.QuadVertexBuffer = nullptr;
+		for (auto& vertexBuffer : s_Renderer2DData.QuadVertexBuffers)
+			vertexBuffer = nullptr;
 		s_Renderer2DData.QuadIndexBuffer = nullptr;
 
 		s_Renderer2DData.TextPipeline = nullptr;
-		s_Renderer2DData.TextVertexBuffer = nullptr;
+		for (auto& vertexBuffer : s_Renderer2DData.TextVertexBuffers)
+			vertexBuffer = nullptr;
 		s_Renderer2DData.TextIndexBuffer = nullptr;
 		s_Renderer2DData.TextureMap = nullptr;
 	}
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <array>
+
 #include "AABB.h"
 
 #include "Pipeline.h"
 #include "Buffer.h"
 #include "Texture2D.h"
 #include "Font.h"
+#include "SwapChain.h"
 
 namespace Flameberry {
 
@@ -31,21 +34,25 @@ namespace Flameberry {
 		int EntityIndex = -1;
 	};
 
+	// The host visible vertex buffers are written by the main thread every frame, hence every frame in flight has it's own
+	// so that they are not overwritten while an earlier frame is still being rendered from them
 	struct Renderer2DData
 	{
 		// Lines
 		Ref<Pipeline> LinePipeline;
-		Ref<Buffer> LineVertexBuffer;
+		std::array<Ref<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> LineVertexBuffers;
 		std::vector<LineVertex> LineVertices;
 
 		// Quads
 		Ref<Pipeline> QuadPipeline;
-		Ref<Buffer> QuadVertexBuffer, QuadIndexBuffer;
+		std::array<Ref<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> QuadVertexBuffers;
+		Ref<Buffer> QuadIndexBuffer;
 		std::vector<QuadVertex> QuadVertices;
 		uint32_t QuadVertexBufferOffset = 0;
 
 		Ref<Pipeline> TextPipeline;
-		Ref<Buffer> TextVertexBuffer, TextIndexBuffer;
+		std::array<Ref<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> TextVertexBuffers;
+		Ref<Buffer> TextIndexBuffer;
 		uint32_t TextVertexBufferOffset = 0;
 
 		struct TextBatch
@@ -85,7 +92,8 @@ namespace Flameberry {
 		static void AddAABB(const AABB& aabb, const glm::mat4& transform, const glm::vec4& color);
 		static void AddText(const std::string& text, const Ref<Font>& fontAsset, const glm::mat4& transform, const TextParams& textParams, int entityIndex = -1);
 
-		static void BeginScene(VkDescriptorSet globalDescriptorSet);
+		// The global descriptor set holds the camera uniform buffer, which is bound with the given dynamic offset into the uniform ring
+		static void BeginScene(VkDescriptorSet globalDescriptorSet, uint32_t globalDynamicOffset);
 		static void EndScene();
 
 		static void SetActiveTexture(const Ref<Texture2D>& texture) { s_Renderer2DData.TextureMap = texture; }
@@ -97,6 +105,7 @@ namespace Flameberry {
 		static Renderer2DData s_Renderer2DData;
 
 		inline static VkDescriptorSet s_GlobalDescriptorSet = VK_NULL_HANDLE;
+		inline static uint32_t s_GlobalDynamicOffset = 0;
 	};
 
 } // namespace Flameberry
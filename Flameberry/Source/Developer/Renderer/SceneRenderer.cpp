@@ -1,11 +1,17 @@
 #include "SceneRenderer.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Asset/Importers/TextureImporter.h"
+#include "Asset/Importers/MeshImporter.h"
 #include "Core/Core.h"
+#include "Core/Algorithm.h"
 #include "Core/Log.h"
 #include "Core/Profiler.h"
 
@@ -21,12 +27,27 @@
 #include "Frustum.h"
 #include "Light.h"
 #include "Skymap.h"
+#include "UniformRing.h"
+#include "TextureTable.h"
+#include "MaterialParameterBuffer.h"
+#include "GPUProfiler.h"
 
 #include "Asset/AssetManager.h"
 #include "vulkan/vulkan_core.h"
 
 namespace Flameberry {
 
+	// The number of mesh draw calls recorded by a single worker thread into one secondary command buffer
+	constexpr static uint32_t s_MaxDrawCallsPerCommandList = 256;
+	// The initial number of instances that the instance storage buffer of each frame can hold
+	constexpr static uint32_t s_InitialInstanceStorageCapacity = 1024;
+	// The number of texels the camera can move by before the cached cascades have to be rendered again
+	constexpr static float s_CachedCascadeMoveThresholdTexels = 64.0f;
+	// The number of frames a mesh entity has to stay unchanged for to be rendered into the cached cascades as a static shadow caster
+	constexpr static uint64_t s_StaticShadowCasterFrameCount = 30;
+	// The initial number of point lights, spot lights, clusters and light indices that the light storage buffers of each frame can hold
+	constexpr static uint32_t s_InitialLightStorageCapacities[4] = { 128, 128, LightClusterGrid::ClusterCount, LightClusterGrid::ClusterCount * 8 };
+
 	struct CameraUniformBufferObject
 	{
 		glm::mat4 ViewMatrix, ProjectionMatrix, ViewProjectionMatrix;
@@ -52,19 +73,30 @@ namespace Flameberry {
 
 	struct SceneUniformBufferData
 	{
-		alignas(16) glm::mat4 CascadeViewProjectionMatrices[SceneRendererSettings::CascadeCount];
-		alignas(16) float CascadeDepthSplits[SceneRendererSettings::CascadeCount];
+		alignas(16) glm::mat4 CascadeViewProjectionMatrices[SceneRendererSettings::MaxCascadeCount];
+		alignas(16) float CascadeDepthSplits[SceneRendererSettings::MaxCascadeCount];
 		alignas(16) glm::vec3 cameraPosition;
 		alignas(16) DirectionalLight directionalLight;
-		alignas(16) PointLight PointLights[10];
-		alignas(16) SpotLight SpotLights[10];
-		alignas(4) int PointLightCount = 0, SpotLightCount = 0;
+		// The lights themselves are stored in the storage buffers of the scene descriptor set and looked up through the cluster of the fragment
+		alignas(16) glm::uvec4 ClusterGridSize{ LightClusterGrid::GridSizeX, LightClusterGrid::GridSizeY, LightClusterGrid::GridSizeZ, 0 };
+		alignas(8) glm::vec2 ClusterTileSize;
+		alignas(8) glm::vec2 ClusterDepthSliceScaleBias;
 		alignas(4) float SkyLightIntensity = 0.0f;
 		alignas(16) SceneRendererSettingsUniform RendererSettings;
 	};
 
+	// The shadow map pipeline clamps the depth, so the casters between the light and a cascade still cast shadows into it
+	// Hence the orthographic volume of the cascade is extruded towards the light by disabling it's near plane
+	static Frustum GetShadowCasterVolume(const glm::mat4& cascadeViewProjectionMatrix)
+	{
+		Frustum casterVolume;
+		casterVolume.ExtractFrustumPlanes(cascadeViewProjectionMatrix);
+		casterVolume.Planes[4] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		return casterVolume;
+	}
+
 	SceneRenderer::SceneRenderer(const glm::vec2& viewportSize)
-		: m_ViewportSize(viewportSize)
+		: m_ViewportSize(viewportSize), m_RenderTargetSize(glm::floor(viewportSize)), m_RenderExtent(m_RenderTargetSize)
 	{
 		Init();
 	}
@@ -79,109 +111,51 @@ namespace Flameberry {
 
 		m_RendererData = CreateUnique<RendererData>();
 
-		/////////////////////////////////////// Preparing Shadow Mapping Pass ///////////////////////////////////////
 		{
-			FramebufferSpecification shadowMapFramebufferSpec;
-			shadowMapFramebufferSpec.Width = SceneRendererSettings::CascadeSize;
-			shadowMapFramebufferSpec.Height = SceneRendererSettings::CascadeSize;
-			shadowMapFramebufferSpec.Attachments = { { VK_FORMAT_D32_SFLOAT, SceneRendererSettings::CascadeCount } };
-			shadowMapFramebufferSpec.Samples = 1;
-			shadowMapFramebufferSpec.DepthStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-			shadowMapFramebufferSpec.DepthStencilClearValue = { 1.0f, 0 };
-
-			RenderPassSpecification shadowMapRenderPassSpec;
-			shadowMapRenderPassSpec.TargetFramebuffers.resize(imageCount);
-			shadowMapRenderPassSpec.Dependencies = {
-				{
-					VK_SUBPASS_EXTERNAL,						  // uint32_t                   srcSubpass
-					0,											  // uint32_t                   dstSubpass
-					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,		  // VkPipelineStageFlags       srcStageMask
-					VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,	  // VkPipelineStageFlags       dstStageMask
-					VK_ACCESS_SHADER_READ_BIT,					  // VkAccessFlags              srcAccessMask
-					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, // VkAccessFlags              dstAccessMask
-					VK_DEPENDENCY_BY_REGION_BIT					  // VkDependencyFlags          dependencyFlags
-				},
-				{
-					0,											  // uint32_t                   srcSubpass
-					VK_SUBPASS_EXTERNAL,						  // uint32_t                   dstSubpass
-					VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,	  // VkPipelineStageFlags       srcStageMask
-					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,		  // VkPipelineStageFlags       dstStageMask
-					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, // VkAccessFlags              srcAccessMask
-					VK_ACCESS_SHADER_READ_BIT,					  // VkAccessFlags              dstAccessMask
-					VK_DEPENDENCY_BY_REGION_BIT					  // VkDependencyFlags          dependencyFlags
-				}
-			};
-
-			for (uint32_t i = 0; i < imageCount; i++)
-				shadowMapRenderPassSpec.TargetFramebuffers[i] = CreateRef<Framebuffer>(shadowMapFramebufferSpec);
-
-			m_ShadowMapRenderPass = CreateRef<RenderPass>(shadowMapRenderPassSpec);
-
-			// Shadow Map Pipeline
-			auto bufferSize = sizeof(glm::mat4) * SceneRendererSettings::CascadeCount;
+			// The culling is done on the main thread while the render thread records the previous frame, so a separate pool is used
+			const uint32_t hardwareThreadCount = std::thread::hardware_concurrency();
+			const uint32_t workerCount = std::clamp(hardwareThreadCount > 2 ? hardwareThreadCount - 2 : 1u, 1u, 4u);
+			m_CullingThreadPool = CreateUnique<ThreadPool>(workerCount);
 
-			BufferSpecification uniformBufferSpec;
-			uniformBufferSpec.InstanceCount = 1;
-			uniformBufferSpec.InstanceSize = bufferSize;
-			uniformBufferSpec.Usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-			uniformBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			// The occluder geometry is imported from disk, which would stall the frames waiting on the culling pool
+			m_OccluderLoadingThreadPool = CreateUnique<ThreadPool>(1);
+		}
 
-			m_ShadowMapUniformBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-			for (auto& uniformBuffer : m_ShadowMapUniformBuffers)
+		////////////////////////////////////// Preparing Instance Storage Buffers ///////////////////////////////////////
+		{
+			BufferSpecification instanceBufferSpec;
+			instanceBufferSpec.InstanceCount = s_InitialInstanceStorageCapacity;
+			instanceBufferSpec.InstanceSize = sizeof(MeshInstanceData);
+			instanceBufferSpec.Usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			instanceBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+			m_InstanceStorageBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+			for (auto& instanceBuffer : m_InstanceStorageBuffers)
 			{
-				uniformBuffer = std::make_unique<Buffer>(uniformBufferSpec);
-				uniformBuffer->MapMemory(bufferSize);
+				instanceBuffer = std::make_unique<Buffer>(instanceBufferSpec);
+				instanceBuffer->MapMemory(instanceBuffer->GetBufferSize());
 			}
+		}
 
+		/////////////////////////////////////// Preparing Shadow Mapping Pass ///////////////////////////////////////
+		{
 			// Creating Descriptors
 			DescriptorSetLayoutSpecification shadowDescSetLayoutSpec;
 			shadowDescSetLayoutSpec.Bindings.emplace_back();
 			shadowDescSetLayoutSpec.Bindings[0].binding = 0;
-			shadowDescSetLayoutSpec.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			shadowDescSetLayoutSpec.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			shadowDescSetLayoutSpec.Bindings[0].descriptorCount = 1;
 			shadowDescSetLayoutSpec.Bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-			m_ShadowMapDescriptorSetLayout = DescriptorSetLayout::CreateOrGetCached(shadowDescSetLayoutSpec);
-
-			DescriptorSetSpecification shadowMapDescSetSpec;
-			shadowMapDescSetSpec.Layout = m_ShadowMapDescriptorSetLayout;
-
-			m_ShadowMapDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-			for (uint32_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
-			{
-				m_ShadowMapDescriptorSets[i] = CreateRef<DescriptorSet>(shadowMapDescSetSpec);
-
-				VkDescriptorBufferInfo bufferInfo{};
-				bufferInfo.buffer = m_ShadowMapUniformBuffers[i]->GetVulkanBuffer();
-				bufferInfo.range = bufferSize;
-				bufferInfo.offset = 0;
-
-				m_ShadowMapDescriptorSets[i]->WriteBuffer(0, bufferInfo);
-
-				m_ShadowMapDescriptorSets[i]->Update();
-			}
-
-			PipelineSpecification pipelineSpec{};
-			pipelineSpec.Shader = ShaderLibrary::Get("DirectionalShadowMap");
-			pipelineSpec.RenderPass = m_ShadowMapRenderPass;
-
-			pipelineSpec.VertexLayout = {
-				ShaderDataType::Float3,	 // a_Position
-				ShaderDataType::Dummy12, // Normal (Unnecessary)
-				ShaderDataType::Dummy8,	 // TextureCoords (Unnecessary)
-				ShaderDataType::Dummy12, // Tangent (Unnecessary)
-				ShaderDataType::Dummy12	 // BiTangent (Unnecessary)
-			};
-
-			pipelineSpec.Viewport.width = SceneRendererSettings::CascadeSize;
-			pipelineSpec.Viewport.height = SceneRendererSettings::CascadeSize;
-			pipelineSpec.Scissor = { { 0, 0 }, { SceneRendererSettings::CascadeSize, SceneRendererSettings::CascadeSize } };
-
-			pipelineSpec.CullMode = VK_CULL_MODE_FRONT_BIT;
-			pipelineSpec.DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-			pipelineSpec.DepthClampEnable = true;
+			// Instance Storage Buffer
+			shadowDescSetLayoutSpec.Bindings.emplace_back();
+			shadowDescSetLayoutSpec.Bindings[1].binding = 1;
+			shadowDescSetLayoutSpec.Bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			shadowDescSetLayoutSpec.Bindings[1].descriptorCount = 1;
+			shadowDescSetLayoutSpec.Bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-			m_ShadowMapPipeline = CreateRef<Pipeline>(pipelineSpec);
+			// The descriptor sets are transient, as they refer to the instance storage buffer the shadow casters of the frame are written into
+			m_ShadowMapDescriptorSetLayout = DescriptorSetLayout::CreateOrGetCached(shadowDescSetLayoutSpec);
 
 			VkSamplerCreateInfo sampler_info{};
 			sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -199,6 +173,8 @@ namespace Flameberry {
 			sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 
 			VK_CHECK_RESULT(vkCreateSampler(device, &sampler_info, nullptr, &m_ShadowMapSampler));
+
+			CreateShadowMapResources();
 		}
 		/////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -207,50 +183,55 @@ namespace Flameberry {
 			// Scene
 			VkDeviceSize uniformBufferSize = sizeof(CameraUniformBufferObject);
 
-			BufferSpecification uniformBufferSpec;
-			uniformBufferSpec.InstanceCount = 1;
-			uniformBufferSpec.InstanceSize = uniformBufferSize;
-			uniformBufferSpec.Usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-			uniformBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-			m_CameraUniformBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-			for (auto& uniformBuffer : m_CameraUniformBuffers)
-			{
-				uniformBuffer = std::make_unique<Buffer>(uniformBufferSpec);
-				uniformBuffer->MapMemory(uniformBufferSize);
-			}
-
 			// Creating Descriptors
 			DescriptorSetLayoutSpecification cameraBufferDescLayoutSpec;
 			cameraBufferDescLayoutSpec.Bindings.emplace_back();
 
 			cameraBufferDescLayoutSpec.Bindings[0].binding = 0;
-			cameraBufferDescLayoutSpec.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			cameraBufferDescLayoutSpec.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			cameraBufferDescLayoutSpec.Bindings[0].descriptorCount = 1;
 			cameraBufferDescLayoutSpec.Bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
+			// The camera descriptor set is allocated from the transient descriptor allocator by every `RenderScene()` call
 			m_CameraBufferDescSetLayout = DescriptorSetLayout::CreateOrGetCached(cameraBufferDescLayoutSpec);
 
-			DescriptorSetSpecification cameraBufferDescSetSpec;
-			cameraBufferDescSetSpec.Layout = m_CameraBufferDescSetLayout;
+			// The mesh descriptor set is the camera descriptor set extended by the instance storage buffer
+			DescriptorSetLayoutSpecification meshDescLayoutSpec = cameraBufferDescLayoutSpec;
+			meshDescLayoutSpec.Bindings.emplace_back();
 
-			m_CameraBufferDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+			meshDescLayoutSpec.Bindings[1].binding = 1;
+			meshDescLayoutSpec.Bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			meshDescLayoutSpec.Bindings[1].descriptorCount = 1;
+			meshDescLayoutSpec.Bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+			m_MeshDescriptorSetLayout = DescriptorSetLayout::CreateOrGetCached(meshDescLayoutSpec);
+
+			DescriptorSetSpecification meshDescSetSpec;
+			meshDescSetSpec.Layout = m_MeshDescriptorSetLayout;
+
+			m_MeshDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
 			for (uint32_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
 			{
-				m_CameraBufferDescriptorSets[i] = CreateRef<DescriptorSet>(cameraBufferDescSetSpec);
+				m_MeshDescriptorSets[i] = CreateRef<DescriptorSet>(meshDescSetSpec);
+
+				VkDescriptorBufferInfo cameraBufferInfo{};
+				cameraBufferInfo.buffer = UniformRing::GetBuffer(i);
+				cameraBufferInfo.offset = 0;
+				cameraBufferInfo.range = uniformBufferSize;
 
-				VkDescriptorBufferInfo vk_descriptor_buffer_info{};
-				vk_descriptor_buffer_info.buffer = m_CameraUniformBuffers[i]->GetVulkanBuffer();
-				vk_descriptor_buffer_info.offset = 0;
-				vk_descriptor_buffer_info.range = uniformBufferSize;
+				VkDescriptorBufferInfo instanceBufferInfo{};
+				instanceBufferInfo.buffer = m_InstanceStorageBuffers[i]->GetVulkanBuffer();
+				instanceBufferInfo.offset = 0;
+				instanceBufferInfo.range = VK_WHOLE_SIZE;
 
-				m_CameraBufferDescriptorSets[i]->WriteBuffer(0, vk_descriptor_buffer_info);
-				m_CameraBufferDescriptorSets[i]->Update();
+				m_MeshDescriptorSets[i]->WriteBuffer(0, cameraBufferInfo);
+				m_MeshDescriptorSets[i]->WriteBuffer(1, instanceBufferInfo);
+				m_MeshDescriptorSets[i]->Update();
 			}
 
 			FramebufferSpecification sceneFramebufferSpec;
-			sceneFramebufferSpec.Width = m_ViewportSize.x;
-			sceneFramebufferSpec.Height = m_ViewportSize.y;
+			sceneFramebufferSpec.Width = m_RenderTargetSize.x;
+			sceneFramebufferSpec.Height = m_RenderTargetSize.y;
 			sceneFramebufferSpec.Attachments = { swapchainImageFormat, SwapChain::GetDepthFormat() };
 			sceneFramebufferSpec.Samples = sampleCount;
 			sceneFramebufferSpec.ClearColorValue = { 0.0f, 0.0f, 0.0f, 1.0f };
@@ -290,30 +271,43 @@ namespace Flameberry {
 
 			{
 				// Creating Mesh Pipeline
-				VkDeviceSize uniformBufferSize = sizeof(SceneUniformBufferData);
+				// Light Storage Buffers: Point Lights, Spot Lights, Light Clusters and Light Indices
+				const VkDeviceSize lightStorageElementSizes[4] = { sizeof(PointLight), sizeof(SpotLight), sizeof(LightCluster), sizeof(uint32_t) };
 
-				BufferSpecification bufferSpec;
-				bufferSpec.InstanceCount = 1;
-				bufferSpec.InstanceSize = uniformBufferSize;
-				bufferSpec.Usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-				bufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-				m_SceneUniformBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-				for (auto& uniformBuffer : m_SceneUniformBuffers)
+				m_LightStorageBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+				for (auto& lightStorageBuffers : m_LightStorageBuffers)
 				{
-					uniformBuffer = std::make_unique<Buffer>(bufferSpec);
-					uniformBuffer->MapMemory(uniformBufferSize);
+					for (uint32_t i = 0; i < 4; i++)
+					{
+						BufferSpecification storageBufferSpec;
+						storageBufferSpec.InstanceCount = s_InitialLightStorageCapacities[i];
+						storageBufferSpec.InstanceSize = lightStorageElementSizes[i];
+						storageBufferSpec.Usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+						storageBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+						lightStorageBuffers[i] = std::make_unique<Buffer>(storageBufferSpec);
+						lightStorageBuffers[i]->MapMemory(lightStorageBuffers[i]->GetBufferSize());
+					}
 				}
 
 				DescriptorSetLayoutSpecification sceneDescSetLayoutSpec;
-				sceneDescSetLayoutSpec.Bindings.resize(1);
+				sceneDescSetLayoutSpec.Bindings.resize(6);
 
 				// Scene Uniform Buffer
 				sceneDescSetLayoutSpec.Bindings[0].binding = 0;
-				sceneDescSetLayoutSpec.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+				sceneDescSetLayoutSpec.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 				sceneDescSetLayoutSpec.Bindings[0].descriptorCount = 1;
 				sceneDescSetLayoutSpec.Bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
+				// Light Storage Buffers followed by the Material Parameter Buffer
+				for (uint32_t i = 1; i < 6; i++)
+				{
+					sceneDescSetLayoutSpec.Bindings[i].binding = i;
+					sceneDescSetLayoutSpec.Bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					sceneDescSetLayoutSpec.Bindings[i].descriptorCount = 1;
+					sceneDescSetLayoutSpec.Bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+				}
+
 				m_SceneDescriptorSetLayout = DescriptorSetLayout::CreateOrGetCached(sceneDescSetLayoutSpec);
 
 				DescriptorSetSpecification sceneDescSetSpec;
@@ -327,9 +321,28 @@ namespace Flameberry {
 					VkDescriptorBufferInfo bufferInfo{};
 					bufferInfo.range = sizeof(SceneUniformBufferData);
 					bufferInfo.offset = 0;
-					bufferInfo.buffer = m_SceneUniformBuffers[i]->GetVulkanBuffer();
+					bufferInfo.buffer = UniformRing::GetBuffer(i);
 
 					m_SceneDataDescriptorSets[i]->WriteBuffer(0, bufferInfo);
+
+					// The buffer infos are referenced until the descriptor set is updated
+					VkDescriptorBufferInfo storageBufferInfos[4]{};
+					for (uint32_t binding = 1; binding < 5; binding++)
+					{
+						storageBufferInfos[binding - 1].range = VK_WHOLE_SIZE;
+						storageBufferInfos[binding - 1].offset = 0;
+						storageBufferInfos[binding - 1].buffer = m_LightStorageBuffers[i][binding - 1]->GetVulkanBuffer();
+
+						m_SceneDataDescriptorSets[i]->WriteBuffer(binding, storageBufferInfos[binding - 1]);
+					}
+
+					VkDescriptorBufferInfo materialBufferInfo{};
+					materialBufferInfo.range = VK_WHOLE_SIZE;
+					materialBufferInfo.offset = 0;
+					materialBufferInfo.buffer = MaterialParameterBuffer::GetBuffer(i);
+
+					m_SceneDataDescriptorSets[i]->WriteBuffer(5, materialBufferInfo);
+
 					m_SceneDataDescriptorSets[i]->Update();
 				}
 
@@ -386,7 +399,8 @@ namespace Flameberry {
 				pipelineSpec.StencilOpState.reference = 1;
 				pipelineSpec.StencilOpState.writeMask = 1;
 
-				m_MeshPipeline = CreateRef<Pipeline>(pipelineSpec);
+				// The variant with all the features enabled is what the shader used to branch into at runtime, and is created up front
+				m_MeshPipelines = CreateUnique<PipelinePermutationCache>(pipelineSpec, MeshPipelineFeature_Count, MeshPipelineFeature_All);
 			}
 
 			// Skybox Pipeline
@@ -504,25 +518,265 @@ namespace Flameberry {
 		m_DirectionalLightIcon = Texture2D::TryGetOrLoadTexture(FBY_PROJECT_DIR "Flameberry/Assets/Icons/SunIcon.png");
 	}
 
-	void SceneRenderer::RenderScene(const glm::vec2& viewportSize, const Ref<Scene>& scene, const GenericCamera& camera, const glm::vec3& cameraPosition, FEntity selectedEntity, bool renderGrid, bool renderDebugIcons, bool renderOutline, bool renderPhysicsCollider)
+	void SceneRenderer::CreateShadowMapResources()
+	{
+		auto& settings = m_RendererSettings;
+		settings.CascadeCount = std::clamp(settings.CascadeCount, SceneRendererSettings::MinCascadeCount, SceneRendererSettings::MaxCascadeCount);
+
+		m_ShadowMapCascadeCount = settings.CascadeCount;
+		m_ShadowMapCascadeSize = settings.CascadeSize;
+
+		// The new static shadow map has to be cleared and all of the cached cascades have to be rendered again
+		m_DirtyStaticCascadeMask = ~0u;
+		for (auto& cacheKey : m_CascadeCacheKeys)
+			cacheKey = CascadeCacheKey{};
+
+		// The shadow maps of the frame and the static shadow map are loaded, as their contents are copied into them before the passes begin
+		FramebufferSpecification shadowMapFramebufferSpec;
+		shadowMapFramebufferSpec.Width = m_ShadowMapCascadeSize;
+		shadowMapFramebufferSpec.Height = m_ShadowMapCascadeSize;
+		shadowMapFramebufferSpec.Attachments = { { VK_FORMAT_D32_SFLOAT, m_ShadowMapCascadeCount } };
+		shadowMapFramebufferSpec.Samples = 1;
+		shadowMapFramebufferSpec.DepthLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		shadowMapFramebufferSpec.DepthStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+		shadowMapFramebufferSpec.DepthStencilClearValue = { 1.0f, 0 };
+
+		RenderPassSpecification shadowMapRenderPassSpec;
+		shadowMapRenderPassSpec.TargetFramebuffers.resize(VulkanContext::GetCurrentWindow()->GetSwapChain()->GetSwapChainImageCount());
+		shadowMapRenderPassSpec.Dependencies = {
+			{
+				VK_SUBPASS_EXTERNAL,						  // uint32_t                   srcSubpass
+				0,											  // uint32_t                   dstSubpass
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,		  // VkPipelineStageFlags       srcStageMask
+				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,	  // VkPipelineStageFlags       dstStageMask
+				VK_ACCESS_SHADER_READ_BIT,					  // VkAccessFlags              srcAccessMask
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, // VkAccessFlags              dstAccessMask
+				VK_DEPENDENCY_BY_REGION_BIT					  // VkDependencyFlags          dependencyFlags
+			},
+			{
+				0,											  // uint32_t                   srcSubpass
+				VK_SUBPASS_EXTERNAL,						  // uint32_t                   dstSubpass
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,	  // VkPipelineStageFlags       srcStageMask
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,		  // VkPipelineStageFlags       dstStageMask
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, // VkAccessFlags              srcAccessMask
+				VK_ACCESS_SHADER_READ_BIT,					  // VkAccessFlags              dstAccessMask
+				VK_DEPENDENCY_BY_REGION_BIT					  // VkDependencyFlags          dependencyFlags
+			}
+		};
+
+		RenderPassSpecification staticShadowMapRenderPassSpec = shadowMapRenderPassSpec;
+		staticShadowMapRenderPassSpec.TargetFramebuffers = { CreateRef<Framebuffer>(shadowMapFramebufferSpec) };
+
+		for (auto& framebuffer : shadowMapRenderPassSpec.TargetFramebuffers)
+			framebuffer = CreateRef<Framebuffer>(shadowMapFramebufferSpec);
+
+		m_ShadowMapRenderPass = CreateRef<RenderPass>(shadowMapRenderPassSpec);
+
+		RenderPassSpecification shadowMapClearRenderPassSpec = shadowMapRenderPassSpec;
+		shadowMapClearRenderPassSpec.DepthLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		m_ShadowMapClearRenderPass = CreateRef<RenderPass>(shadowMapClearRenderPassSpec);
+
+		m_StaticShadowMapRenderPass = CreateRef<RenderPass>(staticShadowMapRenderPassSpec);
+
+		// Both the render passes are compatible, hence they share the pipeline
+		PipelineSpecification pipelineSpec{};
+		pipelineSpec.Shader = ShaderLibrary::Get("DirectionalShadowMap");
+		pipelineSpec.RenderPass = m_ShadowMapRenderPass;
+
+		pipelineSpec.VertexLayout = {
+			ShaderDataType::Float3,	 // a_Position
+			ShaderDataType::Dummy12, // Normal (Unnecessary)
+			ShaderDataType::Dummy8,	 // TextureCoords (Unnecessary)
+			ShaderDataType::Dummy12, // Tangent (Unnecessary)
+			ShaderDataType::Dummy12	 // BiTangent (Unnecessary)
+		};
+
+		pipelineSpec.Viewport.width = m_ShadowMapCascadeSize;
+		pipelineSpec.Viewport.height = m_ShadowMapCascadeSize;
+		pipelineSpec.Scissor = { { 0, 0 }, { m_ShadowMapCascadeSize, m_ShadowMapCascadeSize } };
+
+		pipelineSpec.CullMode = VK_CULL_MODE_FRONT_BIT;
+		pipelineSpec.DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		pipelineSpec.DepthClampEnable = true;
+
+		m_ShadowMapPipeline = CreateRef<Pipeline>(pipelineSpec);
+
+		// The descriptor sets referring to the shadow maps are created along with the geometry pass, so they are only updated on recreation
+		for (uint32_t i = 0; i < m_ShadowMapRefDescSets.size(); i++)
+		{
+			VkDescriptorImageInfo imageInfo{};
+			imageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			imageInfo.imageView = m_ShadowMapRenderPass->GetSpecification().TargetFramebuffers[i]->GetDepthAttachment()->GetVulkanImageView();
+			imageInfo.sampler = m_ShadowMapSampler;
+
+			m_ShadowMapRefDescSets[i]->WriteImage(0, imageInfo);
+			m_ShadowMapRefDescSets[i]->Update();
+		}
+
+		FBY_INFO("Created shadow maps with {} cascades of size {}", m_ShadowMapCascadeCount, m_ShadowMapCascadeSize);
+	}
+
+	void SceneRenderer::RenderScene(const glm::vec2& viewportSize, const SceneRenderProxies& proxies, const GenericCamera& camera, const glm::vec3& cameraPosition, bool renderGrid, bool renderDebugIcons, bool renderOutline, bool renderPhysicsCollider)
 	{
-		RenderScene(viewportSize, scene, camera.GetViewMatrix(), camera.GetProjectionMatrix(), cameraPosition, camera.GetSettings().Near, camera.GetSettings().Far, selectedEntity, renderGrid, renderDebugIcons, renderOutline, renderPhysicsCollider);
+		RenderScene(viewportSize, proxies, camera.GetViewMatrix(), camera.GetProjectionMatrix(), cameraPosition, camera.GetSettings().Near, camera.GetSettings().Far, renderGrid, renderDebugIcons, renderOutline, renderPhysicsCollider);
 	}
 
-	void SceneRenderer::RenderScene(const glm::vec2& viewportSize, const Ref<Scene>& scene, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& cameraPosition, float cameraNear, float cameraFar, FEntity selectedEntity, bool renderGrid, bool renderDebugIcons, bool renderOutline, bool renderPhysicsCollider)
+	const SceneRenderProxies& SceneRenderer::ExtractScene(const Ref<Scene>& scene, FEntity selectedEntity)
+	{
+		FBY_PROFILE_SCOPE("ExtractScene");
+
+		auto& previousProxies = m_SceneProxies[(m_NextSceneProxiesIndex + 1) % 2];
+		auto& proxies = m_SceneProxies[m_NextSceneProxiesIndex];
+		m_NextSceneProxiesIndex = (m_NextSceneProxiesIndex + 1) % 2;
+
+		proxies.Clear();
+
+		// The caches of the extraction are handed over from the previous proxies, which aren't accessed by the extraction anymore
+		proxies.MeshBoundsCache = std::move(previousProxies.MeshBoundsCache);
+		proxies.ExtractionIndex = previousProxies.ExtractionIndex + 1;
+
+		// The render proxies and their bounds are shared by the shadow, geometry and mouse picking passes
+		ExtractMeshEntities(scene, proxies);
+
+		for (const auto entity : scene->GetRegistry()->Group<TransformComponent, SkyLightComponent>())
+		{
+			const auto& skyLight = scene->GetRegistry()->GetComponent<SkyLightComponent>(entity);
+			proxies.SkyLightIntensity = skyLight.Intensity;
+			proxies.SkymapAsset = skyLight.EnableSkymap && AssetManager::IsAssetHandleValid(skyLight.Skymap) ? AssetManager::GetAsset<Skymap>(skyLight.Skymap) : nullptr;
+
+			// The empty skymap is used while the cubemaps are being generated
+			if (proxies.SkymapAsset && !proxies.SkymapAsset->IsReady())
+				proxies.SkymapAsset = nullptr;
+		}
+
+		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, DirectionalLightComponent>())
+		{
+			const auto& [transform, dirLight] = scene->GetRegistry()->GetComponent<TransformComponent, DirectionalLightComponent>(entity);
+
+			proxies.HasDirectionalLight = true;
+			proxies.DirLight.Color = dirLight.Color;
+			proxies.DirLight.Intensity = dirLight.Intensity;
+			// NOTE: X direction is 0.000001f to avoid shadows being not rendered when directional light perspective camera is looking directly downwards
+			proxies.DirLight.Direction = glm::rotate(glm::quat(transform.Rotation), glm::vec3(0.000001f, -1.0f, 0.0f));
+			proxies.DirLight.LightSize = dirLight.LightSize;
+
+			proxies.DirectionalLightIcons.emplace_back(BillboardProxy{ transform.Translation, (int)entity.GetIndex() });
+		}
+
+		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, PointLightComponent>())
+		{
+			const auto& [transform, light] = scene->GetRegistry()->GetComponent<TransformComponent, PointLightComponent>(entity);
+
+			PointLight& pointLight = proxies.PointLights.emplace_back();
+			pointLight.Position = transform.Translation;
+			pointLight.Range = CalculateLightRange(light.Color, light.Intensity);
+			pointLight.Color = light.Color;
+			pointLight.Intensity = light.Intensity;
+
+			proxies.PointLightEntityIndices.emplace_back((int)entity.GetIndex());
+		}
+
+		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, SpotLightComponent>())
+		{
+			const auto& [transform, light] = scene->GetRegistry()->GetComponent<TransformComponent, SpotLightComponent>(entity);
+
+			SpotLight& spotLight = proxies.SpotLights.emplace_back();
+			spotLight.Position = transform.Translation;
+			spotLight.Range = CalculateLightRange(light.Color, light.Intensity);
+			spotLight.Direction = glm::rotate(glm::quat(transform.Rotation), glm::vec3(0.000001f, -1.0f, 0.0f));
+			spotLight.Color = light.Color;
+			spotLight.Intensity = light.Intensity;
+			spotLight.InnerConeAngle = glm::radians(light.InnerConeAngle);
+			spotLight.OuterConeAngle = glm::radians(light.OuterConeAngle);
+
+			proxies.SpotLightEntityIndices.emplace_back((int)entity.GetIndex());
+		}
+
+		for (const auto entity : scene->GetRegistry()->Group<TransformComponent, CameraComponent>())
+		{
+			const auto& transform = scene->GetRegistry()->GetComponent<TransformComponent>(entity);
+			proxies.CameraIcons.emplace_back(BillboardProxy{ transform.Translation, (int)entity.GetIndex() });
+		}
+
+		if (selectedEntity != FEntity::Null)
+		{
+			if (const auto* transform = scene->GetRegistry()->TryGetComponent<TransformComponent>(selectedEntity))
+			{
+				auto& selected = proxies.SelectedEntity;
+				selected.IsValid = true;
+				selected.Transform = *transform;
+
+				if (const auto* boxCollider = scene->GetRegistry()->TryGetComponent<BoxColliderComponent>(selectedEntity))
+				{
+					selected.HasBoxCollider = true;
+					selected.BoxCollider = *boxCollider;
+				}
+				if (const auto* sphereCollider = scene->GetRegistry()->TryGetComponent<SphereColliderComponent>(selectedEntity))
+				{
+					selected.HasSphereCollider = true;
+					selected.SphereCollider = *sphereCollider;
+				}
+				if (const auto* capsuleCollider = scene->GetRegistry()->TryGetComponent<CapsuleColliderComponent>(selectedEntity))
+				{
+					selected.HasCapsuleCollider = true;
+					selected.CapsuleCollider = *capsuleCollider;
+				}
+				if (const auto* cameraComp = scene->GetRegistry()->TryGetComponent<CameraComponent>(selectedEntity))
+				{
+					selected.HasCamera = true;
+					selected.CameraSettings = cameraComp->Camera.GetSettings();
+				}
+			}
+		}
+
+		for (const auto entity : scene->GetRegistry()->Group<TransformComponent, TextComponent>())
+		{
+			const auto& [transform, text] = scene->GetRegistry()->GetComponent<TransformComponent, TextComponent>(entity);
+			proxies.Texts.emplace_back(TextProxy{ text.TextString, AssetManager::GetAsset<Font>(text.Font), transform.CalculateTransform(), text.Color, text.Kerning, text.LineSpacing, (int)entity.GetIndex() });
+		}
+
+		return proxies;
+	}
+
+	void SceneRenderer::RenderScene(const glm::vec2& viewportSize, const SceneRenderProxies& proxies, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& cameraPosition, float cameraNear, float cameraFar, bool renderGrid, bool renderDebugIcons, bool renderOutline, bool renderPhysicsCollider)
 	{
 		uint32_t currentFrame = Renderer::GetCurrentFrameIndex();
-		std::vector<FEntity> pointLightEntityHandles, spotLightEntityHandles;
+
+		// Recreate the shadow maps when the cascade settings are changed
+		if (m_RendererSettings.CascadeCount != m_ShadowMapCascadeCount || m_RendererSettings.CascadeSize != m_ShadowMapCascadeSize)
+		{
+			Renderer::WaitForRenderThread();
+			VulkanContext::GetCurrentDevice()->WaitIdle();
+			CreateShadowMapResources();
+		}
+
+		// TODO: Temporarily placing this code here, it is inefficient to keep these arrays filled till the next frame
+		m_RendererData->Clear();
+		m_InstanceCount = 0;
+
+		// The frame which last used this frame index is complete, so the buffers it retired are no longer in use
+		m_RetiredStorageBuffers[currentFrame].clear();
+		m_RenderedProxies = &proxies;
 
 		m_ViewportSize = viewportSize;
 
+		UpdateRenderScale();
+		{
+			// The GPU timings of this frame are read back a few frames later, so the render scale it's rendered at is kept till then
+			const uint64_t frameNumber = GPUProfiler::GetFrameNumber();
+			m_RenderScaleSamples[frameNumber % m_RenderScaleSamples.size()] = RenderScaleSample{ frameNumber, m_RenderScale };
+		}
+		m_RenderTargetSize = glm::max(m_RenderTargetSize, glm::floor(viewportSize));
+		m_RenderExtent = glm::floor(viewportSize * m_RenderScale);
+
 		// Resize Framebuffers
-		Renderer::Submit([&](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
+		// The size is captured by value as the main thread might update `m_RenderTargetSize` while the render thread executes this
+		Renderer::Submit([this, renderTargetSize = m_RenderTargetSize](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
 			{
 				const auto& framebufferSpec = m_GeometryPass->GetSpecification().TargetFramebuffers[imageIndex]->GetSpecification();
-				if (!(m_ViewportSize.x == 0 || m_ViewportSize.y == 0) && (framebufferSpec.Width != m_ViewportSize.x || framebufferSpec.Height != m_ViewportSize.y))
+				if (!(renderTargetSize.x == 0 || renderTargetSize.y == 0) && (framebufferSpec.Width != renderTargetSize.x || framebufferSpec.Height != renderTargetSize.y))
 				{
-					m_GeometryPass->GetSpecification().TargetFramebuffers[imageIndex]->OnResize(m_ViewportSize.x, m_ViewportSize.y, m_GeometryPass->GetRenderPass());
+					m_GeometryPass->GetSpecification().TargetFramebuffers[imageIndex]->OnResize(renderTargetSize.x, renderTargetSize.y, m_GeometryPass->GetRenderPass());
 
 #if 0
                     VkDescriptorImageInfo imageInfo{
@@ -548,49 +802,77 @@ namespace Flameberry {
 		cameraBufferData.ProjectionMatrix = projectionMatrix;
 		cameraBufferData.ViewProjectionMatrix = projectionMatrix * viewMatrix;
 
-		m_CameraUniformBuffers[currentFrame]->WriteToBuffer(&cameraBufferData, sizeof(CameraUniformBufferObject));
-
-		SceneUniformBufferData sceneUniformBufferData;
+		// The uniform data is allocated from the uniform ring, hence every `RenderScene()` call of the frame keeps it's own copy
+		m_CameraBufferOffset = UniformRing::Write(&cameraBufferData, sizeof(CameraUniformBufferObject));
 
-		// Keep the skylight ready
-		SkyLightComponent* skymap = nullptr;
-		for (const auto entity : scene->GetRegistry()->Group<TransformComponent, SkyLightComponent>())
 		{
-			skymap = scene->GetRegistry()->TryGetComponent<SkyLightComponent>(entity);
-			sceneUniformBufferData.SkyLightIntensity = skymap->Intensity;
+			m_CameraBufferDescriptorSet = Renderer::AllocateTransientDescriptorSet(m_CameraBufferDescSetLayout);
+
+			VkDescriptorBufferInfo cameraBufferInfo{};
+			cameraBufferInfo.buffer = UniformRing::GetBuffer(currentFrame);
+			cameraBufferInfo.offset = 0;
+			cameraBufferInfo.range = sizeof(CameraUniformBufferObject);
+
+			VkWriteDescriptorSet cameraBufferWrite{};
+			cameraBufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			cameraBufferWrite.dstSet = m_CameraBufferDescriptorSet;
+			cameraBufferWrite.dstBinding = 0;
+			cameraBufferWrite.descriptorCount = 1;
+			cameraBufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			cameraBufferWrite.pBufferInfo = &cameraBufferInfo;
+
+			vkUpdateDescriptorSets(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), 1, &cameraBufferWrite, 0, nullptr);
 		}
 
+		SceneUniformBufferData sceneUniformBufferData;
+		sceneUniformBufferData.SkyLightIntensity = proxies.SkyLightIntensity;
+
 		// Important variable
 		bool shouldRenderShadows = false;
+		uint32_t shadowCasterSubMeshCount = 0;
 
-		// Update Directional Lights
-		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, DirectionalLightComponent>())
+		if (proxies.HasDirectionalLight)
 		{
-			auto [transform, dirLight] = scene->GetRegistry()->GetComponent<TransformComponent, DirectionalLightComponent>(entity);
-			sceneUniformBufferData.directionalLight.Color = dirLight.Color;
-			sceneUniformBufferData.directionalLight.Intensity = dirLight.Intensity;
-
-			// NOTE: X direction is 0.000001f to avoid shadows being not rendered when directional light perspective camera is looking directly downwards
-			sceneUniformBufferData.directionalLight.Direction = glm::rotate(glm::quat(transform.Rotation), glm::vec3(0.000001f, -1.0f, 0.0f));
-			sceneUniformBufferData.directionalLight.LightSize = dirLight.LightSize;
+			sceneUniformBufferData.directionalLight = proxies.DirLight;
+			shouldRenderShadows = m_RendererSettings.EnableShadows;
+		}
 
-			shouldRenderShadows = m_RendererSettings.EnableShadows && true;
+		// The static cascades rendered by a dropped frame never reached the GPU, hence they are rendered again
+		// If this renderer didn't render the frame right before this one, it can't tell whether that frame was dropped
+		const uint64_t frameNumber = Renderer::GetFrameNumber();
+		if (m_PendingStaticCascadeMask && m_PendingStaticCascadeFrameNumber != frameNumber)
+		{
+			const bool isPendingFrameSubmitted = m_PendingStaticCascadeFrameNumber + 1 == frameNumber && !Renderer::WasLastFrameDropped();
+			if (!isPendingFrameSubmitted)
+				m_DirtyStaticCascadeMask |= m_PendingStaticCascadeMask;
+			m_PendingStaticCascadeMask = 0;
 		}
 
 		if (shouldRenderShadows)
 		{
-			// TODO: Calculate these only when camera or directional light is updated
+			// The cascades which are switched between being cached and not cached have to be cleared
+			const uint32_t cachedCascadeMask = GetCachedCascadeMask();
+			m_DirtyStaticCascadeMask |= cachedCascadeMask ^ m_CachedCascadeMask;
+			m_CachedCascadeMask = cachedCascadeMask;
+
 			CalculateShadowMapCascades(cameraBufferData.ViewProjectionMatrix, cameraNear, cameraFar, sceneUniformBufferData.directionalLight.Direction);
-			glm::mat4 cascades[SceneRendererSettings::CascadeCount];
-			for (uint8_t i = 0; i < SceneRendererSettings::CascadeCount; i++)
+			InvalidateStaticShadowCascades();
+
+			glm::mat4 cascades[SceneRendererSettings::MaxCascadeCount];
+			for (uint8_t i = 0; i < SceneRendererSettings::MaxCascadeCount; i++)
 				cascades[i] = m_Cascades[i].ViewProjectionMatrix;
 
-			m_ShadowMapUniformBuffers[currentFrame]->WriteToBuffer(cascades, sizeof(glm::mat4) * SceneRendererSettings::CascadeCount);
+			m_ShadowMapBufferOffset = UniformRing::Write(cascades, sizeof(glm::mat4) * SceneRendererSettings::MaxCascadeCount);
+		}
+		else
+		{
+			// The changes of the static shadow casters are not tracked while the shadows are disabled
+			m_DirtyStaticCascadeMask = ~0u;
 		}
 
 		sceneUniformBufferData.cameraPosition = cameraPosition;
 
-		for (uint32_t i = 0; i < SceneRendererSettings::CascadeCount; i++)
+		for (uint32_t i = 0; i < SceneRendererSettings::MaxCascadeCount; i++)
 		{
 			sceneUniformBufferData.CascadeViewProjectionMatrices[i] = m_Cascades[i].ViewProjectionMatrix;
 			sceneUniformBufferData.CascadeDepthSplits[i] = m_Cascades[i].DepthSplit;
@@ -602,83 +884,152 @@ namespace Flameberry {
 		sceneUniformBufferData.RendererSettings.GammaCorrectionFactor = m_RendererSettings.GammaCorrectionFactor;
 		sceneUniformBufferData.RendererSettings.Exposure = m_RendererSettings.Exposure;
 
-		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, PointLightComponent>())
+		// Clustered Lighting: Every fragment only evaluates the lights assigned to the cluster that it lies in
 		{
-			const auto& [transform, light] = scene->GetRegistry()->GetComponent<TransformComponent, PointLightComponent>(entity);
-			sceneUniformBufferData.PointLights[sceneUniformBufferData.PointLightCount].Position = transform.Translation;
-			sceneUniformBufferData.PointLights[sceneUniformBufferData.PointLightCount].Color = light.Color;
-			sceneUniformBufferData.PointLights[sceneUniformBufferData.PointLightCount].Intensity = light.Intensity;
-			sceneUniformBufferData.PointLightCount++;
+			// The clusters are indexed by the fragment coordinates, which span the render extent
+			m_LightClusterGrid.Update(projectionMatrix, cameraNear, cameraFar, m_RenderExtent);
+			m_LightClusterGrid.AssignLights(viewMatrix, proxies.PointLights, proxies.SpotLights, m_CullingThreadPool.get());
 
-			pointLightEntityHandles.emplace_back(entity);
-		}
+			const auto& clusters = m_LightClusterGrid.GetClusters();
+			const auto& lightIndices = m_LightClusterGrid.GetLightIndices();
 
-		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, SpotLightComponent>())
-		{
-			const auto& [transform, light] = scene->GetRegistry()->GetComponent<TransformComponent, SpotLightComponent>(entity);
-			sceneUniformBufferData.SpotLights[sceneUniformBufferData.SpotLightCount].Position = transform.Translation;
-			sceneUniformBufferData.SpotLights[sceneUniformBufferData.SpotLightCount].Direction = glm::rotate(glm::quat(transform.Rotation), glm::vec3(0.000001f, -1.0f, 0.0f));
-			sceneUniformBufferData.SpotLights[sceneUniformBufferData.SpotLightCount].Color = light.Color;
-			sceneUniformBufferData.SpotLights[sceneUniformBufferData.SpotLightCount].Intensity = light.Intensity;
-			sceneUniformBufferData.SpotLights[sceneUniformBufferData.SpotLightCount].InnerConeAngle = glm::radians(light.InnerConeAngle);
-			sceneUniformBufferData.SpotLights[sceneUniformBufferData.SpotLightCount].OuterConeAngle = glm::radians(light.OuterConeAngle);
-			sceneUniformBufferData.SpotLightCount++;
-
-			spotLightEntityHandles.emplace_back(entity);
+			WriteLightStorageBuffer(1, proxies.PointLights.data(), (uint32_t)proxies.PointLights.size(), sizeof(PointLight));
+			WriteLightStorageBuffer(2, proxies.SpotLights.data(), (uint32_t)proxies.SpotLights.size(), sizeof(SpotLight));
+			WriteLightStorageBuffer(3, clusters.data(), (uint32_t)clusters.size(), sizeof(LightCluster));
+			WriteLightStorageBuffer(4, lightIndices.data(), (uint32_t)lightIndices.size(), sizeof(uint32_t));
+
+			sceneUniformBufferData.ClusterTileSize = m_LightClusterGrid.GetTileSize();
+			sceneUniformBufferData.ClusterDepthSliceScaleBias = m_LightClusterGrid.GetDepthSliceScaleBias();
 		}
 
-		m_SceneUniformBuffers[currentFrame]->WriteToBuffer(&sceneUniformBufferData, sizeof(SceneUniformBufferData));
+		m_SceneBufferOffset = UniformRing::Write(&sceneUniformBufferData, sizeof(SceneUniformBufferData));
 
 		/////////////////////////////////////////////////////////////////////////////////////////////////////////
 		///////////////////////////////////////// Shadow Mapping Pass ///////////////////////////////////////////
 
 		if (shouldRenderShadows)
 		{
-			m_ShadowMapRenderPass->Begin();
-			Renderer::Submit([shadowMapDescSet = m_ShadowMapDescriptorSets[currentFrame]->GetVulkanDescriptorSet(), shadowMapPipelineLayout = m_ShadowMapPipeline->GetVulkanPipelineLayout(), pipeline = m_ShadowMapPipeline->GetVulkanPipeline()](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
-				{
-					// Binding the shadow map pipeline here instead of using the `Pipeline::Bind()` function to reduce `Renderer::Submit()` calls
-					vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-					vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMapPipelineLayout, 0, 1, &shadowMapDescSet, 0, nullptr);
-				});
+			// The shadow passes are multiview render passes, hence the scope is recorded outside of them
+			GPUProfiler::BeginScope("Shadow Cascades");
 
-			for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, MeshComponent>())
-			{
-				const auto& [transform, mesh] = scene->GetRegistry()->GetComponent<TransformComponent, MeshComponent>(entity);
+			const uint32_t cascadeMask = (1u << m_ShadowMapCascadeCount) - 1;
+			const uint32_t dirtyCascadeMask = m_DirtyStaticCascadeMask & cascadeMask;
 
-				if (auto staticMesh = AssetManager::GetAsset<StaticMesh>(mesh.MeshHandle))
+			// Only the submeshes casting a shadow into any of the cascades are drawn, the submeshes sharing the geometry are instanced
+			shadowCasterSubMeshCount = GatherShadowCasterDrawItems(m_CachedCascadeMask, dirtyCascadeMask & m_CachedCascadeMask, m_RendererData->StaticShadowCasterDrawItems, m_RendererData->ShadowCasterDrawItems);
+
+			// The instance storage of both the shadow passes is reserved up front, so that the buffer the descriptor set refers to isn't replaced while they are submitted
+			ReserveInstanceStorage(m_InstanceCount + (uint32_t)m_RendererData->StaticShadowCasterDrawItems.size() + (uint32_t)m_RendererData->ShadowCasterDrawItems.size());
+
+			const VkDescriptorSet shadowMapDescSet = Renderer::AllocateTransientDescriptorSet(m_ShadowMapDescriptorSetLayout);
+			{
+				VkDescriptorBufferInfo bufferInfos[2]{};
+				// The uniform buffer always holds the maximum number of cascades, so that it doesn't depend upon the cascade count
+				bufferInfos[0].buffer = UniformRing::GetBuffer(currentFrame);
+				bufferInfos[0].offset = 0;
+				bufferInfos[0].range = sizeof(glm::mat4) * SceneRendererSettings::MaxCascadeCount;
+
+				bufferInfos[1].buffer = m_InstanceStorageBuffers[currentFrame]->GetVulkanBuffer();
+				bufferInfos[1].offset = 0;
+				bufferInfos[1].range = VK_WHOLE_SIZE;
+
+				VkWriteDescriptorSet shadowMapWrites[2]{};
+				for (uint32_t binding = 0; binding < 2; binding++)
 				{
-					ModelMatrixPushConstantData pushContantData;
-					pushContantData.ModelMatrix = transform.CalculateTransform();
-					Renderer::Submit([staticMesh, shadowMapPipelineLayout = m_ShadowMapPipeline->GetVulkanPipelineLayout(), pushContantData](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
-						{
-							vkCmdPushConstants(cmdBuffer, shadowMapPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ModelMatrixPushConstantData), &pushContantData);
-							Renderer::RT_BindVertexAndIndexBuffers(cmdBuffer, staticMesh->GetVertexBuffer()->GetVulkanBuffer(), staticMesh->GetIndexBuffer()->GetVulkanBuffer());
-							const uint32_t size = staticMesh->GetSubMeshes().back().IndexOffset + staticMesh->GetSubMeshes().back().IndexCount;
-							vkCmdDrawIndexed(cmdBuffer, size, 1, 0, 0, 0);
-						});
+					shadowMapWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					shadowMapWrites[binding].dstSet = shadowMapDescSet;
+					shadowMapWrites[binding].dstBinding = binding;
+					shadowMapWrites[binding].descriptorCount = 1;
+					shadowMapWrites[binding].descriptorType = binding ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+					shadowMapWrites[binding].pBufferInfo = &bufferInfos[binding];
 				}
+
+				vkUpdateDescriptorSets(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), 2, shadowMapWrites, 0, nullptr);
+			}
+
+			const auto submitShadowMapPipelineBinding = [=, shadowMapBufferOffset = m_ShadowMapBufferOffset, shadowMapPipelineLayout = m_ShadowMapPipeline->GetVulkanPipelineLayout(), pipeline = m_ShadowMapPipeline->GetVulkanPipeline()]()
+			{
+				Renderer::Submit([=](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
+					{
+						// Binding the shadow map pipeline here instead of using the `Pipeline::Bind()` function to reduce `Renderer::Submit()` calls
+						vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+						vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadowMapPipelineLayout, 0, 1, &shadowMapDescSet, 1, &shadowMapBufferOffset);
+					});
+			};
+
+			// Render the static shadow casters into the dirty cached cascades, the rest of the frames reuse them
+			if (dirtyCascadeMask & m_CachedCascadeMask)
+			{
+				Renderer::Submit([staticShadowMap = m_StaticShadowMapRenderPass->GetSpecification().TargetFramebuffers[0]->GetDepthAttachment()->GetVulkanImage(), cascadeCount = m_ShadowMapCascadeCount, cachedCascadeMask = m_CachedCascadeMask, dirtyCascadeMask](VkCommandBuffer cmdBuffer, uint32_t)
+					{
+						RT_ClearStaticShadowMapCascades(cmdBuffer, staticShadowMap, cascadeCount, cachedCascadeMask, dirtyCascadeMask);
+					});
+
+				m_StaticShadowMapRenderPass->Begin(0, { 0, 0 }, { 0, 0 }, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				Renderer::BeginCommandList(m_StaticShadowMapRenderPass->GetRenderPass());
+				submitShadowMapPipelineBinding();
+				SubmitInstancedMeshEntityDrawItems(m_RendererData->StaticShadowCasterDrawItems);
+				Renderer::EndCommandList();
+				m_StaticShadowMapRenderPass->End();
+			}
+
+			// The cascades which aren't cached are cleared when they become cached
+			// The rendered cascades stay pending until it's known whether this frame reaches the GPU
+			m_PendingStaticCascadeMask |= dirtyCascadeMask & m_CachedCascadeMask;
+			m_PendingStaticCascadeFrameNumber = frameNumber;
+			m_DirtyStaticCascadeMask &= ~cascadeMask;
+
+			// The shadow map of the frame starts off as a copy of the cached cascades of the static shadow map
+			// When none of the cascades are cached, the shadow map is cleared by the load operation of the pass instead
+			const auto& shadowMapRenderPass = m_CachedCascadeMask ? m_ShadowMapRenderPass : m_ShadowMapClearRenderPass;
+			if (m_CachedCascadeMask)
+			{
+				Renderer::Submit([staticShadowMap = m_StaticShadowMapRenderPass->GetSpecification().TargetFramebuffers[0]->GetDepthAttachment()->GetVulkanImage(), renderPass = m_ShadowMapRenderPass, cascadeCount = m_ShadowMapCascadeCount, cachedCascadeMask = m_CachedCascadeMask, cascadeSize = m_ShadowMapCascadeSize](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
+					{
+						RT_CopyStaticShadowMap(cmdBuffer, staticShadowMap, renderPass->GetSpecification().TargetFramebuffers[imageIndex]->GetDepthAttachment()->GetVulkanImage(), cascadeCount, cachedCascadeMask, cascadeSize);
+					});
 			}
-			m_ShadowMapRenderPass->End();
+
+			// The dynamic shadow casters and the static shadow casters of the cascades which aren't cached are rendered on top of the static shadow map
+			// The shadow pass is recorded by a worker thread in parallel with the geometry pass
+			shadowMapRenderPass->Begin(-1, { 0, 0 }, { 0, 0 }, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			Renderer::BeginCommandList(shadowMapRenderPass->GetRenderPass());
+			submitShadowMapPipelineBinding();
+			SubmitInstancedMeshEntityDrawItems(m_RendererData->ShadowCasterDrawItems);
+			Renderer::EndCommandList();
+			shadowMapRenderPass->End();
+
+			GPUProfiler::EndScope();
 		}
 
 		/////////////////////////////////////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////// Geometry Pass //////////////////////////////////////////////
 
-		m_GeometryPass->Begin();
+		// The contents of the geometry pass are split into command lists (skymap, meshes, 2D, grid) which are recorded by worker threads
+		GPUProfiler::BeginScope("Geometry");
+		// Only the region of the render targets covered by the render extent is rendered into
+		const VkExtent2D renderExtent{ (uint32_t)m_RenderExtent.x, (uint32_t)m_RenderExtent.y };
+		m_GeometryPass->Begin(-1, { 0, 0 }, renderExtent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		// Dynamic state is not inherited by secondary command buffers, hence it has to be set at the beginning of every command list
+		const auto beginGeometryCommandList = [this, renderExtent]()
+		{
+			Renderer::BeginCommandList(m_GeometryPass->GetRenderPass());
+			RenderCommand::SetViewport(0.0f, 0.0f, m_RenderExtent.x, m_RenderExtent.y);
+			RenderCommand::SetScissor({ 0, 0 }, renderExtent);
+		};
 
-		RenderCommand::SetViewport(0.0f, 0.0f, m_ViewportSize.x, m_ViewportSize.y);
-		RenderCommand::SetScissor({ 0, 0 }, VkExtent2D{ (uint32_t)m_ViewportSize.x, (uint32_t)m_ViewportSize.y });
+		beginGeometryCommandList();
 
 		/////////////////////////////////////////// Skymap Rendering ////////////////////////////////////////////
 
-		bool shouldRenderSkymap = skymap && skymap->EnableSkymap && AssetManager::IsAssetHandleValid(skymap->Skymap);
+		bool shouldRenderSkymap = proxies.SkymapAsset != nullptr;
 		VkDescriptorSet textureDescSet = VK_NULL_HANDLE;
 
 		if (shouldRenderSkymap)
 		{
 			VkPipelineLayout pipelineLayout = m_SkymapPipeline->GetVulkanPipelineLayout();
-			textureDescSet = AssetManager::GetAsset<Skymap>(skymap->Skymap)->GetDescriptorSet()->GetVulkanDescriptorSet();
+			textureDescSet = proxies.SkymapAsset->GetDescriptorSet()->GetVulkanDescriptorSet();
 
 			SkymapPushConstantObject pco;
 			pco.ViewProjectionMatrix = projectionMatrix * glm::mat4(glm::mat3(viewMatrix));
@@ -694,20 +1045,30 @@ namespace Flameberry {
 				});
 		}
 
+		Renderer::EndCommandList();
+
 		///////////////////////////////////////// Mesh Pipeline Binding //////////////////////////////////////////
 
-		Renderer::Submit([=, pipeline = m_MeshPipeline->GetVulkanPipeline(), pipelineLayout = m_MeshPipeline->GetVulkanPipelineLayout()](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
-			{
-				VkDescriptorSet descriptorSets[] = {
-					m_CameraBufferDescriptorSets[currentFrame]->GetVulkanDescriptorSet(),
-					m_SceneDataDescriptorSets[currentFrame]->GetVulkanDescriptorSet(),
-					m_ShadowMapRefDescSets[imageIndex]->GetVulkanDescriptorSet(),
-					shouldRenderSkymap ? textureDescSet : Skymap::GetEmptyDescriptorSet()->GetVulkanDescriptorSet()
-				};
+		// Every mesh command list has to bind the global descriptor sets again, the pipeline variants are bound along with the draws
+		const auto submitMeshPipelineBinding = [=, cameraBufferOffset = m_CameraBufferOffset, sceneBufferOffset = m_SceneBufferOffset, pipelineLayout = m_MeshPipelines->GetVulkanPipelineLayout()]()
+		{
+			Renderer::Submit([=](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
+				{
+					VkDescriptorSet descriptorSets[] = {
+						m_MeshDescriptorSets[currentFrame]->GetVulkanDescriptorSet(),
+						m_SceneDataDescriptorSets[currentFrame]->GetVulkanDescriptorSet(),
+						m_ShadowMapRefDescSets[imageIndex]->GetVulkanDescriptorSet(),
+						shouldRenderSkymap ? textureDescSet : Skymap::GetEmptyDescriptorSet()->GetVulkanDescriptorSet(),
+						// The materials only push the indices of their texture maps
+						TextureTable::GetDescriptorSet()
+					};
 
-				Renderer::RT_BindPipeline(cmdBuffer, pipeline);
-				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, sizeof(descriptorSets) / sizeof(VkDescriptorSet), descriptorSets, 0, nullptr);
-			});
+					// Ordered by the set and the binding of the dynamic descriptors
+					uint32_t dynamicOffsets[] = { cameraBufferOffset, sceneBufferOffset };
+
+					vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, sizeof(descriptorSets) / sizeof(VkDescriptorSet), descriptorSets, sizeof(dynamicOffsets) / sizeof(uint32_t), dynamicOffsets);
+				});
+		};
 
 #if 0
         // Without sorting
@@ -715,171 +1076,225 @@ namespace Flameberry {
         {
             const auto& [transform, mesh] = scene->GetRegistry()->GetComponent<TransformComponent, MeshComponent>(entity);
             if (auto staticMesh = AssetManager::GetAsset<StaticMesh>(mesh.MeshHandle); staticMesh)
-                Renderer::SubmitMeshWithMaterial(staticMesh, m_MeshPipeline, mesh.OverridenMaterialTable, transform.GetTransform());
+                Renderer::SubmitMeshWithMaterial(staticMesh, m_MeshPipelines->GetVariant(0), mesh.OverridenMaterialTable, transform.GetTransform());
         }
 #else
 		// With sorting
 
-		// TODO: Temporarily placing this code here, it is inefficient to keep this array filled till the next frame
-		m_RendererData->RenderObjects.clear();
-
 		/////////////////////////////////////// Gathering All Render Objects ///////////////////////////////////////
 
-		// TODO: Move this someplace better
-		Frustum cameraFrustum;
+		const auto& subMeshBounds = proxies.SubMeshBounds;
+		auto& visibilityMask = m_RendererData->SubMeshVisibilityMask;
+		uint32_t visibleSubMeshCount = subMeshBounds.GetCount();
 
 		if (m_RendererSettings.FrustumCulling)
+		{
+			FBY_PROFILE_SCOPE("FrustumCulling");
+
+			// TODO: Move this someplace better
+			Frustum cameraFrustum;
 			cameraFrustum.ExtractFrustumPlanes(cameraBufferData.ViewProjectionMatrix);
 
-		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, MeshComponent>())
+			visibleSubMeshCount = CullAABBs(subMeshBounds, cameraFrustum, visibilityMask);
+		}
+		else
+			visibilityMask.assign((subMeshBounds.GetCount() + 63) / 64, ~0ull);
+
+		uint32_t occludedSubMeshCount = 0;
+		if (m_RendererSettings.OcclusionCulling)
 		{
-			const auto& [transform, mesh] = scene->GetRegistry()->GetComponent<TransformComponent, MeshComponent>(entity);
+			FBY_PROFILE_SCOPE("OcclusionCulling");
 
-			if (auto staticMesh = AssetManager::GetAsset<StaticMesh>(mesh.MeshHandle))
-			{
-				uint32_t submeshIndex = 0;
+			occludedSubMeshCount = CullOccludedSubMeshes(cameraBufferData.ViewProjectionMatrix);
+			visibleSubMeshCount -= occludedSubMeshCount;
+		}
 
-				m_RendererData->RenderObjects.reserve(m_RendererData->RenderObjects.size() + staticMesh->GetSubMeshes().size());
+		Renderer::Submit([visibleSubMeshCount, culledSubMeshCount = subMeshBounds.GetCount() - visibleSubMeshCount - occludedSubMeshCount, occludedSubMeshCount, shadowCasterSubMeshCount](VkCommandBuffer, uint32_t)
+			{
+				Renderer::RT_RecordCullingStats(visibleSubMeshCount, culledSubMeshCount, occludedSubMeshCount, shadowCasterSubMeshCount);
+			});
 
-				for (const auto& submesh : staticMesh->GetSubMeshes())
-				{
-					if (m_RendererSettings.FrustumCulling)
-					{
-						const auto modelMatrix = transform.CalculateTransform();
+		if (m_RendererSettings.ShowBoundingBoxes)
+		{
+			for (uint32_t meshEntityIndex = 0; meshEntityIndex < proxies.MeshEntities.size(); meshEntityIndex++)
+			{
+				for (const auto& submesh : proxies.MeshEntities[meshEntityIndex].Mesh->GetSubMeshes())
+					Renderer2D::AddAABB(submesh.AABB, proxies.Instances[meshEntityIndex].ModelMatrix, glm::vec4(1, 1, 0, 1));
+			}
+		}
 
-						// TODO: Move this outside of the `if (m_RendererSettings.FrustumCulling)`
-						if (m_RendererSettings.ShowBoundingBoxes)
-							Renderer2D::AddAABB(submesh.AABB, modelMatrix, glm::vec4(1, 1, 0, 1));
+		// Select the mesh pipeline variant of every material, the new variants are built on the pipeline builder threads
+		{
+			FBY_PROFILE_SCOPE("SelectPipelineVariants");
+
+			uint32_t settingsFeatureBits = 0;
+			if (shouldRenderShadows)
+				settingsFeatureBits |= MeshPipelineFeature_Shadows;
+			if (m_RendererSettings.SoftShadows)
+				settingsFeatureBits |= MeshPipelineFeature_SoftShadows;
+			if (m_RendererSettings.SkyReflections)
+				settingsFeatureBits |= MeshPipelineFeature_SkyReflections;
+
+			auto& materialPipelineIndices = m_RendererData->MaterialPipelineIndices;
+			materialPipelineIndices.resize(proxies.Materials.size());
+			for (uint32_t materialIndex = 0; materialIndex < proxies.Materials.size(); materialIndex++)
+			{
+				uint32_t variantIndex = m_MeshPipelines->GetOrCreateVariantIndex(GetMaterialFeatureBits(proxies.Materials[materialIndex]) | settingsFeatureBits);
 
-						// Skip processing the mesh if it is out of the camera frustum
-						if (!IsAABBInsideFrustum(submesh.AABB, modelMatrix, cameraFrustum))
-							continue;
-					}
+				// Until the variant is built the material is drawn with the default variant which supports all the features, or not drawn at all if that isn't built either
+				if (!m_MeshPipelines->GetVariant(variantIndex)->IsReady())
+					variantIndex = m_MeshPipelines->GetVariant(0)->IsReady() ? 0 : UINT32_MAX;
 
-					// The Assumption here is every mesh loaded will have a Material, i.e. materialAsset won't be nullptr
-					Ref<MaterialAsset> materialAsset;
-					if (const auto it = mesh.OverridenMaterialTable.find(submeshIndex); it != mesh.OverridenMaterialTable.end())
-						materialAsset = AssetManager::GetAsset<MaterialAsset>(it->second);
-					else if (AssetManager::IsAssetHandleValid(submesh.MaterialHandle))
-						materialAsset = AssetManager::GetAsset<MaterialAsset>(submesh.MaterialHandle);
-
-					// Add it to final list of render objects
-					m_RendererData->RenderObjects.emplace_back(
-						staticMesh->GetVertexBuffer()->GetVulkanBuffer(),
-						staticMesh->GetIndexBuffer()->GetVulkanBuffer(),
-						submesh.IndexOffset,
-						submesh.IndexCount,
-						&transform,
-						materialAsset);
-
-					submeshIndex++;
-				}
+				materialPipelineIndices[materialIndex] = variantIndex;
 			}
 		}
 
+		const auto& renderProxies = proxies.RenderProxies;
+		for (uint32_t proxyIndex = 0; proxyIndex < renderProxies.size(); proxyIndex++)
+		{
+			const auto& proxy = renderProxies[proxyIndex];
+
+			// Skip processing the submesh if it is culled from the camera view or doesn't have a valid material
+			if (!(visibilityMask[proxyIndex / 64] & (1ull << (proxyIndex % 64))) || proxy.MaterialIndex == UINT32_MAX)
+				continue;
+
+			// Sort opaque objects front to back within the same pipeline, mesh and material to reduce overdraw
+			const glm::vec3 center(subMeshBounds.CenterX[proxyIndex], subMeshBounds.CenterY[proxyIndex], subMeshBounds.CenterZ[proxyIndex]);
+			const uint32_t depthBucket = DrawSortKey::QuantizeDepth(glm::distance(cameraPosition, center) / cameraFar);
+
+			const uint32_t pipelineIndex = m_RendererData->MaterialPipelineIndices[proxy.MaterialIndex];
+			if (pipelineIndex == UINT32_MAX)
+				continue;
+
+			const uint32_t materialIndex = proxies.Materials[proxy.MaterialIndex]->GetMaterialBufferIndex();
+
+			auto& drawItem = m_RendererData->DrawItems.emplace_back();
+			drawItem.SortKey = DrawSortKey::Create(DrawPass::Opaque, pipelineIndex, proxy.GeometryIndex, materialIndex, depthBucket);
+			drawItem.VertexBuffer = proxy.VertexBuffer;
+			drawItem.IndexBuffer = proxy.IndexBuffer;
+			drawItem.VertexOffset = proxy.VertexOffset;
+			drawItem.IndexOffset = proxy.IndexOffset;
+			drawItem.IndexCount = proxy.IndexCount;
+			drawItem.InstanceIndex = proxy.MeshEntityIndex;
+			drawItem.MaterialIndex = materialIndex;
+			drawItem.PipelineIndex = pipelineIndex;
+			drawItem.ViewMask = ~0u;
+		}
+
 		///////////////////////////////////////////////// Sorting /////////////////////////////////////////////////
 		{
-			FBY_PROFILE_SCOPE("Sort_RenderObjects");
-			/// Sorting the render objects according to the material IDs
-			auto cmp = [](const RenderObject& a, const RenderObject& b)
-			{
-				return a.MaterialAsset->Handle < b.MaterialAsset->Handle;
-			};
-			std::stable_sort(m_RendererData->RenderObjects.begin(), m_RendererData->RenderObjects.end(), cmp);
+			FBY_PROFILE_SCOPE("Sort_DrawItems");
+			Algorithm::RadixSort64(m_RendererData->DrawItems, m_RendererData->SortScratchBuffer, [](const DrawItem& item) { return item.SortKey; });
 		}
 
 		//////////////////////////////////////////////// Rendering ////////////////////////////////////////////////
 
-		AssetHandle boundMaterialHandle = 0;
+		const auto& drawItems = m_RendererData->DrawItems;
+		const uint32_t firstInstance = WriteInstanceData(drawItems);
+
+		uint32_t boundPipelineIndex = UINT32_MAX;
 		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
-		TransformComponent* boundTransform = nullptr;
 
-		for (const auto& obj : m_RendererData->RenderObjects)
+		uint32_t drawCallCount = 0;
+		for (uint32_t i = 0; i < drawItems.size();)
 		{
-			Renderer::Submit([bindMaterial = boundMaterialHandle != obj.MaterialAsset->Handle,
-								 bindVertexAndIndexBuffers = boundVertexBuffer != obj.VertexBuffer,
-								 bindTransform = boundTransform != obj.Transform,
-								 pipelineLayout = m_MeshPipeline->GetVulkanPipelineLayout(),
-								 material = obj.MaterialAsset->GetUnderlyingMaterial(),
-								 vertexBuffer = obj.VertexBuffer,
-								 indexBuffer = obj.IndexBuffer,
-								 transform = obj.Transform->CalculateTransform(),
-								 indexCount = obj.IndexCount,
-								 indexOffset = obj.IndexOffset](VkCommandBuffer cmdBuffer, uint32_t)
+			const auto& item = drawItems[i];
+
+			// Collapse the consecutive draw items sharing the geometry and pipeline into one instanced draw call, the material is read per instance
+			uint32_t instanceCount = 1;
+			while (i + instanceCount < drawItems.size() && item.CanBeInstancedWith(drawItems[i + instanceCount]))
+				instanceCount++;
+
+			// Split the draw calls into chunks so that they can be recorded by multiple worker threads
+			if (drawCallCount % s_MaxDrawCallsPerCommandList == 0)
+			{
+				if (drawCallCount != 0)
+					Renderer::EndCommandList();
+
+				beginGeometryCommandList();
+				submitMeshPipelineBinding();
+
+				// A new command buffer doesn't have any state bound
+				boundPipelineIndex = UINT32_MAX;
+				boundVertexBuffer = VK_NULL_HANDLE;
+			}
+
+			// Only the variants which are already built are drawn with, so this never waits for the pipeline builder threads
+			Renderer::Submit([pipeline = boundPipelineIndex != item.PipelineIndex ? m_MeshPipelines->GetVariant(item.PipelineIndex)->GetVulkanPipeline() : VK_NULL_HANDLE,
+								 bindVertexAndIndexBuffers = boundVertexBuffer != item.VertexBuffer,
+								 vertexBuffer = item.VertexBuffer,
+								 indexBuffer = item.IndexBuffer,
+								 vertexOffset = item.VertexOffset,
+								 indexCount = item.IndexCount,
+								 indexOffset = item.IndexOffset,
+								 instanceCount,
+								 firstInstance = firstInstance + i](VkCommandBuffer cmdBuffer, uint32_t)
 				{
-					if (bindMaterial)
-						Renderer::RT_BindMaterial(cmdBuffer, pipelineLayout, material);
+					if (pipeline)
+						Renderer::RT_BindPipeline(cmdBuffer, pipeline);
 
 					if (bindVertexAndIndexBuffers)
 						Renderer::RT_BindVertexAndIndexBuffers(cmdBuffer, vertexBuffer, indexBuffer);
 
-					if (bindTransform)
-						vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), glm::value_ptr(transform));
-
-					// Draw the object
-					vkCmdDrawIndexed(cmdBuffer, indexCount, 1, indexOffset, 0, 0);
+					// Draw all the instances of the object
+					vkCmdDrawIndexed(cmdBuffer, indexCount, instanceCount, indexOffset, vertexOffset, firstInstance);
 				});
 
-			boundMaterialHandle = obj.MaterialAsset->Handle;
-			boundVertexBuffer = obj.VertexBuffer;
-			boundTransform = obj.Transform;
+			boundPipelineIndex = item.PipelineIndex;
+			boundVertexBuffer = item.VertexBuffer;
+
+			drawCallCount++;
+			i += instanceCount;
 		}
+
+		if (drawItems.size())
+			Renderer::EndCommandList();
 #endif
 		////////////////////////////////////////////// 2D Rendering //////////////////////////////////////////////
 
-		Renderer2D::BeginScene(m_CameraBufferDescriptorSets[currentFrame]->GetVulkanDescriptorSet());
+		beginGeometryCommandList();
+		GPUProfiler::BeginScope("2D");
+		Renderer2D::BeginScene(m_CameraBufferDescriptorSet, m_CameraBufferOffset);
 
 		if (renderDebugIcons)
 		{
 			// Render Point Light Icons
 			Renderer2D::SetActiveTexture(m_PointLightIcon);
-			for (uint32_t i = 0; i < sceneUniformBufferData.PointLightCount; i++)
-				Renderer2D::AddBillboard(sceneUniformBufferData.PointLights[i].Position, 0.7f, sceneUniformBufferData.PointLights[i].Color, viewMatrix, pointLightEntityHandles[i].GetIndex());
+			for (uint32_t i = 0; i < (uint32_t)proxies.PointLights.size(); i++)
+				Renderer2D::AddBillboard(proxies.PointLights[i].Position, 0.7f, proxies.PointLights[i].Color, viewMatrix, proxies.PointLightEntityIndices[i]);
 			Renderer2D::FlushQuads();
 
 			// Render Spot Light Icons
 			Renderer2D::SetActiveTexture(m_SpotLightIcon);
-			for (uint32_t i = 0; i < sceneUniformBufferData.SpotLightCount; i++)
-				Renderer2D::AddBillboard(sceneUniformBufferData.SpotLights[i].Position, 1.0f, sceneUniformBufferData.SpotLights[i].Color, viewMatrix, spotLightEntityHandles[i].GetIndex());
+			for (uint32_t i = 0; i < (uint32_t)proxies.SpotLights.size(); i++)
+				Renderer2D::AddBillboard(proxies.SpotLights[i].Position, 1.0f, proxies.SpotLights[i].Color, viewMatrix, proxies.SpotLightEntityIndices[i]);
 			Renderer2D::FlushQuads();
 
 			Renderer2D::SetActiveTexture(m_CameraIcon);
-			for (auto entity : scene->GetRegistry()->Group<TransformComponent, CameraComponent>())
-			{
-				auto& transform = scene->GetRegistry()->GetComponent<TransformComponent>(entity);
-				Renderer2D::AddBillboard(transform.Translation, 0.7f, glm::vec3(1), viewMatrix, entity.GetIndex());
-			}
+			for (const auto& icon : proxies.CameraIcons)
+				Renderer2D::AddBillboard(icon.Position, 0.7f, glm::vec3(1), viewMatrix, icon.EntityIndex);
 			Renderer2D::FlushQuads();
 
 			Renderer2D::SetActiveTexture(m_DirectionalLightIcon);
-			for (auto entity : scene->GetRegistry()->Group<TransformComponent, DirectionalLightComponent>())
-			{
-				auto& transform = scene->GetRegistry()->GetComponent<TransformComponent>(entity);
-				Renderer2D::AddBillboard(transform.Translation, 1.2f, glm::vec3(1), viewMatrix, entity.GetIndex());
-			}
+			for (const auto& icon : proxies.DirectionalLightIcons)
+				Renderer2D::AddBillboard(icon.Position, 1.2f, glm::vec3(1), viewMatrix, icon.EntityIndex);
 			Renderer2D::FlushQuads();
 		}
 
-		if (renderPhysicsCollider && selectedEntity != FEntity::Null)
+		if (renderPhysicsCollider && proxies.SelectedEntity.IsValid)
 		{
-			if (auto* transform = scene->GetRegistry()->TryGetComponent<TransformComponent>(selectedEntity))
-			{
-				// Draw Physics Collider
-				SubmitPhysicsColliderGeometry(scene, selectedEntity, *transform); // NOTE: This function will check if any of the colliders is present
-				SubmitCameraViewGeometry(scene, selectedEntity, *transform);
-			}
+			// Draw Physics Collider
+			SubmitPhysicsColliderGeometry(proxies.SelectedEntity); // NOTE: This function will check if any of the colliders is present
+			SubmitCameraViewGeometry(proxies.SelectedEntity);
 		}
 
 		// Render all the text in the scene
-		for (const auto entity : scene->GetRegistry()->Group<TransformComponent, TextComponent>())
-		{
-			const auto& [transform, text] = scene->GetRegistry()->GetComponent<TransformComponent, TextComponent>(entity);
-
-			Ref<Font> font = AssetManager::GetAsset<Font>(text.Font);
-			Renderer2D::AddText(text.TextString, font, transform.CalculateTransform(), { text.Color, text.Kerning, text.LineSpacing }, entity.GetIndex());
-		}
+		for (const auto& text : proxies.Texts)
+			Renderer2D::AddText(text.Text, text.FontAsset, text.Transform, { text.Color, text.Kerning, text.LineSpacing }, text.EntityIndex);
 
 		Renderer2D::EndScene();
+		GPUProfiler::EndScope();
+		Renderer::EndCommandList();
 
 		///////////////////////////////////////////// Grid Rendering /////////////////////////////////////////////
 
@@ -888,22 +1303,30 @@ namespace Flameberry {
 		{
 			VkPipelineLayout pipelineLayout = m_GridPipeline->GetVulkanPipelineLayout();
 
-			GridSettingsGPURepresentation& gridSettings = m_GridMaterial->GetUniformDataReferenceAs<GridSettingsGPURepresentation>();
+			// The settings are captured by value, the grid material may still be pushed by the render thread for the previous frame
+			GridSettingsGPURepresentation gridSettings;
 			gridSettings.Fading = (FBoolean)m_RendererSettings.GridFading;
 			gridSettings.Near = m_RendererSettings.GridNear;
 			gridSettings.Far = m_RendererSettings.GridFar;
 
-			Renderer::Submit([material = m_GridMaterial, globalCameraBufferDescSet = m_CameraBufferDescriptorSets[currentFrame]->GetVulkanDescriptorSet(), pipelineLayout, pipeline = m_GridPipeline->GetVulkanPipeline()](VkCommandBuffer cmdBuffer, uint32_t)
+			FBY_ASSERT(m_GridMaterial->GetUniformDataSize() == sizeof(GridSettingsGPURepresentation), "The grid settings don't match the push constants of the grid shader!");
+
+			beginGeometryCommandList();
+			GPUProfiler::BeginScope("Grid");
+			Renderer::Submit([gridSettings, pushConstantOffset = m_GridMaterial->GetPushConstantOffset(), globalCameraBufferDescSet = m_CameraBufferDescriptorSet, cameraBufferOffset = m_CameraBufferOffset, pipelineLayout, pipeline = m_GridPipeline->GetVulkanPipeline()](VkCommandBuffer cmdBuffer, uint32_t)
 				{
 					VkDescriptorSet descriptorSets[] = { globalCameraBufferDescSet };
 					Renderer::RT_BindPipeline(cmdBuffer, pipeline);
-					vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, sizeof(descriptorSets) / sizeof(VkDescriptorSet), descriptorSets, 0, nullptr);
-					Renderer::RT_BindMaterial(cmdBuffer, pipelineLayout, material);
+					vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, sizeof(descriptorSets) / sizeof(VkDescriptorSet), descriptorSets, 1, &cameraBufferOffset);
+					vkCmdPushConstants(cmdBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, pushConstantOffset, sizeof(gridSettings), &gridSettings);
 					vkCmdDraw(cmdBuffer, 6, 1, 0, 0);
 				});
+			GPUProfiler::EndScope();
+			Renderer::EndCommandList();
 		}
 
 		m_GeometryPass->End();
+		GPUProfiler::EndScope();
 
 #if 0
         /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -928,9 +1351,62 @@ namespace Flameberry {
 #endif
 	}
 
+	void SceneRenderer::UpdateRenderScale()
+	{
+		if (!m_RendererSettings.DynamicResolution)
+		{
+			m_RenderScale = m_FilteredRenderScale = 1.0f;
+			return;
+		}
+
+		// The same timings are read until the next frame completes, they are only applied once
+		const uint64_t resultsFrameNumber = GPUProfiler::GetResultsFrameNumber();
+		if (resultsFrameNumber == m_LastTimedFrameNumber)
+			return;
+		m_LastTimedFrameNumber = resultsFrameNumber;
+
+		// The timings of a frame this renderer didn't render, or whose sample is already overwritten, can't be compared with any render scale
+		const auto& sample = m_RenderScaleSamples[resultsFrameNumber % m_RenderScaleSamples.size()];
+		if (sample.FrameNumber != resultsFrameNumber)
+			return;
+
+		// The first result is the GPU time of the whole frame
+		const auto& gpuResults = GPUProfiler::GetResults();
+		if (gpuResults.empty() || gpuResults[0].Time <= 0.0)
+			return;
+
+		// Only the geometry passes are rendered at the render scale, the rest of the frame (shadows, UI) doesn't change with it
+		float geometryTime = 0.0f;
+		for (const auto& scope : gpuResults)
+		{
+			if (std::strcmp(scope.Name, "Geometry") == 0)
+				geometryTime += (float)scope.Time;
+		}
+
+		if (geometryTime <= 0.0f)
+			return;
+
+		// The geometry passes get whatever is left of the target frame time after the unscaled passes
+		// Their GPU time is roughly proportional to the number of pixels rendered, i.e. to the square of the scale they were rendered at
+		const float frameTime = (float)gpuResults[0].Time;
+		const float geometryBudget = m_RendererSettings.TargetFrameTime - (frameTime - geometryTime);
+		const float desiredRenderScale = geometryBudget > 0.0f ? sample.RenderScale * glm::sqrt(geometryBudget / geometryTime) : m_RendererSettings.MinRenderScale;
+
+		// The timings are a few frames old, hence the scale only moves part of the way with each new timing to avoid oscillating
+		constexpr float smoothingFactor = 0.1f;
+		m_FilteredRenderScale = glm::clamp(glm::mix(m_FilteredRenderScale, desiredRenderScale, smoothingFactor), m_RendererSettings.MinRenderScale, 1.0f);
+
+		// Quantized so that the light cluster grid, which depends on the render extent, isn't rebuilt on every frame
+		constexpr float renderScaleStep = 0.05f;
+		m_RenderScale = glm::clamp(glm::round(m_FilteredRenderScale / renderScaleStep) * renderScaleStep, m_RendererSettings.MinRenderScale, 1.0f);
+	}
+
 	void SceneRenderer::CalculateShadowMapCascades(const glm::mat4& viewProjectionMatrix, float cameraNear, float cameraFar, const glm::vec3& lightDirection)
 	{
-		float cascadeSplits[SceneRendererSettings::CascadeCount];
+		const uint32_t cascadeCount = m_ShadowMapCascadeCount;
+		const float cascadeSize = (float)m_ShadowMapCascadeSize;
+
+		float cascadeSplits[SceneRendererSettings::MaxCascadeCount];
 
 		const float nearClip = cameraNear;
 		const float farClip = cameraFar;
@@ -944,9 +1420,9 @@ namespace Flameberry {
 
 		// Calculate split depths based on view camera frustum
 		// Based on method presented in https://developer.nvidia.com/gpugems/GPUGems3/gpugems3_ch10.html
-		for (uint32_t i = 0; i < SceneRendererSettings::CascadeCount; i++)
+		for (uint32_t i = 0; i < cascadeCount; i++)
 		{
-			const float p = (i + 1) / static_cast<float>(SceneRendererSettings::CascadeCount);
+			const float p = (i + 1) / static_cast<float>(cascadeCount);
 			const float log = minZ * std::pow(ratio, p);
 			const float uniform = minZ + range * p;
 			const float d = m_RendererSettings.CascadeLambdaSplit * (log - uniform) + uniform;
@@ -959,7 +1435,12 @@ namespace Flameberry {
 		// Project frustum corners into world space
 		const glm::mat4 invCam = glm::inverse(viewProjectionMatrix);
 
-		for (uint32_t i = 0; i < SceneRendererSettings::CascadeCount; i++)
+		// The cascade centers are snapped to the texel grid of the light space, which is the world space rotated to face the light
+		const glm::vec3 lightDir = glm::normalize(lightDirection);
+		const glm::mat4 lightRotationMatrix = glm::lookAt(glm::vec3(0.0f), lightDir, glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 invLightRotationMatrix = glm::inverse(lightRotationMatrix);
+
+		for (uint32_t i = 0; i < cascadeCount; i++)
 		{
 			const float splitDist = cascadeSplits[i];
 
@@ -1001,24 +1482,39 @@ namespace Flameberry {
 				float distance = glm::length(frustumCorners[i] - frustumCenter);
 				radius = glm::max(radius, distance);
 			}
-			// radius = std::ceil(radius * 16.0f) / 16.0f;
+			// The bounding sphere doesn't change with the camera rotation, rounding it keeps the texel size of the cascade constant
+			radius = std::ceil(radius * 16.0f) / 16.0f;
 
-			const float width = frustumCorners[5].x - frustumCorners[4].x;
-			const float height = frustumCorners[7].y - frustumCorners[5].y;
+			// The cached cascades are enlarged, so that the camera can move by a few texels before they have to be rendered again
+			const bool isCached = m_CachedCascadeMask & (1u << i);
+			if (isCached)
+				radius /= 1.0f - 2.0f * s_CachedCascadeMoveThresholdTexels / cascadeSize;
 
-			// const float fWorldUnitsPerTexel = 2.0f * radius * 0.70710678118f / (float)SceneRendererSettings::CascadeSize;
-			// const float fInvWorldUnitsPerTexel = 1.0f / fWorldUnitsPerTexel;
+			// Snapping the center to the texels avoids the shimmering of the shadow edges when the camera moves
+			const float worldUnitsPerTexel = 2.0f * radius / cascadeSize;
+			glm::vec3 lightSpaceCenter = glm::vec3(lightRotationMatrix * glm::vec4(frustumCenter, 1.0f));
+			lightSpaceCenter = glm::floor(lightSpaceCenter / worldUnitsPerTexel) * worldUnitsPerTexel;
 
-			const glm::vec3 vWorldUnitsPerTexel(width / (float)SceneRendererSettings::CascadeSize, height / (float)SceneRendererSettings::CascadeSize, 1.0f);
-			const glm::vec3 vInvWorldUnitsPerTexel = 1.0f / vWorldUnitsPerTexel;
+			if (isCached)
+			{
+				auto& cacheKey = m_CascadeCacheKeys[i];
 
-			glm::vec3 maxExtents = (glm::floor(glm::vec3(radius)) * vInvWorldUnitsPerTexel) * vWorldUnitsPerTexel;
-			frustumCenter = (glm::floor(frustumCenter) * vInvWorldUnitsPerTexel) * vWorldUnitsPerTexel;
-			glm::vec3 minExtents = -maxExtents;
+				const float threshold = s_CachedCascadeMoveThresholdTexels * worldUnitsPerTexel;
+				const glm::vec3 centerDelta = glm::abs(lightSpaceCenter - cacheKey.LightSpaceCenter);
 
-			const glm::vec3 lightDir = glm::normalize(lightDirection);
-			const glm::mat4 lightViewMatrix = glm::lookAt(frustumCenter + lightDir * minExtents, frustumCenter, glm::vec3(0.0f, 1.0f, 0.0f));
-			const glm::mat4 lightOrthoMatrix = glm::ortho(minExtents.x, maxExtents.x, minExtents.y, maxExtents.y, 0.0f, maxExtents.z - minExtents.z);
+				// Keep using the volume that the cached shadows were rendered with, as long as it still encloses the cascade
+				if (cacheKey.LightDirection == lightDir && cacheKey.Radius == radius && centerDelta.x <= threshold && centerDelta.y <= threshold && centerDelta.z <= threshold)
+					lightSpaceCenter = cacheKey.LightSpaceCenter;
+				else
+				{
+					cacheKey = CascadeCacheKey{ lightDir, lightSpaceCenter, radius };
+					m_DirtyStaticCascadeMask |= 1u << i;
+				}
+			}
+
+			const glm::vec3 center = glm::vec3(invLightRotationMatrix * glm::vec4(lightSpaceCenter, 1.0f));
+			const glm::mat4 lightViewMatrix = glm::lookAt(center - lightDir * radius, center, glm::vec3(0.0f, 1.0f, 0.0f));
+			const glm::mat4 lightOrthoMatrix = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
 
 			// Store split distance and matrix in cascade
 			m_Cascades[i].DepthSplit = (cameraNear + splitDist * clipRange) * -1.0f;
@@ -1026,50 +1522,72 @@ namespace Flameberry {
 
 			lastSplitDist = cascadeSplits[i];
 		}
+
+		// The shaders always iterate over the maximum number of cascades, the unused cascades are never selected due to their depth split
+		for (uint32_t i = cascadeCount; i < SceneRendererSettings::MaxCascadeCount; i++)
+		{
+			m_Cascades[i].DepthSplit = std::numeric_limits<float>::lowest();
+			m_Cascades[i].ViewProjectionMatrix = glm::mat4(1.0f);
+		}
+	}
+
+	void SceneRenderer::InvalidateStaticShadowCascades()
+	{
+		const auto& changedBounds = m_RenderedProxies->StaticShadowCasterChangedBounds;
+		if (!changedBounds.GetCount())
+			return;
+
+		std::vector<uint64_t> intersectionMask;
+		for (uint32_t i = 0; i < m_ShadowMapCascadeCount; i++)
+		{
+			const uint32_t cascadeBit = 1u << i;
+			if (!(m_CachedCascadeMask & cascadeBit) || (m_DirtyStaticCascadeMask & cascadeBit))
+				continue;
+
+			if (CullAABBs(changedBounds, GetShadowCasterVolume(m_Cascades[i].ViewProjectionMatrix), intersectionMask))
+				m_DirtyStaticCascadeMask |= cascadeBit;
+		}
+	}
+
+	uint32_t SceneRenderer::GetCachedCascadeMask() const
+	{
+		if (!m_RendererSettings.CacheStaticShadows || m_RendererSettings.FirstCachedCascade >= m_ShadowMapCascadeCount)
+			return 0;
+
+		const uint32_t cascadeMask = (1u << m_ShadowMapCascadeCount) - 1;
+		return cascadeMask & ~((1u << m_RendererSettings.FirstCachedCascade) - 1);
 	}
 
 	void SceneRenderer::RenderSceneForMousePicking(const Ref<Scene>& scene, const Ref<RenderPass>& renderPass, const Ref<Pipeline>& pipeline, const Ref<Pipeline>& pipeline2D, const glm::vec2& mousePos)
 	{
 		renderPass->Begin(0, { (int)mousePos.x, (int)mousePos.y }, { 1, 1 });
 
-		Renderer::Submit([pipeline = pipeline->GetVulkanPipeline(), descSet = m_CameraBufferDescriptorSets[Renderer::GetCurrentFrameIndex()]->GetVulkanDescriptorSet(), mousePickingPipelineLayout = pipeline->GetVulkanPipelineLayout()](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
+		Renderer::Submit([pipeline = pipeline->GetVulkanPipeline(), descSet = m_MeshDescriptorSets[Renderer::GetCurrentFrameIndex()]->GetVulkanDescriptorSet(), cameraBufferOffset = m_CameraBufferOffset, mousePickingPipelineLayout = pipeline->GetVulkanPipelineLayout()](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
 			{
 				Renderer::RT_BindPipeline(cmdBuffer, pipeline);
-				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mousePickingPipelineLayout, 0, 1, &descSet, 0, nullptr);
+				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mousePickingPipelineLayout, 0, 1, &descSet, 1, &cameraBufferOffset);
 			});
 
-		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, MeshComponent>())
+		// The entity indices are part of the instance data, hence the entities sharing a mesh can be instanced here too
+		// NOTE: This uses the render proxies and the camera visibility of the last `RenderScene()` call of this frame
+		if (m_RenderedProxies)
 		{
-			const auto& [transform, mesh] = scene->GetRegistry()->GetComponent<TransformComponent, MeshComponent>(entity);
-
-			if (auto staticMesh = AssetManager::GetAsset<StaticMesh>(mesh.MeshHandle))
-			{
-				MousePickingPushConstantData pushContantData;
-				pushContantData.ModelMatrix = transform.CalculateTransform();
-				pushContantData.EntityIndex = entity.GetIndex();
-
-				Renderer::Submit([staticMesh, mousePickingPipelineLayout = pipeline->GetVulkanPipelineLayout(), pushContantData](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
-					{
-						vkCmdPushConstants(cmdBuffer, mousePickingPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MousePickingPushConstantData), &pushContantData);
-						Renderer::RT_BindVertexAndIndexBuffers(cmdBuffer, staticMesh->GetVertexBuffer()->GetVulkanBuffer(), staticMesh->GetIndexBuffer()->GetVulkanBuffer());
-
-						const uint32_t size = staticMesh->GetSubMeshes().back().IndexOffset + staticMesh->GetSubMeshes().back().IndexCount;
-						vkCmdDrawIndexed(cmdBuffer, size, 1, 0, 0, 0);
-					});
-			}
+			GatherMeshEntityDrawItems(m_RendererData->MeshEntityDrawItems);
+			SubmitInstancedMeshEntityDrawItems(m_RendererData->MeshEntityDrawItems);
 		}
 
 		// 2D Quad Entities
 		uint32_t indexCount = 6 * Renderer2D::GetRendererData().QuadVertexBufferOffset / (4 * sizeof(QuadVertex));
-		Renderer::Submit([descSet = m_CameraBufferDescriptorSets[Renderer::GetCurrentFrameIndex()]->GetVulkanDescriptorSet(),
+		Renderer::Submit([descSet = m_CameraBufferDescriptorSet,
+							 cameraBufferOffset = m_CameraBufferOffset,
 							 mousePicking2DPipelineLayout = pipeline2D->GetVulkanPipelineLayout(),
 							 vulkanPipeline2D = pipeline2D->GetVulkanPipeline(),
-							 vertexBuffer = Renderer2D::GetRendererData().QuadVertexBuffer->GetVulkanBuffer(),
+							 vertexBuffer = Renderer2D::GetRendererData().QuadVertexBuffers[Renderer::GetCurrentFrameIndex()]->GetVulkanBuffer(),
 							 indexBuffer = Renderer2D::GetRendererData().QuadIndexBuffer->GetVulkanBuffer(),
 							 indexCount](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
 			{
 				Renderer::RT_BindPipeline(cmdBuffer, vulkanPipeline2D);
-				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mousePicking2DPipelineLayout, 0, 1, &descSet, 0, nullptr);
+				vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mousePicking2DPipelineLayout, 0, 1, &descSet, 1, &cameraBufferOffset);
 
 				Renderer::RT_BindVertexAndIndexBuffers(cmdBuffer, vertexBuffer, indexBuffer);
 				vkCmdDrawIndexed(cmdBuffer, indexCount, 1, 0, 0, 0);
@@ -1077,7 +1595,7 @@ namespace Flameberry {
 
 		// Text Entities
 		indexCount = 6 * Renderer2D::GetRendererData().TextVertexBufferOffset / (4 * sizeof(TextVertex));
-		Renderer::Submit([vertexBuffer = Renderer2D::GetRendererData().TextVertexBuffer->GetVulkanBuffer(),
+		Renderer::Submit([vertexBuffer = Renderer2D::GetRendererData().TextVertexBuffers[Renderer::GetCurrentFrameIndex()]->GetVulkanBuffer(),
 							 indexBuffer = Renderer2D::GetRendererData().TextIndexBuffer->GetVulkanBuffer(),
 							 indexCount](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
 			{
@@ -1088,23 +1606,561 @@ namespace Flameberry {
 		renderPass->End();
 	}
 
+	void SceneRenderer::ExtractMeshEntities(const Ref<Scene>& scene, SceneRenderProxies& outProxies)
+	{
+		FBY_PROFILE_SCOPE("ExtractMeshEntities");
+
+		const uint64_t frame = outProxies.ExtractionIndex;
+		auto& boundsCache = outProxies.MeshBoundsCache;
+
+		for (const auto& entity : scene->GetRegistry()->Group<TransformComponent, MeshComponent>())
+		{
+			const auto& [transform, mesh] = scene->GetRegistry()->GetComponent<TransformComponent, MeshComponent>(entity);
+
+			auto staticMesh = AssetManager::GetAsset<StaticMesh>(mesh.MeshHandle);
+			if (!staticMesh)
+				continue;
+
+			const auto& submeshes = staticMesh->GetSubMeshes();
+			auto& bounds = boundsCache[entity];
+
+			// Recalculate the bounds only when the transform or the mesh of the entity has changed
+			const bool isDirty = bounds.LastUsedFrame == 0
+				|| bounds.MeshHandle != mesh.MeshHandle
+				|| bounds.Centers.size() != submeshes.size()
+				|| bounds.Translation != transform.Translation
+				|| bounds.Rotation != transform.Rotation
+				|| bounds.Scale != transform.Scale;
+
+			if (isDirty)
+			{
+				// A static shadow caster which changes is removed from the cached cascades it was rendered into
+				if (bounds.LastUsedFrame != 0 && frame - bounds.LastModifiedFrame > s_StaticShadowCasterFrameCount)
+				{
+					for (uint32_t i = 0; i < bounds.Centers.size(); i++)
+						outProxies.StaticShadowCasterChangedBounds.Add(bounds.Centers[i], bounds.Extents[i]);
+				}
+
+				bounds.LastModifiedFrame = frame;
+				bounds.Translation = transform.Translation;
+				bounds.Rotation = transform.Rotation;
+				bounds.Scale = transform.Scale;
+				bounds.MeshHandle = mesh.MeshHandle;
+				bounds.ModelMatrix = transform.CalculateTransform();
+
+				bounds.Centers.resize(submeshes.size());
+				bounds.Extents.resize(submeshes.size());
+				for (uint32_t i = 0; i < submeshes.size(); i++)
+					TransformAABB(submeshes[i].AABB, bounds.ModelMatrix, bounds.Centers[i], bounds.Extents[i]);
+			}
+
+			bounds.LastUsedFrame = frame;
+
+			// The mesh entity which stayed unchanged for long enough becomes a static shadow caster and is added to the cached cascades
+			const bool isStaticShadowCaster = frame - bounds.LastModifiedFrame >= s_StaticShadowCasterFrameCount;
+			if (frame - bounds.LastModifiedFrame == s_StaticShadowCasterFrameCount)
+			{
+				for (uint32_t i = 0; i < submeshes.size(); i++)
+					outProxies.StaticShadowCasterChangedBounds.Add(bounds.Centers[i], bounds.Extents[i]);
+			}
+
+			// The occluder geometry is only loaded for the meshes used as occluders, until it's loaded the mesh doesn't occlude anything
+			if (mesh.IsOccluder && staticMesh->RequestOccluderGeometry())
+				m_OccluderLoadingThreadPool->Submit([staticMesh]() { MeshImporter::LoadOccluderGeometry(staticMesh); });
+
+			const uint32_t meshEntityIndex = (uint32_t)outProxies.MeshEntities.size();
+			outProxies.MeshEntities.emplace_back(MeshEntityRenderProxy{ staticMesh, (uint32_t)outProxies.RenderProxies.size(), mesh.IsOccluder, isStaticShadowCaster });
+			outProxies.Instances.emplace_back(MeshInstanceData{ bounds.ModelMatrix, (int)entity.GetIndex() });
+
+			const VkBuffer vertexBuffer = staticMesh->GetVertexBuffer();
+			const VkBuffer indexBuffer = staticMesh->GetIndexBuffer();
+			const uint32_t firstGeometryIndex = outProxies.GetFirstGeometryIndex(staticMesh.get(), (uint32_t)submeshes.size());
+
+			for (uint32_t i = 0; i < submeshes.size(); i++)
+			{
+				AssetHandle materialHandle = submeshes[i].MaterialHandle;
+				if (const auto it = mesh.OverridenMaterialTable.find(i); it != mesh.OverridenMaterialTable.end())
+					materialHandle = it->second;
+
+				auto& proxy = outProxies.RenderProxies.emplace_back();
+				proxy.VertexBuffer = vertexBuffer;
+				proxy.IndexBuffer = indexBuffer;
+				proxy.VertexOffset = staticMesh->GetVertexOffset();
+				proxy.IndexOffset = staticMesh->GetFirstIndex() + submeshes[i].IndexOffset;
+				proxy.IndexCount = submeshes[i].IndexCount;
+				proxy.GeometryIndex = firstGeometryIndex + i;
+				proxy.MaterialIndex = GetMaterialIndex(outProxies, materialHandle);
+				proxy.MeshEntityIndex = meshEntityIndex;
+
+				outProxies.SubMeshBounds.Add(bounds.Centers[i], bounds.Extents[i]);
+			}
+		}
+
+		// Evict the bounds of the entities which are destroyed or don't have a mesh anymore
+		if (boundsCache.size() > outProxies.MeshEntities.size())
+		{
+			for (auto it = boundsCache.begin(); it != boundsCache.end();)
+			{
+				if (it->second.LastUsedFrame != frame)
+				{
+					const auto& bounds = it->second;
+					if (bounds.LastUsedFrame - bounds.LastModifiedFrame >= s_StaticShadowCasterFrameCount)
+					{
+						for (uint32_t i = 0; i < bounds.Centers.size(); i++)
+							outProxies.StaticShadowCasterChangedBounds.Add(bounds.Centers[i], bounds.Extents[i]);
+					}
+
+					it = boundsCache.erase(it);
+				}
+				else
+					++it;
+			}
+		}
+	}
+
+	uint32_t SceneRenderer::GetMaterialIndex(SceneRenderProxies& proxies, AssetHandle materialHandle)
+	{
+		if (const auto it = proxies.MaterialHandleToIndex.find(materialHandle); it != proxies.MaterialHandleToIndex.end())
+			return it->second;
+
+		Ref<MaterialAsset> materialAsset = AssetManager::IsAssetHandleValid(materialHandle) ? AssetManager::GetAsset<MaterialAsset>(materialHandle) : nullptr;
+
+		// The invalid materials are cached as well so that they are not looked up again for the other submeshes
+		uint32_t materialIndex = UINT32_MAX;
+		if (materialAsset)
+		{
+			materialIndex = (uint32_t)proxies.Materials.size();
+			proxies.Materials.emplace_back(materialAsset);
+		}
+
+		proxies.MaterialHandleToIndex[materialHandle] = materialIndex;
+		return materialIndex;
+	}
+
+	uint32_t SceneRenderer::GetMaterialFeatureBits(const Ref<MaterialAsset>& material)
+	{
+		uint32_t featureBits = 0;
+		if (material->IsUsingAlbedoMap())
+			featureBits |= MeshPipelineFeature_AlbedoMap;
+		if (material->IsUsingNormalMap())
+			featureBits |= MeshPipelineFeature_NormalMap;
+		if (material->IsUsingRoughnessMap())
+			featureBits |= MeshPipelineFeature_RoughnessMap;
+		if (material->IsUsingAmbientMap())
+			featureBits |= MeshPipelineFeature_AmbientMap;
+		if (material->IsUsingMetallicMap())
+			featureBits |= MeshPipelineFeature_MetallicMap;
+		return featureBits;
+	}
+
+	uint32_t SceneRenderer::CullOccludedSubMeshes(const glm::mat4& viewProjectionMatrix)
+	{
+		auto& visibilityMask = m_RendererData->SubMeshVisibilityMask;
+
+		m_OcclusionCuller.BeginFrame(viewProjectionMatrix);
+
+		// Only the submeshes of the occluders which passed the frustum culling are rasterized
+		for (uint32_t meshEntityIndex = 0; meshEntityIndex < m_RenderedProxies->MeshEntities.size(); meshEntityIndex++)
+		{
+			const auto& meshEntity = m_RenderedProxies->MeshEntities[meshEntityIndex];
+			if (!meshEntity.IsOccluder || !meshEntity.Mesh->IsOccluderGeometryReady())
+				continue;
+
+			const auto& positions = meshEntity.Mesh->GetOccluderPositions();
+			const auto& indices = meshEntity.Mesh->GetOccluderIndices();
+			if (positions.empty() || indices.empty())
+				continue;
+
+			// The occluder indices are local to the mesh, unlike the index offsets of the render proxies
+			const auto& submeshes = meshEntity.Mesh->GetSubMeshes();
+			for (uint32_t i = 0; i < submeshes.size(); i++)
+			{
+				const uint32_t proxyIndex = meshEntity.FirstRenderProxyIndex + i;
+				if (!(visibilityMask[proxyIndex / 64] & (1ull << (proxyIndex % 64))))
+					continue;
+
+				m_OcclusionCuller.AddOccluder(m_RenderedProxies->Instances[meshEntityIndex].ModelMatrix, positions.data(), indices.data() + submeshes[i].IndexOffset, submeshes[i].IndexCount);
+			}
+		}
+
+		if (!m_OcclusionCuller.GetOccluderTriangleCount())
+			return 0;
+
+		m_OcclusionCuller.RasterizeOccluders(m_CullingThreadPool.get());
+		return m_OcclusionCuller.CullOccludedAABBs(m_RenderedProxies->SubMeshBounds, visibilityMask);
+	}
+
+	void SceneRenderer::GatherMeshEntityDrawItems(std::vector<DrawItem>& outDrawItems)
+	{
+		outDrawItems.clear();
+
+		const auto& visibilityMask = m_RendererData->SubMeshVisibilityMask;
+
+		for (uint32_t meshEntityIndex = 0; meshEntityIndex < m_RenderedProxies->MeshEntities.size(); meshEntityIndex++)
+		{
+			const auto& meshEntity = m_RenderedProxies->MeshEntities[meshEntityIndex];
+			const auto& submeshes = meshEntity.Mesh->GetSubMeshes();
+
+			bool isVisible = false;
+			for (uint32_t proxyIndex = meshEntity.FirstRenderProxyIndex; proxyIndex < meshEntity.FirstRenderProxyIndex + submeshes.size() && !isVisible; proxyIndex++)
+				isVisible = visibilityMask[proxyIndex / 64] & (1ull << (proxyIndex % 64));
+
+			if (!isVisible)
+				continue;
+
+			const auto& proxy = m_RenderedProxies->RenderProxies[meshEntity.FirstRenderProxyIndex];
+
+			auto& drawItem = outDrawItems.emplace_back();
+			// Sorting only by the mesh is enough as these draw items don't use any material
+			drawItem.SortKey = proxy.GeometryIndex;
+			drawItem.VertexBuffer = proxy.VertexBuffer;
+			drawItem.IndexBuffer = proxy.IndexBuffer;
+			drawItem.VertexOffset = proxy.VertexOffset;
+			drawItem.IndexOffset = meshEntity.Mesh->GetFirstIndex();
+			drawItem.IndexCount = meshEntity.Mesh->GetGeometry().IndexCount;
+			drawItem.InstanceIndex = meshEntityIndex;
+			drawItem.MaterialIndex = 0;
+			drawItem.PipelineIndex = 0;
+			drawItem.ViewMask = ~0u;
+		}
+
+		Algorithm::RadixSort64(outDrawItems, m_RendererData->SortScratchBuffer, [](const DrawItem& item) { return item.SortKey; });
+	}
+
+	uint32_t SceneRenderer::GatherShadowCasterDrawItems(uint32_t cachedCascadeMask, uint32_t dirtyCachedCascadeMask, std::vector<DrawItem>& outStaticDrawItems, std::vector<DrawItem>& outDrawItems)
+	{
+		FBY_PROFILE_SCOPE("GatherShadowCasterDrawItems");
+
+		outStaticDrawItems.clear();
+		outDrawItems.clear();
+
+		const auto& subMeshBounds = m_RenderedProxies->SubMeshBounds;
+		auto& cascadeCasterMasks = m_RendererData->CascadeCasterMasks;
+
+		for (uint32_t i = 0; i < m_ShadowMapCascadeCount; i++)
+		{
+			if (!m_RendererSettings.FrustumCulling)
+			{
+				cascadeCasterMasks[i].assign((subMeshBounds.GetCount() + 63) / 64, ~0ull);
+				continue;
+			}
+
+			CullAABBs(subMeshBounds, GetShadowCasterVolume(m_Cascades[i].ViewProjectionMatrix), cascadeCasterMasks[i]);
+		}
+
+		uint32_t shadowCasterCount = 0;
+		for (uint32_t proxyIndex = 0; proxyIndex < m_RenderedProxies->RenderProxies.size(); proxyIndex++)
+		{
+			// All the cascades are rendered by a single multiview draw call, the vertex shader rejects the cascades which are not in the mask
+			uint32_t cascadeMask = 0;
+			for (uint32_t i = 0; i < m_ShadowMapCascadeCount; i++)
+			{
+				if (cascadeCasterMasks[i][proxyIndex / 64] & (1ull << (proxyIndex % 64)))
+					cascadeMask |= 1u << i;
+			}
+
+			if (!cascadeMask)
+				continue;
+
+			shadowCasterCount++;
+
+			const auto& proxy = m_RenderedProxies->RenderProxies[proxyIndex];
+			const bool isStaticShadowCaster = m_RenderedProxies->MeshEntities[proxy.MeshEntityIndex].IsStaticShadowCaster;
+
+			// The static shadow casters of the cached cascades are already present in the static shadow map, unless it is dirty
+			const uint32_t staticCascadeMask = isStaticShadowCaster ? cascadeMask & dirtyCachedCascadeMask : 0;
+			const uint32_t frameCascadeMask = isStaticShadowCaster ? cascadeMask & ~cachedCascadeMask : cascadeMask;
+
+			if (!staticCascadeMask && !frameCascadeMask)
+				continue;
+
+			DrawItem drawItem;
+			// Sorting only by the submesh is enough as these draw items don't use any material
+			drawItem.SortKey = proxy.GeometryIndex;
+			drawItem.VertexBuffer = proxy.VertexBuffer;
+			drawItem.IndexBuffer = proxy.IndexBuffer;
+			drawItem.VertexOffset = proxy.VertexOffset;
+			drawItem.IndexOffset = proxy.IndexOffset;
+			drawItem.IndexCount = proxy.IndexCount;
+			drawItem.InstanceIndex = proxy.MeshEntityIndex;
+			drawItem.MaterialIndex = 0;
+			drawItem.PipelineIndex = 0;
+
+			if (staticCascadeMask)
+			{
+				drawItem.ViewMask = staticCascadeMask;
+				outStaticDrawItems.emplace_back(drawItem);
+			}
+
+			if (frameCascadeMask)
+			{
+				drawItem.ViewMask = frameCascadeMask;
+				outDrawItems.emplace_back(drawItem);
+			}
+		}
+
+		Algorithm::RadixSort64(outStaticDrawItems, m_RendererData->SortScratchBuffer, [](const DrawItem& item) { return item.SortKey; });
+		Algorithm::RadixSort64(outDrawItems, m_RendererData->SortScratchBuffer, [](const DrawItem& item) { return item.SortKey; });
+		return shadowCasterCount;
+	}
+
+	void SceneRenderer::SubmitInstancedMeshEntityDrawItems(const std::vector<DrawItem>& drawItems)
+	{
+		const uint32_t firstInstance = WriteInstanceData(drawItems);
+
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		for (uint32_t i = 0; i < drawItems.size();)
+		{
+			const auto& item = drawItems[i];
+
+			uint32_t instanceCount = 1;
+			while (i + instanceCount < drawItems.size() && item.CanBeInstancedWith(drawItems[i + instanceCount]))
+				instanceCount++;
+
+			Renderer::Submit([bindVertexAndIndexBuffers = boundVertexBuffer != item.VertexBuffer,
+								 vertexBuffer = item.VertexBuffer,
+								 indexBuffer = item.IndexBuffer,
+								 vertexOffset = item.VertexOffset,
+								 indexCount = item.IndexCount,
+								 indexOffset = item.IndexOffset,
+								 instanceCount,
+								 firstInstance = firstInstance + i](VkCommandBuffer cmdBuffer, uint32_t)
+				{
+					if (bindVertexAndIndexBuffers)
+						Renderer::RT_BindVertexAndIndexBuffers(cmdBuffer, vertexBuffer, indexBuffer);
+					vkCmdDrawIndexed(cmdBuffer, indexCount, instanceCount, indexOffset, vertexOffset, firstInstance);
+				});
+
+			boundVertexBuffer = item.VertexBuffer;
+			i += instanceCount;
+		}
+	}
+
+	uint32_t SceneRenderer::WriteInstanceData(const std::vector<DrawItem>& drawItems)
+	{
+		auto& sortedInstances = m_RendererData->SortedInstances;
+		sortedInstances.clear();
+		sortedInstances.reserve(drawItems.size());
+
+		for (const auto& item : drawItems)
+		{
+			auto& instance = sortedInstances.emplace_back(m_RenderedProxies->Instances[item.InstanceIndex]);
+			instance.ViewMask = item.ViewMask;
+			instance.MaterialIndex = item.MaterialIndex;
+		}
+
+		const uint32_t firstInstance = m_InstanceCount;
+		ReserveInstanceStorage(m_InstanceCount + (uint32_t)sortedInstances.size());
+
+		if (sortedInstances.size())
+			m_InstanceStorageBuffers[Renderer::GetCurrentFrameIndex()]->WriteToBuffer(sortedInstances.data(), sortedInstances.size() * sizeof(MeshInstanceData), firstInstance * sizeof(MeshInstanceData));
+
+		m_InstanceCount += (uint32_t)sortedInstances.size();
+		return firstInstance;
+	}
+
+	void SceneRenderer::ReserveInstanceStorage(uint32_t instanceCount)
+	{
+		const uint32_t currentFrame = Renderer::GetCurrentFrameIndex();
+		auto& instanceBuffer = m_InstanceStorageBuffers[currentFrame];
+
+		auto bufferSpec = instanceBuffer->GetSpecification();
+		if (instanceCount <= bufferSpec.InstanceCount)
+			return;
+
+		// The descriptor sets of the frame are only used by the frames having the same index, which are complete once the frame begins
+		// The old buffer is released only once the frame index is reused, in case any of the frames in flight still refers to it
+		bufferSpec.InstanceCount = std::max(2 * bufferSpec.InstanceCount, instanceCount);
+
+		auto newInstanceBuffer = std::make_unique<Buffer>(bufferSpec);
+		newInstanceBuffer->MapMemory(newInstanceBuffer->GetBufferSize());
+
+		// Preserve the instances that are already written in this frame
+		if (m_InstanceCount)
+			newInstanceBuffer->WriteToBuffer(instanceBuffer->GetMappedMemory(), m_InstanceCount * sizeof(MeshInstanceData));
+
+		m_RetiredStorageBuffers[currentFrame].emplace_back(std::move(instanceBuffer));
+		instanceBuffer = std::move(newInstanceBuffer);
+
+		VkDescriptorBufferInfo instanceBufferInfo{};
+		instanceBufferInfo.buffer = instanceBuffer->GetVulkanBuffer();
+		instanceBufferInfo.offset = 0;
+		instanceBufferInfo.range = VK_WHOLE_SIZE;
+
+		m_MeshDescriptorSets[currentFrame]->WriteBuffer(1, instanceBufferInfo);
+		m_MeshDescriptorSets[currentFrame]->Update();
+
+		FBY_INFO("Resized the instance storage buffer of frame {} to {} instances", currentFrame, bufferSpec.InstanceCount);
+	}
+
+	void SceneRenderer::WriteLightStorageBuffer(uint32_t binding, const void* data, uint32_t elementCount, VkDeviceSize elementSize)
+	{
+		const uint32_t currentFrame = Renderer::GetCurrentFrameIndex();
+		auto& storageBuffer = m_LightStorageBuffers[currentFrame][binding - 1];
+
+		auto bufferSpec = storageBuffer->GetSpecification();
+		if (elementCount > bufferSpec.InstanceCount)
+		{
+			// The old buffer is retired like the instance buffer, the scene descriptor set of the frame isn't in use by any frame in flight
+			bufferSpec.InstanceCount = std::max(2 * bufferSpec.InstanceCount, elementCount);
+
+			m_RetiredStorageBuffers[currentFrame].emplace_back(std::move(storageBuffer));
+			storageBuffer = std::make_unique<Buffer>(bufferSpec);
+			storageBuffer->MapMemory(storageBuffer->GetBufferSize());
+
+			VkDescriptorBufferInfo storageBufferInfo{};
+			storageBufferInfo.buffer = storageBuffer->GetVulkanBuffer();
+			storageBufferInfo.offset = 0;
+			storageBufferInfo.range = VK_WHOLE_SIZE;
+
+			m_SceneDataDescriptorSets[currentFrame]->WriteBuffer(binding, storageBufferInfo);
+			m_SceneDataDescriptorSets[currentFrame]->Update();
+
+			FBY_INFO("Resized the light storage buffer at binding {} of frame {} to {} elements", binding, currentFrame, bufferSpec.InstanceCount);
+		}
+
+		if (elementCount)
+			storageBuffer->WriteToBuffer(data, elementCount * elementSize);
+	}
+
+	void SceneRenderer::RT_ClearStaticShadowMapCascades(VkCommandBuffer cmdBuffer, VkImage staticShadowMap, uint32_t cascadeCount, uint32_t cachedCascadeMask, uint32_t dirtyCascadeMask)
+	{
+		std::vector<VkImageSubresourceRange> dirtyRanges;
+		std::vector<VkImageMemoryBarrier> barriers;
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = staticShadowMap;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+		for (uint32_t i = 0; i < cascadeCount; i++)
+		{
+			const uint32_t cascadeBit = 1u << i;
+			if (!(dirtyCascadeMask & cachedCascadeMask & cascadeBit))
+				continue;
+
+			// The previous contents of the dirty cascades are discarded
+			barrier.subresourceRange.baseArrayLayer = i;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+			barriers.emplace_back(barrier);
+			dirtyRanges.emplace_back(barrier.subresourceRange);
+		}
+
+		// Wait for the copies of the previous frames to finish reading the static shadow map
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+		const VkClearDepthStencilValue clearValue = { 1.0f, 0 };
+		vkCmdClearDepthStencilImage(cmdBuffer, staticShadowMap, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, (uint32_t)dirtyRanges.size(), dirtyRanges.data());
+
+		// The static shadow map pass expects all of the cascades in the attachment layout, the contents of the cascades which aren't cached are never read
+		barriers.clear();
+		for (uint32_t i = 0; i < cascadeCount; i++)
+		{
+			const uint32_t cascadeBit = 1u << i;
+			const bool isCached = cachedCascadeMask & cascadeBit;
+			const bool isDirty = isCached && (dirtyCascadeMask & cascadeBit);
+
+			barrier.subresourceRange.baseArrayLayer = i;
+			barrier.oldLayout = isDirty ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : (isCached ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED);
+			barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			barrier.srcAccessMask = isDirty ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+			barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+			barriers.emplace_back(barrier);
+		}
+
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+	}
+
+	void SceneRenderer::RT_CopyStaticShadowMap(VkCommandBuffer cmdBuffer, VkImage staticShadowMap, VkImage shadowMap, uint32_t cascadeCount, uint32_t cachedCascadeMask, uint32_t cascadeSize)
+	{
+		VkImageMemoryBarrier barriers[2] = {};
+		for (auto& barrier : barriers)
+		{
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, cascadeCount };
+		}
+
+		barriers[0].image = staticShadowMap;
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		// The previous contents of the shadow map are discarded, but it might still be sampled by the geometry pass of an earlier frame
+		barriers[1].image = shadowMap;
+		barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].srcAccessMask = 0;
+		barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, barriers);
+
+		// Only the cached cascades are copied, the rest of them are cleared
+		std::vector<VkImageCopy> regions;
+		std::vector<VkImageSubresourceRange> clearRanges;
+		for (uint32_t i = 0; i < cascadeCount; i++)
+		{
+			if (cachedCascadeMask & (1u << i))
+			{
+				VkImageCopy region{};
+				region.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, i, 1 };
+				region.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, i, 1 };
+				region.extent = { cascadeSize, cascadeSize, 1 };
+				regions.emplace_back(region);
+			}
+			else
+				clearRanges.push_back({ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, i, 1 });
+		}
+
+		vkCmdCopyImage(cmdBuffer, staticShadowMap, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, shadowMap, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(), regions.data());
+
+		if (clearRanges.size())
+		{
+			const VkClearDepthStencilValue clearValue = { 1.0f, 0 };
+			vkCmdClearDepthStencilImage(cmdBuffer, shadowMap, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, (uint32_t)clearRanges.size(), clearRanges.data());
+		}
+
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		barriers[0].srcAccessMask = 0;
+		barriers[0].dstAccessMask = 0;
+
+		// The shadow pass loads the copied contents in the attachment layout
+		barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 0, 0, nullptr, 0, nullptr, 2, barriers);
+	}
+
 	void SceneRenderer::ReloadMeshShaders()
 	{
-		m_MeshPipeline->ReloadShaders();
+		m_MeshPipelines->ReloadShaders();
 	}
 
 	// TODO: Move this to EditorLayer.cpp ASAP
-	void SceneRenderer::SubmitPhysicsColliderGeometry(const Ref<Scene>& scene, FEntity entity, TransformComponent& transform)
+	void SceneRenderer::SubmitPhysicsColliderGeometry(const SelectedEntityProxy& entity)
 	{
+		const auto& transform = entity.Transform;
 		// TODO: Optimise this function (maybe embed the vertices (?))
 		GLM_CONSTEXPR glm::vec3 greenColor(0.2f, 1.0f, 0.2f);
 		constexpr float bias(0.001f);
 		const glm::mat3 rotationMatrix = glm::toMat3(glm::quat(transform.Rotation));
 
 		// Render Physics Colliders
-		if (auto* boxCollider = scene->GetRegistry()->TryGetComponent<BoxColliderComponent>(entity))
+		if (entity.HasBoxCollider)
 		{
-			const glm::vec3 halfExtent = transform.Scale * boxCollider->Size * 0.5f + bias;
+			const glm::vec3 halfExtent = transform.Scale * entity.BoxCollider.Size * 0.5f + bias;
 
 			// Calculate the positions of the vertices of the collider
 			glm::vec3 vertex1 = glm::vec3(transform.Translation + rotationMatrix * glm::vec3(-halfExtent.x, -halfExtent.y, -halfExtent.z));
@@ -1137,10 +2193,10 @@ namespace Flameberry {
 			Renderer2D::AddLine(vertex3, vertex1, greenColor);
 			Renderer2D::AddLine(vertex7, vertex5, greenColor);
 		}
-		else if (auto* sphereCollider = scene->GetRegistry()->TryGetComponent<SphereColliderComponent>(entity); sphereCollider)
+		else if (entity.HasSphereCollider)
 		{
 			// Define the radius of the sphere
-			float radius = sphereCollider->Radius * glm::max(glm::max(transform.Scale.x, transform.Scale.y), transform.Scale.z) + bias;
+			float radius = entity.SphereCollider.Radius * glm::max(glm::max(transform.Scale.x, transform.Scale.y), transform.Scale.z) + bias;
 
 			// Define the number of lines
 			int numLines = 32;
@@ -1173,11 +2229,11 @@ namespace Flameberry {
 			Renderer2D::AddLine(glm::vec3(pos.x, pos.z, pos.y) + transform.Translation, transform.Translation + glm::vec3(radius, 0.0f, 0.0f), greenColor);
 			Renderer2D::AddLine(glm::vec3(pos.z, pos.y, pos.x) + transform.Translation, transform.Translation + glm::vec3(0.0f, 0.0f, radius), greenColor);
 		}
-		else if (auto* capsuleCollider = scene->GetRegistry()->TryGetComponent<CapsuleColliderComponent>(entity); capsuleCollider)
+		else if (entity.HasCapsuleCollider)
 		{
 			// Define the radius and half height of the capsule
-			float halfHeight = 0.5f * capsuleCollider->Height * transform.Scale.y;
-			float radius = capsuleCollider->Radius * glm::max(transform.Scale.x, transform.Scale.z) + bias;
+			float halfHeight = 0.5f * entity.CapsuleCollider.Height * transform.Scale.y;
+			float radius = entity.CapsuleCollider.Radius * glm::max(transform.Scale.x, transform.Scale.z) + bias;
 
 			Renderer2D::AddLine(transform.Translation + rotationMatrix * glm::vec3(radius, halfHeight, 0), transform.Translation + rotationMatrix * glm::vec3(radius, -halfHeight, 0), greenColor);
 			Renderer2D::AddLine(transform.Translation + rotationMatrix * glm::vec3(-radius, halfHeight, 0), transform.Translation + rotationMatrix * glm::vec3(-radius, -halfHeight, 0), greenColor);
@@ -1196,13 +2252,14 @@ namespace Flameberry {
 	}
 
 	// TODO: Move this to EditorLayer.cpp ASAP
-	void SceneRenderer::SubmitCameraViewGeometry(const Ref<Scene>& scene, FEntity entity, TransformComponent& transform)
+	void SceneRenderer::SubmitCameraViewGeometry(const SelectedEntityProxy& entity)
 	{
 		GLM_CONSTEXPR glm::vec3 color(0.961f, 0.796f, 0.486f); // TODO: Replace with Theme::AccentColor
-		if (auto* cameraComp = scene->GetRegistry()->TryGetComponent<CameraComponent>(entity))
+		if (entity.HasCamera)
 		{
+			const auto& transform = entity.Transform;
 			const glm::mat3 rotationMatrix = glm::toMat3(glm::quat(transform.Rotation));
-			const auto& settings = cameraComp->Camera.GetSettings();
+			const auto& settings = entity.CameraSettings;
 			float aspectRatio = m_ViewportSize.x / m_ViewportSize.y;
 
 			switch (settings.ProjectionType)
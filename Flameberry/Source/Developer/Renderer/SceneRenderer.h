@@ -3,35 +3,56 @@
 #include "CommandBuffer.h"
 #include "DescriptorSet.h"
 #include "Pipeline.h"
+#include "PipelinePermutationCache.h"
 #include "MaterialAsset.h"
+#include "StaticMesh.h"
+#include "Frustum.h"
+#include "LightCulling.h"
+#include "OcclusionCulling.h"
+#include "Font.h"
+#include "Skymap.h"
+#include "SwapChain.h"
+#include "GenericCamera.h"
 #include "ECS/Components.h"
 #include "ECS/Scene.h"
 
 namespace Flameberry {
 
-	struct ModelMatrixPushConstantData
+	// Matches the `MeshInstance` struct (std430) read by the mesh vertex shaders using `gl_InstanceIndex`
+	struct MeshInstanceData
 	{
 		glm::mat4 ModelMatrix;
-	};
-
-	struct MousePickingPushConstantData
-	{
-		glm::mat4 ModelMatrix;
-		int EntityIndex;
+		alignas(16) int EntityIndex;
+		// Bit `i` is set when the instance is to be rendered to the view `i` of a multiview render pass (the shadow cascades)
+		uint32_t ViewMask;
+		// Index into `MaterialParameterBuffer`, hence the instances of a draw call can have different materials
+		uint32_t MaterialIndex;
 	};
 
 	struct SceneRendererSettings
 	{
-		bool FrustumCulling = true, ShowBoundingBoxes = false;
+		bool FrustumCulling = true, OcclusionCulling = true, ShowBoundingBoxes = false;
 		float GammaCorrectionFactor = 2.2f, Exposure = 1.0f;
 
 		bool EnableShadows = true, ShowCascades = false, SoftShadows = true, SkyReflections = true;
 		float CascadeLambdaSplit = 0.91f;
+		// Changing these recreates the shadow maps
+		uint32_t CascadeCount = 4, CascadeSize = 1024 * 2;
+
+		// The static shadow casters of the cascades starting from `FirstCachedCascade` are rendered once and reused until the cascade changes
+		bool CacheStaticShadows = true;
+		uint32_t FirstCachedCascade = 1;
 
 		bool GridFading = true;
 		float GridNear = 0.1f, GridFar = 100.0f;
 
-		static constexpr uint32_t CascadeCount = 4, CascadeSize = 1024 * 2; // TODO: Make this a renderer startup setting
+		// The scene is rendered into a scaled down region of the render targets to hold the target GPU frame time, the region is upscaled when displayed
+		bool DynamicResolution = false;
+		float TargetFrameTime = 1000.0f / 60.0f; // in milliseconds
+		float MinRenderScale = 0.5f;
+
+		// The shadow map is sampled as a texture array, hence it needs at least 2 cascades
+		static constexpr uint32_t MinCascadeCount = 2, MaxCascadeCount = 4;
 	};
 
 	struct Cascade
@@ -40,27 +61,252 @@ namespace Flameberry {
 		float DepthSplit;
 	};
 
+	// The light space volume which the cached static shadows of a cascade were rendered with
+	struct CascadeCacheKey
+	{
+		glm::vec3 LightDirection, LightSpaceCenter;
+		float Radius = 0.0f;
+	};
+
 	///////////////////////////////////////////////////////////////////////////////////
 	///////// Data Structures for storing all Rendering Information Per Frame /////////
 
-	struct RenderObject
+	enum class DrawPass : uint8_t
+	{
+		Opaque = 0
+	};
+
+	// The feature bits of the variants of the mesh pipeline, matching the specialization constant IDs of `PBR.frag`
+	// The material features come first followed by the renderer settings, which are the same for all the draws of a frame
+	enum MeshPipelineFeature : uint32_t
+	{
+		MeshPipelineFeature_AlbedoMap = 1 << 0,
+		MeshPipelineFeature_NormalMap = 1 << 1,
+		MeshPipelineFeature_RoughnessMap = 1 << 2,
+		MeshPipelineFeature_AmbientMap = 1 << 3,
+		MeshPipelineFeature_MetallicMap = 1 << 4,
+		MeshPipelineFeature_Shadows = 1 << 5,
+		MeshPipelineFeature_SoftShadows = 1 << 6,
+		MeshPipelineFeature_SkyReflections = 1 << 7,
+
+		MeshPipelineFeature_Count = 8,
+		MeshPipelineFeature_All = (1 << MeshPipelineFeature_Count) - 1
+	};
+
+	// Packs the state of a draw call into a 64 bit key, from the most significant to the least significant bits:
+	// | Pass (4) | Pipeline (8) | Geometry (16) | Material (16) | Depth Bucket (20) |
+	// Sorting by this key minimizes the state changes and draws the objects sharing the same state front to back
+	// As the materials are read from the material parameter buffer, the draws of the same geometry can be instanced even across materials
+	struct DrawSortKey
+	{
+		static constexpr uint32_t PassBits = 4, PipelineBits = 8, GeometryBits = 16, MaterialBits = 16, DepthBits = 20;
+
+		static uint64_t Create(DrawPass pass, uint32_t pipelineIndex, uint32_t geometryIndex, uint32_t materialIndex, uint32_t depthBucket)
+		{
+			uint64_t key = (uint64_t)pass & ((1ull << PassBits) - 1);
+			key = (key << PipelineBits) | (pipelineIndex & ((1ull << PipelineBits) - 1));
+			key = (key << GeometryBits) | (geometryIndex & ((1ull << GeometryBits) - 1));
+			key = (key << MaterialBits) | (materialIndex & ((1ull << MaterialBits) - 1));
+			key = (key << DepthBits) | (depthBucket & ((1ull << DepthBits) - 1));
+			return key;
+		}
+
+		// Quantizes the normalized [0, 1] distance from the camera
+		static uint32_t QuantizeDepth(float normalizedDepth)
+		{
+			return (uint32_t)(glm::clamp(normalizedDepth, 0.0f, 1.0f) * (float)((1u << DepthBits) - 1));
+		}
+	};
+
+	// Trivially copyable description of a single draw call, so that it can be radix sorted cheaply
+	struct DrawItem
+	{
+		uint64_t SortKey;
+
+		// The meshes share the vertex and index buffers of the blocks of `GeometryArena`, so the buffers are rebound only when the block changes
+		VkBuffer VertexBuffer, IndexBuffer;
+		int32_t VertexOffset;
+		uint32_t IndexOffset, IndexCount;
+
+		// Index into the per frame instance table of `RendererData`
+		uint32_t InstanceIndex;
+		// Index into `MaterialParameterBuffer`, copied to `MeshInstanceData::MaterialIndex`
+		uint32_t MaterialIndex;
+		// Index of the variant of the mesh pipeline, which is the same for all the draw items sharing a material
+		uint32_t PipelineIndex;
+		// Copied to `MeshInstanceData::ViewMask`, hence the draw items with different view masks can still be instanced together
+		uint32_t ViewMask;
+
+		// Consecutive draw items drawing the same geometry with the same pipeline are collapsed into one instanced draw call
+		bool CanBeInstancedWith(const DrawItem& other) const
+		{
+			return VertexBuffer == other.VertexBuffer && VertexOffset == other.VertexOffset && IndexOffset == other.IndexOffset && IndexCount == other.IndexCount && PipelineIndex == other.PipelineIndex;
+		}
+	};
+
+	// The world space bounds of the submeshes of a mesh entity, recalculated only when it's transform or mesh changes
+	struct MeshBoundsCacheEntry
+	{
+		glm::vec3 Translation, Rotation, Scale;
+		AssetHandle MeshHandle = 0;
+
+		glm::mat4 ModelMatrix;
+		std::vector<glm::vec3> Centers, Extents;
+
+		uint64_t LastUsedFrame = 0, LastModifiedFrame = 0;
+	};
+
+	struct MeshEntityRenderProxy
+	{
+		// Keeps the buffers of the mesh alive while the frame is being rendered, it's submeshes and occluder geometry don't change after loading
+		Ref<StaticMesh> Mesh;
+		// Index of the render proxy of the first submesh in `SceneRenderProxies::RenderProxies`
+		uint32_t FirstRenderProxyIndex;
+		bool IsOccluder;
+		// The static shadow casters are rendered into the cached cascades only when they are invalidated
+		bool IsStaticShadowCaster;
+	};
+
+	// A submesh of a mesh entity along with everything needed to draw it, extracted once per frame and shared by all the passes
+	// The world space bounds of the proxy `i` are at index `i` of `SceneRenderProxies::SubMeshBounds` and it's visibility in a view is the bit `i` of the mask of that view
+	struct RenderProxy
 	{
 		VkBuffer VertexBuffer, IndexBuffer;
+		// The offsets of the geometry of the submesh in the buffers of it's geometry arena block
+		int32_t VertexOffset;
 		uint32_t IndexOffset, IndexCount;
+		uint32_t GeometryIndex;
+		// Index into `SceneRenderProxies::Materials`, `UINT32_MAX` when the submesh doesn't have a valid material
+		uint32_t MaterialIndex;
+		// Index into `SceneRenderProxies::MeshEntities` as well as `SceneRenderProxies::Instances`, which holds the world matrix and the entity index
+		uint32_t MeshEntityIndex;
+	};
 
-		TransformComponent* Transform;
+	struct BillboardProxy
+	{
+		glm::vec3 Position;
+		int EntityIndex;
+	};
 
-		Ref<MaterialAsset> MaterialAsset;
+	struct TextProxy
+	{
+		std::string Text;
+		Ref<Font> FontAsset;
+		glm::mat4 Transform;
+		glm::vec3 Color;
+		float Kerning, LineSpacing;
+		int EntityIndex;
+	};
 
-		RenderObject(VkBuffer vertexBuffer, VkBuffer indexBuffer, uint32_t indexOffset, uint32_t indexCount, TransformComponent* transform, Ref<Flameberry::MaterialAsset> materialAsset)
-			: VertexBuffer(vertexBuffer), IndexBuffer(indexBuffer), IndexOffset(indexOffset), IndexCount(indexCount), Transform(transform), MaterialAsset(materialAsset)
+	// The components of the selected entity that the debug geometry (physics colliders and camera frustum) is drawn from
+	struct SelectedEntityProxy
+	{
+		bool IsValid = false;
+		TransformComponent Transform;
+
+		bool HasBoxCollider = false, HasSphereCollider = false, HasCapsuleCollider = false, HasCamera = false;
+		BoxColliderComponent BoxCollider;
+		SphereColliderComponent SphereCollider;
+		CapsuleColliderComponent CapsuleCollider;
+		GenericCameraSettings CameraSettings;
+	};
+
+	// The render state of a scene copied by `SceneRenderer::ExtractScene()`
+	// The renderer builds the frame only from these, so the scene can be updated for the next frame while the current one is being rendered
+	struct SceneRenderProxies
+	{
+		// Meshes
+		std::vector<MeshEntityRenderProxy> MeshEntities;
+		std::vector<RenderProxy> RenderProxies;
+		AABBSoA SubMeshBounds;
+		// There is one instance per mesh entity
+		std::vector<MeshInstanceData> Instances;
+		std::vector<Ref<MaterialAsset>> Materials;
+		std::unordered_map<AssetHandle, uint32_t> MaterialHandleToIndex;
+		std::unordered_map<const StaticMesh*, uint32_t> MeshToGeometryIndex;
+		uint32_t GeometryCount = 0;
+
+		// The bounds of the static shadow casters which were added, changed or removed since the last extraction
+		AABBSoA StaticShadowCasterChangedBounds;
+
+		// Lights
+		bool HasDirectionalLight = false;
+		DirectionalLight DirLight;
+		std::vector<PointLight> PointLights;
+		std::vector<SpotLight> SpotLights;
+		std::vector<int> PointLightEntityIndices, SpotLightEntityIndices;
+
+		// Sky Light
+		float SkyLightIntensity = 0.0f;
+		// Null when the sky light doesn't render a skymap
+		Ref<Skymap> SkymapAsset;
+
+		// Editor
+		std::vector<BillboardProxy> CameraIcons, DirectionalLightIcons;
+		SelectedEntityProxy SelectedEntity;
+
+		std::vector<TextProxy> Texts;
+
+		// Persists across extractions and is moved into the proxies of the next extraction, the entries not used in an extraction are evicted
+		// It is only accessed by the extraction, hence it isn't cleared along with the rest of the proxies
+		std::unordered_map<FEntity::THandleType, MeshBoundsCacheEntry> MeshBoundsCache;
+		uint64_t ExtractionIndex = 0;
+
+		// Every submesh of a mesh gets a consecutive geometry index, starting from the returned index
+		uint32_t GetFirstGeometryIndex(const StaticMesh* mesh, uint32_t submeshCount)
 		{
+			const auto [it, inserted] = MeshToGeometryIndex.try_emplace(mesh, GeometryCount);
+			if (inserted)
+				GeometryCount += submeshCount;
+			return it->second;
+		}
+
+		void Clear()
+		{
+			MeshEntities.clear();
+			RenderProxies.clear();
+			SubMeshBounds.Clear();
+			Instances.clear();
+			Materials.clear();
+			MaterialHandleToIndex.clear();
+			MeshToGeometryIndex.clear();
+			GeometryCount = 0;
+			StaticShadowCasterChangedBounds.Clear();
+			HasDirectionalLight = false;
+			PointLights.clear();
+			SpotLights.clear();
+			PointLightEntityIndices.clear();
+			SpotLightEntityIndices.clear();
+			SkyLightIntensity = 0.0f;
+			SkymapAsset = nullptr;
+			CameraIcons.clear();
+			DirectionalLightIcons.clear();
+			SelectedEntity = SelectedEntityProxy{};
+			Texts.clear();
 		}
 	};
 
 	struct RendererData
 	{
-		std::vector<RenderObject> RenderObjects;
+		std::vector<DrawItem> DrawItems, MeshEntityDrawItems, ShadowCasterDrawItems, StaticShadowCasterDrawItems, SortScratchBuffer;
+
+		// Staging array for the instance data of the draw items in their sorted order
+		std::vector<MeshInstanceData> SortedInstances;
+
+		// The mesh pipeline variant of each material of the proxies, indexed by the material index
+		std::vector<uint32_t> MaterialPipelineIndices;
+
+		// Per view visibility of the render proxies
+		std::vector<uint64_t> SubMeshVisibilityMask;
+		std::vector<uint64_t> CascadeCasterMasks[SceneRendererSettings::MaxCascadeCount];
+
+		void Clear()
+		{
+			DrawItems.clear();
+			MeshEntityDrawItems.clear();
+			ShadowCasterDrawItems.clear();
+			StaticShadowCasterDrawItems.clear();
+		}
 	};
 
 	///////////////////////////////////////////////////////////////////////////////////
@@ -71,48 +317,149 @@ namespace Flameberry {
 		SceneRenderer(const glm::vec2& viewportSize);
 		~SceneRenderer();
 
-		void RenderScene(const glm::vec2& viewportSize, const Ref<Scene>& scene, const GenericCamera& camera, const glm::vec3& cameraPosition, FEntity selectedEntity, bool renderGrid = true, bool renderDebugIcons = true, bool renderOutline = true, bool renderPhysicsCollider = true);
-		void RenderScene(const glm::vec2& viewportSize, const Ref<Scene>& scene, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& cameraPosition, float cameraNear, float cameraFar, FEntity selectedEntity, bool renderGrid = true, bool renderDebugIcons = true, bool renderOutline = true, bool renderPhysicsCollider = true);
+		// Copies the render state of the scene into renderer owned proxies, once this returns the scene can be updated for the next frame
+		// The proxies are double buffered, so the next frame is extracted by the main thread while the render thread consumes the current one
+		// The extraction doesn't touch the state of the renderer, the caches it needs travel along with the proxies
+		const SceneRenderProxies& ExtractScene(const Ref<Scene>& scene, FEntity selectedEntity);
+
+		// Builds the frame only from the extracted proxies without touching the scene
+		void RenderScene(const glm::vec2& viewportSize, const SceneRenderProxies& proxies, const GenericCamera& camera, const glm::vec3& cameraPosition, bool renderGrid = true, bool renderDebugIcons = true, bool renderOutline = true, bool renderPhysicsCollider = true);
+		void RenderScene(const glm::vec2& viewportSize, const SceneRenderProxies& proxies, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, const glm::vec3& cameraPosition, float cameraNear, float cameraFar, bool renderGrid = true, bool renderDebugIcons = true, bool renderOutline = true, bool renderPhysicsCollider = true);
 
 		VkImageView GetGeometryPassOutputImageView(uint32_t index) const { return m_GeometryPass->GetSpecification().TargetFramebuffers[index]->GetColorResolveAttachment(0)->GetVulkanImageView(); }
 		VkImageView GetCompositePassOutputImageView(uint32_t index) const { return m_CompositePass->GetSpecification().TargetFramebuffers[index]->GetColorAttachment(0)->GetVulkanImageView(); }
 
 		SceneRendererSettings& GetRendererSettingsRef() { return m_RendererSettings; }
+		float GetRenderScale() const { return m_RenderScale; }
+		// The region of the geometry pass output which the viewport was rendered into, in texture coordinates
+		glm::vec2 GetViewportUVScale() const { return m_RenderExtent / glm::max(m_RenderTargetSize, glm::vec2(1.0f)); }
 		void RenderSceneForMousePicking(const Ref<Scene>& scene, const Ref<RenderPass>& renderPass, const Ref<Pipeline>& pipeline, const Ref<Pipeline>& pipeline2D, const glm::vec2& mousePos);
 
 		void ReloadMeshShaders();
 
 	private:
 		void Init();
+		// (Re)creates the shadow maps and the shadow map pipeline using the cascade count and size of the renderer settings
+		void CreateShadowMapResources();
 
+		// Adjusts the render scale using the GPU time of the last frame whose timestamps were read back
+		void UpdateRenderScale();
 		void CalculateShadowMapCascades(const glm::mat4& viewProjectionMatrix, float cameraNear, float cameraFar, const glm::vec3& lightDirection);
-		void SubmitPhysicsColliderGeometry(const Ref<Scene>& scene, FEntity entity, TransformComponent& transform);
-		void SubmitCameraViewGeometry(const Ref<Scene>& scene, FEntity entity, TransformComponent& transform);
+		void SubmitPhysicsColliderGeometry(const SelectedEntityProxy& entity);
+		void SubmitCameraViewGeometry(const SelectedEntityProxy& entity);
+
+		// Walks the mesh entities once per frame and extracts a render proxy along with the world space bounds of each of their submeshes
+		// The assets are resolved here, so that none of the passes have to query the registry or the asset manager
+		void ExtractMeshEntities(const Ref<Scene>& scene, SceneRenderProxies& outProxies);
+		// Returns the index of the material in the material table of the proxies, the asset manager is queried once per unique material
+		uint32_t GetMaterialIndex(SceneRenderProxies& proxies, AssetHandle materialHandle);
+		// Rasterizes the visible submeshes of the occluder entities and clears the submeshes hidden behind them from the visibility mask
+		// Returns the number of occluded submeshes
+		uint32_t CullOccludedSubMeshes(const glm::mat4& viewProjectionMatrix);
+
+		// Gathers one draw item per mesh entity covering all of it's submeshes, sorted so that the entities sharing a mesh are next to each other
+		// The mesh entities with all of their submeshes culled from the camera view are skipped
+		void GatherMeshEntityDrawItems(std::vector<DrawItem>& outDrawItems);
+		// Marks the cached cascades in which a static shadow caster was added, changed or removed as dirty
+		void InvalidateStaticShadowCascades();
+		uint32_t GetCachedCascadeMask() const;
+
+		// Gathers one draw item per submesh which casts a shadow into at least one of the cascades, the cascades are marked in the view mask
+		// The static shadow casters are gathered into `outStaticDrawItems` only for the dirty cached cascades, as the other cached cascades already contain them
+		// Returns the number of shadow casting submeshes
+		uint32_t GatherShadowCasterDrawItems(uint32_t cachedCascadeMask, uint32_t dirtyCachedCascadeMask, std::vector<DrawItem>& outStaticDrawItems, std::vector<DrawItem>& outDrawItems);
+		// Returns the mesh pipeline feature bits of the texture maps used by the material
+		static uint32_t GetMaterialFeatureBits(const Ref<MaterialAsset>& material);
+		// Submits the sorted draw items which don't need any material, by collapsing the entities sharing a mesh into instanced draw calls
+		void SubmitInstancedMeshEntityDrawItems(const std::vector<DrawItem>& drawItems);
+		// Copies the instance data of the sorted draw items into the instance storage buffer of the current frame
+		// Returns the index of the first instance, which is to be added to the `firstInstance` of the draw calls
+		uint32_t WriteInstanceData(const std::vector<DrawItem>& drawItems);
+		void ReserveInstanceStorage(uint32_t instanceCount);
+		// Writes the elements into the light storage buffer of the current frame which is bound to `binding` of the scene descriptor set, growing it when needed
+		void WriteLightStorageBuffer(uint32_t binding, const void* data, uint32_t elementCount, VkDeviceSize elementSize);
+
+		// Clears the dirty cached cascades of the static shadow map and transitions the whole image for the static shadow map pass
+		static void RT_ClearStaticShadowMapCascades(VkCommandBuffer cmdBuffer, VkImage staticShadowMap, uint32_t cascadeCount, uint32_t cachedCascadeMask, uint32_t dirtyCascadeMask);
+		// Copies the cached cascades of the static shadow map into the shadow map of the frame and clears the rest of it's cascades
+		static void RT_CopyStaticShadowMap(VkCommandBuffer cmdBuffer, VkImage staticShadowMap, VkImage shadowMap, uint32_t cascadeCount, uint32_t cachedCascadeMask, uint32_t cascadeSize);
 
 	private:
 		glm::vec2 m_ViewportSize;
+		// The render targets only grow, so that the changes of the render scale never recreate them
+		glm::vec2 m_RenderTargetSize;
+		// The size of the region the scene is rendered into, i.e. the viewport size scaled by the render scale
+		glm::vec2 m_RenderExtent;
+		float m_RenderScale = 1.0f;
+		// The unquantized render scale the controller converges towards
+		float m_FilteredRenderScale = 1.0f;
+
+		// The render scale of the recent frames, the GPU timings are read back a few frames later and have to be compared against the scale they were measured at
+		struct RenderScaleSample
+		{
+			uint64_t FrameNumber = UINT64_MAX;
+			float RenderScale = 1.0f;
+		};
+		std::array<RenderScaleSample, 2 * SwapChain::MAX_FRAMES_IN_FLIGHT> m_RenderScaleSamples;
+		// The frame number of the last GPU timings the render scale was updated from
+		uint64_t m_LastTimedFrameNumber = UINT64_MAX;
 
 		// Command Buffers
 		std::vector<Ref<CommandBuffer>> m_CommandBuffers;
 
 		// Geometry
 		Ref<RenderPass> m_GeometryPass;
-		Ref<DescriptorSetLayout> m_CameraBufferDescSetLayout, m_SceneDescriptorSetLayout, m_ShadowMapRefDescriptorSetLayout;
-		std::vector<Ref<DescriptorSet>> m_CameraBufferDescriptorSets, m_SceneDataDescriptorSets, m_ShadowMapRefDescSets;
-		std::vector<std::unique_ptr<Buffer>> m_CameraUniformBuffers, m_SceneUniformBuffers;
-		Ref<Pipeline> m_MeshPipeline, m_SkymapPipeline, m_GridPipeline;
+		Ref<DescriptorSetLayout> m_CameraBufferDescSetLayout, m_MeshDescriptorSetLayout, m_SceneDescriptorSetLayout, m_ShadowMapRefDescriptorSetLayout;
+		// The mesh descriptor sets contain the camera uniform buffer and the instance storage buffer, used by the mesh and the mouse picking pipelines
+		std::vector<Ref<DescriptorSet>> m_MeshDescriptorSets, m_SceneDataDescriptorSets, m_ShadowMapRefDescSets;
+		// The transient camera descriptor set of the last `RenderScene()` call, valid only for the frame being recorded
+		VkDescriptorSet m_CameraBufferDescriptorSet = VK_NULL_HANDLE;
+		// The dynamic offsets of the uniform data of the last `RenderScene()` call into the uniform ring, the descriptor sets refer to the ring buffer of their frame
+		uint32_t m_CameraBufferOffset = 0, m_SceneBufferOffset = 0;
+		// The variants of the mesh pipeline are keyed by the `MeshPipelineFeature` bits
+		Unique<PipelinePermutationCache> m_MeshPipelines;
+		Ref<Pipeline> m_SkymapPipeline, m_GridPipeline;
 		VkSampler m_VkTextureSampler;
 		Ref<Material> m_GridMaterial;
 
 		// Shadow Map
-		Ref<RenderPass> m_ShadowMapRenderPass;
+		// The static shadow map pass renders the static shadow casters of the cached cascades into a single persistent shadow map
+		// The clear shadow map pass shares the framebuffers of the shadow map pass, and is used instead of it when none of the cascades are cached
+		Ref<RenderPass> m_ShadowMapRenderPass, m_ShadowMapClearRenderPass, m_StaticShadowMapRenderPass;
 		Ref<Pipeline> m_ShadowMapPipeline;
 		Ref<DescriptorSetLayout> m_ShadowMapDescriptorSetLayout;
-		std::vector<Ref<DescriptorSet>> m_ShadowMapDescriptorSets;
-		std::vector<std::unique_ptr<Buffer>> m_ShadowMapUniformBuffers;
+		uint32_t m_ShadowMapBufferOffset = 0;
 		VkSampler m_ShadowMapSampler;
 
-		Cascade m_Cascades[SceneRendererSettings::CascadeCount];
+		// The cascade settings that the shadow maps were created with
+		uint32_t m_ShadowMapCascadeCount = 0, m_ShadowMapCascadeSize = 0;
+		// Bit `i` is set when the cascade `i` of the static shadow map has to be cleared and rendered again
+		uint32_t m_DirtyStaticCascadeMask = ~0u, m_CachedCascadeMask = 0;
+		// The cascades rendered into the static shadow map by the frame with the given number, they are marked dirty again if the frame is dropped
+		uint32_t m_PendingStaticCascadeMask = 0;
+		uint64_t m_PendingStaticCascadeFrameNumber = 0;
+		CascadeCacheKey m_CascadeCacheKeys[SceneRendererSettings::MaxCascadeCount];
+
+		// Instancing
+		// The per instance data of all the instanced draw calls of a frame, grows on demand
+		std::vector<std::unique_ptr<Buffer>> m_InstanceStorageBuffers;
+		uint32_t m_InstanceCount = 0;
+
+		// The storage buffers replaced by bigger ones during each frame, released when the frame index is reused `MAX_FRAMES_IN_FLIGHT` frames later
+		std::array<std::vector<std::unique_ptr<Buffer>>, SwapChain::MAX_FRAMES_IN_FLIGHT> m_RetiredStorageBuffers;
+
+		// Clustered Lighting
+		// The point lights, the spot lights, the clusters and the light indices bound to the bindings 1 to 4 of the scene descriptor set, grow on demand
+		std::vector<std::array<std::unique_ptr<Buffer>, 4>> m_LightStorageBuffers;
+		LightClusterGrid m_LightClusterGrid;
+
+		SoftwareOcclusionCuller m_OcclusionCuller;
+		// Used for assigning the lights to the clusters and for rasterizing the occluders
+		Unique<ThreadPool> m_CullingThreadPool;
+		// Loads the occluder geometry in the background, the frames never wait on it
+		Unique<ThreadPool> m_OccluderLoadingThreadPool;
+
+		Cascade m_Cascades[SceneRendererSettings::MaxCascadeCount];
 		SceneRendererSettings m_RendererSettings;
 
 		// Post processing
@@ -126,6 +473,12 @@ namespace Flameberry {
 
 		// Batching
 		Unique<RendererData> m_RendererData;
+
+		// Extraction
+		SceneRenderProxies m_SceneProxies[2];
+		uint32_t m_NextSceneProxiesIndex = 0;
+		// The proxies rendered by the last `RenderScene()` call, also used by the mouse picking pass
+		const SceneRenderProxies* m_RenderedProxies = nullptr;
 	};
 
 } // namespace Flameberry
@@ -1,17 +1,22 @@
 #include "Shader.h"
 
 #include <fstream>
+#include <cstring>
+#include <type_traits>
 #include <SPIRV-Reflect/spirv_reflect.h>
 
 #include "Core/Core.h"
+#include "Core/Algorithm.h"
 #include "Renderer/VulkanContext.h"
 #include "Renderer/VulkanDebug.h"
+#include "Renderer/TextureTable.h"
 
 #define FBY_SHADER_RENDERER_ONLY_PREFIX "_FBY_"
 
 namespace Flameberry {
 
-	static std::unordered_map<uint64_t, uint32_t> s_DescriptorSetAndBindingIntegerToArrayIndex;
+	// Thread local as the shaders are loaded in parallel
+	static thread_local std::unordered_map<uint64_t, uint32_t> s_DescriptorSetAndBindingIntegerToArrayIndex;
 
 	bool operator==(const ReflectionDescriptorBindingSpecification& s1, const ReflectionDescriptorBindingSpecification& s2)
 	{
@@ -66,6 +71,76 @@ namespace Flameberry {
 			}
 		}
 
+		// 'FBSR', the version has to be incremented whenever the reflection or the layout of the cache changes
+		static constexpr uint32_t s_ReflectionCacheMagic = 0x52534246;
+		static constexpr uint32_t s_ReflectionCacheVersion = 1;
+
+		struct ReflectionCacheFileHeader
+		{
+			uint32_t Magic, Version;
+			// The hash of the SPIR-V binaries of all the stages, the cache is stale when the shader is recompiled
+			uint64_t SpvHash;
+			uint64_t DataSize, DataHash;
+		};
+
+		class ReflectionCacheWriter
+		{
+		public:
+			template <typename T>
+			void Write(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				const uint8_t* bytes = (const uint8_t*)&value;
+				m_Data.insert(m_Data.end(), bytes, bytes + sizeof(T));
+			}
+
+			void WriteString(const std::string& str)
+			{
+				Write((uint32_t)str.size());
+				m_Data.insert(m_Data.end(), str.begin(), str.end());
+			}
+
+			const std::vector<uint8_t>& GetData() const { return m_Data; }
+
+		private:
+			std::vector<uint8_t> m_Data;
+		};
+
+		// Every read fails once the end of the data is reached
+		class ReflectionCacheReader
+		{
+		public:
+			ReflectionCacheReader(const std::vector<uint8_t>& data)
+				: m_Data(data) {}
+
+			template <typename T>
+			bool Read(T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				if (m_Offset + sizeof(T) > m_Data.size())
+					return false;
+				memcpy(&value, m_Data.data() + m_Offset, sizeof(T));
+				m_Offset += sizeof(T);
+				return true;
+			}
+
+			bool ReadString(std::string& str)
+			{
+				uint32_t size;
+				if (!Read(size) || m_Offset + size > m_Data.size())
+					return false;
+				str.assign((const char*)m_Data.data() + m_Offset, size);
+				m_Offset += size;
+				return true;
+			}
+
+			bool IsAtEnd() const { return m_Offset == m_Data.size(); }
+
+		private:
+			const std::vector<uint8_t>& m_Data;
+			size_t m_Offset = 0;
+		};
+
 	} // namespace Utils
 
 	Shader::Shader(const std::filesystem::path& vertexShaderSpvPath, const std::filesystem::path& fragmentShaderSpvPath)
@@ -74,17 +149,13 @@ namespace Flameberry {
 		const auto& stem = vertexShaderSpvPath.stem().string();
 		m_Name = stem.substr(0, stem.find('.'));
 
-		// Clear the map to be used for the current shader
-		s_DescriptorSetAndBindingIntegerToArrayIndex.clear();
-
-		// Vertex Shader
 		std::vector<char> vertexShaderSpvBinaryCode = LoadShaderSpvCode(vertexShaderSpvPath);
-		Reflect(vertexShaderSpvBinaryCode);
-		m_VertexShaderModule = CreateVulkanShaderModule(vertexShaderSpvBinaryCode);
-
-		// Fragment Shader
 		std::vector<char> fragmentShaderSpvBinaryCode = LoadShaderSpvCode(fragmentShaderSpvPath);
-		Reflect(fragmentShaderSpvBinaryCode);
+
+		// The reflection data of both the stages is cached in a single file next to the SPIR-V binaries
+		LoadOrReflect(vertexShaderSpvPath.parent_path() / (m_Name + ".reflection"), { &vertexShaderSpvBinaryCode, &fragmentShaderSpvBinaryCode });
+
+		m_VertexShaderModule = CreateVulkanShaderModule(vertexShaderSpvBinaryCode);
 		m_FragmentShaderModule = CreateVulkanShaderModule(fragmentShaderSpvBinaryCode);
 	}
 
@@ -93,11 +164,8 @@ namespace Flameberry {
 		const auto& stem = spvBinaryPath.stem().string();
 		m_Name = stem.substr(0, stem.find('.'));
 
-		// Clear the map to be used for the current shader
-		s_DescriptorSetAndBindingIntegerToArrayIndex.clear();
-
 		std::vector<char> shaderSpvBinaryCode = LoadShaderSpvCode(spvBinaryPath);
-		Reflect(shaderSpvBinaryCode);
+		LoadOrReflect(spvBinaryPath.parent_path() / (m_Name + ".reflection"), { &shaderSpvBinaryCode });
 		m_ShaderModule = CreateVulkanShaderModule(shaderSpvBinaryCode);
 	}
 
@@ -300,12 +368,17 @@ namespace Flameberry {
 							fullName = binding->type_description->type_name;
 					}
 
+					// The uniform buffers hold per frame data, which is allocated from the uniform ring and bound with a dynamic offset
+					VkDescriptorType descriptorType = (VkDescriptorType)binding->descriptor_type;
+					if (descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+						descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+
 					ReflectionDescriptorBindingSpecification reflectionDescriptorBindingSpecification{
 						fullName, // Name
 						binding->set, // Set
 						binding->binding, // Binding
 						binding->count, // Count
-						(VkDescriptorType)binding->descriptor_type, // Type
+						descriptorType, // Type
 						(VkShaderStageFlags)reflectionShaderModule.GetShaderStage(), // VulkanShaderStage
 						rendererOnly, // IsRendererOnly
 						isDescriptorTypeImage // IsDescriptorTypeImage
@@ -337,6 +410,261 @@ namespace Flameberry {
 		}
 	}
 
+	void Shader::LoadOrReflect(const std::filesystem::path& cachePath, const std::vector<const std::vector<char>*>& shaderSpvBinaryCodes)
+	{
+		uint64_t spvHash = Algorithm::HashFNV1a64(shaderSpvBinaryCodes[0]->data(), shaderSpvBinaryCodes[0]->size());
+		for (size_t i = 1; i < shaderSpvBinaryCodes.size(); i++)
+			spvHash = Algorithm::HashFNV1a64(shaderSpvBinaryCodes[i]->data(), shaderSpvBinaryCodes[i]->size(), spvHash);
+
+		m_IsReflectionCached = DeserializeReflectionData(cachePath, spvHash);
+
+		if (!m_IsReflectionCached)
+		{
+			// Discard whatever was read from an invalid cache
+			m_VulkanShaderStageFlags = 0;
+			m_SpecializationConstantIDSet.clear();
+			m_PushConstantSpecifications.clear();
+			m_UniformFullNameToSpecification.clear();
+			m_DescriptorBindingSpecifications.clear();
+			m_DescriptorBindingVariableFullNameToSpecificationIndex.clear();
+			m_DescriptorSetSpecifications.clear();
+
+			// Clear the map to be used for the current shader
+			s_DescriptorSetAndBindingIntegerToArrayIndex.clear();
+
+			for (const auto* shaderSpvBinaryCode : shaderSpvBinaryCodes)
+				Reflect(*shaderSpvBinaryCode);
+
+			SerializeReflectionData(cachePath, spvHash);
+		}
+
+		CreateDescriptorSetLayouts();
+	}
+
+	bool Shader::DeserializeReflectionData(const std::filesystem::path& cachePath, uint64_t spvHash)
+	{
+		std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return false;
+
+		const size_t fileSize = (size_t)file.tellg();
+		if (fileSize < sizeof(Utils::ReflectionCacheFileHeader))
+			return false;
+
+		Utils::ReflectionCacheFileHeader header;
+		file.seekg(0);
+		file.read((char*)&header, sizeof(Utils::ReflectionCacheFileHeader));
+
+		if (header.Magic != Utils::s_ReflectionCacheMagic || header.Version != Utils::s_ReflectionCacheVersion || header.SpvHash != spvHash
+			|| header.DataSize != fileSize - sizeof(Utils::ReflectionCacheFileHeader))
+			return false;
+
+		std::vector<uint8_t> data(header.DataSize);
+		file.read((char*)data.data(), data.size());
+		if (!file || Algorithm::HashFNV1a64(data.data(), data.size()) != header.DataHash)
+		{
+			FBY_WARN("Discarding corrupted reflection cache: {}", cachePath);
+			return false;
+		}
+
+		Utils::ReflectionCacheReader reader(data);
+		uint32_t count;
+
+		if (!reader.Read(m_VulkanShaderStageFlags))
+			return false;
+
+		if (!reader.Read(count))
+			return false;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t constantID;
+			if (!reader.Read(constantID))
+				return false;
+			m_SpecializationConstantIDSet.insert(constantID);
+		}
+
+		if (!reader.Read(count))
+			return false;
+		m_PushConstantSpecifications.resize(count);
+		for (auto& specification : m_PushConstantSpecifications)
+		{
+			if (!reader.ReadString(specification.Name) || !reader.Read(specification.VulkanShaderStage) || !reader.Read(specification.Size) || !reader.Read(specification.Offset) || !reader.Read(specification.RendererOnly))
+				return false;
+		}
+
+		if (!reader.Read(count))
+			return false;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			std::string fullName;
+			ReflectionUniformVariableSpecification specification;
+			if (!reader.ReadString(fullName) || !reader.ReadString(specification.Name) || !reader.Read(specification.LocalOffset) || !reader.Read(specification.GlobalOffset) || !reader.Read(specification.Size))
+				return false;
+			m_UniformFullNameToSpecification[fullName] = specification;
+		}
+
+		if (!reader.Read(count))
+			return false;
+		m_DescriptorBindingSpecifications.resize(count);
+		for (auto& specification : m_DescriptorBindingSpecifications)
+		{
+			if (!reader.ReadString(specification.Name) || !reader.Read(specification.Set) || !reader.Read(specification.Binding) || !reader.Read(specification.Count)
+				|| !reader.Read(specification.Type) || !reader.Read(specification.VulkanShaderStage) || !reader.Read(specification.RendererOnly) || !reader.Read(specification.IsDescriptorTypeImage))
+				return false;
+		}
+
+		if (!reader.Read(count))
+			return false;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			std::string fullName;
+			uint32_t index;
+			if (!reader.ReadString(fullName) || !reader.Read(index) || index >= m_DescriptorBindingSpecifications.size())
+				return false;
+			m_DescriptorBindingVariableFullNameToSpecificationIndex[fullName] = index;
+		}
+
+		if (!reader.Read(count))
+			return false;
+		m_DescriptorSetSpecifications.resize(count);
+		for (auto& specification : m_DescriptorSetSpecifications)
+		{
+			if (!reader.Read(specification.Set) || !reader.Read(specification.BindingCount))
+				return false;
+		}
+
+		// The descriptor sets refer to consecutive ranges of the bindings, a cache whose counts don't add up would be read out of bounds
+		size_t bindingCount = 0;
+		for (const auto& specification : m_DescriptorSetSpecifications)
+			bindingCount += specification.BindingCount;
+
+		if (bindingCount > m_DescriptorBindingSpecifications.size())
+		{
+			FBY_WARN("Discarding reflection cache with mismatching descriptor binding counts: {}", cachePath);
+			return false;
+		}
+
+		return reader.IsAtEnd();
+	}
+
+	void Shader::SerializeReflectionData(const std::filesystem::path& cachePath, uint64_t spvHash) const
+	{
+		Utils::ReflectionCacheWriter writer;
+
+		writer.Write(m_VulkanShaderStageFlags);
+
+		writer.Write((uint32_t)m_SpecializationConstantIDSet.size());
+		for (uint32_t constantID : m_SpecializationConstantIDSet)
+			writer.Write(constantID);
+
+		writer.Write((uint32_t)m_PushConstantSpecifications.size());
+		for (const auto& specification : m_PushConstantSpecifications)
+		{
+			writer.WriteString(specification.Name);
+			writer.Write(specification.VulkanShaderStage);
+			writer.Write(specification.Size);
+			writer.Write(specification.Offset);
+			writer.Write(specification.RendererOnly);
+		}
+
+		writer.Write((uint32_t)m_UniformFullNameToSpecification.size());
+		for (const auto& [fullName, specification] : m_UniformFullNameToSpecification)
+		{
+			writer.WriteString(fullName);
+			writer.WriteString(specification.Name);
+			writer.Write(specification.LocalOffset);
+			writer.Write(specification.GlobalOffset);
+			writer.Write(specification.Size);
+		}
+
+		writer.Write((uint32_t)m_DescriptorBindingSpecifications.size());
+		for (const auto& specification : m_DescriptorBindingSpecifications)
+		{
+			writer.WriteString(specification.Name);
+			writer.Write(specification.Set);
+			writer.Write(specification.Binding);
+			writer.Write(specification.Count);
+			writer.Write(specification.Type);
+			writer.Write(specification.VulkanShaderStage);
+			writer.Write(specification.RendererOnly);
+			writer.Write(specification.IsDescriptorTypeImage);
+		}
+
+		writer.Write((uint32_t)m_DescriptorBindingVariableFullNameToSpecificationIndex.size());
+		for (const auto& [fullName, index] : m_DescriptorBindingVariableFullNameToSpecificationIndex)
+		{
+			writer.WriteString(fullName);
+			writer.Write(index);
+		}
+
+		writer.Write((uint32_t)m_DescriptorSetSpecifications.size());
+		for (const auto& specification : m_DescriptorSetSpecifications)
+		{
+			writer.Write(specification.Set);
+			writer.Write(specification.BindingCount);
+		}
+
+		const auto& data = writer.GetData();
+
+		Utils::ReflectionCacheFileHeader header;
+		header.Magic = Utils::s_ReflectionCacheMagic;
+		header.Version = Utils::s_ReflectionCacheVersion;
+		header.SpvHash = spvHash;
+		header.DataSize = data.size();
+		header.DataHash = Algorithm::HashFNV1a64(data.data(), data.size());
+
+		std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			FBY_WARN("Failed to write reflection cache: {}", cachePath);
+			return;
+		}
+
+		file.write((const char*)&header, sizeof(Utils::ReflectionCacheFileHeader));
+		file.write((const char*)data.data(), data.size());
+	}
+
+	void Shader::CreateDescriptorSetLayouts()
+	{
+		// The layouts are created and deduplicated once here, instead of every time a pipeline or a material is created using the shader
+		std::vector<VkDescriptorSetLayoutBinding> vulkanDescSetBindings;
+		uint32_t index = 0;
+
+		for (const auto& reflectionDescSet : m_DescriptorSetSpecifications)
+		{
+			// The unsized arrays (reflected with a count of 0) are only used for the bindless texture table, which has a set of it's own
+			if (reflectionDescSet.BindingCount == 1 && m_DescriptorBindingSpecifications[index].Count == 0)
+			{
+				FBY_ASSERT(m_DescriptorBindingSpecifications[index].Binding == 0 && m_DescriptorBindingSpecifications[index].Type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+					"The unsized descriptor array '{}' of shader '{}' doesn't match the layout of the texture table", m_DescriptorBindingSpecifications[index].Name, m_Name);
+
+				m_DescriptorSetLayouts.emplace_back(TextureTable::GetDescriptorSetLayout());
+				index++;
+				continue;
+			}
+
+			vulkanDescSetBindings.reserve(reflectionDescSet.BindingCount);
+			for (uint32_t i = 0; i < reflectionDescSet.BindingCount; i++)
+			{
+				vulkanDescSetBindings.emplace_back(VkDescriptorSetLayoutBinding{
+					m_DescriptorBindingSpecifications[index].Binding,
+					m_DescriptorBindingSpecifications[index].Type,
+					m_DescriptorBindingSpecifications[index].Count,
+					m_DescriptorBindingSpecifications[index].VulkanShaderStage,
+					nullptr });
+				index++;
+			}
+
+			// Create or Get the Cached descriptor set layout
+			if (vulkanDescSetBindings.size())
+			{
+				DescriptorSetLayoutSpecification layoutSpecification{ vulkanDescSetBindings };
+				m_DescriptorSetLayouts.emplace_back(DescriptorSetLayout::CreateOrGetCached(layoutSpecification));
+				vulkanDescSetBindings.clear();
+			}
+		}
+	}
+
 	VkShaderModule Shader::CreateVulkanShaderModule(const std::vector<char>& shaderSpvBinaryCode)
 	{
 		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
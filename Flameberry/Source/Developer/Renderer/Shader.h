@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <set>
+#include <vector>
 #include <filesystem>
 
 #include <vulkan/vulkan.h>
@@ -9,11 +10,14 @@
 // TODO: Should this include be in the cpp file only with forward declaration and heap allocation of spv_reflect::ShaderModule?
 #include <SPIRV-Reflect/spirv_reflect.h>
 
+#include "Core/Core.h"
+#include "DescriptorSet.h"
+
 namespace Flameberry {
 
 	struct ReflectionPushConstantSpecification
 	{
-		const char* Name;
+		std::string Name;
 		VkShaderStageFlagBits VulkanShaderStage;
 		uint32_t Size, Offset;
 		bool RendererOnly = true;
@@ -22,7 +26,7 @@ namespace Flameberry {
 	struct ReflectionUniformVariableSpecification
 	{
 		// This `Name` variable currently has no use
-		const char* Name;
+		std::string Name;
 		uint32_t LocalOffset, GlobalOffset, Size;
 	};
 
@@ -91,6 +95,10 @@ namespace Flameberry {
 		const std::vector<ReflectionPushConstantSpecification>& GetPushConstantSpecifications() const { return m_PushConstantSpecifications; }
 		const std::vector<ReflectionDescriptorBindingSpecification>& GetDescriptorBindingSpecifications() const { return m_DescriptorBindingSpecifications; }
 		const std::vector<ReflectionDescriptorSetSpecification>& GetDescriptorSetSpecifications() const { return m_DescriptorSetSpecifications; }
+		// The layouts of the non empty descriptor sets, created once the shader is loaded and shared with all the other shaders using identical layouts
+		const std::vector<Ref<DescriptorSetLayout>>& GetDescriptorSetLayouts() const { return m_DescriptorSetLayouts; }
+		// Whether the reflection data was loaded from the reflection cache instead of reflecting the SPIR-V
+		bool IsReflectionCached() const { return m_IsReflectionCached; }
 
 		// Costly functions
 		const ReflectionUniformVariableSpecification& GetUniform(const std::string& name) const;
@@ -99,6 +107,11 @@ namespace Flameberry {
 	private:
 		std::vector<char> LoadShaderSpvCode(const std::filesystem::path& path);
 		void Reflect(const std::vector<char>& shaderSpvBinaryCode);
+		// Loads the reflection data from the cache next to the SPIR-V binaries, or reflects the binaries and updates the cache
+		void LoadOrReflect(const std::filesystem::path& cachePath, const std::vector<const std::vector<char>*>& shaderSpvBinaryCodes);
+		bool DeserializeReflectionData(const std::filesystem::path& cachePath, uint64_t spvHash);
+		void SerializeReflectionData(const std::filesystem::path& cachePath, uint64_t spvHash) const;
+		void CreateDescriptorSetLayouts();
 		VkShaderModule CreateVulkanShaderModule(const std::vector<char>& shaderSpvBinaryCode);
 
 	private:
@@ -122,6 +135,9 @@ namespace Flameberry {
 		std::vector<ReflectionPushConstantSpecification> m_PushConstantSpecifications;
 		std::vector<ReflectionDescriptorBindingSpecification> m_DescriptorBindingSpecifications;
 		std::vector<ReflectionDescriptorSetSpecification> m_DescriptorSetSpecifications;
+		std::vector<Ref<DescriptorSetLayout>> m_DescriptorSetLayouts;
+
+		bool m_IsReflectionCached = false;
 
 		// This should only be accessed while initialisation of material or while editing it.
 		// Don't access this during rendering every frame. As std::string hashing causes overhead
@@ -1,5 +1,11 @@
 #include "ShaderLibrary.h"
 
+#include <array>
+#include <unordered_set>
+
+#include "Core/Timer.h"
+#include "PipelineBuilder.h"
+
 namespace Flameberry {
 
 	std::unordered_map<std::string, Ref<Shader>> ShaderLibrary::s_ShaderStorage;
@@ -7,6 +13,8 @@ namespace Flameberry {
 
 	void ShaderLibrary::Init()
 	{
+		Timer timer;
+
 		// Currently this is hardcoded as no new shaders are loaded dynamically at runtime
 		const char* paths[][2] = {
 			{ "PBR.vert.spv", "PBR.frag.spv" },
@@ -27,17 +35,37 @@ namespace Flameberry {
 			"BRDFLUT.comp.spv",
 		};
 
-		for (const auto& path : paths)
-		{
-			Ref<Shader> shader = CreateRef<Shader>(s_ShaderBaseDirectory / path[0], s_ShaderBaseDirectory / path[1]);
+		constexpr uint32_t graphicsShaderCount = sizeof(paths) / sizeof(paths[0]);
+		constexpr uint32_t computeShaderCount = sizeof(computeShaderPaths) / sizeof(computeShaderPaths[0]);
+
+		// The shaders are loaded, reflected and their modules are created in parallel
+		std::array<Ref<Shader>, graphicsShaderCount + computeShaderCount> shaders;
+		std::vector<std::shared_future<void>> fences;
+		fences.reserve(shaders.size());
+
+		for (uint32_t i = 0; i < graphicsShaderCount; i++)
+			fences.emplace_back(PipelineBuilder::Submit([&shaders, &paths, i]() { shaders[i] = CreateRef<Shader>(s_ShaderBaseDirectory / paths[i][0], s_ShaderBaseDirectory / paths[i][1]); }));
+
+		for (uint32_t i = 0; i < computeShaderCount; i++)
+			fences.emplace_back(PipelineBuilder::Submit([&shaders, &computeShaderPaths, i]() { shaders[graphicsShaderCount + i] = CreateRef<Shader>(s_ShaderBaseDirectory / computeShaderPaths[i]); }));
+
+		for (auto& fence : fences)
+			fence.get();
+
+		for (const auto& shader : shaders)
 			s_ShaderStorage[shader->GetName()] = shader;
-		}
 
-		for (const auto& path : computeShaderPaths)
+		uint32_t cachedShaderCount = 0, layoutCount = 0;
+		std::unordered_set<DescriptorSetLayout*> uniqueLayouts;
+		for (const auto& [name, shader] : s_ShaderStorage)
 		{
-			Ref<Shader> shader = CreateRef<Shader>(s_ShaderBaseDirectory / path);
-			s_ShaderStorage[shader->GetName()] = shader;
+			cachedShaderCount += shader->IsReflectionCached();
+			layoutCount += (uint32_t)shader->GetDescriptorSetLayouts().size();
+			for (const auto& layout : shader->GetDescriptorSetLayouts())
+				uniqueLayouts.insert(layout.get());
 		}
+
+		FBY_INFO("Loaded {} shaders in {} ms ({} from the reflection cache), {} descriptor set layouts deduplicated to {}", s_ShaderStorage.size(), timer.GetTimeEllapsedMilliseconds(), cachedShaderCount, layoutCount, uniqueLayouts.size());
 	}
 
 	Ref<Shader> ShaderLibrary::Get(const std::string& shaderName)
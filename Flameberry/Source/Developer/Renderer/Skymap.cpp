@@ -8,7 +8,6 @@
 #include "Renderer/Shader.h"
 #include "Renderer/ShaderLibrary.h"
 #include "Renderer/VulkanContext.h"
-#include "Renderer/CommandBuffer.h"
 #include "Renderer/Buffer.h"
 #include "Renderer/Pipeline.h"
 #include "Renderer/Texture2D.h"
@@ -46,8 +45,12 @@ namespace Flameberry {
 		// Calculate the image size manually
 		const float imageSize = 4 * width * height * bytesPerChannel;
 
+		// The resources used by the generation are kept alive until the GPU is done with them
+		m_GenerationResources = CreateUnique<GenerationResources>();
+
 		// This will store the flat equirectangular image which will only be used to create the necessary cubemaps for IBL
 		Ref<Image> equirectangularImage;
+		Ref<Buffer> stagingBuffer;
 		{
 			// Create a Vulkan Image based on the pixel data we loaded using stbi_image
 			ImageSpecification imageSpec;
@@ -70,20 +73,13 @@ namespace Flameberry {
 			stagingBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 			stagingBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-			// Creation of the actual staging buffer
-			Buffer stagingBuffer(stagingBufferSpec);
+			// Creation of the actual staging buffer, the copy to the image is recorded along with the rest of the generation
+			stagingBuffer = CreateRef<Buffer>(stagingBufferSpec);
 
 			// Transfer of the pixel data from CPU to the staging buffer
-			stagingBuffer.MapMemory(imageSize);
-			stagingBuffer.WriteToBuffer(pixels, imageSize, 0);
-			stagingBuffer.UnmapMemory();
-
-			// Before transferring it is important to ensure that the imageLayout is set to be the destination
-			equirectangularImage->TransitionLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-			// Copy the pixel data from the staging buffer to the actual image in GPU
-			equirectangularImage->WriteFromBuffer(stagingBuffer.GetVulkanBuffer());
-			// After transferring it is important to ensure that the imageLayout is correct to make the image ready for use
-			equirectangularImage->TransitionLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			stagingBuffer->MapMemory(imageSize);
+			stagingBuffer->WriteToBuffer(pixels, imageSize, 0);
+			stagingBuffer->UnmapMemory();
 		}
 
 		// Calculate the number of mip levels based upon the image dimensions
@@ -139,7 +135,8 @@ namespace Flameberry {
 		}
 
 		// The image views for accessing each mip in the compute shader
-		std::vector<VkImageView> prefilteredMipMapImageViews(mipLevels);
+		std::vector<VkImageView>& prefilteredMipMapImageViews = m_GenerationResources->PrefilteredMipMapImageViews;
+		prefilteredMipMapImageViews.resize(mipLevels);
 		{
 			// Creation of the Prefiltered Map
 			// This process is almost the same as the creation of the m_CubemapImage
@@ -380,20 +377,19 @@ namespace Flameberry {
 			descSetBRDFLUT->Update();
 		}
 
-		// The command buffer to run the whole process --------------------------------------------------------------------------------
-		CommandBufferSpecification cmdBufferSpecification;
-		cmdBufferSpecification.CommandPool = VulkanContext::GetCurrentDevice()->GetComputeCommandPool();
-		cmdBufferSpecification.SingleTimeUsage = true;
-		cmdBufferSpecification.IsPrimary = true;
-
-		// Creation of the command buffer
-		CommandBuffer cmdBuffer(cmdBufferSpecification);
+		// The command buffer to run the whole process, which is submitted without waiting for it ------------------------------------
+		const auto& vulkanDevice = VulkanContext::GetCurrentDevice();
+		auto vulkanCmdBuffer = vulkanDevice->BeginOneShotCommandBuffer(true);
 
-		// Recording the Command Buffer
-		cmdBuffer.Begin();
+		// Step 0: Upload of the equirectangular image
+		// Before transferring it is important to ensure that the imageLayout is set to be the destination
+		equirectangularImage->CmdTransitionLayout(vulkanCmdBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		// Copy the pixel data from the staging buffer to the actual image in GPU
+		equirectangularImage->CmdWriteFromBuffer(vulkanCmdBuffer, stagingBuffer->GetVulkanBuffer());
+		// After transferring it is important to ensure that the imageLayout is correct to make the image ready for use
+		equirectangularImage->CmdTransitionLayout(vulkanCmdBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 		// Step 1: Generation of the cube map using the equirectangular image
-		auto vulkanCmdBuffer = cmdBuffer.GetVulkanCommandBuffer();
 		auto vulkanComputePipelineLayout = cubemapGenerationPipeline->GetVulkanPipelineLayout();
 		auto vulkanComputePipeline = cubemapGenerationPipeline->GetVulkanPipeline();
 		auto vulkanDescSet = cubemapGenerationDescriptorSet->GetVulkanDescriptorSet();
@@ -466,16 +462,14 @@ namespace Flameberry {
 			m_BRDFLUTMap->CmdTransitionLayout(vulkanCmdBuffer, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 		}
 
-		// End the command buffer recording
-		cmdBuffer.End();
-
-		// Submit the command buffer
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &vulkanCmdBuffer;
+		// End and submit the command buffer, the skymap is not used by the renderer until it completes
+		m_GenerationResources->Submission = vulkanDevice->SubmitOneShot(vulkanCmdBuffer, true);
 
-		VK_CHECK_RESULT(vkQueueSubmit(VulkanContext::GetCurrentDevice()->GetComputeQueue(), 1, &submitInfo, VK_NULL_HANDLE));
+		m_GenerationResources->StagingBuffer = stagingBuffer;
+		m_GenerationResources->EquirectangularImage = equirectangularImage;
+		m_GenerationResources->Pipelines = { cubemapGenerationPipeline, irrandianceMapGenerationPipeline, prefilteredMapGenerationPipeline, pipelineBRDFLUT };
+		m_GenerationResources->DescriptorSets = { cubemapGenerationDescriptorSet, irradianceMapGenerationDescriptorSet, descSetBRDFLUT };
+		m_GenerationResources->DescriptorSets.insert(m_GenerationResources->DescriptorSets.end(), prefilteredMapGenerationDescriptorSets.begin(), prefilteredMapGenerationDescriptorSets.end());
 
 		// Now that all the processing is done, we need to bring all the skymap resources into a descriptor set to be used later by the PBR pipeline
 		std::vector<VkDescriptorSetLayoutBinding> descBindings = {
@@ -536,24 +530,42 @@ namespace Flameberry {
 		m_SkymapDescriptorSet->WriteImage(2, prefilteredMapImageInfo);
 		m_SkymapDescriptorSet->WriteImage(3, brdflutMapImageInfo);
 		m_SkymapDescriptorSet->Update();
+	}
 
-		// TODO: Remove this in the future
-		VulkanContext::GetCurrentDevice()->WaitIdleComputeQueue();
-		VulkanContext::GetCurrentDevice()->WaitIdleGraphicsQueue();
-		VulkanContext::GetCurrentDevice()->WaitIdle();
+	Skymap::~Skymap()
+	{
+		if (m_GenerationResources)
+		{
+			VulkanContext::GetCurrentDevice()->Wait(m_GenerationResources->Submission);
+			ReleaseGenerationResources();
+		}
 
 		const auto device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+		vkDestroySampler(device, m_BRDFLUTSampler, nullptr);
+		vkDestroySampler(device, m_MultiLODSampler, nullptr);
+	}
 
-		// Destroy temporary resources
-		for (const auto& imageView : prefilteredMipMapImageViews)
-			vkDestroyImageView(device, imageView, nullptr);
+	bool Skymap::IsReady()
+	{
+		if (!m_GenerationResources)
+			return true;
+
+		if (!VulkanContext::GetCurrentDevice()->IsComplete(m_GenerationResources->Submission))
+			return false;
+
+		ReleaseGenerationResources();
+		return true;
 	}
 
-	Skymap::~Skymap()
+	void Skymap::ReleaseGenerationResources()
 	{
 		const auto device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
-		vkDestroySampler(device, m_BRDFLUTSampler, nullptr);
-		vkDestroySampler(device, m_MultiLODSampler, nullptr);
+
+		// Destroy temporary resources
+		for (const auto& imageView : m_GenerationResources->PrefilteredMipMapImageViews)
+			vkDestroyImageView(device, imageView, nullptr);
+
+		m_GenerationResources = nullptr;
 	}
 
 	void Skymap::Init()
@@ -4,7 +4,10 @@
 
 #include "Asset/Asset.h"
 #include "Renderer/Image.h"
+#include "Renderer/Buffer.h"
+#include "Renderer/Pipeline.h"
 #include "Renderer/DescriptorSet.h"
+#include "Renderer/VulkanDevice.h"
 
 namespace Flameberry {
 
@@ -15,6 +18,8 @@ namespace Flameberry {
 		~Skymap();
 
 		Ref<DescriptorSet> GetDescriptorSet() { return m_SkymapDescriptorSet; }
+		// The cubemaps are generated asynchronously on the compute queue, the skymap is to be used only once this returns true
+		bool IsReady();
 
 		static void Init();
 		static void Destroy();
@@ -22,6 +27,20 @@ namespace Flameberry {
 
 		FBY_DECLARE_ASSET_TYPE(AssetType::Skymap);
 
+	private:
+		// The temporary resources of the generation, which are released once the generation completes
+		struct GenerationResources
+		{
+			OneShotSubmission Submission;
+			Ref<Buffer> StagingBuffer;
+			Ref<Image> EquirectangularImage;
+			std::vector<Ref<ComputePipeline>> Pipelines;
+			std::vector<Ref<DescriptorSet>> DescriptorSets;
+			std::vector<VkImageView> PrefilteredMipMapImageViews;
+		};
+
+		void ReleaseGenerationResources();
+
 	private:
 		Ref<Image> m_CubemapImage, m_IrradianceMap, m_PrefilteredMap, m_BRDFLUTMap;
 
@@ -32,6 +51,8 @@ namespace Flameberry {
 		// The sampler that is essential for BDRFLUT pipeline, to ensure no weird artefacts
 		VkSampler m_BRDFLUTSampler;
 
+		Unique<GenerationResources> m_GenerationResources;
+
 		static Ref<DescriptorSet> s_EmptyDescriptorSet;
 		static Ref<Image> s_EmptyCubemap;
 
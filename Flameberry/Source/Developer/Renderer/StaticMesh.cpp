@@ -10,13 +10,21 @@
 
 namespace Flameberry {
 
-	StaticMesh::StaticMesh(const Ref<Buffer>& vertexBuffer, const Ref<Buffer>& indexBuffer, const std::vector<SubMesh>& submeshes)
-		: m_VertexBuffer(vertexBuffer), m_IndexBuffer(indexBuffer), m_SubMeshes(std::move(submeshes))
+	StaticMesh::StaticMesh(const GeometryAllocation& geometry, const std::vector<SubMesh>& submeshes)
+		: m_Geometry(geometry), m_SubMeshes(std::move(submeshes))
 	{
 	}
 
 	StaticMesh::~StaticMesh()
 	{
+		GeometryArena::Free(m_Geometry);
+	}
+
+	void StaticMesh::SetOccluderGeometry(std::vector<glm::vec3>&& positions, std::vector<uint32_t>&& indices)
+	{
+		m_OccluderPositions = std::move(positions);
+		m_OccluderIndices = std::move(indices);
+		m_IsOccluderGeometryReady.store(true, std::memory_order_release);
 	}
 
 } // namespace Flameberry
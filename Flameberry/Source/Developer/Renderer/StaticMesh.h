@@ -2,8 +2,12 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
+#include <filesystem>
 
-#include "Buffer.h"
+#include <glm/glm.hpp>
+
+#include "GeometryArena.h"
 #include "Asset/Asset.h"
 #include "AABB.h"
 
@@ -12,6 +16,7 @@ namespace Flameberry {
 	struct SubMesh
 	{
 		AssetHandle MaterialHandle = 0;
+		// Relative to the first index of the mesh in the geometry arena
 		uint32_t IndexOffset, IndexCount;
 		AABB AABB;
 	};
@@ -21,22 +26,44 @@ namespace Flameberry {
 	class StaticMesh : public Asset
 	{
 	public:
-		StaticMesh(const Ref<Buffer>& vertexBuffer, const Ref<Buffer>& indexBuffer, const std::vector<SubMesh>& submeshes);
+		// The geometry is owned by the mesh and is returned to the geometry arena when the mesh is destroyed
+		StaticMesh(const GeometryAllocation& geometry, const std::vector<SubMesh>& submeshes);
 		~StaticMesh();
 
 		inline void SetName(const std::string& name) { m_Name = name; }
 		std::string GetName() const { return m_Name; }
+		// The file the mesh was imported from
+		void SetFilePath(const std::filesystem::path& filePath) { m_FilePath = filePath; }
+		const std::filesystem::path& GetFilePath() const { return m_FilePath; }
 		const std::vector<SubMesh>& GetSubMeshes() const { return m_SubMeshes; }
-		const Ref<Buffer>& GetVertexBuffer() const { return m_VertexBuffer; }
-		const Ref<Buffer>& GetIndexBuffer() const { return m_IndexBuffer; }
+		const GeometryAllocation& GetGeometry() const { return m_Geometry; }
+		// The buffers of the geometry block shared with the other meshes, the submeshes are drawn using `GetVertexOffset()` and `GetFirstIndex()`
+		VkBuffer GetVertexBuffer() const { return GeometryArena::GetVertexBuffer(m_Geometry.BlockIndex); }
+		VkBuffer GetIndexBuffer() const { return GeometryArena::GetIndexBuffer(m_Geometry.BlockIndex); }
+		int32_t GetVertexOffset() const { return (int32_t)m_Geometry.VertexOffset; }
+		uint32_t GetFirstIndex() const { return m_Geometry.FirstIndex; }
+
+		// The vertex positions and the indices are kept on the CPU only for the meshes used as occluders, so that they can be rasterized into the occlusion buffer
+		// They are loaded on a worker thread when they are requested for the first time, this returns true only for the first request
+		bool RequestOccluderGeometry() { return !m_IsOccluderGeometryRequested.exchange(true); }
+		bool IsOccluderGeometryReady() const { return m_IsOccluderGeometryReady.load(std::memory_order_acquire); }
+		// To be called once, the geometry is not to be accessed before `IsOccluderGeometryReady()` returns true
+		void SetOccluderGeometry(std::vector<glm::vec3>&& positions, std::vector<uint32_t>&& indices);
+		const std::vector<glm::vec3>& GetOccluderPositions() const { return m_OccluderPositions; }
+		const std::vector<uint32_t>& GetOccluderIndices() const { return m_OccluderIndices; }
 
 		FBY_DECLARE_ASSET_TYPE(AssetType::StaticMesh);
 
 	private:
-		Ref<Buffer> m_VertexBuffer, m_IndexBuffer;
+		GeometryAllocation m_Geometry;
 		std::vector<SubMesh> m_SubMeshes;
 
+		std::vector<glm::vec3> m_OccluderPositions;
+		std::vector<uint32_t> m_OccluderIndices;
+		std::atomic<bool> m_IsOccluderGeometryRequested{ false }, m_IsOccluderGeometryReady{ false };
+
 		std::string m_Name = "StaticMesh";
+		std::filesystem::path m_FilePath;
 		friend class SceneSerializer;
 	};
 
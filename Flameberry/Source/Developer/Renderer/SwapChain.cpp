@@ -76,6 +76,12 @@ namespace Flameberry {
 		vkGetSwapchainImagesKHR(device, m_VkSwapChain, &m_ImageCount, m_VkSwapChainImages.data());
 	}
 
+	void SwapChain::WaitForFrame(uint32_t frameIndex) const
+	{
+		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+		vkWaitForFences(device, 1, &m_InFlightFences[frameIndex], VK_TRUE, UINT64_MAX);
+	}
+
 	VkResult SwapChain::AcquireNextImage()
 	{
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
@@ -113,6 +119,9 @@ namespace Flameberry {
 
 		vkResetFences(device, 1, &m_InFlightFences[m_CurrentFrameIndex]);
 
+		// The queues can be used by the main thread too, for e.g. for single time commands
+		std::scoped_lock<std::mutex> lock(VulkanContext::GetCurrentDevice()->GetQueueMutex());
+
 		VK_CHECK_RESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, m_InFlightFences[m_CurrentFrameIndex]));
 
 		VkSwapchainKHR swapchains[] = { m_VkSwapChain };
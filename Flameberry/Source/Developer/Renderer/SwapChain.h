@@ -16,12 +16,15 @@ namespace Flameberry {
 
 		VkExtent2D GetExtent2D() const { return m_VkSwapChainExtent2D; }
 		uint32_t GetAcquiredImageIndex() const { return m_ImageIndex; }
+		uint32_t GetCurrentFrameIndex() const { return m_CurrentFrameIndex; }
 		uint32_t GetSwapChainImageCount() const { return (uint32_t)m_VkSwapChainImages.size(); }
 		VkFormat GetSwapChainImageFormat() const { return m_VkSwapChainImageFormat; }
 		VkSwapchainKHR GetVulkanSwapChain() const { return m_VkSwapChain; }
 		std::vector<VkImageView> GetImageViews() const { return m_VkSwapChainImageViews; }
 		std::vector<VkImage> GetImages() const { return m_VkSwapChainImages; }
 
+		// Blocks until the GPU has finished the last frame submitted with the given frame index
+		void WaitForFrame(uint32_t frameIndex) const;
 		VkResult AcquireNextImage();
 		VkResult SubmitCommandBuffer(VkCommandBuffer commandBuffer);
 		void Invalidate();
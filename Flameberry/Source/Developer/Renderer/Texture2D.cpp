@@ -6,6 +6,7 @@
 #include "Buffer.h"
 
 #include "VulkanContext.h"
+#include "TextureTable.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
@@ -89,25 +90,8 @@ namespace Flameberry {
 
 		m_TextureImage = CreateRef<Image>(m_TextureImageSpecification);
 
-		BufferSpecification stagingBufferSpec;
-		stagingBufferSpec.InstanceCount = 1;
-		stagingBufferSpec.InstanceSize = imageSize;
-		stagingBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		stagingBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-		Buffer stagingBuffer(stagingBufferSpec);
-
-		stagingBuffer.MapMemory(imageSize);
-		stagingBuffer.WriteToBuffer(data, imageSize, 0);
-		stagingBuffer.UnmapMemory();
-
-		m_TextureImage->TransitionLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		m_TextureImage->WriteFromBuffer(stagingBuffer.GetVulkanBuffer());
-
-		if (m_TextureImageSpecification.MipLevels > 1)
-			m_TextureImage->GenerateMipmaps(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		else
-			m_TextureImage->TransitionLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// The copy, the mipmap generation and the layout transitions are recorded into the upload batch of this frame
+		m_UploadToken = UploadManager::UploadToImage(m_TextureImage, data, imageSize, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 		if (sampler == VK_NULL_HANDLE)
 		{
@@ -139,13 +123,17 @@ namespace Flameberry {
 		}
 		else
 			m_Sampler = sampler;
+
+		m_TextureTableIndex = TextureTable::Register(m_TextureImage->GetVulkanImageView(), m_Sampler);
 	}
 
 	Texture2D::~Texture2D()
 	{
+		TextureTable::Unregister(m_TextureTableIndex);
+
 		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
 		if (m_DescriptorSet != VK_NULL_HANDLE)
-			vkFreeDescriptorSets(device, VulkanContext::GetCurrentGlobalDescriptorPool()->GetVulkanDescriptorPool(), 1, &m_DescriptorSet);
+			vkFreeDescriptorSets(device, m_DescriptorPool->GetVulkanDescriptorPool(), 1, &m_DescriptorSet);
 		if (m_DidCreateSampler)
 			vkDestroySampler(device, m_Sampler, nullptr);
 	}
@@ -154,7 +142,7 @@ namespace Flameberry {
 	{
 		if (m_DescriptorSet == VK_NULL_HANDLE)
 		{
-			VulkanContext::GetCurrentGlobalDescriptorPool()->AllocateDescriptorSet(&m_DescriptorSet, s_DescriptorLayout->GetLayout());
+			m_DescriptorPool = VulkanContext::GetCurrentGlobalDescriptorAllocator()->Allocate(s_DescriptorLayout, &m_DescriptorSet);
 
 			// Update the Descriptor Set:
 			VkDescriptorImageInfo desc_image[1] = {};
@@ -211,8 +199,8 @@ namespace Flameberry {
 		{
 			const auto& device = VulkanContext::GetCurrentDevice();
 
-			VkCommandBuffer commandBuffer;
-			device->BeginSingleTimeCommandBuffer(commandBuffer);
+			// The transition is not waited for, the frames are submitted after it to the same queue and the barrier orders their fragment shaders after it
+			VkCommandBuffer commandBuffer = device->BeginOneShotCommandBuffer();
 
 			VkPipelineStageFlags sourceStageFlags;
 			VkPipelineStageFlags destinationStageFlags;
@@ -237,7 +225,7 @@ namespace Flameberry {
 
 			vkCmdPipelineBarrier(commandBuffer, sourceStageFlags, destinationStageFlags, 0, 0, nullptr, 0, nullptr, 1, &vk_image_memory_barrier);
 
-			device->EndSingleTimeCommandBuffer(commandBuffer);
+			device->SubmitOneShot(commandBuffer);
 		}
 
 		// Create Sampler
@@ -8,6 +8,7 @@
 #include "Core/UUID.h"
 
 #include "Image.h"
+#include "UploadManager.h"
 #include "DescriptorSet.h"
 #include "Asset/Asset.h"
 
@@ -32,6 +33,10 @@ namespace Flameberry {
 		VkImageView GetImageView() const { return m_TextureImage->GetVulkanImageView(); }
 		VkSampler GetSampler() const { return m_Sampler; }
 		ImageSpecification GetImageSpecification() const { return m_TextureImageSpecification; }
+		// The texture can be used by the frames submitted after it's creation, the token tells when it's pixels are actually on the GPU
+		UploadToken GetUploadToken() const { return m_UploadToken; }
+		// The index of the texture in the bindless `TextureTable`, which stays the same for the lifetime of the texture
+		uint32_t GetTextureTableIndex() const { return m_TextureTableIndex; }
 
 		FBY_DECLARE_ASSET_TYPE(AssetType::Texture2D);
 
@@ -58,6 +63,10 @@ namespace Flameberry {
 		Ref<Image> m_TextureImage;
 		VkSampler m_Sampler{};
 		VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+		// The pool of the global descriptor allocator which the set is allocated from
+		Ref<DescriptorPool> m_DescriptorPool;
+		UploadToken m_UploadToken;
+		uint32_t m_TextureTableIndex;
 
 		bool m_DidCreateSampler = false;
 
@@ -0,0 +1,131 @@
+#include "TextureTable.h"
+
+#include <algorithm>
+
+#include "VulkanContext.h"
+#include "Texture2D.h"
+
+namespace Flameberry {
+
+	Ref<DescriptorPool> TextureTable::s_DescriptorPool;
+	Ref<DescriptorSetLayout> TextureTable::s_DescriptorSetLayout;
+	Ref<DescriptorSet> TextureTable::s_DescriptorSet;
+
+	uint32_t TextureTable::s_Capacity = 0, TextureTable::s_SlotCount = 0;
+	std::vector<uint32_t> TextureTable::s_FreeSlots;
+	std::vector<uint32_t> TextureTable::s_FreedSlots[SwapChain::MAX_FRAMES_IN_FLIGHT];
+	uint32_t TextureTable::s_FrameIndex = 0;
+	std::mutex TextureTable::s_Mutex;
+
+	void TextureTable::Init()
+	{
+		const auto device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+
+		VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+		vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &vulkan12Properties;
+		vkGetPhysicalDeviceProperties2(VulkanContext::GetPhysicalDevice(), &properties2);
+
+		s_Capacity = std::min({ MaxTextureCount, vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+		// The slots which are not written are never accessed by the shaders, and the textures are written while the table is bound by the frames in flight
+		DescriptorSetLayoutSpecification layoutSpec;
+		layoutSpec.Bindings.emplace_back(VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, s_Capacity, VK_SHADER_STAGE_ALL_GRAPHICS, nullptr });
+		layoutSpec.Flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutSpec.BindingFlags = { VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT };
+
+		s_DescriptorSetLayout = DescriptorSetLayout::CreateOrGetCached(layoutSpec);
+
+		const std::vector<VkDescriptorPoolSize> poolSizes = { { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, s_Capacity } };
+		s_DescriptorPool = CreateRef<DescriptorPool>(device, poolSizes, 1, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT | VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+
+		DescriptorSetSpecification descSetSpec;
+		descSetSpec.Pool = s_DescriptorPool;
+		descSetSpec.Layout = s_DescriptorSetLayout;
+		s_DescriptorSet = CreateRef<DescriptorSet>(descSetSpec);
+
+		const uint32_t emptyTextureIndex = Register(Texture2D::GetEmptyImageView(), Texture2D::GetDefaultSampler());
+		FBY_ASSERT(emptyTextureIndex == EmptyTextureIndex, "The empty texture must be the first texture registered in the texture table");
+
+		FBY_INFO("Created texture table with a capacity of {} textures", s_Capacity);
+	}
+
+	void TextureTable::Shutdown()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		s_DescriptorSet = nullptr;
+		s_DescriptorPool = nullptr;
+		s_DescriptorSetLayout = nullptr;
+
+		s_SlotCount = 0;
+		s_FreeSlots.clear();
+		for (auto& freedSlots : s_FreedSlots)
+			freedSlots.clear();
+	}
+
+	uint32_t TextureTable::Register(VkImageView imageView, VkSampler sampler)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		uint32_t index;
+		if (s_FreeSlots.size())
+		{
+			index = s_FreeSlots.back();
+			s_FreeSlots.pop_back();
+		}
+		else if (s_SlotCount < s_Capacity)
+			index = s_SlotCount++;
+		else
+		{
+			FBY_ERROR("Texture table capacity of {} textures exceeded, the texture will be replaced by the empty texture", s_Capacity);
+			return EmptyTextureIndex;
+		}
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageView = imageView;
+		imageInfo.sampler = sampler;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		s_DescriptorSet->WriteImage(0, imageInfo, index);
+		s_DescriptorSet->Update();
+		return index;
+	}
+
+	void TextureTable::Unregister(uint32_t index)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		// The textures outliving the renderer don't have to give their slots back
+		if (!s_DescriptorSet || index == EmptyTextureIndex)
+			return;
+
+		s_FreedSlots[s_FrameIndex].push_back(index);
+	}
+
+	void TextureTable::ReleaseFreedSlots()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		// The oldest frame's slots are no longer sampled by any frame in flight
+		s_FrameIndex = (s_FrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+
+		s_FreeSlots.insert(s_FreeSlots.end(), s_FreedSlots[s_FrameIndex].begin(), s_FreedSlots[s_FrameIndex].end());
+		s_FreedSlots[s_FrameIndex].clear();
+	}
+
+	uint32_t TextureTable::GetTextureCount()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		uint32_t freedSlotCount = 0;
+		for (const auto& freedSlots : s_FreedSlots)
+			freedSlotCount += (uint32_t)freedSlots.size();
+		return s_SlotCount - (uint32_t)s_FreeSlots.size() - freedSlotCount;
+	}
+
+} // namespace Flameberry
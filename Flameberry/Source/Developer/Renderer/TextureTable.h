@@ -0,0 +1,56 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Core/Core.h"
+#include "DescriptorSet.h"
+#include "SwapChain.h"
+
+namespace Flameberry {
+
+	// A single descriptor set holding an array of all the textures, indexed by the shaders using the indices passed in the material data
+	// Every texture is written into the table once when it is created and keeps it's index for it's lifetime
+	// Hence a pass binds the table once instead of binding the descriptor sets of every material
+	// The shaders declare the table as an unsized `sampler2D` array, which the shader reflection maps to the layout of the table
+	class TextureTable
+	{
+	public:
+		// The index of the empty texture, which is used for the unassigned texture maps
+		static constexpr uint32_t EmptyTextureIndex = 0;
+		// Clamped to the descriptor indexing limits of the device
+		static constexpr uint32_t MaxTextureCount = 4096;
+
+	public:
+		// To be called after `Texture2D::InitStaticResources()` as the empty texture is registered at `EmptyTextureIndex`
+		static void Init();
+		static void Shutdown();
+
+		// Writes the texture into a free slot of the table and returns the index of the slot
+		static uint32_t Register(VkImageView imageView, VkSampler sampler);
+		// The slot is reused only after the frames in flight which might be sampling it are complete
+		static void Unregister(uint32_t index);
+		// Releases the slots unregistered `MAX_FRAMES_IN_FLIGHT` frames ago, to be called once per frame while the render thread is idle
+		static void ReleaseFreedSlots();
+
+		static Ref<DescriptorSetLayout> GetDescriptorSetLayout() { return s_DescriptorSetLayout; }
+		static VkDescriptorSet GetDescriptorSet() { return s_DescriptorSet->GetVulkanDescriptorSet(); }
+		static uint32_t GetCapacity() { return s_Capacity; }
+		static uint32_t GetTextureCount();
+
+	private:
+		static Ref<DescriptorPool> s_DescriptorPool;
+		static Ref<DescriptorSetLayout> s_DescriptorSetLayout;
+		static Ref<DescriptorSet> s_DescriptorSet;
+
+		static uint32_t s_Capacity, s_SlotCount;
+		static std::vector<uint32_t> s_FreeSlots;
+		// The slots unregistered during each of the last frames, indexed by the frame
+		static std::vector<uint32_t> s_FreedSlots[SwapChain::MAX_FRAMES_IN_FLIGHT];
+		static uint32_t s_FrameIndex;
+		// The textures can be destroyed by the render thread when it releases the last reference to them
+		static std::mutex s_Mutex;
+	};
+
+} // namespace Flameberry
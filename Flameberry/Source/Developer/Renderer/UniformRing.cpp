@@ -0,0 +1,69 @@
+#include "UniformRing.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "VulkanContext.h"
+
+namespace Flameberry {
+
+	std::array<Unique<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> UniformRing::s_Buffers;
+	uint32_t UniformRing::s_FrameIndex = 0;
+	VkDeviceSize UniformRing::s_Offset = 0, UniformRing::s_MinAlignment = 0;
+
+	void UniformRing::Init()
+	{
+		const VkPhysicalDeviceProperties properties = VulkanContext::GetPhysicalDeviceProperties();
+		s_MinAlignment = std::max(properties.limits.minUniformBufferOffsetAlignment, properties.limits.minStorageBufferOffsetAlignment);
+
+		BufferSpecification ringBufferSpec;
+		ringBufferSpec.InstanceCount = 1;
+		ringBufferSpec.InstanceSize = FrameCapacity;
+		ringBufferSpec.Usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		ringBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		for (auto& buffer : s_Buffers)
+		{
+			buffer = CreateUnique<Buffer>(ringBufferSpec);
+			buffer->MapMemory(FrameCapacity);
+		}
+
+		BeginFrame(0);
+	}
+
+	void UniformRing::Shutdown()
+	{
+		for (auto& buffer : s_Buffers)
+			buffer = nullptr;
+	}
+
+	void UniformRing::BeginFrame(uint32_t frameIndex)
+	{
+		s_FrameIndex = frameIndex;
+		s_Offset = 0;
+	}
+
+	UniformRingAllocation UniformRing::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		// The offset alignments of the device are powers of 2
+		alignment = std::max(alignment, s_MinAlignment);
+		const VkDeviceSize offset = (s_Offset + alignment - 1) & ~(alignment - 1);
+
+		FBY_ASSERT(offset + size <= FrameCapacity, "Uniform ring capacity of {} bytes exceeded while allocating {} bytes", FrameCapacity, size);
+
+		s_Offset = offset + size;
+
+		UniformRingAllocation allocation;
+		allocation.Data = (uint8_t*)s_Buffers[s_FrameIndex]->GetMappedMemory() + offset;
+		allocation.DynamicOffset = (uint32_t)offset;
+		return allocation;
+	}
+
+	uint32_t UniformRing::Write(const void* data, VkDeviceSize size)
+	{
+		UniformRingAllocation allocation = Allocate(size);
+		memcpy(allocation.Data, data, size);
+		return allocation.DynamicOffset;
+	}
+
+} // namespace Flameberry
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <vulkan/vulkan.h>
+
+#include "Core/Core.h"
+#include "Buffer.h"
+#include "SwapChain.h"
+
+namespace Flameberry {
+
+	struct UniformRingAllocation
+	{
+		// Points into the persistently mapped ring buffer of the current frame
+		void* Data = nullptr;
+		// To be passed to `vkCmdBindDescriptorSets()` for the dynamic uniform/storage buffer descriptor referring to the ring buffer
+		uint32_t DynamicOffset = 0;
+	};
+
+	// A persistently mapped uniform/storage buffer per frame in flight, the per frame data is linearly allocated from it and bound using dynamic offsets
+	// The descriptor sets refer to the ring buffer of their frame once, hence the data can be written any number of times per frame without rewriting the descriptors
+	// Allocated only by the main thread while the frame is being recorded, the ring of the frame is reset at the beginning of the frame
+	class UniformRing
+	{
+	public:
+		static constexpr VkDeviceSize FrameCapacity = 4 * 1024 * 1024;
+
+	public:
+		static void Init();
+		static void Shutdown();
+
+		// Called once the main thread starts recording the frame with the given index
+		static void BeginFrame(uint32_t frameIndex);
+
+		// The alignment is raised to the minimum uniform/storage buffer offset alignment of the device
+		static UniformRingAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+		// Copies the data into the ring and returns it's dynamic offset
+		static uint32_t Write(const void* data, VkDeviceSize size);
+
+		static VkBuffer GetBuffer(uint32_t frameIndex) { return s_Buffers[frameIndex]->GetVulkanBuffer(); }
+		// The size allocated during the current frame
+		static VkDeviceSize GetUsedSize() { return s_Offset; }
+
+	private:
+		static std::array<Unique<Buffer>, SwapChain::MAX_FRAMES_IN_FLIGHT> s_Buffers;
+		static uint32_t s_FrameIndex;
+		static VkDeviceSize s_Offset, s_MinAlignment;
+	};
+
+} // namespace Flameberry
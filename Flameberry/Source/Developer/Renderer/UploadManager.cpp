@@ -0,0 +1,343 @@
+#include "UploadManager.h"
+
+#include "VulkanDebug.h"
+#include "VulkanContext.h"
+
+namespace Flameberry {
+
+	Unique<Buffer> UploadManager::s_StagingRing;
+	VkDeviceSize UploadManager::s_RingHead = 0, UploadManager::s_RingTail = 0, UploadManager::s_RingUsedSize = 0;
+
+	VkCommandPool UploadManager::s_CommandPool = VK_NULL_HANDLE;
+	std::vector<VkCommandBuffer> UploadManager::s_FreeCommandBuffers;
+	VkSemaphore UploadManager::s_TimelineSemaphore = VK_NULL_HANDLE;
+	uint64_t UploadManager::s_NextTimelineValue = 1;
+
+	UploadManager::UploadBatch UploadManager::s_PendingBatch;
+	std::deque<UploadManager::UploadBatch> UploadManager::s_SubmittedBatches;
+
+	std::mutex UploadManager::s_Mutex;
+
+	void UploadManager::Init()
+	{
+		const auto& device = VulkanContext::GetCurrentDevice();
+
+		BufferSpecification stagingRingSpec;
+		stagingRingSpec.InstanceCount = 1;
+		stagingRingSpec.InstanceSize = StagingRingSize;
+		stagingRingSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		stagingRingSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+		s_StagingRing = CreateUnique<Buffer>(stagingRingSpec);
+		s_StagingRing->MapMemory(StagingRingSize);
+
+		// The device command pools are used by the single time commands of the other threads, hence the uploads have their own
+		VkCommandPoolCreateInfo commandPoolCreateInfo{};
+		commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolCreateInfo.queueFamilyIndex = device->GetQueueFamilyIndices().GraphicsQueueFamilyIndex;
+		commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		VK_CHECK_RESULT(vkCreateCommandPool(device->GetVulkanDevice(), &commandPoolCreateInfo, nullptr, &s_CommandPool));
+
+		VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{};
+		semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		semaphoreTypeCreateInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo{};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+		VK_CHECK_RESULT(vkCreateSemaphore(device->GetVulkanDevice(), &semaphoreCreateInfo, nullptr, &s_TimelineSemaphore));
+	}
+
+	void UploadManager::Shutdown()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(s_Mutex);
+			SubmitPendingBatch();
+			while (!s_SubmittedBatches.empty())
+				ReleaseCompletedBatches(true);
+		}
+
+		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+		vkDestroySemaphore(device, s_TimelineSemaphore, nullptr);
+		vkDestroyCommandPool(device, s_CommandPool, nullptr);
+
+		s_FreeCommandBuffers.clear();
+		s_StagingRing = nullptr;
+	}
+
+	UploadToken UploadManager::UploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		VkBuffer stagingBuffer = s_StagingRing->GetVulkanBuffer();
+		VkDeviceSize stagingOffset = 0;
+
+		if (size > StagingRingSize)
+		{
+			BufferSpecification stagingBufferSpec;
+			stagingBufferSpec.InstanceCount = 1;
+			stagingBufferSpec.InstanceSize = size;
+			stagingBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			stagingBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+			auto& temporaryBuffer = s_PendingBatch.TemporaryStagingBuffers.emplace_back(CreateUnique<Buffer>(stagingBufferSpec));
+			temporaryBuffer->MapMemory(size);
+			temporaryBuffer->WriteToBuffer(data, size, 0);
+			stagingBuffer = temporaryBuffer->GetVulkanBuffer();
+		}
+		else
+		{
+			stagingOffset = AllocateStagingMemory(size, 16);
+			s_StagingRing->WriteToBuffer(data, size, stagingOffset);
+		}
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = stagingOffset;
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = size;
+
+		vkCmdCopyBuffer(GetPendingCommandBuffer(), stagingBuffer, dstBuffer, 1, &copyRegion);
+		return UploadToken{ s_NextTimelineValue };
+	}
+
+	UploadToken UploadManager::UploadToImage(const Ref<Image>& image, const void* data, VkDeviceSize size, VkImageLayout finalLayout)
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+
+		VkBuffer stagingBuffer = s_StagingRing->GetVulkanBuffer();
+		VkDeviceSize stagingOffset = 0;
+
+		if (size > StagingRingSize)
+		{
+			BufferSpecification stagingBufferSpec;
+			stagingBufferSpec.InstanceCount = 1;
+			stagingBufferSpec.InstanceSize = size;
+			stagingBufferSpec.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			stagingBufferSpec.MemoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+			auto& temporaryBuffer = s_PendingBatch.TemporaryStagingBuffers.emplace_back(CreateUnique<Buffer>(stagingBufferSpec));
+			temporaryBuffer->MapMemory(size);
+			temporaryBuffer->WriteToBuffer(data, size, 0);
+			stagingBuffer = temporaryBuffer->GetVulkanBuffer();
+		}
+		else
+		{
+			// The buffer offset of a buffer to image copy needs to be a multiple of 4 and the texel size, which 16 is for the formats used by the textures
+			stagingOffset = AllocateStagingMemory(size, 16);
+			s_StagingRing->WriteToBuffer(data, size, stagingOffset);
+		}
+
+		VkCommandBuffer cmdBuffer = GetPendingCommandBuffer();
+
+		image->CmdTransitionLayout(cmdBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		image->CmdWriteFromBuffer(cmdBuffer, stagingBuffer, stagingOffset);
+
+		if (image->GetSpecification().MipLevels > 1)
+			image->CmdGenerateMipmaps(cmdBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout);
+		else
+			image->CmdTransitionLayout(cmdBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout);
+
+		s_PendingBatch.Images.emplace_back(image);
+		return UploadToken{ s_NextTimelineValue };
+	}
+
+	void UploadManager::SubmitPendingUploads()
+	{
+		std::scoped_lock<std::mutex> lock(s_Mutex);
+		SubmitPendingBatch();
+		ReleaseCompletedBatches(false);
+	}
+
+	bool UploadManager::IsComplete(UploadToken token)
+	{
+		uint64_t completedValue = 0;
+		VK_CHECK_RESULT(vkGetSemaphoreCounterValue(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), s_TimelineSemaphore, &completedValue));
+		return completedValue >= token.Value;
+	}
+
+	void UploadManager::Wait(UploadToken token)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(s_Mutex);
+			if (token.Value == s_NextTimelineValue)
+				SubmitPendingBatch();
+		}
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &s_TimelineSemaphore;
+		waitInfo.pValues = &token.Value;
+
+		VK_CHECK_RESULT(vkWaitSemaphores(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), &waitInfo, UINT64_MAX));
+	}
+
+	VkDeviceSize UploadManager::AllocateStagingMemory(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		VkDeviceSize offset;
+		while (!TryAllocateStagingMemory(size, alignment, offset))
+		{
+			// The copies of the pending batch are read from the ring too, so it has to be submitted before waiting for it
+			if (s_SubmittedBatches.empty())
+				SubmitPendingBatch();
+			ReleaseCompletedBatches(true);
+		}
+		return offset;
+	}
+
+	bool UploadManager::TryAllocateStagingMemory(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset)
+	{
+		if (s_RingUsedSize == 0)
+			s_RingHead = s_RingTail = 0;
+		else if (s_RingHead == s_RingTail)
+			return false;
+
+		const VkDeviceSize alignedHead = (s_RingHead + alignment - 1) & ~(alignment - 1);
+
+		VkDeviceSize consumedSize;
+		if (s_RingHead >= s_RingTail)
+		{
+			// The free memory is split into [head, end) and [0, tail)
+			if (alignedHead + size <= StagingRingSize)
+			{
+				outOffset = alignedHead;
+				consumedSize = alignedHead - s_RingHead + size;
+			}
+			else if (size <= s_RingTail)
+			{
+				// Skip the end of the ring and wrap around
+				outOffset = 0;
+				consumedSize = StagingRingSize - s_RingHead + size;
+			}
+			else
+				return false;
+		}
+		else
+		{
+			if (alignedHead + size > s_RingTail)
+				return false;
+
+			outOffset = alignedHead;
+			consumedSize = alignedHead - s_RingHead + size;
+		}
+
+		s_RingHead = (outOffset + size) % StagingRingSize;
+		s_RingUsedSize += consumedSize;
+
+		s_PendingBatch.RingSize += consumedSize;
+		s_PendingBatch.RingEnd = s_RingHead;
+		return true;
+	}
+
+	VkCommandBuffer UploadManager::GetPendingCommandBuffer()
+	{
+		if (s_PendingBatch.CommandBuffer != VK_NULL_HANDLE)
+			return s_PendingBatch.CommandBuffer;
+
+		if (s_FreeCommandBuffers.empty())
+		{
+			VkCommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocateInfo.commandPool = s_CommandPool;
+			allocateInfo.commandBufferCount = 1;
+
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(VulkanContext::GetCurrentDevice()->GetVulkanDevice(), &allocateInfo, &s_PendingBatch.CommandBuffer));
+		}
+		else
+		{
+			s_PendingBatch.CommandBuffer = s_FreeCommandBuffers.back();
+			s_FreeCommandBuffers.pop_back();
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CHECK_RESULT(vkBeginCommandBuffer(s_PendingBatch.CommandBuffer, &beginInfo));
+		return s_PendingBatch.CommandBuffer;
+	}
+
+	void UploadManager::SubmitPendingBatch()
+	{
+		if (s_PendingBatch.CommandBuffer == VK_NULL_HANDLE)
+			return;
+
+		// Make the transfers visible to the commands submitted to the queue after this batch, i.e. the frames using the resources
+		VkMemoryBarrier memoryBarrier{};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+		vkCmdPipelineBarrier(s_PendingBatch.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+		VK_CHECK_RESULT(vkEndCommandBuffer(s_PendingBatch.CommandBuffer));
+
+		s_PendingBatch.TimelineValue = s_NextTimelineValue++;
+
+		VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineSubmitInfo.signalSemaphoreValueCount = 1;
+		timelineSubmitInfo.pSignalSemaphoreValues = &s_PendingBatch.TimelineValue;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineSubmitInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &s_PendingBatch.CommandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &s_TimelineSemaphore;
+
+		const auto& device = VulkanContext::GetCurrentDevice();
+		{
+			std::scoped_lock<std::mutex> lock(device->GetQueueMutex());
+			VK_CHECK_RESULT(vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE));
+		}
+
+		s_SubmittedBatches.emplace_back(std::move(s_PendingBatch));
+		s_PendingBatch = UploadBatch{};
+	}
+
+	void UploadManager::ReleaseCompletedBatches(bool waitForOldest)
+	{
+		if (s_SubmittedBatches.empty())
+			return;
+
+		const auto& device = VulkanContext::GetCurrentDevice()->GetVulkanDevice();
+
+		if (waitForOldest)
+		{
+			VkSemaphoreWaitInfo waitInfo{};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &s_TimelineSemaphore;
+			waitInfo.pValues = &s_SubmittedBatches.front().TimelineValue;
+
+			VK_CHECK_RESULT(vkWaitSemaphores(device, &waitInfo, UINT64_MAX));
+		}
+
+		uint64_t completedValue = 0;
+		VK_CHECK_RESULT(vkGetSemaphoreCounterValue(device, s_TimelineSemaphore, &completedValue));
+
+		while (!s_SubmittedBatches.empty() && s_SubmittedBatches.front().TimelineValue <= completedValue)
+		{
+			auto& batch = s_SubmittedBatches.front();
+
+			// The batches complete in order, so the tail of the ring simply moves to the end of the batch
+			if (batch.RingSize)
+			{
+				s_RingTail = batch.RingEnd;
+				s_RingUsedSize -= batch.RingSize;
+			}
+
+			VK_CHECK_RESULT(vkResetCommandBuffer(batch.CommandBuffer, 0));
+			s_FreeCommandBuffers.emplace_back(batch.CommandBuffer);
+
+			s_SubmittedBatches.pop_front();
+		}
+	}
+
+} // namespace Flameberry
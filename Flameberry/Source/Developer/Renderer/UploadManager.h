@@ -0,0 +1,81 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Core/Core.h"
+#include "Buffer.h"
+#include "Image.h"
+
+namespace Flameberry {
+
+	// Identifies the batch of uploads a copy was recorded into, the default token is always complete
+	struct UploadToken
+	{
+		uint64_t Value = 0;
+	};
+
+	// Copies the data into a persistently mapped staging ring buffer and records the transfers into a batch instead of waiting for each of them
+	// The batch is submitted once per frame before the frame itself, on the graphics queue, so the frame is ordered after the uploads by a barrier at the end of the batch
+	// The completion of each batch is tracked by a timeline semaphore, which is what the upload tokens wait on
+	class UploadManager
+	{
+	public:
+		static constexpr VkDeviceSize StagingRingSize = 64 * 1024 * 1024;
+
+	public:
+		static void Init();
+		// Waits for all the uploads to complete
+		static void Shutdown();
+
+		static UploadToken UploadToBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+		// Writes the first mip level of the image and generates the rest of them, the image is transitioned from undefined to the final layout
+		// The image is kept alive until the upload completes
+		static UploadToken UploadToImage(const Ref<Image>& image, const void* data, VkDeviceSize size, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// Submits the pending batch, to be called before the frame using the uploaded resources is submitted
+		static void SubmitPendingUploads();
+
+		static bool IsComplete(UploadToken token);
+		// Submits the batch of the token if it is pending and blocks until it is complete
+		static void Wait(UploadToken token);
+
+	private:
+		struct UploadBatch
+		{
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			uint64_t TimelineValue = 0;
+			// The size of the staging ring consumed by the batch and the offset of the ring at it's end
+			VkDeviceSize RingSize = 0, RingEnd = 0;
+			// Uploads larger than the ring get a staging buffer of their own
+			std::vector<Unique<Buffer>> TemporaryStagingBuffers;
+			std::vector<Ref<Image>> Images;
+		};
+
+		// Returns the offset into the staging ring, the pending batch is submitted and the old batches are waited on when the ring is full
+		static VkDeviceSize AllocateStagingMemory(VkDeviceSize size, VkDeviceSize alignment);
+		static bool TryAllocateStagingMemory(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+		static VkCommandBuffer GetPendingCommandBuffer();
+		static void SubmitPendingBatch();
+		// Recycles the command buffers and the staging memory of the completed batches
+		static void ReleaseCompletedBatches(bool waitForOldest);
+
+	private:
+		static Unique<Buffer> s_StagingRing;
+		static VkDeviceSize s_RingHead, s_RingTail, s_RingUsedSize;
+
+		static VkCommandPool s_CommandPool;
+		static std::vector<VkCommandBuffer> s_FreeCommandBuffers;
+		static VkSemaphore s_TimelineSemaphore;
+		// The value the pending batch will signal, every submitted batch signals a value one greater than the previous one
+		static uint64_t s_NextTimelineValue;
+
+		static UploadBatch s_PendingBatch;
+		static std::deque<UploadBatch> s_SubmittedBatches;
+
+		static std::mutex s_Mutex;
+	};
+
+} // namespace Flameberry
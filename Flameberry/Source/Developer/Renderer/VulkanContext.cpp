@@ -3,6 +3,7 @@
 #include <set>
 #include <map>
 #include <string>
+#include <cstring>
 
 #include "Core/Core.h"
 
@@ -74,16 +75,33 @@ namespace Flameberry {
 		vkGetPhysicalDeviceProperties(m_VkPhysicalDevice, &vk_physical_device_props);
 		FBY_INFO("Selected Vulkan Physical Device: {}", vk_physical_device_props.deviceName);
 
+		// The optional extensions are enabled only when the selected device supports them
+		{
+			uint32_t extensionCount = 0;
+			vkEnumerateDeviceExtensionProperties(m_VkPhysicalDevice, nullptr, &extensionCount, nullptr);
+
+			std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+			vkEnumerateDeviceExtensionProperties(m_VkPhysicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+			for (const auto& extension : availableExtensions)
+			{
+				if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+					s_VulkanDeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+			}
+		}
+
 		m_VulkanDevice = CreateRef<VulkanDevice>(m_VkPhysicalDevice, pWindow);
 
 		constexpr uint32_t maxDescSets = 500;
 
 		std::vector<VkDescriptorPoolSize> poolSizes = {
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 * 8 },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 3 * 8 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * 16 },
 			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxDescSets },
 			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 50 }
 		};
 		m_GlobalDescriptorPool = CreateRef<DescriptorPool>(m_VulkanDevice->GetVulkanDevice(), poolSizes, maxDescSets);
+		m_GlobalDescriptorAllocator = CreateUnique<DescriptorAllocator>(256);
 
 #if (defined(VK_USE_PLATFORM_MACOS_MVK) || defined(VK_USE_PLATFORM_METAL_EXT))
 		// SRS - on macOS set environment variable to configure MoltenVK for using Metal argument buffers (needed for descriptor indexing)
@@ -134,33 +152,23 @@ namespace Flameberry {
 					FBY_ERROR("\t{}", name);
 			}
 
-			VkPhysicalDeviceFeatures supportedFeatures;
-			vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
-
-			VkPhysicalDeviceFeatures2 deviceFeatures2{};
-			deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
-
-			VkPhysicalDeviceVulkan12Features vulkan12Features{};
-			vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
 
-			deviceFeatures2.pNext = &vulkan12Features;
-			vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures2);
+			const auto missingFeatures = VulkanDevice::GetMissingRequiredFeatures(physicalDevice);
+			if (missingFeatures.size())
+			{
+				FBY_ERROR("The physical device '{}' doesn't support the following feature(s):", deviceProperties.deviceName);
+				for (const char* feature : missingFeatures)
+					FBY_ERROR("\t{}", feature);
+			}
 
 			bool isPhysicalDeviceValid = indices.GraphicsQueueFamilyIndex != -1
 				&& indices.ComputeQueueFamilyIndex!= -1
 				&& indices.PresentationSupportedQueueFamilyIndex != -1
 				&& foundRequiredExtensions
 				&& isSwapchainAdequate
-				&& supportedFeatures.samplerAnisotropy
-				&& supportedFeatures.sampleRateShading
-				&& supportedFeatures.fillModeNonSolid
-				&& supportedFeatures.tessellationShader
-				&& supportedFeatures.depthClamp
-				&& supportedFeatures.shaderStorageImageArrayDynamicIndexing
-				&& vulkan12Features.descriptorIndexing;
-
-			VkPhysicalDeviceProperties deviceProperties;
-			vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+				&& missingFeatures.empty();
 
 			int score = 0;
 
@@ -170,7 +178,7 @@ namespace Flameberry {
 			if (isPhysicalDeviceValid)
 				physicalDeviceMap[score] = physicalDevice;
 		}
-		FBY_ASSERT(physicalDeviceMap.size(), "Failed to find valid physical device!");
+		FBY_ASSERT(physicalDeviceMap.size(), "Failed to find a physical device supporting the required extensions and features!");
 		return physicalDeviceMap.rbegin()->second;
 	}
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstring>
 #include <vulkan/vulkan.h>
 
 #include "Core/Core.h"
@@ -28,12 +29,22 @@ namespace Flameberry {
 		}
 		static VulkanWindow* GetCurrentWindow() { return GetCurrentContext()->m_Window; }
 		static Ref<DescriptorPool> GetCurrentGlobalDescriptorPool() { return GetCurrentContext()->m_GlobalDescriptorPool; }
+		static DescriptorAllocator* GetCurrentGlobalDescriptorAllocator() { return GetCurrentContext()->m_GlobalDescriptorAllocator.get(); }
 		static bool EnableValidationLayers() { return s_EnableValidationLayers; }
 
 		static VkPhysicalDevice GetValidPhysicalDevice(const std::vector<VkPhysicalDevice>& vk_physical_devices, VkSurfaceKHR surface);
 		static std::vector<const char*> GetValidationLayerNames() { return s_ValidationLayers; }
 
 		static const std::vector<const char*>& GetVulkanDeviceExtensions() { return s_VulkanDeviceExtensions; }
+		static bool IsDeviceExtensionEnabled(const char* extensionName)
+		{
+			for (const char* extension : s_VulkanDeviceExtensions)
+			{
+				if (strcmp(extension, extensionName) == 0)
+					return true;
+			}
+			return false;
+		}
 
 		static void SetCurrentContext(VulkanContext* pContext) { s_CurrentContext = pContext; }
 		static VulkanContext* GetCurrentContext()
@@ -49,7 +60,10 @@ namespace Flameberry {
 		VkPhysicalDevice m_VkPhysicalDevice = VK_NULL_HANDLE;
 		VulkanWindow* m_Window = nullptr;
 
+		// Used by ImGui, which allocates it's descriptor sets from a single pool
 		Ref<DescriptorPool> m_GlobalDescriptorPool;
+		// Used by all the other descriptor sets with a long lifetime, which don't specify a pool
+		Unique<DescriptorAllocator> m_GlobalDescriptorAllocator;
 
 	private:
 		static std::vector<const char*> s_VulkanDeviceExtensions;
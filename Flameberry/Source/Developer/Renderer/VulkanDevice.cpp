@@ -12,6 +12,12 @@ namespace Flameberry {
 		// Getting Queue Family Indices
 		m_QueueFamilyIndices = RenderCommand::GetQueueFamilyIndices(m_VulkanPhysicalDevice, pVulkanWindow->GetWindowSurface());
 
+		// The physical device is selected only if it supports all of the required features, enabling a missing one fails the device creation
+		const auto missingFeatures = GetMissingRequiredFeatures(m_VulkanPhysicalDevice);
+		for (const char* feature : missingFeatures)
+			FBY_CRITICAL("The selected physical device doesn't support the required feature: {}", feature);
+		FBY_ASSERT(missingFeatures.empty(), "The selected physical device is missing {} required feature(s)!", missingFeatures.size());
+
 		std::vector<VkDeviceQueueCreateInfo> vulkanDeviceQueueCreateInfos = CreateDeviceQueueInfos({ m_QueueFamilyIndices.GraphicsQueueFamilyIndex,
 			m_QueueFamilyIndices.ComputeQueueFamilyIndex,
 			m_QueueFamilyIndices.PresentationSupportedQueueFamilyIndex });
@@ -24,10 +30,19 @@ namespace Flameberry {
 		deviceFeatures2.features.fillModeNonSolid = VK_TRUE;
 		deviceFeatures2.features.tessellationShader = VK_TRUE;
 		deviceFeatures2.features.depthClamp = VK_TRUE;
+		deviceFeatures2.features.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
 
 		VkPhysicalDeviceVulkan12Features vulkan12Features{};
 		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
 		vulkan12Features.descriptorIndexing = VK_TRUE;
+		// Used by the bindless texture table, which is indexed with `nonuniformEXT()` by the fragment shaders
+		vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+		vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+		vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		// Used to track the completion of the uploads and the one-shot submissions
+		vulkan12Features.timelineSemaphore = VK_TRUE;
 
 		deviceFeatures2.pNext = &vulkan12Features;
 
@@ -69,6 +84,8 @@ namespace Flameberry {
 		vkGetDeviceQueue(m_VulkanDevice, m_QueueFamilyIndices.ComputeQueueFamilyIndex, 0, &m_ComputeQueue);
 		vkGetDeviceQueue(m_VulkanDevice, m_QueueFamilyIndices.PresentationSupportedQueueFamilyIndex, 0, &m_PresentationQueue);
 
+		m_MemoryAllocator = CreateUnique<DeviceMemoryAllocator>(m_VulkanPhysicalDevice, m_VulkanDevice, VulkanContext::IsDeviceExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME));
+
 		{
 			// Creating Graphics Queue Command Pool
 			VkCommandPoolCreateInfo commandPoolCreateInfo{};
@@ -88,48 +105,195 @@ namespace Flameberry {
 		
 			VK_CHECK_RESULT(vkCreateCommandPool(m_VulkanDevice, &commandPoolCreateInfo, nullptr, &m_ComputeQueueCommandPool));
 		}
+
+		// The one-shot command buffers have pools of their own, as they are reset individually once their submissions complete
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			auto& oneShotQueue = m_OneShotQueues[i];
+
+			VkCommandPoolCreateInfo commandPoolCreateInfo{};
+			commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			commandPoolCreateInfo.queueFamilyIndex = i ? m_QueueFamilyIndices.ComputeQueueFamilyIndex : m_QueueFamilyIndices.GraphicsQueueFamilyIndex;
+			commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+			VK_CHECK_RESULT(vkCreateCommandPool(m_VulkanDevice, &commandPoolCreateInfo, nullptr, &oneShotQueue.CommandPool));
+
+			VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{};
+			semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+			semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			semaphoreTypeCreateInfo.initialValue = 0;
+
+			VkSemaphoreCreateInfo semaphoreCreateInfo{};
+			semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+			VK_CHECK_RESULT(vkCreateSemaphore(m_VulkanDevice, &semaphoreCreateInfo, nullptr, &oneShotQueue.TimelineSemaphore));
+		}
 	}
 
-	void VulkanDevice::BeginSingleTimeCommandBuffer(VkCommandBuffer& commandBuffer, bool isCompute) const
+	VkCommandBuffer VulkanDevice::BeginOneShotCommandBuffer(bool isCompute) const
 	{
-		VkCommandBufferAllocateInfo vk_command_buffer_allocate_info{};
-		vk_command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		vk_command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		vk_command_buffer_allocate_info.commandPool = isCompute ? m_ComputeQueueCommandPool : m_GraphicsQueueCommandPool;
-		vk_command_buffer_allocate_info.commandBufferCount = 1;
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		{
+			std::scoped_lock<std::mutex> lock(m_OneShotMutex);
+
+			auto& oneShotQueue = GetOneShotQueue(isCompute);
+			RecycleCompletedCommandBuffers(oneShotQueue);
+
+			if (oneShotQueue.FreeCommandBuffers.size())
+			{
+				commandBuffer = oneShotQueue.FreeCommandBuffers.back();
+				oneShotQueue.FreeCommandBuffers.pop_back();
+			}
+			else
+			{
+				VkCommandBufferAllocateInfo allocateInfo{};
+				allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				allocateInfo.commandPool = oneShotQueue.CommandPool;
+				allocateInfo.commandBufferCount = 1;
+
+				VK_CHECK_RESULT(vkAllocateCommandBuffers(m_VulkanDevice, &allocateInfo, &commandBuffer));
+			}
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+		return commandBuffer;
+	}
+
+	OneShotSubmission VulkanDevice::SubmitOneShot(VkCommandBuffer commandBuffer, bool isCompute) const
+	{
+		VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
 
-		vkAllocateCommandBuffers(m_VulkanDevice, &vk_command_buffer_allocate_info, &commandBuffer);
+		std::scoped_lock<std::mutex> lock(m_OneShotMutex);
 
-		VkCommandBufferBeginInfo vk_command_buffer_begin_info{};
-		vk_command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		vk_command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		auto& oneShotQueue = GetOneShotQueue(isCompute);
+		const uint64_t timelineValue = oneShotQueue.NextTimelineValue++;
 
-		vkBeginCommandBuffer(commandBuffer, &vk_command_buffer_begin_info);
+		VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineSubmitInfo.signalSemaphoreValueCount = 1;
+		timelineSubmitInfo.pSignalSemaphoreValues = &timelineValue;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineSubmitInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &oneShotQueue.TimelineSemaphore;
+
+		{
+			std::scoped_lock<std::mutex> queueLock(m_QueueMutex);
+			VK_CHECK_RESULT(vkQueueSubmit(isCompute ? m_ComputeQueue : m_GraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
+		}
+
+		oneShotQueue.SubmittedCommandBuffers.emplace_back(timelineValue, commandBuffer);
+		return OneShotSubmission{ timelineValue, isCompute };
 	}
 
-	void VulkanDevice::EndSingleTimeCommandBuffer(VkCommandBuffer& commandBuffer, bool isCompute) const
+	bool VulkanDevice::IsComplete(const OneShotSubmission& submission) const
 	{
-		vkEndCommandBuffer(commandBuffer);
+		uint64_t completedValue = 0;
+		VK_CHECK_RESULT(vkGetSemaphoreCounterValue(m_VulkanDevice, GetOneShotQueue(submission.IsCompute).TimelineSemaphore, &completedValue));
+		return completedValue >= submission.Value;
+	}
 
-		VkSubmitInfo vk_submit_info{};
-		vk_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		vk_submit_info.commandBufferCount = 1;
-		vk_submit_info.pCommandBuffers = &commandBuffer;
+	void VulkanDevice::Wait(const OneShotSubmission& submission) const
+	{
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &GetOneShotQueue(submission.IsCompute).TimelineSemaphore;
+		waitInfo.pValues = &submission.Value;
+
+		VK_CHECK_RESULT(vkWaitSemaphores(m_VulkanDevice, &waitInfo, UINT64_MAX));
+	}
+
+	void VulkanDevice::RecycleCompletedCommandBuffers(OneShotQueue& oneShotQueue) const
+	{
+		if (oneShotQueue.SubmittedCommandBuffers.empty())
+			return;
+
+		uint64_t completedValue = 0;
+		VK_CHECK_RESULT(vkGetSemaphoreCounterValue(m_VulkanDevice, oneShotQueue.TimelineSemaphore, &completedValue));
 
-		VkQueue vulkanQueue = isCompute ? m_ComputeQueue : m_GraphicsQueue;
-		vkQueueSubmit(vulkanQueue, 1, &vk_submit_info, VK_NULL_HANDLE);
-		vkQueueWaitIdle(vulkanQueue);
+		while (!oneShotQueue.SubmittedCommandBuffers.empty() && oneShotQueue.SubmittedCommandBuffers.front().first <= completedValue)
+		{
+			VkCommandBuffer commandBuffer = oneShotQueue.SubmittedCommandBuffers.front().second;
+			VK_CHECK_RESULT(vkResetCommandBuffer(commandBuffer, 0));
 
-		vkFreeCommandBuffers(m_VulkanDevice, m_GraphicsQueueCommandPool, 1, &commandBuffer);
+			oneShotQueue.FreeCommandBuffers.push_back(commandBuffer);
+			oneShotQueue.SubmittedCommandBuffers.pop_front();
+		}
 	}
 
 	VulkanDevice::~VulkanDevice()
 	{
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			auto& oneShotQueue = m_OneShotQueues[i];
+
+			// Wait for the submissions still in flight before their command buffers are freed along with the pool
+			if (oneShotQueue.SubmittedCommandBuffers.size())
+				Wait(OneShotSubmission{ oneShotQueue.SubmittedCommandBuffers.back().first, i == 1 });
+
+			vkDestroySemaphore(m_VulkanDevice, oneShotQueue.TimelineSemaphore, nullptr);
+			vkDestroyCommandPool(m_VulkanDevice, oneShotQueue.CommandPool, nullptr);
+		}
+
 		vkDestroyCommandPool(m_VulkanDevice, m_GraphicsQueueCommandPool, nullptr);
 		vkDestroyCommandPool(m_VulkanDevice, m_ComputeQueueCommandPool, nullptr);
+		m_MemoryAllocator = nullptr;
 		vkDestroyDevice(m_VulkanDevice, nullptr);
 	}
 
+	std::vector<const char*> VulkanDevice::GetMissingRequiredFeatures(VkPhysicalDevice physicalDevice)
+	{
+		VkPhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		VkPhysicalDeviceMultiviewFeaturesKHR multiviewFeatures{};
+		multiviewFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES_KHR;
+		multiviewFeatures.pNext = &vulkan12Features;
+
+		VkPhysicalDeviceFeatures2 deviceFeatures2{};
+		deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures2.pNext = &multiviewFeatures;
+
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &deviceFeatures2);
+
+		// Every feature enabled while creating the device
+		const std::pair<const char*, VkBool32> requiredFeatures[] = {
+			{ "samplerAnisotropy", deviceFeatures2.features.samplerAnisotropy },
+			{ "sampleRateShading", deviceFeatures2.features.sampleRateShading },
+			{ "fillModeNonSolid", deviceFeatures2.features.fillModeNonSolid },
+			{ "tessellationShader", deviceFeatures2.features.tessellationShader },
+			{ "depthClamp", deviceFeatures2.features.depthClamp },
+			{ "shaderStorageImageArrayDynamicIndexing", deviceFeatures2.features.shaderStorageImageArrayDynamicIndexing },
+			{ "multiview", multiviewFeatures.multiview },
+			{ "descriptorIndexing", vulkan12Features.descriptorIndexing },
+			{ "runtimeDescriptorArray", vulkan12Features.runtimeDescriptorArray },
+			{ "shaderSampledImageArrayNonUniformIndexing", vulkan12Features.shaderSampledImageArrayNonUniformIndexing },
+			{ "descriptorBindingPartiallyBound", vulkan12Features.descriptorBindingPartiallyBound },
+			{ "descriptorBindingSampledImageUpdateAfterBind", vulkan12Features.descriptorBindingSampledImageUpdateAfterBind },
+			{ "descriptorBindingUpdateUnusedWhilePending", vulkan12Features.descriptorBindingUpdateUnusedWhilePending },
+			{ "timelineSemaphore", vulkan12Features.timelineSemaphore }
+		};
+
+		std::vector<const char*> missingFeatures;
+		for (const auto& [feature, isSupported] : requiredFeatures)
+		{
+			if (!isSupported)
+				missingFeatures.push_back(feature);
+		}
+		return missingFeatures;
+	}
+
 	std::vector<VkDeviceQueueCreateInfo> VulkanDevice::CreateDeviceQueueInfos(const std::set<uint32_t>& uniqueQueueFamilyIndices)
 	{
 		constexpr float queuePriority = 1.0f;
@@ -148,16 +312,19 @@ namespace Flameberry {
 
 	void VulkanDevice::WaitIdle() const
 	{
+		std::scoped_lock<std::mutex> lock(m_QueueMutex);
 		vkDeviceWaitIdle(m_VulkanDevice);
 	}
 
 	void VulkanDevice::WaitIdleGraphicsQueue() const
 	{
+		std::scoped_lock<std::mutex> lock(m_QueueMutex);
 		vkQueueWaitIdle(m_GraphicsQueue);
 	}
 	
 	void VulkanDevice::WaitIdleComputeQueue() const
 	{
+		std::scoped_lock<std::mutex> lock(m_QueueMutex);
 		vkQueueWaitIdle(m_ComputeQueue);
 	}
 
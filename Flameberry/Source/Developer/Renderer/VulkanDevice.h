@@ -2,10 +2,13 @@
 
 #include <vector>
 #include <set>
+#include <deque>
+#include <mutex>
 #include <vulkan/vulkan.h>
 
 #include "Core/Core.h"
 #include "Renderer/VulkanWindow.h"
+#include "Renderer/DeviceMemoryAllocator.h"
 
 namespace Flameberry {
 
@@ -16,6 +19,13 @@ namespace Flameberry {
 		uint32_t PresentationSupportedQueueFamilyIndex = -1;
 	};
 
+	// Identifies a one-shot submission on either the graphics or the compute queue, the default submission is always complete
+	struct OneShotSubmission
+	{
+		uint64_t Value = 0;
+		bool IsCompute = false;
+	};
+
 	class VulkanDevice
 	{
 	public:
@@ -29,9 +39,17 @@ namespace Flameberry {
 		inline QueueFamilyIndices GetQueueFamilyIndices() const { return m_QueueFamilyIndices; }
 		VkCommandPool GetGraphicsCommandPool() const { return m_GraphicsQueueCommandPool; }
 		VkCommandPool GetComputeCommandPool() const { return m_ComputeQueueCommandPool; }
+		// Vulkan requires external synchronization of the queues, which are now accessed by both the main and the render thread
+		std::mutex& GetQueueMutex() const { return m_QueueMutex; }
+		DeviceMemoryAllocator& GetMemoryAllocator() const { return *m_MemoryAllocator; }
 
-		void BeginSingleTimeCommandBuffer(VkCommandBuffer& commandBuffer, bool isCompute = false) const;
-		void EndSingleTimeCommandBuffer(VkCommandBuffer& commandBuffer, bool isCompute = false) const;
+		// Returns a recycled command buffer which is ready for recording, to be submitted using `SubmitOneShot()`
+		VkCommandBuffer BeginOneShotCommandBuffer(bool isCompute = false) const;
+		// Ends and submits the command buffer without waiting for it, the command buffer is recycled once the submission completes
+		// The resources used by the commands are to be kept alive by the caller until `IsComplete()` returns true
+		OneShotSubmission SubmitOneShot(VkCommandBuffer commandBuffer, bool isCompute = false) const;
+		bool IsComplete(const OneShotSubmission& submission) const;
+		void Wait(const OneShotSubmission& submission) const;
 
 		void WaitIdle() const;
 		void WaitIdleGraphicsQueue() const;
@@ -39,12 +57,39 @@ namespace Flameberry {
 
 		std::vector<VkDeviceQueueCreateInfo> CreateDeviceQueueInfos(const std::set<uint32_t>& uniqueQueueFamilyIndices);
 
+		// Returns the names of the features required by the renderer that the physical device doesn't support
+		static std::vector<const char*> GetMissingRequiredFeatures(VkPhysicalDevice physicalDevice);
+
+	private:
+		// The command buffers of the one-shot submissions of a queue, the completion of which is tracked by a timeline semaphore
+		struct OneShotQueue
+		{
+			VkCommandPool CommandPool = VK_NULL_HANDLE;
+			VkSemaphore TimelineSemaphore = VK_NULL_HANDLE;
+			// Every submission signals a value one greater than the previous one
+			uint64_t NextTimelineValue = 1;
+			std::vector<VkCommandBuffer> FreeCommandBuffers;
+			// The submitted command buffers along with the timeline value they signal, in the order of submission
+			std::deque<std::pair<uint64_t, VkCommandBuffer>> SubmittedCommandBuffers;
+		};
+
+		OneShotQueue& GetOneShotQueue(bool isCompute) const { return m_OneShotQueues[isCompute ? 1 : 0]; }
+		// Moves the command buffers of the completed submissions back to the free list, to be called while holding `m_OneShotMutex`
+		void RecycleCompletedCommandBuffers(OneShotQueue& oneShotQueue) const;
+
 	private:
 		VkDevice m_VulkanDevice;
 		VkQueue m_GraphicsQueue, m_ComputeQueue, m_PresentationQueue;
 		QueueFamilyIndices m_QueueFamilyIndices;
 
 		VkCommandPool m_GraphicsQueueCommandPool, m_ComputeQueueCommandPool;
+		mutable std::mutex m_QueueMutex;
+
+		// Indexed by whether the queue is the compute queue
+		mutable OneShotQueue m_OneShotQueues[2];
+		mutable std::mutex m_OneShotMutex;
+
+		Unique<DeviceMemoryAllocator> m_MemoryAllocator;
 
 		VkPhysicalDevice& m_VulkanPhysicalDevice;
 	};
@@ -109,8 +109,9 @@ namespace Flameberry {
 
 	bool VulkanWindow::BeginFrame()
 	{
+		// A suboptimal image is still acquired and it's semaphore signaled, so the frame is rendered to it
 		VkResult result = m_SwapChain->AcquireNextImage();
-		if (result != VK_SUCCESS)
+		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
 		{
 			if (result == VK_ERROR_OUT_OF_DATE_KHR)
 				m_SwapChain->Invalidate();
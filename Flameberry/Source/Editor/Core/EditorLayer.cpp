@@ -11,6 +11,11 @@
 
 #include "Physics/Physics.h"
 #include "Renderer/ShaderLibrary.h"
+#include "Renderer/GeometryArena.h"
+#include "Renderer/UniformRing.h"
+#include "Renderer/TextureTable.h"
+#include "Renderer/MaterialParameterBuffer.h"
+#include "Renderer/GPUProfiler.h"
 
 namespace Flameberry {
 
@@ -115,11 +120,19 @@ namespace Flameberry {
 		DescriptorSetLayoutSpecification mousePickingDescSetLayoutSpec;
 		mousePickingDescSetLayoutSpec.Bindings.emplace_back();
 		mousePickingDescSetLayoutSpec.Bindings[0].binding = 0;
-		mousePickingDescSetLayoutSpec.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		mousePickingDescSetLayoutSpec.Bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		mousePickingDescSetLayoutSpec.Bindings[0].descriptorCount = 1;
 		mousePickingDescSetLayoutSpec.Bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		mousePickingDescSetLayoutSpec.Bindings[0].pImmutableSamplers = nullptr;
 
+		// Instance Storage Buffer
+		mousePickingDescSetLayoutSpec.Bindings.emplace_back();
+		mousePickingDescSetLayoutSpec.Bindings[1].binding = 1;
+		mousePickingDescSetLayoutSpec.Bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		mousePickingDescSetLayoutSpec.Bindings[1].descriptorCount = 1;
+		mousePickingDescSetLayoutSpec.Bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		mousePickingDescSetLayoutSpec.Bindings[1].pImmutableSamplers = nullptr;
+
 		m_MousePickingDescriptorSetLayout = DescriptorSetLayout::CreateOrGetCached(mousePickingDescSetLayoutSpec);
 
 		{
@@ -163,15 +176,20 @@ namespace Flameberry {
 		auto swapchain = VulkanContext::GetCurrentWindow()->GetSwapChain();
 		uint32_t imageCount = swapchain->GetSwapChainImageCount();
 
-		m_ViewportDescriptorSets.resize(imageCount);
-		m_CompositePassViewportDescriptorSets.resize(imageCount);
-		for (int i = 0; i < imageCount; i++)
+		// The UI of a frame is built before the swapchain image it is rendered into is acquired
+		// Hence the viewport descriptor sets are per frame in flight and are pointed at the output of the acquired image by the render thread
+		m_ViewportDescriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		for (auto& descriptorSet : m_ViewportDescriptorSets)
 		{
-			m_ViewportDescriptorSets[i] = ImGui_ImplVulkan_AddTexture(
+			descriptorSet = ImGui_ImplVulkan_AddTexture(
 				Texture2D::GetDefaultSampler(),
-				m_SceneRenderer->GetGeometryPassOutputImageView(i),
+				m_SceneRenderer->GetGeometryPassOutputImageView(0),
 				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
 
+		m_CompositePassViewportDescriptorSets.resize(imageCount);
+		for (int i = 0; i < imageCount; i++)
+		{
 #if 0
             m_CompositePassViewportDescriptorSets[i] = ImGui_ImplVulkan_AddTexture(
                 Texture2D::GetDefaultSampler(),
@@ -198,6 +216,7 @@ namespace Flameberry {
 
 		if (m_ShouldReloadMeshShaders)
 		{
+			Renderer::WaitForRenderThread();
 			VulkanContext::GetCurrentDevice()->WaitIdle();
 			m_SceneRenderer->ReloadMeshShaders();
 			m_ShouldReloadMeshShaders = false;
@@ -211,14 +230,19 @@ namespace Flameberry {
 				// TODO: Design this better
 				const auto& camera = m_ActiveCameraController.GetCamera();
 
+				// The scene is extracted while the render thread is still rendering the last frame
+				const auto& proxies = m_SceneRenderer->ExtractScene(m_ActiveScene, m_SceneHierarchyPanel->GetSelectionContext());
+
 				// Actual Rendering (All scene related render passes)
-				m_SceneRenderer->RenderScene(m_RenderViewportSize, m_ActiveScene, camera, m_ActiveCameraController.GetPosition(), m_SceneHierarchyPanel->GetSelectionContext(), m_EnableGrid);
+				m_SceneRenderer->RenderScene(m_RenderViewportSize, proxies, camera, m_ActiveCameraController.GetPosition(), m_EnableGrid);
 				break;
 			}
 			case EditorState::Play:
 			{
 				m_ActiveScene->OnUpdateRuntime(delta);
 
+				const auto& proxies = m_SceneRenderer->ExtractScene(m_ActiveScene, FEntity::Null);
+
 				// TODO: Design this better
 				const auto cameraEntity = m_ActiveScene->GetPrimaryCameraEntity();
 				if (cameraEntity != FEntity::Null)
@@ -226,12 +250,12 @@ namespace Flameberry {
 					auto [transform, cameraComp] = m_ActiveScene->GetRegistry()->GetComponent<TransformComponent, CameraComponent>(cameraEntity);
 					auto& camera = cameraComp.Camera;
 					camera.SetView(transform.Translation, transform.Rotation);
-					m_SceneRenderer->RenderScene(m_RenderViewportSize, m_ActiveScene, camera, transform.Translation, FEntity::Null, false, false, false, false);
+					m_SceneRenderer->RenderScene(m_RenderViewportSize, proxies, camera, transform.Translation, false, false, false, false);
 				}
 				else
 				{
 					const auto& camera = m_ActiveCameraController.GetCamera();
-					m_SceneRenderer->RenderScene(m_RenderViewportSize, m_ActiveScene, camera, m_ActiveCameraController.GetPosition(), FEntity::Null, false, false, false, false);
+					m_SceneRenderer->RenderScene(m_RenderViewportSize, proxies, camera, m_ActiveCameraController.GetPosition(), false, false, false, false);
 				}
 				break;
 			}
@@ -240,38 +264,55 @@ namespace Flameberry {
 				m_ActiveScene->OnUpdateSimulation(delta);
 
 				const auto& camera = m_ActiveCameraController.GetCamera();
+				const auto& proxies = m_SceneRenderer->ExtractScene(m_ActiveScene, m_SceneHierarchyPanel->GetSelectionContext());
+
 				// Actual Rendering (All scene related render passes)
-				m_SceneRenderer->RenderScene(m_RenderViewportSize, m_ActiveScene, camera, m_ActiveCameraController.GetPosition(), m_SceneHierarchyPanel->GetSelectionContext(), m_EnableGrid);
+				m_SceneRenderer->RenderScene(m_RenderViewportSize, proxies, camera, m_ActiveCameraController.GetPosition(), m_EnableGrid);
 			}
 		}
 
 		// Update all image index related descriptors
-		Renderer::Submit([&](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
+		Renderer::Submit([&, frameIndex = Renderer::GetCurrentFrameIndex()](VkCommandBuffer cmdBuffer, uint32_t imageIndex)
 			{
 				// TODO: Update these descriptors only when there corresponding framebuffer is updated
-				InvalidateViewportImGuiDescriptorSet(imageIndex);
+				InvalidateViewportImGuiDescriptorSet(frameIndex, imageIndex);
 #if 0
                 InvalidateCompositePassImGuiDescriptorSet(imageIndex);
 #endif
 			});
 
 		// Retrieving the entity index from the mouse picking framebuffer
-		// This is written before the rendering block...
-		// to make sure that we access the buffer in the next frame after the rendering is done in the last one
-		if (m_IsMousePickingBufferReady)
+		// The pixel is copied once the mouse picking pass of the last frame is submitted, and read back in a later frame once the copy completes
+		if (m_IsMousePickingReadbackPending && VulkanContext::GetCurrentDevice()->IsComplete(m_MousePickingReadback))
 		{
-			RenderCommand::WritePixelFromImageToBuffer(
-				m_MousePickingBuffer->GetVulkanBuffer(),
-				m_MousePickingRenderPass->GetSpecification().TargetFramebuffers[0]->GetColorAttachment(0)->GetVulkanImage(),
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				{ m_MouseX, m_ViewportSize.y - m_MouseY - 1 });
-
 			m_MousePickingBuffer->MapMemory(sizeof(int32_t));
 			int32_t* data = (int32_t*)m_MousePickingBuffer->GetMappedMemory();
 			int32_t entityIndex = data[0];
 			m_MousePickingBuffer->UnmapMemory();
 			m_SceneHierarchyPanel->SetSelectionContext((entityIndex != -1) ? m_ActiveScene->GetRegistry()->GetEntityAtIndex(entityIndex) : FEntity::Null);
 			// FBY_LOG("Selected Entity Index: {}", entityIndex);
+			m_IsMousePickingReadbackPending = false;
+		}
+
+		// The mouse picking pass of a dropped frame is never rendered, so it's rendered again in this frame instead of being read back
+		bool shouldRenderMousePickingPass = false;
+		if (m_IsMousePickingBufferReady && Renderer::WasLastFrameDropped())
+		{
+			shouldRenderMousePickingPass = true;
+			m_IsMousePickingBufferReady = false;
+		}
+
+		if (m_IsMousePickingBufferReady)
+		{
+			// The mouse picking pass of the last frame should be submitted by the render thread before the copy is submitted after it
+			Renderer::WaitForRenderThread();
+			m_MousePickingReadback = RenderCommand::WritePixelFromImageToBuffer(
+				m_MousePickingBuffer->GetVulkanBuffer(),
+				m_MousePickingRenderPass->GetSpecification().TargetFramebuffers[0]->GetColorAttachment(0)->GetVulkanImage(),
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				{ m_MouseX, m_ViewportSize.y - m_MouseY - 1 });
+
+			m_IsMousePickingReadbackPending = true;
 			m_IsMousePickingBufferReady = false;
 		}
 
@@ -292,17 +333,20 @@ namespace Flameberry {
 			m_MouseY = (int)my;
 
 			if (m_MouseX >= 0 && m_MouseY >= 0 && m_MouseX < (int)viewportSize.x && m_MouseY < (int)viewportSize.y)
-			{
-				FBY_PROFILE_SCOPE("Last Mouse Picking Pass");
-				m_IsMousePickingBufferReady = true;
+				shouldRenderMousePickingPass = true;
+		}
 
-				auto framebuffer = m_MousePickingRenderPass->GetSpecification().TargetFramebuffers[0];
-				if (framebuffer->GetSpecification().Width != m_ViewportSize.x || framebuffer->GetSpecification().Height != m_ViewportSize.y)
-					framebuffer->OnResize(m_ViewportSize.x, m_ViewportSize.y, m_MousePickingRenderPass->GetRenderPass());
+		if (shouldRenderMousePickingPass)
+		{
+			FBY_PROFILE_SCOPE("Last Mouse Picking Pass");
+			m_IsMousePickingBufferReady = true;
 
-				RenderCommand::SetViewport(0, 0, m_ViewportSize.x, m_ViewportSize.y);
-				m_SceneRenderer->RenderSceneForMousePicking(m_ActiveScene, m_MousePickingRenderPass, m_MousePickingPipeline, m_MousePicking2DPipeline, glm::vec2(m_MouseX, (int)(m_ViewportSize.y - m_MouseY - 1)));
-			}
+			auto framebuffer = m_MousePickingRenderPass->GetSpecification().TargetFramebuffers[0];
+			if (framebuffer->GetSpecification().Width != m_ViewportSize.x || framebuffer->GetSpecification().Height != m_ViewportSize.y)
+				framebuffer->OnResize(m_ViewportSize.x, m_ViewportSize.y, m_MousePickingRenderPass->GetRenderPass());
+
+			RenderCommand::SetViewport(0, 0, m_ViewportSize.x, m_ViewportSize.y);
+			m_SceneRenderer->RenderSceneForMousePicking(m_ActiveScene, m_MousePickingRenderPass, m_MousePickingPipeline, m_MousePicking2DPipeline, glm::vec2(m_MouseX, (int)(m_ViewportSize.y - m_MouseY - 1)));
 		}
 
 		if (m_ShouldOpenAnotherScene)
@@ -360,9 +404,11 @@ namespace Flameberry {
 
 		Application::Get().ImGuiLayerBlockEvents(!m_IsViewportFocused && !m_SceneHierarchyPanel->IsFocused());
 
-		uint32_t imageIndex = VulkanContext::GetCurrentWindow()->GetImageIndex();
+		const uint32_t frameIndex = Renderer::GetCurrentFrameIndex();
 
-		ImGui::Image(reinterpret_cast<ImTextureID>(m_ViewportDescriptorSets[imageIndex]), ImVec2{ m_ViewportSize.x, m_ViewportSize.y });
+		// The scene is rendered into the top left region of the render targets, which is upscaled to the size of the viewport
+		const glm::vec2 viewportUVScale = m_SceneRenderer->GetViewportUVScale();
+		ImGui::Image(reinterpret_cast<ImTextureID>(m_ViewportDescriptorSets[frameIndex]), ImVec2{ m_ViewportSize.x, m_ViewportSize.y }, ImVec2{ 0.0f, 0.0f }, ImVec2{ viewportUVScale.x, viewportUVScale.y });
 
 		// Scene File Drop Target
 		if (ImGui::BeginDragDropTarget() && m_EditorState == EditorState::Edit)
@@ -462,16 +508,16 @@ namespace Flameberry {
 		// UI_CompositeView();
 	}
 
-	void EditorLayer::InvalidateViewportImGuiDescriptorSet(uint32_t index) const
+	void EditorLayer::InvalidateViewportImGuiDescriptorSet(uint32_t frameIndex, uint32_t imageIndex) const
 	{
 		VkDescriptorImageInfo desc_image[1] = {};
 		desc_image[0].sampler = Texture2D::GetDefaultSampler();
-		desc_image[0].imageView = m_SceneRenderer->GetGeometryPassOutputImageView(index);
+		desc_image[0].imageView = m_SceneRenderer->GetGeometryPassOutputImageView(imageIndex);
 		desc_image[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 		VkWriteDescriptorSet write_desc[1] = {};
 		write_desc[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		write_desc[0].dstSet = m_ViewportDescriptorSets[index];
+		write_desc[0].dstSet = m_ViewportDescriptorSets[frameIndex];
 		write_desc[0].descriptorCount = 1;
 		write_desc[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		write_desc[0].pImageInfo = desc_image;
@@ -1012,14 +1058,59 @@ namespace Flameberry {
 		{
 			ImGui::TextWrapped("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 			FBY_DISPLAY_SCOPE_DETAILS_IMGUI();
+			GPUProfiler::DisplayScopeDetailsImGui();
 
 			const auto& rendererFrameStats = Renderer::GetRendererFrameStats();
 			// ImGui::Text("Mesh Count: %u", rendererFrameStats.MeshCount);
 			// ImGui::Text("SubMesh Count: %u", rendererFrameStats.SubMeshCount);
 			ImGui::Text("Bound Materials: %u", rendererFrameStats.BoundMaterials);
 			ImGui::Text("Vertex and IndexBuffer State Switches: %u", rendererFrameStats.VertexAndIndexBufferStateSwitches);
+			ImGui::Text("Visible SubMeshes: %u", rendererFrameStats.VisibleSubMeshCount);
+			ImGui::Text("Culled SubMeshes: %u", rendererFrameStats.CulledSubMeshCount);
+			ImGui::Text("Occluded SubMeshes: %u", rendererFrameStats.OccludedSubMeshCount);
+			ImGui::Text("Shadow Caster SubMeshes: %u", rendererFrameStats.ShadowCasterSubMeshCount);
 			// ImGui::Text("Mesh Draw Calls: %u", rendererFrameStats.DrawCallCount);
 			// ImGui::Text("Indices: %u", rendererFrameStats.IndexCount);
+
+			const auto geometryArenaStats = GeometryArena::GetStats();
+			ImGui::Text("Geometry Blocks: %u (%u meshes)", geometryArenaStats.BlockCount, geometryArenaStats.AllocationCount);
+			ImGui::Text("Geometry Vertices: %llu / %llu", (unsigned long long)geometryArenaStats.UsedVertexCount, (unsigned long long)geometryArenaStats.VertexCapacity);
+			ImGui::Text("Geometry Indices: %llu / %llu", (unsigned long long)geometryArenaStats.UsedIndexCount, (unsigned long long)geometryArenaStats.IndexCapacity);
+			ImGui::Text("Uniform Ring: %llu / %llu bytes", (unsigned long long)UniformRing::GetUsedSize(), (unsigned long long)UniformRing::FrameCapacity);
+			ImGui::Text("Texture Table: %u / %u textures", TextureTable::GetTextureCount(), TextureTable::GetCapacity());
+			ImGui::Text("Material Buffer: %u / %u materials", MaterialParameterBuffer::GetMaterialCount(), MaterialParameterBuffer::MaxMaterialCount);
+			const auto* descriptorAllocator = VulkanContext::GetCurrentGlobalDescriptorAllocator();
+			ImGui::Text("Descriptor Pools: %u (%llu sets allocated)", descriptorAllocator->GetPoolCount(), (unsigned long long)descriptorAllocator->GetAllocatedSetCount());
+		}
+		ImGui::NewLine();
+
+		if (ImGui::CollapsingHeader("Device Memory", ImGuiTreeNodeFlags_SpanAvailWidth | ImGuiTreeNodeFlags_Framed))
+		{
+			auto& memoryAllocator = VulkanContext::GetCurrentDevice()->GetMemoryAllocator();
+			const auto memoryStats = memoryAllocator.GetStats();
+
+			constexpr float toMB = 1.0f / (1024.0f * 1024.0f);
+
+			for (uint32_t i = 0; i < (uint32_t)MemoryCategory::Count; i++)
+			{
+				const auto& categoryStats = memoryStats.Categories[i];
+				ImGui::Text("%s: %u allocations, %.2f MB", MemoryCategoryToString((MemoryCategory)i), categoryStats.AllocationCount, categoryStats.AllocatedSize * toMB);
+			}
+
+			ImGui::Separator();
+			ImGui::Text("Blocks: %u (%u empty), %.2f / %.2f MB used", memoryStats.BlockCount, memoryStats.EmptyBlockCount, memoryStats.UsedBlockSize * toMB, memoryStats.BlockSize * toMB);
+			ImGui::Text("Free Ranges: %u, Largest: %.2f MB", memoryStats.FreeRangeCount, memoryStats.LargestFreeRangeSize * toMB);
+			ImGui::Text("Dedicated Allocations: %u, %.2f MB", memoryStats.DedicatedAllocationCount, memoryStats.DedicatedSize * toMB);
+
+			ImGui::Separator();
+			for (uint32_t i = 0; i < memoryStats.Heaps.size(); i++)
+			{
+				const auto& heap = memoryStats.Heaps[i];
+				ImGui::Text("Heap %u (%s): %.1f / %.1f MB budget, %.1f MB total", i, heap.IsDeviceLocal ? "Device Local" : "Host", heap.Usage * toMB, heap.Budget * toMB, heap.Size * toMB);
+			}
+
+			if (ImGui::Button("Release Empty Blocks"))
+				memoryAllocator.ReleaseEmptyBlocks();
 		}
 		ImGui::NewLine();
 
@@ -1038,6 +1129,9 @@ namespace Flameberry {
 				UI::TableKeyElement("Frustum Culling");
 				ImGui::Checkbox("##Frustum_Culling", &settings.FrustumCulling);
 
+				UI::TableKeyElement("Occlusion Culling");
+				ImGui::Checkbox("##Occlusion_Culling", &settings.OcclusionCulling);
+
 				UI::TableKeyElement("Show Bounding Boxes");
 				ImGui::Checkbox("##Show_Bounding_Boxes", &settings.ShowBoundingBoxes);
 
@@ -1053,6 +1147,38 @@ namespace Flameberry {
 				UI::TableKeyElement("Lambda Split");
 				FBY_PUSH_WIDTH_MAX(ImGui::DragFloat("##Lambda_Split", &settings.CascadeLambdaSplit, 0.001f, 0.0f, 1.0f));
 
+				UI::TableKeyElement("Cascade Count");
+				FBY_PUSH_WIDTH_MAX(ImGui::SliderScalar("##Cascade_Count", ImGuiDataType_U32, &settings.CascadeCount, &SceneRendererSettings::MinCascadeCount, &SceneRendererSettings::MaxCascadeCount));
+
+				UI::TableKeyElement("Cascade Size");
+
+				const uint32_t cascadeSizes[] = { 512, 1024, 2048, 4096 };
+				const char* cascadeSizeStrings[] = { "512", "1024", "2048", "4096" };
+				const std::string currentCascadeSizeString = std::to_string(settings.CascadeSize);
+
+				ImGui::PushItemWidth(-1.0f);
+				if (ImGui::BeginCombo("##Cascade_Size", currentCascadeSizeString.c_str()))
+				{
+					for (int i = 0; i < 4; i++)
+					{
+						bool isSelected = (cascadeSizes[i] == settings.CascadeSize);
+						if (ImGui::Selectable(cascadeSizeStrings[i], &isSelected))
+							settings.CascadeSize = cascadeSizes[i];
+
+						if (isSelected)
+							ImGui::SetItemDefaultFocus();
+					}
+					ImGui::EndCombo();
+				}
+				ImGui::PopItemWidth();
+
+				UI::TableKeyElement("Cache Static Shadows");
+				ImGui::Checkbox("##Cache_Static_Shadows", &settings.CacheStaticShadows);
+
+				UI::TableKeyElement("First Cached Cascade");
+				const uint32_t minCachedCascade = 0, maxCachedCascade = settings.CascadeCount;
+				FBY_PUSH_WIDTH_MAX(ImGui::SliderScalar("##First_Cached_Cascade", ImGuiDataType_U32, &settings.FirstCachedCascade, &minCachedCascade, &maxCachedCascade));
+
 				UI::TableKeyElement("Sky Reflections");
 				ImGui::Checkbox("##Sky_Reflections", &settings.SkyReflections);
 
@@ -1071,6 +1197,18 @@ namespace Flameberry {
 				UI::TableKeyElement("Grid Far");
 				FBY_PUSH_WIDTH_MAX(ImGui::DragFloat("##Grid_Far", &settings.GridFar, 0.01f, settings.GridNear));
 
+				UI::TableKeyElement("Dynamic Resolution");
+				ImGui::Checkbox("##Dynamic_Resolution", &settings.DynamicResolution);
+
+				UI::TableKeyElement("Target Frame Time");
+				FBY_PUSH_WIDTH_MAX(ImGui::DragFloat("##Target_Frame_Time", &settings.TargetFrameTime, 0.1f, 1.0f, 100.0f, "%.2f ms"));
+
+				UI::TableKeyElement("Min Render Scale");
+				FBY_PUSH_WIDTH_MAX(ImGui::DragFloat("##Min_Render_Scale", &settings.MinRenderScale, 0.01f, 0.25f, 1.0f));
+
+				UI::TableKeyElement("Render Scale");
+				ImGui::Text("%.2f", m_SceneRenderer->GetRenderScale());
+
 				UI::EndKeyValueTable();
 			}
 		}
@@ -32,7 +32,7 @@ namespace Flameberry {
 		void OnMouseButtonPressedEvent(MouseButtonPressedEvent& e);
 		void OnMouseScrolledEvent(MouseScrollEvent& e);
 
-		void InvalidateViewportImGuiDescriptorSet(uint32_t index) const;
+		void InvalidateViewportImGuiDescriptorSet(uint32_t frameIndex, uint32_t imageIndex) const;
 		void InvalidateCompositePassImGuiDescriptorSet(uint32_t index) const;
 
 		void OpenProject();
@@ -105,6 +105,9 @@ namespace Flameberry {
 
 		// Mouse Picking
 		Unique<Buffer> m_MousePickingBuffer;
+		// The copy of the picked pixel into the buffer, which is read back once it completes
+		OneShotSubmission m_MousePickingReadback;
+		bool m_IsMousePickingReadbackPending = false;
 		Ref<RenderPass> m_MousePickingRenderPass;
 
 		Ref<Pipeline> m_MousePickingPipeline, m_MousePicking2DPipeline;
@@ -356,6 +356,10 @@ namespace Flameberry {
 							}
 							ImGui::EndDragDropTarget();
 						}
+
+						UI::TableKeyElement("Is Occluder");
+						ImGui::Checkbox("##IsOccluder", &mesh.IsOccluder);
+
 						UI::EndKeyValueTable();
 					}
 